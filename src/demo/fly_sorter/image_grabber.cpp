@@ -1,6 +1,12 @@
 #include "image_grabber.hpp"
 #include "camera_facade.hpp"
 #include "exception.hpp"
+#include "stamped_image.hpp"
+#include "video_reader.hpp"
+#include "video_reader_avi.hpp"
+#include "video_reader_images.hpp"
+#include "prefetch_video_reader.hpp"
+#include "video_frame_iterator.hpp"
 #include <QPointer>
 #include <QMap>
 #include <QFile>
@@ -192,60 +198,43 @@ void ImageGrabber::runCaptureFromCamera()
 
 void ImageGrabber::runCaptureFromFile()
 {
-    cv::VideoCapture fileCapture;
-
-    // Open the capture input file
+    // Reads any file with a VideoReader - movies written by BIAS (fmf, ufmf,
+    // zfmf, mjpg), avi files and image sequence directories. Frames are 
+    // decoded ahead of playback by the prefetch thread.
+    std::shared_ptr<VideoReader> readerPtr;
     try
     {
-        fileCapture.open(param_.captureInputFile.toStdString());
-    }
-    catch(cv::Exception& exception)
-    {
-        QString errorMsg = QString("Error opening captureInputFile, ");
-        errorMsg += param_.captureInputFile + QString(", - ");
-        errorMsg += QString::fromStdString(exception.what());
-        emit fileReadError(errorMsg);
-        return;
+        std::shared_ptr<VideoReader> fileReaderPtr = VideoReader::createReader(param_.captureInputFile);
+        std::shared_ptr<VideoReader_avi> aviReaderPtr = std::dynamic_pointer_cast<VideoReader_avi>(fileReaderPtr);
+        if (aviReaderPtr)
+        {
+            int fourcc = aviReaderPtr -> getFourcc();
+            //std::cout << "fourcc: " << fourcc << std::endl;
+            if ((fourcc == 0) || (fourcc == 808466521))
+            {
+                // --------------------------------------------------------------------
+                // TEMPORARY - currently having problems with DIB/raw formats need to 
+                // fix this
+                // --------------------------------------------------------------------
+                QString errorMsg = QString("Fourcc code is equal to 0 - this is currently not supported");
+                emit fileReadError(errorMsg);
+                return;
+            }
+        }
+        readerPtr = std::make_shared<PrefetchVideoReader>(fileReaderPtr);
     }
-    if (!fileCapture.isOpened())
+    catch (RuntimeError &runtimeError)
     {
         QString errorMsg = QString("Unable to open captureInputFile, ");
-        errorMsg += param_.captureInputFile; 
-        emit fileReadError(errorMsg);
-        return;
-    }
-
-    // Get number of frames and fourcc
-    unsigned int numFrames;
-    int fourcc;
-    try
-    {
-        numFrames = (unsigned int)(fileCapture.get(CV_CAP_PROP_FRAME_COUNT));
-        fourcc = int(fileCapture.get(CV_CAP_PROP_FOURCC));
-    }
-    catch(cv::Exception& exception)
-    {
-        QString errorMsg = QString("Unable to get properties from captureInputFile, ");
-        errorMsg += param_.captureInputFile + QString(", "); 
-        errorMsg += QString::fromStdString(exception.what());
-        emit fileReadError(errorMsg);
-        return;
-    }
-    //std::cout << "fourcc: " << fourcc << std::endl;
-    //std::cout << "numFrames: " << numFrames << std::endl;
-    if ((fourcc == 0) || (fourcc == 808466521))
-    {
-        // --------------------------------------------------------------------
-        // TEMPORARY - currently having problems with DIB/raw formats need to 
-        // fix this
-        // --------------------------------------------------------------------
-        QString errorMsg = QString("Fourcc code is equal to 0 - this is currently not supported");
+        errorMsg += param_.captureInputFile + QString(", - ");
+        errorMsg += QString::fromStdString(runtimeError.what());
         emit fileReadError(errorMsg);
         return;
     }
 
     // Read frame from input file at frameRate.
-    unsigned long frameCount = 0;
+    unsigned long numFrames = readerPtr -> getNumberOfFrames();
+    VideoFrameIterator frameIt(readerPtr);
     //float sleepDt = 1.0e3/param_.frameRate;
     //float sleepDt = 0.5*1.0e3/param_.frameRate;
     float sleepDt = 0.2*1.0e3/param_.frameRate;
@@ -254,53 +243,43 @@ void ImageGrabber::runCaptureFromFile()
     std::cout << param_.captureInputFile.toStdString() << std::endl;
     std::cout << "begin play back" << std::endl;
     ImageData imageData;
+    StampedImage stampedImg;
 
-    while ((!stopped_) && (frameCount < numFrames))
+    while ((!stopped_) && (!frameIt.atEnd()))
     {
+        unsigned long frameCount = frameIt.getFrameNumber();
         std::cout << (frameCount+1) << "/" << numFrames << std::endl;
 
-        cv::Mat mat;
-
         try
         {
-            fileCapture >> mat;
+            frameIt.next(stampedImg);
         }
-        catch (cv::Exception &exception)
+        catch (RuntimeError &runtimeError)
         {
             QString errorMsg = QString("Unable to read frame %1: ").arg(frameCount);
-            errorMsg += QString::fromStdString(exception.what());
+            errorMsg += QString::fromStdString(runtimeError.what());
             emit fileReadError(errorMsg);
             stopped_ = true;
             continue;
         }
-        catch (...)
-        {
-            QString errorMsg = QString("Unable to read frame %1: ").arg(frameCount);
-            errorMsg += QString("an uknown exception occured");
-            emit fileReadError(errorMsg);
-            stopped_ = true;
-            continue;
 
-        }
-        if (mat.empty())
+        // Get deep copy of image mat (required) - the reader's images are
+        // shared with its cache. Mono movies are converted to color.
+        cv::Mat mat;
+        if (stampedImg.image.channels() == 1)
         {
-            // This shouldn't happen, but just in case 
-            // skip any frames that come back empty.
-            frameCount++;
-            //std::cout << "empty frame" << std::endl;
-            continue;
+            cv::cvtColor(stampedImg.image, mat, CV_GRAY2BGR);
         }
         else
         {
-            //std::cout << std::endl;
+            mat = stampedImg.image.clone(); 
         }
 
-        imageData.mat = mat.clone(); // Get deep copy of image mat (required)
+        imageData.mat = mat;
         imageData.frameCount = frameCount; 
         QDateTime currentDateTime = QDateTime::currentDateTime();
         imageData.dateTime = double(currentDateTime.toMSecsSinceEpoch())*(1.0e-3);
         emit newImage(imageData);
-        frameCount++;
 
         ThreadHelper::msleep(sleepDt);
         // DEBUG -  slow down
@@ -312,21 +291,6 @@ void ImageGrabber::runCaptureFromFile()
         //-------------------------------------------------------------------------
     }
     std::cout << "play back done" << std::endl;
-
-    // Release file
-    try
-    {
-        fileCapture.release();
-    }
-    catch(cv::Exception& exception)
-    {
-        QString errorMsg = QString("Error releasing captureInputFile, ");
-        errorMsg += param_.captureInputFile + QString(", - ");
-        errorMsg += QString::fromStdString(exception.what());
-        emit fileReadError(errorMsg);
-        return;
-    }
-    //std::cout << "end" << std::endl;
     return;
 }
 
@@ -383,15 +347,13 @@ void ImageGrabber::runCaptureFromDir()
         return;
     }
 
-
-    while ((!stopped_)  && frameNumberIt.hasNext())
+    // Get the image files to play back in frame number order
+    QStringList fileNameList;
+    std::vector<int> frameNumberVec;
+    while (frameNumberIt.hasNext())
     {
-        ImageData imageData;
-
         int frameNumber = frameNumberIt.next();
         QFileInfo fileInfo = frameNumberToFileInfoMap[frameNumber];
-        QString fileName = fileInfo.absoluteFilePath();
-        //std::cout  << "count: " << fileCount << ", fileName " << fileName.toStdString(); 
 
         // Filter out undesired values
         if (!frameNumberFilterMap.contains(frameNumber))
@@ -405,29 +367,38 @@ void ImageGrabber::runCaptureFromDir()
         bool filterValue = frameNumberFilterMap[frameNumber];
         if (!filterValue)
         {
-            //std::cout << " - skipped (filtered)" << std::endl;
             continue;
         }
 
         // Make sure file exists
         if (!fileInfo.exists())
         {
-            //std::cout <<" - skipped (doesn't exist)" << std::endl;
             continue;
         }
-        //std::cout << std::endl;
+        fileNameList.append(fileInfo.absoluteFilePath());
+        frameNumberVec.push_back(frameNumber);
+    }
+
+    // Images are decoded ahead of playback by the prefetch thread
+    std::shared_ptr<VideoReader_images> imagesReaderPtr = std::make_shared<VideoReader_images>();
+    imagesReaderPtr -> setReadFlags(CV_LOAD_IMAGE_COLOR);
+    imagesReaderPtr -> open(fileNameList);
+    PrefetchVideoReader reader(imagesReaderPtr);
 
+    for (unsigned long i=0; (i<reader.getNumberOfFrames()) && (!stopped_); i++)
+    {
+        ImageData imageData;
 
         // Read image from file
         cv::Mat subImageMat;
         try
         { 
-            subImageMat = cv::imread(fileName.toStdString());
+            reader.getFrame(i, subImageMat);
         }
-        catch (cv::Exception &exception)
+        catch (RuntimeError &runtimeError)
         {
-            QString errorMsg = QString("Unable to read image %1: ").arg(fileName);
-            errorMsg += QString::fromStdString(exception.what());
+            QString errorMsg = QString("Unable to read image %1: ").arg(fileNameList[int(i)]);
+            errorMsg += QString::fromStdString(runtimeError.what());
             emit fileReadError(errorMsg);
             stopped_ = true;
             continue;
@@ -442,7 +413,7 @@ void ImageGrabber::runCaptureFromDir()
         cv::copyMakeBorder(subImageMat,fullImageMat, pad, pad, pad, pad, cv::BORDER_CONSTANT, padColor);
 
         imageData.mat = fullImageMat.clone(); // Get deep copy of image mat (required)
-        imageData.frameCount = frameNumber; 
+        imageData.frameCount = frameNumberVec[i]; 
         QDateTime currentDateTime = QDateTime::currentDateTime();
         imageData.dateTime = double(currentDateTime.toMSecsSinceEpoch())*(1.0e-3);
         emit newImage(imageData);
@@ -133,6 +133,19 @@ namespace bias {
 
         // Capture Errors
         ERROR_CAPTURE_MAX_ERROR_COUNT,
+
+        // Video Reader Errors
+        ERROR_VIDEO_READER_OPEN,
+        ERROR_VIDEO_READER_FORMAT,
+        ERROR_VIDEO_READER_READ,
+
+        // Logging Watchdog Errors
+        ERROR_LOGGING_WATCHDOG_WARNING,
+        ERROR_LOGGING_WATCHDOG_DEGRADE,
+
+        // File Migration Errors
+        ERROR_FILE_MIGRATION_COPY,
+        ERROR_FILE_MIGRATION_VERIFY,
         
         NUMBER_OF_ERROR,
     }; 
@@ -321,6 +334,7 @@ namespace bias {
         VIDEOFILE_FORMAT_AVI,
         VIDEOFILE_FORMAT_FMF,
         VIDEOFILE_FORMAT_UFMF,
+        VIDEOFILE_FORMAT_ZFMF,
         NUMBER_OF_VIDEOFILE_FORMAT,
         VIDEOFILE_FORMAT_UNSPECIFIED,
     };
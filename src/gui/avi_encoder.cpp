@@ -0,0 +1,280 @@
+#include "avi_encoder.hpp"
+#include <QMutex>
+#include <QThread>
+
+namespace bias
+{
+
+    AviEncoder::AviEncoder(
+            int fourcc, 
+            double fps, 
+            cv::Size size, 
+            bool isColor, 
+            unsigned int maxQueueSize, 
+            QMutex *openMutexPtr
+            )
+    {
+        setAutoDelete(false);
+        fourcc_ = fourcc;
+        fps_ = fps;
+        size_ = size;
+        isColor_ = isColor;
+        maxQueueSize_ = maxQueueSize;
+        openMutexPtr_ = openMutexPtr;
+
+        stopped_ = false;
+        busy_ = false;
+        errorFlag_ = false;
+        numFramesQueued_ = 0;
+        numEncoded_ = 0;
+        numDropped_ = 0;
+    }
+
+
+    void AviEncoder::open(QString fileName)
+    {
+        // Closes the current file, if any, first
+        AviEncodeJob job;
+        job.type = AVI_ENCODE_OPEN;
+        job.fileName = fileName;
+        pushJob(job);
+    }
+
+
+    bool AviEncoder::push(const cv::Mat &image)
+    {
+        bool accepted = false;
+        acquireLock();
+        if ((numFramesQueued_ < maxQueueSize_) && (!errorFlag_))
+        {
+            AviEncodeJob job;
+            job.type = AVI_ENCODE_FRAME;
+            job.image = image;
+            jobQueue_.push(job);
+            numFramesQueued_++;
+            jobWaitCond_.wakeAll();
+            accepted = true;
+        }
+        else
+        {
+            numDropped_++;
+        }
+        releaseLock();
+        return accepted;
+    }
+
+
+    void AviEncoder::close()
+    {
+        AviEncodeJob job;
+        job.type = AVI_ENCODE_CLOSE;
+        pushJob(job);
+    }
+
+
+    void AviEncoder::stop()
+    {
+        // Remaining jobs are processed before run returns
+        acquireLock();
+        stopped_ = true;
+        jobWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+
+    void AviEncoder::waitForIdle()
+    {
+        acquireLock();
+        while ((!jobQueue_.empty()) || busy_)
+        {
+            idleWaitCond_.wait(&mutex_);
+        }
+        releaseLock();
+    }
+
+
+    bool AviEncoder::isIdle()
+    {
+        acquireLock();
+        bool idle = jobQueue_.empty() && (!busy_);
+        releaseLock();
+        return idle;
+    }
+
+
+    bool AviEncoder::haveError()
+    {
+        acquireLock();
+        bool errorFlag = errorFlag_;
+        releaseLock();
+        return errorFlag;
+    }
+
+
+    std::string AviEncoder::getErrorMsg()
+    {
+        acquireLock();
+        std::string errorMsg = errorMsg_;
+        releaseLock();
+        return errorMsg;
+    }
+
+
+    unsigned long AviEncoder::getNumberEncoded()
+    {
+        acquireLock();
+        unsigned long numEncoded = numEncoded_;
+        releaseLock();
+        return numEncoded;
+    }
+
+
+    unsigned long AviEncoder::getNumberDropped()
+    {
+        acquireLock();
+        unsigned long numDropped = numDropped_;
+        releaseLock();
+        return numDropped;
+    }
+
+
+    unsigned int AviEncoder::getQueueSize()
+    {
+        acquireLock();
+        unsigned int queueSize = numFramesQueued_;
+        releaseLock();
+        return queueSize;
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+    void AviEncoder::pushJob(const AviEncodeJob &job)
+    {
+        acquireLock();
+        jobQueue_.push(job);
+        jobWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+
+    void AviEncoder::processJob(const AviEncodeJob &job)
+    {
+        switch (job.type)
+        {
+            case AVI_ENCODE_OPEN:
+                {
+                    bool isOpened = false;
+                    std::string errorMsg("unable to open file ");
+                    errorMsg += job.fileName.toStdString();
+                    openMutexPtr_ -> lock();
+                    if (videoWriter_.isOpened())
+                    {
+                        videoWriter_.release();
+                    }
+                    try
+                    {
+                        isOpened = videoWriter_.open(job.fileName.toStdString(), fourcc_, fps_, size_, isColor_);
+                        isOpened = isOpened && videoWriter_.isOpened();
+                    }
+                    catch (cv::Exception &e)
+                    {
+                        errorMsg += std::string(":\n\n") + e.what();
+                    }
+                    openMutexPtr_ -> unlock();
+                    if (!isOpened)
+                    {
+                        setError(errorMsg);
+                    }
+                }
+                break;
+
+            case AVI_ENCODE_FRAME:
+                if (videoWriter_.isOpened())
+                {
+                    try
+                    {
+                        videoWriter_ << job.image;
+                        acquireLock();
+                        numEncoded_++;
+                        releaseLock();
+                    }
+                    catch (cv::Exception &e)
+                    {
+                        setError(std::string("unable to encode frame:\n\n") + e.what());
+                    }
+                }
+                break;
+
+            case AVI_ENCODE_CLOSE:
+                openMutexPtr_ -> lock();
+                if (videoWriter_.isOpened())
+                {
+                    videoWriter_.release();
+                }
+                openMutexPtr_ -> unlock();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+
+    void AviEncoder::setError(std::string msg)
+    {
+        // Only the first error is kept
+        acquireLock();
+        if (!errorFlag_)
+        {
+            errorFlag_ = true;
+            errorMsg_ = msg;
+        }
+        releaseLock();
+    }
+
+
+    void AviEncoder::run()
+    {
+        QThread::currentThread() -> setPriority(QThread::NormalPriority);
+
+        while (true)
+        {
+            acquireLock();
+            busy_ = false;
+            if (jobQueue_.empty())
+            {
+                idleWaitCond_.wakeAll();
+            }
+            while (jobQueue_.empty() && (!stopped_))
+            {
+                jobWaitCond_.wait(&mutex_);
+            }
+            if (jobQueue_.empty())
+            {
+                // Stopped and nothing left to do 
+                releaseLock();
+                break;
+            }
+            AviEncodeJob job = jobQueue_.front();
+            jobQueue_.pop();
+            if (job.type == AVI_ENCODE_FRAME)
+            {
+                numFramesQueued_--;
+            }
+            busy_ = true;
+            releaseLock();
+
+            processJob(job);
+        }
+
+        // Release file if stopped without a close job 
+        processJob(AviEncodeJob{AVI_ENCODE_CLOSE, QString(), cv::Mat()});
+
+        acquireLock();
+        busy_ = false;
+        idleWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+} // namespace bias
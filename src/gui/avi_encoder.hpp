@@ -0,0 +1,99 @@
+#ifndef BIAS_AVI_ENCODER_HPP
+#define BIAS_AVI_ENCODER_HPP
+
+#include "lockable.hpp"
+#include <QRunnable>
+#include <QString>
+#include <QWaitCondition>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <memory>
+#include <queue>
+#include <string>
+
+class QMutex;
+
+namespace bias
+{
+
+    enum AviEncodeJobType
+    {
+        AVI_ENCODE_OPEN=0,
+        AVI_ENCODE_FRAME,
+        AVI_ENCODE_CLOSE,
+    };
+
+
+    struct AviEncodeJob
+    {
+        AviEncodeJobType type;
+        QString fileName;
+        cv::Mat image;
+    };
+
+
+    class AviEncoder : public QRunnable, public Lockable<Empty>
+    {
+        // Encodes frames into avi files on its own thread. Jobs (open file, 
+        // frame, close file) are processed in order. Only frames count 
+        // towards the queue size - when the queue is full frames are refused
+        // and counted as dropped. Errors are recorded and reported by the
+        // writer on the logger thread.
+
+        public:
+
+            AviEncoder(
+                    int fourcc, 
+                    double fps, 
+                    cv::Size size, 
+                    bool isColor, 
+                    unsigned int maxQueueSize, 
+                    QMutex *openMutexPtr
+                    );
+
+            void open(QString fileName);
+            bool push(const cv::Mat &image);
+            void close();
+            void stop();
+            void waitForIdle();
+
+            bool isIdle();
+            bool haveError();
+            std::string getErrorMsg();
+            unsigned long getNumberEncoded();
+            unsigned long getNumberDropped();
+            unsigned int getQueueSize();
+
+        protected:
+
+            int fourcc_;
+            double fps_;
+            cv::Size size_;
+            bool isColor_;
+            unsigned int maxQueueSize_;
+            QMutex *openMutexPtr_;
+            cv::VideoWriter videoWriter_;
+
+            bool stopped_;
+            bool busy_;
+            bool errorFlag_;
+            std::string errorMsg_;
+            unsigned int numFramesQueued_;
+            unsigned long numEncoded_;
+            unsigned long numDropped_;
+
+            std::queue<AviEncodeJob> jobQueue_;
+            QWaitCondition jobWaitCond_;
+            QWaitCondition idleWaitCond_;
+
+            void pushJob(const AviEncodeJob &job);
+            void processJob(const AviEncodeJob &job);
+            void setError(std::string msg);
+            void run();
+    };
+
+    typedef std::shared_ptr<AviEncoder> AviEncoderPtr;
+
+} // namespace bias
+
+#endif // #ifndef BIAS_AVI_ENCODER_HPP
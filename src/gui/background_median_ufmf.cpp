@@ -1,5 +1,7 @@
 #include "background_median_ufmf.hpp"
 #include "background_data_ufmf.hpp"
+#include "median_image_ufmf.hpp"
+#include "ufmf_codec.hpp"
 #include "affinity.hpp"
 #include <iostream>
 #include <QThread>
@@ -17,7 +19,7 @@ namespace bias
     BackgroundMedian_ufmf::BackgroundMedian_ufmf( 
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr,
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr,
-            std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr,
+            std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr,
             unsigned int cameraNumber,
             QObject *parent
             ) 
@@ -30,12 +32,13 @@ namespace bias
     void BackgroundMedian_ufmf::initialize(
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr,
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr,
-            std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr,
+            std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr,
             unsigned int cameraNumber
             )
     {
         ready_ = false;
         stopped_ = true;
+        compressionLevel_ = 0;
         bgNewDataQueuePtr_ = bgNewDataQueuePtr;
         bgOldDataQueuePtr_ = bgOldDataQueuePtr;
         medianMatQueuePtr_ = medianMatQueuePtr;
@@ -58,12 +61,18 @@ namespace bias
     }
 
 
+    void BackgroundMedian_ufmf::setCompressionLevel(unsigned int level)
+    {
+        // Keyframe compression level, 0 = keyframes aren't compressed
+        compressionLevel_ = level;
+    }
+
+
     void BackgroundMedian_ufmf::run()
     {
         bool done = false;
-        bool isFirst = true;
         BackgroundData_ufmf backgroundData;
-        cv::Mat medianImage;
+        MedianImage_ufmf medianImage;
 
         if (!ready_) 
         { 
@@ -96,7 +105,18 @@ namespace bias
             //std::cout << "*** new median data" << std::endl;
 
             // Compute median
-            medianImage = backgroundData.getMedianImage();
+            medianImage.image = backgroundData.getMedianImage();
+
+            // Code keyframe data here so the writer doesn't have to 
+            if (compressionLevel_ > 0)
+            {
+                UfmfCodec::encode(
+                        (const char *) medianImage.image.data, 
+                        uint32_t(medianImage.image.rows*medianImage.image.cols),
+                        compressionLevel_, 
+                        medianImage.codedData
+                        );
+            }
 
             medianMatQueuePtr_ -> acquireLock();
             medianMatQueuePtr_ -> push(medianImage);
@@ -10,6 +10,7 @@ namespace cv {class Mat;}
 namespace bias
 {
     class BackgroundData_ufmf;
+    struct MedianImage_ufmf;
 
 
     class BackgroundMedian_ufmf
@@ -22,27 +23,29 @@ namespace bias
             BackgroundMedian_ufmf( 
                     std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr,
                     std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr,
-                    std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr,
+                    std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr,
                     unsigned int cameraNumber,
                     QObject *parent=0
                     );
             void initialize(
                     std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr,
                     std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr,
-                    std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr,
+                    std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr,
                     unsigned int cameraNumber
                     );
             void stop();
+            void setCompressionLevel(unsigned int level);
 
         private:
             bool ready_;
             bool stopped_;
             unsigned int cameraNumber_;
+            unsigned int compressionLevel_;
 
             // Queues of incoming and outgoing background data for median calculation
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr_;
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr_;
-            std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr_;
+            std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr_;
             void run();
 
     };
@@ -13,6 +13,11 @@
 #include "video_writer_avi.hpp"
 #include "video_writer_fmf.hpp"
 #include "video_writer_ufmf.hpp"
+#include "video_writer_zfmf.hpp"
+#include "trigger_recorder.hpp"
+#include "logging_watchdog.hpp"
+#include "file_migrator.hpp"
+#include "frame_stamp_log.hpp"
 #include "affinity.hpp"
 #include "property_dialog.hpp"
 #include "timer_settings_dialog.hpp"
@@ -97,6 +102,7 @@ namespace bias
         map.insert(VIDEOFILE_FORMAT_AVI,  QString("avi"));
         map.insert(VIDEOFILE_FORMAT_FMF,  QString("fmf"));
         map.insert(VIDEOFILE_FORMAT_UFMF, QString("ufmf"));
+        map.insert(VIDEOFILE_FORMAT_ZFMF, QString("zfmf"));
         return map;
     };
     const QMap<VideoFileFormat, QString> VIDEOFILE_EXTENSION_MAP = createExtensionMap();
@@ -321,10 +327,25 @@ namespace bias
             return rtnStatus;
         }
 
+        if (logging_ && videoWriterParams_.staging.enabled && !QDir(videoWriterParams_.staging.directory).exists())
+        {
+            QString msgTitle("Capture Error");
+            QString msgText("Unable to start image capture: staging directory does not exist, ");
+            msgText += videoWriterParams_.staging.directory;
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this, msgTitle, msgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = msgText;
+            return rtnStatus;
+        }
+
         frameCount_ = 0;
         timeStamp_ = 0.0;
         framesPerSec_ = 0.0;
         skippedFramesWarning_ = false;
+        loggingWatchdogMsg_ = QString();
 
         newImageQueuePtr_ -> clear();
         logImageQueuePtr_ -> clear();
@@ -336,8 +357,18 @@ namespace bias
 
         if (logging_)
         {
-            // Create video writer based on video file format type
+            // Create video writer based on video file format type. With 
+            // staging files are written to the staging directory and moved 
+            // to the video file directory by the file migrator.
             QString videoFileFullPath = getVideoFileFullPath(autoNamingString);
+            if (videoWriterParams_.staging.enabled)
+            {
+                setupFileMigrator();
+                stagingDestDir_ = currentVideoFileDir_;
+                stagingSessionName_ = currentVideoFileName_ + autoNamingString;
+                QDir stagingDir(videoWriterParams_.staging.directory);
+                videoFileFullPath = stagingDir.absoluteFilePath(QFileInfo(videoFileFullPath).fileName());
+            }
             std::shared_ptr<VideoWriter> videoWriterPtr; 
 
             switch (videoFileFormat_)
@@ -382,6 +413,14 @@ namespace bias
                             );
                     break;
 
+                case VIDEOFILE_FORMAT_ZFMF:
+                    videoWriterPtr = std::make_shared<VideoWriter_zfmf>(
+                            videoWriterParams_.zfmf,
+                            videoFileFullPath,
+                            cameraNumber_
+                            );
+                    break;
+
                 default:
                     videoWriterPtr = std::make_shared<VideoWriter>(
                             videoFileFullPath,
@@ -394,6 +433,8 @@ namespace bias
             // Set output file
             videoWriterPtr -> setFileName(videoFileFullPath);
             videoWriterPtr -> setVersioning(autoNamingOptions_.includeVersionNumber);
+            videoWriterPtr -> setRolloverParams(videoWriterParams_.rollover);
+            videoWriterPtr -> setCheckpointParams(videoWriterParams_.checkpoint);
             versionNumber = videoWriterPtr -> getNextVersionNumber();
 
             imageLoggerPtr_ = new ImageLogger(
@@ -419,8 +460,79 @@ namespace bias
                     SLOT(imageLoggingError(unsigned int, QString))
                    );
 
+            if (videoWriterParams_.staging.enabled)
+            {
+                connect(
+                        videoWriterPtr.get(),
+                        SIGNAL(segmentFinished(QString)),
+                        this,
+                        SLOT(onVideoSegmentFinished(QString))
+                       );
+            }
+
+            // Free space and throughput watchdog
+            if (videoWriterParams_.watchdog.enabled)
+            {
+                double plannedDurationSec = 0.0;
+                if (actionTimerEnabledPtr_ -> isChecked())
+                {
+                    plannedDurationSec = double(captureDurationSec_);
+                }
+                loggingWatchdogPtr_ = std::make_shared<LoggingWatchdog>(
+                        videoWriterParams_.watchdog,
+                        QFileInfo(videoFileFullPath).absolutePath(),
+                        videoFileFormat_,
+                        plannedDurationSec
+                        );
+                imageLoggerPtr_ -> setWatchdog(loggingWatchdogPtr_);
+
+                // Fallback writer for the ufmf degrade step, only used from fmf
+                bool haveUfmfStep = videoWriterParams_.watchdog.degradeSteps.contains(
+                        LoggingWatchdog::DEGRADE_STEP_UFMF
+                        );
+                if ((videoFileFormat_ == VIDEOFILE_FORMAT_FMF) && haveUfmfStep)
+                {
+                    QString fileName = currentVideoFileName_ + autoNamingString;
+                    fileName += "." + VIDEOFILE_EXTENSION_MAP[VIDEOFILE_FORMAT_UFMF];
+                    QString fallbackFullPath = QFileInfo(videoFileFullPath).absoluteDir().absoluteFilePath(fileName);
+                    std::shared_ptr<VideoWriter> fallbackWriterPtr = std::make_shared<VideoWriter_ufmf>(
+                            videoWriterParams_.ufmf,
+                            fallbackFullPath,
+                            cameraNumber_
+                            );
+                    fallbackWriterPtr -> setFileName(fallbackFullPath);
+                    fallbackWriterPtr -> setVersioning(autoNamingOptions_.includeVersionNumber);
+                    fallbackWriterPtr -> setRolloverParams(videoWriterParams_.rollover);
+                    fallbackWriterPtr -> setCheckpointParams(videoWriterParams_.checkpoint);
+                    imageLoggerPtr_ -> setFallbackWriter(fallbackWriterPtr);
+
+                    connect(
+                            fallbackWriterPtr.get(),
+                            SIGNAL(imageLoggingError(unsigned int, QString)),
+                            this,
+                            SLOT(imageLoggingError(unsigned int, QString))
+                           );
+
+                    if (videoWriterParams_.staging.enabled)
+                    {
+                        connect(
+                                fallbackWriterPtr.get(),
+                                SIGNAL(segmentFinished(QString)),
+                                this,
+                                SLOT(onVideoSegmentFinished(QString))
+                               );
+                    }
+                }
+            }
+
             threadPoolPtr_ -> start(imageLoggerPtr_);
 
+            // Pre/post trigger recording - only triggered clips are logged
+            if (videoWriterParams_.trigger.enabled)
+            {
+                triggerRecorderPtr_ = std::make_shared<TriggerRecorder>(videoWriterParams_.trigger);
+            }
+
         } // if (logging_)
 
         if (isPluginEnabled())
@@ -461,6 +573,16 @@ namespace bias
                 this
                 );
         imageDispatcherPtr_ -> setAutoDelete(false);
+        imageDispatcherPtr_ -> setTriggerRecorder(triggerRecorderPtr_);
+        imageDispatcherPtr_ -> setLogSubscription(logSubscriptionParams_);
+        imageDispatcherPtr_ -> setPluginSubscription(pluginSubscriptionParams_);
+        imageDispatcherPtr_ -> setDisplaySubscription(displaySubscriptionParams_);
+        if (videoWriterParams_.stampLog.enabled)
+        {
+            QString stampLogName = QString("stamp_log_cam%1").arg(cameraNumber_);
+            stampLogName += FrameStampLog::FILE_EXT;
+            imageDispatcherPtr_ -> setStampLogFileName(getVideoFileDir().absoluteFilePath(stampLogName));
+        }
 
         connect(
                 imageGrabberPtr_, 
@@ -497,6 +619,12 @@ namespace bias
         threadPoolPtr_ -> start(imageDispatcherPtr_);
         // ------------------------------------------------------------------------------
 
+        if (triggerRecorderPtr_ && (videoWriterParams_.trigger.intervalSec > 0.0))
+        {
+            int triggerInterval = int(1000.0*videoWriterParams_.trigger.intervalSec);
+            triggerRecordingTimerPtr_ -> start(triggerInterval);
+        }
+
         // Set Capture start and stop time
         captureStartDateTime_ = QDateTime::currentDateTime();
         captureStopDateTime_ = captureStartDateTime_.addSecs(captureDurationSec_);
@@ -545,6 +673,7 @@ namespace bias
         {
             captureDurationTimerPtr_ -> stop();
         }
+        triggerRecordingTimerPtr_ -> stop();
 
         // Note, image grabber and dispatcher are destroyed by the 
         // threadPool when their run methods exit.
@@ -623,6 +752,36 @@ namespace bias
         pluginImageQueuePtr_ -> clear();
         pluginImageQueuePtr_ -> releaseLock();
 
+        triggerRecorderPtr_.reset();
+        loggingWatchdogPtr_.reset();
+
+        // The logger's writers are destroyed before the staging sweep so that
+        // every file is closed, with its index written, before it is migrated.
+        delete imageLoggerPtr_;
+
+        // Everything left from the session in the staging directory - index
+        // files, manifests and segments not reported by the writer. Files 
+        // already queued by onVideoSegmentFinished are skipped by addFile, 
+        // as are those reported after the sweep.
+        if (logging_ && !fileMigratorPtr_.isNull() && !stagingSessionName_.isEmpty())
+        {
+            QDir stagingDir(fileMigratorPtr_ -> getParams().directory);
+            QStringList nameFilters;
+            nameFilters.append(stagingSessionName_ + QString("*"));
+            QFileInfoList entryList = stagingDir.entryInfoList(nameFilters, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+            for (QFileInfo entryInfo : entryList)
+            {
+                QString destName = stagingDestDir_.absoluteFilePath(entryInfo.fileName());
+                if (entryInfo.isDir())
+                {
+                    fileMigratorPtr_ -> addDirectory(entryInfo.absoluteFilePath(), destName);
+                }
+                else
+                {
+                    fileMigratorPtr_ -> addFile(entryInfo.absoluteFilePath(), destName);
+                }
+            }
+        }
         
         if (isPluginEnabled())
         {
@@ -647,11 +806,10 @@ namespace bias
 
         emit imageCaptureStopped();
 
-        // Manually delete grabber, dispatcher and logger threads   
-        // required as autoDelete is set to false
+        // Manually delete grabber and dispatcher threads, the logger has  
+        // been deleted above - required as autoDelete is set to false
         delete imageGrabberPtr_;
         delete imageDispatcherPtr_;
-        delete imageLoggerPtr_;
 
         rtnStatus.success = true;
         rtnStatus.message = QString("");
@@ -929,6 +1087,10 @@ namespace bias
         
         QVariantMap bmpSettingsMap;
         bmpSettingsMap.insert("frameSkip", videoWriterParams_.bmp.frameSkip);
+        bmpSettingsMap.insert("imageFormat", videoWriterParams_.bmp.imageFormat);
+        bmpSettingsMap.insert("pngCompression", videoWriterParams_.bmp.pngCompression);
+        bmpSettingsMap.insert("framesPerDir", (unsigned int)(videoWriterParams_.bmp.framesPerDir));
+        bmpSettingsMap.insert("compressionThreads", videoWriterParams_.bmp.numberOfCompressors);
         loggingSettingsMap.insert("bmp", bmpSettingsMap);
 
         QVariantMap jpgSettingsMap;
@@ -938,15 +1100,29 @@ namespace bias
         jpgSettingsMap.insert("mjpg", videoWriterParams_.jpg.mjpgFlag);
         jpgSettingsMap.insert("mjpgMaxFramePerFileFlag", videoWriterParams_.jpg.mjpgMaxFramePerFileFlag);
         jpgSettingsMap.insert("mjpgMaxFramePerFile", (unsigned long long)(videoWriterParams_.jpg.mjpgMaxFramePerFile));
+        jpgSettingsMap.insert("fastDct", videoWriterParams_.jpg.fastDct);
+        jpgSettingsMap.insert("chromaSubsampling", JpegEncoder::subsamplingToString(videoWriterParams_.jpg.chromaSubsampling));
+
+        QVariantMap jpgRateControlMap;
+        jpgRateControlMap.insert("on", videoWriterParams_.jpg.rateControl);
+        jpgRateControlMap.insert("minQuality", videoWriterParams_.jpg.minQuality);
+        jpgRateControlMap.insert("targetBytesPerSec", videoWriterParams_.jpg.targetBytesPerSec);
+        jpgRateControlMap.insert("targetQueueSize", videoWriterParams_.jpg.targetQueueSize);
+        jpgSettingsMap.insert("rateControl", jpgRateControlMap);
         loggingSettingsMap.insert("jpg", jpgSettingsMap);
 
         QVariantMap aviSettingsMap;
         aviSettingsMap.insert("frameSkip", videoWriterParams_.avi.frameSkip);
         aviSettingsMap.insert("codec", videoWriterParams_.avi.codec);
+        aviSettingsMap.insert("encodeThreads", videoWriterParams_.avi.numberOfEncoders);
+        aviSettingsMap.insert("encodeQueueSize", videoWriterParams_.avi.encodeQueueSize);
         loggingSettingsMap.insert("avi", aviSettingsMap);
 
         QVariantMap fmfSettingsMap;
         fmfSettingsMap.insert("frameSkip", videoWriterParams_.fmf.frameSkip);
+        fmfSettingsMap.insert("directIO", videoWriterParams_.fmf.directIo);
+        fmfSettingsMap.insert("stripeDirs", videoWriterParams_.fmf.stripeDirs);
+        fmfSettingsMap.insert("stripeChunkFrames", videoWriterParams_.fmf.stripeChunkFrames);
         loggingSettingsMap.insert("fmf", fmfSettingsMap);
 
         QVariantMap ufmfSettingsMap;
@@ -961,8 +1137,69 @@ namespace bias
         ufmfDilateMap.insert("on", videoWriterParams_.ufmf.dilateState);
         ufmfDilateMap.insert("windowSize", videoWriterParams_.ufmf.dilateWindowSize);
         ufmfSettingsMap.insert("dilate", ufmfDilateMap);
+        ufmfSettingsMap.insert("directIO", videoWriterParams_.ufmf.directIo);
+        ufmfSettingsMap.insert("tightBoxes", videoWriterParams_.ufmf.tightBoxes);
+        ufmfSettingsMap.insert("tightBoxStats", videoWriterParams_.ufmf.tightBoxStats);
+        ufmfSettingsMap.insert("compressionLevel", videoWriterParams_.ufmf.compressionLevel);
         
         loggingSettingsMap.insert("ufmf", ufmfSettingsMap);
+
+        QVariantMap zfmfSettingsMap;
+        zfmfSettingsMap.insert("frameSkip", videoWriterParams_.zfmf.frameSkip);
+        zfmfSettingsMap.insert("chunkFrames", videoWriterParams_.zfmf.chunkFrames);
+        zfmfSettingsMap.insert("compressionLevel", videoWriterParams_.zfmf.compressionLevel);
+        zfmfSettingsMap.insert("compressionThreads", videoWriterParams_.zfmf.numberOfCompressors);
+        zfmfSettingsMap.insert("directIO", videoWriterParams_.zfmf.directIo);
+        loggingSettingsMap.insert("zfmf", zfmfSettingsMap);
+
+        // Add file rollover settings - common to all formats
+        QVariantMap rolloverSettingsMap;
+        rolloverSettingsMap.insert("maxBytes", qulonglong(videoWriterParams_.rollover.maxBytes));
+        rolloverSettingsMap.insert("maxDuration", videoWriterParams_.rollover.maxDuration);
+        rolloverSettingsMap.insert("maxFrames", qulonglong(videoWriterParams_.rollover.maxFrames));
+        rolloverSettingsMap.insert("preallocate", videoWriterParams_.rollover.preallocate);
+        loggingSettingsMap.insert("rollover", rolloverSettingsMap);
+
+        // Add pre/post trigger recording settings - common to all formats
+        QVariantMap triggerSettingsMap;
+        triggerSettingsMap.insert("enabled", videoWriterParams_.trigger.enabled);
+        triggerSettingsMap.insert("preTriggerSec", videoWriterParams_.trigger.preTriggerSec);
+        triggerSettingsMap.insert("postTriggerSec", videoWriterParams_.trigger.postTriggerSec);
+        triggerSettingsMap.insert("maxBufferFrames", qulonglong(videoWriterParams_.trigger.maxBufferFrames));
+        triggerSettingsMap.insert("intervalSec", videoWriterParams_.trigger.intervalSec);
+        loggingSettingsMap.insert("trigger", triggerSettingsMap);
+
+        // Add logging watchdog settings - common to all formats
+        QVariantMap watchdogSettingsMap;
+        watchdogSettingsMap.insert("enabled", videoWriterParams_.watchdog.enabled);
+        watchdogSettingsMap.insert("minFreeBytes", qulonglong(videoWriterParams_.watchdog.minFreeBytes));
+        watchdogSettingsMap.insert("minRemainingSec", videoWriterParams_.watchdog.minRemainingSec);
+        watchdogSettingsMap.insert("degradeSteps", videoWriterParams_.watchdog.degradeSteps);
+        loggingSettingsMap.insert("watchdog", watchdogSettingsMap);
+
+        // Add staging settings - common to all formats
+        QVariantMap stagingSettingsMap;
+        stagingSettingsMap.insert("enabled", videoWriterParams_.staging.enabled);
+        stagingSettingsMap.insert("directory", videoWriterParams_.staging.directory);
+        stagingSettingsMap.insert("maxBytesPerSec", videoWriterParams_.staging.maxBytesPerSec);
+        stagingSettingsMap.insert("verifyChecksum", videoWriterParams_.staging.verifyChecksum);
+        loggingSettingsMap.insert("staging", stagingSettingsMap);
+
+        // Add checkpoint settings - used by fmf and ufmf
+        QVariantMap checkpointSettingsMap;
+        checkpointSettingsMap.insert("enabled", videoWriterParams_.checkpoint.enabled);
+        checkpointSettingsMap.insert("interval", videoWriterParams_.checkpoint.interval);
+        checkpointSettingsMap.insert("maxFrames", qulonglong(videoWriterParams_.checkpoint.maxFrames));
+        loggingSettingsMap.insert("checkpoint", checkpointSettingsMap);
+
+        // Add per-frame time stamp sidecar settings
+        QVariantMap stampLogSettingsMap;
+        stampLogSettingsMap.insert("enabled", videoWriterParams_.stampLog.enabled);
+        loggingSettingsMap.insert("stampLog", stampLogSettingsMap);
+
+        // Add frames passed to logging
+        loggingSettingsMap.insert("subscription", getSubscriptionMap(logSubscriptionParams_));
+
         loggingMap.insert("settings", loggingSettingsMap);
 
         // Add logging auto-naming options
@@ -992,6 +1229,7 @@ namespace bias
         displayMap.insert("rotation", (unsigned int)(imageRotation_));
         displayMap.insert("updateFrequency", imageDisplayFreq_);
         displayMap.insert("colorMap",COLORMAP_INT_TO_STRING_MAP[colorMapNumber_]);
+        displayMap.insert("subscription", getSubscriptionMap(displaySubscriptionParams_));
         configurationMap.insert("display", displayMap);
 
         // Add server configuration
@@ -1017,6 +1255,7 @@ namespace bias
                 pluginMap.insert("name", pluginName);
                 QVariantMap pluginConfigMap = getCurrentPlugin() -> getConfigAsMap();;
                 pluginMap.insert("config", pluginConfigMap);
+                pluginMap.insert("subscription", getSubscriptionMap(pluginSubscriptionParams_));
                 configurationMap.insert("plugin", pluginMap);
             }
         } 
@@ -1276,6 +1515,30 @@ namespace bias
         return rtnStatus;
     }
 
+
+    RtnStatus CameraWindow::triggerRecording(bool showErrorDlg)
+    {
+        RtnStatus rtnStatus;
+        QString msgTitle("Trigger Recording Error");
+
+        if (!capturing_ || !triggerRecorderPtr_)
+        {
+            QString msgText("Unable to trigger recording: not capturing with trigger recording enabled");
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this, msgTitle, msgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = msgText;
+            return rtnStatus;
+        }
+        triggerRecorderPtr_ -> trigger();
+
+        rtnStatus.success = true;
+        rtnStatus.message = QString("");
+        return rtnStatus;
+    }
+
     
     QString CameraWindow::getCameraGuidString(RtnStatus &rtnStatus)
     {
@@ -1679,6 +1942,49 @@ namespace bias
     }
 
 
+    QVariantMap CameraWindow::getLoggingWatchdogStatus()
+    {
+        QVariantMap statusMap;
+        statusMap.insert("enabled", bool(loggingWatchdogPtr_));
+        if (!loggingWatchdogPtr_)
+        {
+            return statusMap;
+        }
+        LoggingWatchdogStatus status = loggingWatchdogPtr_ -> getStatus();
+        statusMap.insert("warning", status.warning);
+        statusMap.insert("message", status.message);
+        statusMap.insert("framesPerSec", status.framesPerSec);
+        statusMap.insert("writeFramesPerSec", status.writeFramesPerSec);
+        statusMap.insert("requiredBytesPerSec", status.requiredBytesPerSec);
+        statusMap.insert("achievedBytesPerSec", status.achievedBytesPerSec);
+        statusMap.insert("freeBytes", qulonglong(status.freeBytes));
+        statusMap.insert("remainingSec", status.remainingSec);
+        statusMap.insert("queueSize", status.queueSize);
+        statusMap.insert("degradeLevel", status.degradeLevel);
+        return statusMap;
+    }
+
+
+    QVariantMap CameraWindow::getFileMigrationStatus()
+    {
+        QVariantMap statusMap;
+        statusMap.insert("enabled", !fileMigratorPtr_.isNull());
+        if (fileMigratorPtr_.isNull())
+        {
+            return statusMap;
+        }
+        FileMigrationStatus status = fileMigratorPtr_ -> getStatus();
+        statusMap.insert("numberOfFiles", qulonglong(status.numberOfFiles));
+        statusMap.insert("numberOfBytes", qulonglong(status.numberOfBytes));
+        statusMap.insert("numberOfMigrated", qulonglong(status.numberOfMigrated));
+        statusMap.insert("numberOfFailed", qulonglong(status.numberOfFailed));
+        statusMap.insert("bytesPerSec", status.bytesPerSec);
+        statusMap.insert("currentFileName", status.currentFileName);
+        statusMap.insert("lastError", status.lastError);
+        return statusMap;
+    }
+
+
     bool CameraWindow::isConnected()
     {
         return connected_;
@@ -1743,6 +2049,8 @@ namespace bias
             disconnectCamera();
         }
 
+        stopFileMigrator();
+
         event -> accept();
     }
 
@@ -1842,6 +2150,11 @@ namespace bias
             }
 
         } // if (capturing_)
+        else if (!fileMigratorPtr_.isNull())
+        {
+            // Keep migration backlog up to date 
+            updateStatusLabel();
+        }
 
 
         // Update plugin preview
@@ -1887,6 +2200,46 @@ namespace bias
     }
 
 
+    void CameraWindow::triggerRecordingOnTimer()
+    {
+        if (triggerRecorderPtr_)
+        {
+            triggerRecorderPtr_ -> trigger();
+        }
+    }
+
+
+    void CameraWindow::onTriggerRecordingRequest(double timeStamp)
+    {
+        if (capturing_ && triggerRecorderPtr_)
+        {
+            triggerRecorderPtr_ -> trigger(timeStamp);
+        }
+    }
+
+
+    void CameraWindow::onVideoSegmentFinished(QString fileName)
+    {
+        // Closed file in the staging directory - keeps its path relative to
+        // the staging directory in the video file directory.
+        if (fileMigratorPtr_.isNull())
+        {
+            return;
+        }
+        QDir stagingDir(fileMigratorPtr_ -> getParams().directory);
+        QString destFileName = stagingDestDir_.absoluteFilePath(stagingDir.relativeFilePath(fileName));
+        fileMigratorPtr_ -> addFile(fileName, destFileName);
+    }
+
+
+    void CameraWindow::fileMigrationError(unsigned int errorId, QString errorMsg)
+    {
+        // Logging isn't affected - the file is left in the staging directory
+        std::cout << "warning: " << errorMsg.toStdString() << ", error id = " << errorId << std::endl;
+        updateStatusLabel();
+    }
+
+
     void CameraWindow::tabWidgetChanged(int index)
     {
         updateAllImageLabels();
@@ -1934,6 +2287,11 @@ namespace bias
         {
             skippedFramesWarning_ = true;
         }
+        else if ((errorId == ERROR_LOGGING_WATCHDOG_WARNING) || (errorId == ERROR_LOGGING_WATCHDOG_DEGRADE))
+        {
+            // Logging continues - shown on the preview image
+            loggingWatchdogMsg_ = errorMsg;
+        }
         else
         {
             stopImageCapture();
@@ -2566,6 +2924,8 @@ namespace bias
 
         threadPoolPtr_ = new QThreadPool(this);
         threadPoolPtr_ -> setMaxThreadCount(MAX_THREAD_COUNT);
+        migrationThreadPoolPtr_ = new QThreadPool(this);
+        migrationThreadPoolPtr_ -> setMaxThreadCount(1);
         newImageQueuePtr_ = std::make_shared<LockableQueue<StampedImage>>();
         logImageQueuePtr_ = std::make_shared<LockableQueue<StampedImage>>();
         pluginImageQueuePtr_ = std::make_shared<LockableQueue<StampedImage>>();
@@ -2583,12 +2943,23 @@ namespace bias
         pluginMap_[GrabDetectorPlugin::PLUGIN_NAME] = new GrabDetectorPlugin(pluginImageLabelPtr_,this);
         // -------------------------------------------------------------------------------
 
+        for (QPointer<BiasPlugin> pluginPtr : pluginMap_)
+        {
+            connect(
+                    pluginPtr,
+                    SIGNAL(triggerRecordingRequest(double)),
+                    this,
+                    SLOT(onTriggerRecordingRequest(double))
+                   );
+        }
+
         setupStatusLabel();
         setupCameraMenu();
         setupLoggingMenu();
         setupDisplayMenu();
         setupImageDisplayTimer();
         setupCaptureDurationTimer();
+        setupTriggerRecordingTimer();
         setupImageLabels();
         setupPluginMenu();
         updateAllMenus(); 
@@ -2788,6 +3159,13 @@ namespace bias
                 SLOT(actionLoggingFormatTriggered())
                );
 
+        connect(
+                actionLoggingFormatZFMFPtr_,
+                SIGNAL(triggered()),
+                this,
+                SLOT(actionLoggingFormatTriggered())
+               );
+
         connect(
                 actionLoggingFormatIFMFPtr_,
                 SIGNAL(triggered()),
@@ -3038,6 +3416,60 @@ namespace bias
     }
 
 
+    void CameraWindow::setupTriggerRecordingTimer()
+    {
+        triggerRecordingTimerPtr_ = new QTimer(this);
+        connect(
+                triggerRecordingTimerPtr_,
+                SIGNAL(timeout()),
+                this,
+                SLOT(triggerRecordingOnTimer())
+               );
+    }
+
+
+    void CameraWindow::setupFileMigrator()
+    {
+        // Started when staging is first used and restarted when the staging
+        // settings change. Files pending from an earlier run are resumed.
+        if (!fileMigratorPtr_.isNull())
+        {
+            VideoWriterParams_staging params = fileMigratorPtr_ -> getParams();
+            bool isSame = (params.directory == videoWriterParams_.staging.directory);
+            isSame = isSame && (params.maxBytesPerSec == videoWriterParams_.staging.maxBytesPerSec);
+            isSame = isSame && (params.verifyChecksum == videoWriterParams_.staging.verifyChecksum);
+            if (isSame)
+            {
+                return;
+            }
+            stopFileMigrator();
+        }
+
+        fileMigratorPtr_ = new FileMigrator(videoWriterParams_.staging, cameraNumber_, this);
+        fileMigratorPtr_ -> setAutoDelete(false);
+        connect(
+                fileMigratorPtr_,
+                SIGNAL(fileMigrationError(unsigned int, QString)),
+                this,
+                SLOT(fileMigrationError(unsigned int, QString))
+               );
+        migrationThreadPoolPtr_ -> start(fileMigratorPtr_);
+    }
+
+
+    void CameraWindow::stopFileMigrator()
+    {
+        // Stops after the current chunk, the rest is kept in the journal
+        if (fileMigratorPtr_.isNull())
+        {
+            return;
+        }
+        fileMigratorPtr_ -> stop();
+        migrationThreadPoolPtr_ -> waitForDone();
+        delete fileMigratorPtr_;
+    }
+
+
     void CameraWindow::updateWindowTitle()
     {
         QString windowTitle;
@@ -3127,12 +3559,14 @@ namespace bias
         loggingFormatActionGroupPtr_ -> addAction(actionLoggingFormatAVIPtr_);
         loggingFormatActionGroupPtr_ -> addAction(actionLoggingFormatFMFPtr_);
         loggingFormatActionGroupPtr_ -> addAction(actionLoggingFormatUFMFPtr_);
+        loggingFormatActionGroupPtr_ -> addAction(actionLoggingFormatZFMFPtr_);
         loggingFormatActionGroupPtr_ -> addAction(actionLoggingFormatIFMFPtr_);
         actionToVideoFileFormatMap_[actionLoggingFormatBMPPtr_] = VIDEOFILE_FORMAT_BMP;
         actionToVideoFileFormatMap_[actionLoggingFormatJPGPtr_] = VIDEOFILE_FORMAT_JPG;
         actionToVideoFileFormatMap_[actionLoggingFormatAVIPtr_] = VIDEOFILE_FORMAT_AVI;
         actionToVideoFileFormatMap_[actionLoggingFormatFMFPtr_] = VIDEOFILE_FORMAT_FMF;
         actionToVideoFileFormatMap_[actionLoggingFormatUFMFPtr_] = VIDEOFILE_FORMAT_UFMF;
+        actionToVideoFileFormatMap_[actionLoggingFormatZFMFPtr_] = VIDEOFILE_FORMAT_ZFMF;
 
         if (logging_)
         {
@@ -3355,6 +3789,14 @@ namespace bias
             painter.setPen(QColor(255,0,0));
             painter.drawText(5,pixmapScaled.size().height()- 12, msg);
         }
+
+        // Display logging watchdog warning
+        if (!loggingWatchdogMsg_.isEmpty() && addFrameCount)
+        {
+            QPainter painter(&pixmapScaled);
+            painter.setPen(QColor(255,160,0));
+            painter.drawText(5,pixmapScaled.size().height()- 26, loggingWatchdogMsg_);
+        }
         imageLabelPtr -> setPixmap(pixmapScaled);
     }
 
@@ -3536,6 +3978,22 @@ namespace bias
         {
             statusMsg += QString(", ") + msg;
         }
+
+        if (!fileMigratorPtr_.isNull())
+        {
+            FileMigrationStatus migrationStatus = fileMigratorPtr_ -> getStatus();
+            if (migrationStatus.numberOfFiles > 0)
+            {
+                statusMsg += QString(",  migrating %1 files (%2 MB, %3 MB/s)")
+                    .arg(migrationStatus.numberOfFiles)
+                    .arg(double(migrationStatus.numberOfBytes)/1.0e6, 0, 'f', 1)
+                    .arg(migrationStatus.bytesPerSec/1.0e6, 0, 'f', 1);
+            }
+            if (migrationStatus.numberOfFailed > 0)
+            {
+                statusMsg += QString(",  %1 files failed to migrate").arg(migrationStatus.numberOfFailed);
+            }
+        }
         statusLabelPtr_ -> setText(statusMsg);
     }
 
@@ -5004,6 +5462,23 @@ namespace bias
         }
         imageDisplayFreq_ = displayFreq;
 
+        // new optional parameter
+        if (displayMap.contains("subscription"))
+        {
+            ImageSubscriptionParams subscriptionParams;
+            rtnStatus = setSubscriptionFromMap(
+                    displayMap["subscription"].toMap(),
+                    QString("Display configuration"),
+                    subscriptionParams,
+                    showErrorDlg
+                    );
+            if (!rtnStatus.success)
+            {
+                return rtnStatus;
+            }
+            displaySubscriptionParams_ = subscriptionParams;
+        }
+
         rtnStatus.success = true;
         rtnStatus.message = QString("");
         return rtnStatus;
@@ -5291,67 +5766,201 @@ namespace bias
             return rtnStatus;
         }
 
+        // new optional parameter
+        if (pluginMap.contains("subscription"))
+        {
+            ImageSubscriptionParams subscriptionParams;
+            rtnStatus = setSubscriptionFromMap(
+                    pluginMap["subscription"].toMap(),
+                    QString("Plugin"),
+                    subscriptionParams,
+                    showErrorDlg
+                    );
+            if (!rtnStatus.success)
+            {
+                return rtnStatus;
+            }
+            pluginSubscriptionParams_ = subscriptionParams;
+        }
+
         setPluginEnabled(true);
 
         return rtnStatus;
     }
 
 
-    RtnStatus CameraWindow::setCameraPropertyFromMap(
-            QVariantMap propValueMap, 
-            PropertyInfo propInfo, 
+    RtnStatus CameraWindow::setSubscriptionFromMap(
+            QVariantMap subscriptionMap,
+            QString consumerName,
+            ImageSubscriptionParams &params,
             bool showErrorDlg
             )
     {
+        // Frames passed to a consumer by the image dispatcher - all values 
+        // are optional.
         RtnStatus rtnStatus;
-        Property newProp;
-        newProp.type = propInfo.type;
-        QString errMsgTitle("Load Configuration Error (Camera Property)");
-        QString name = QString::fromStdString(getPropertyTypeString(propInfo.type));
+        QString errMsgTitle("Load Configuration Error (Subscription)");
 
-        // Get value for "Present"
-        if (!propValueMap.contains("present"))
+        if (subscriptionMap.contains("divisor"))
         {
-            QString errMsgText = QString(
-                    "Camera: property %1 has no value for present"
-                    ).arg(name);
-            if (showErrorDlg)
+            if (!subscriptionMap["divisor"].canConvert<unsigned int>())
             {
-                QMessageBox::critical(this,errMsgTitle,errMsgText);
+                QString errMsgText = consumerName + QString(": unable to convert");
+                errMsgText += " subscription divisor to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
             }
-            rtnStatus.success = false;
-            rtnStatus.message = errMsgText;
-            return rtnStatus;
-        }
-        if (!propValueMap["present"].canConvert<bool>())
-        {
-            QString errMsgText = QString(
-                    "Camera: property %1 unable to cast present to bool"
-                    ).arg(name);
-            if (showErrorDlg)
+            params.divisor = subscriptionMap["divisor"].toUInt();
+            if (params.divisor < 1)
             {
-                QMessageBox::critical(this,errMsgTitle,errMsgText);
+                QString errMsgText = consumerName + QString(": subscription divisor");
+                errMsgText += " must be greater than or equal to 1";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
             }
-            rtnStatus.success = false;
-            rtnStatus.message = errMsgText;
-            return rtnStatus;
         }
-        newProp.present =  propValueMap["present"].toBool();
-        if (newProp.present != propInfo.present)
+
+        if (subscriptionMap.contains("maxFps"))
         {
-            QString errMsgText = QString(
-                    "Camera: property %1 present value does not match that in property info"
-                    ).arg(name);
-            if (showErrorDlg)
+            if (!subscriptionMap["maxFps"].canConvert<double>())
             {
-                QMessageBox::critical(this,errMsgTitle,errMsgText);
+                QString errMsgText = consumerName + QString(": unable to convert");
+                errMsgText += " subscription maxFps to double";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            params.maxFps = subscriptionMap["maxFps"].toDouble();
+            if (params.maxFps < 0.0)
+            {
+                QString errMsgText = consumerName + QString(": subscription maxFps");
+                errMsgText += " must be greater than or equal to 0";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
             }
-            rtnStatus.success = false;
-            rtnStatus.message = errMsgText;
-            return rtnStatus;
         }
 
-        // Get value for "Absolute Control"
+        if (subscriptionMap.contains("roi"))
+        {
+            QVariantMap roiMap = subscriptionMap["roi"].toMap();
+            QStringList roiKeys = QStringList() << "x" << "y" << "width" << "height";
+            QList<int> roiValues;
+            for (QString key : roiKeys)
+            {
+                bool ok = roiMap.contains(key) && roiMap[key].canConvert<int>();
+                int value = ok ? roiMap[key].toInt() : -1;
+                if (!ok || (value < 0))
+                {
+                    QString errMsgText = consumerName + QString(": subscription roi");
+                    errMsgText += QString(" %1 must be an integer greater than or equal to 0").arg(key);
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                roiValues.append(value);
+            }
+            params.roi = cv::Rect(roiValues[0], roiValues[1], roiValues[2], roiValues[3]);
+        }
+
+        rtnStatus.success = true;
+        rtnStatus.message = QString("");
+        return rtnStatus;
+    }
+
+
+    QVariantMap CameraWindow::getSubscriptionMap(ImageSubscriptionParams params)
+    {
+        QVariantMap subscriptionMap;
+        subscriptionMap.insert("divisor", params.divisor);
+        subscriptionMap.insert("maxFps", params.maxFps);
+        QVariantMap roiMap;
+        roiMap.insert("x", params.roi.x);
+        roiMap.insert("y", params.roi.y);
+        roiMap.insert("width", params.roi.width);
+        roiMap.insert("height", params.roi.height);
+        subscriptionMap.insert("roi", roiMap);
+        return subscriptionMap;
+    }
+
+
+    RtnStatus CameraWindow::setCameraPropertyFromMap(
+            QVariantMap propValueMap, 
+            PropertyInfo propInfo, 
+            bool showErrorDlg
+            )
+    {
+        RtnStatus rtnStatus;
+        Property newProp;
+        newProp.type = propInfo.type;
+        QString errMsgTitle("Load Configuration Error (Camera Property)");
+        QString name = QString::fromStdString(getPropertyTypeString(propInfo.type));
+
+        // Get value for "Present"
+        if (!propValueMap.contains("present"))
+        {
+            QString errMsgText = QString(
+                    "Camera: property %1 has no value for present"
+                    ).arg(name);
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this,errMsgTitle,errMsgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = errMsgText;
+            return rtnStatus;
+        }
+        if (!propValueMap["present"].canConvert<bool>())
+        {
+            QString errMsgText = QString(
+                    "Camera: property %1 unable to cast present to bool"
+                    ).arg(name);
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this,errMsgTitle,errMsgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = errMsgText;
+            return rtnStatus;
+        }
+        newProp.present =  propValueMap["present"].toBool();
+        if (newProp.present != propInfo.present)
+        {
+            QString errMsgText = QString(
+                    "Camera: property %1 present value does not match that in property info"
+                    ).arg(name);
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this,errMsgTitle,errMsgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = errMsgText;
+            return rtnStatus;
+        }
+
+        // Get value for "Absolute Control"
         if (!propValueMap.contains("absoluteControl"))
         {
             QString errMsgText = QString(
@@ -6158,6 +6767,55 @@ namespace bias
         }
         videoWriterParams_.avi.codec = aviCodec;
 
+        // new optional parameter
+        if (aviMap.contains("encodeThreads"))
+        {
+            if (!aviMap["encodeThreads"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " avi encodeThreads to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.avi.numberOfEncoders = aviMap["encodeThreads"].toUInt();
+        }
+
+        // new optional parameter
+        if (aviMap.contains("encodeQueueSize"))
+        {
+            if (!aviMap["encodeQueueSize"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " avi encodeQueueSize to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            unsigned int aviEncodeQueueSize = aviMap["encodeQueueSize"].toUInt();
+            if (aviEncodeQueueSize == 0)
+            {
+                QString errMsgText("Logging Settings: avi encodeQueueSize must");
+                errMsgText += " be greater than zero";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.avi.encodeQueueSize = aviEncodeQueueSize;
+        }
+
 
         // Get bmp values
         // --------------
@@ -6211,6 +6869,117 @@ namespace bias
         }
         videoWriterParams_.bmp.frameSkip = bmpFrameSkip;
 
+        // new optional parameter
+        if (bmpMap.contains("imageFormat"))
+        {
+            if (!bmpMap["imageFormat"].canConvert<QString>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " bmp imageFormat to string";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            QString bmpImageFormat = bmpMap["imageFormat"].toString();
+            if (!VideoWriter_bmp::isAllowedImageFormat(bmpImageFormat))
+            {
+                QString errMsgText("Logging Settings: bmp imageFormat must");
+                errMsgText += " be bmp, png or tif";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.bmp.imageFormat = bmpImageFormat;
+        }
+
+        // new optional parameter
+        if (bmpMap.contains("pngCompression"))
+        {
+            if (!bmpMap["pngCompression"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " bmp pngCompression to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            unsigned int bmpPngCompression = bmpMap["pngCompression"].toUInt();
+            if (bmpPngCompression > VideoWriter_bmp::MAX_PNG_COMPRESSION)
+            {
+                QString errMsgText("Logging Settings: bmp pngCompression must");
+                errMsgText += " be in range 0 to 9";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.bmp.pngCompression = bmpPngCompression;
+        }
+
+        // new optional parameter
+        if (bmpMap.contains("framesPerDir"))
+        {
+            if (!bmpMap["framesPerDir"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " bmp framesPerDir to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.bmp.framesPerDir = bmpMap["framesPerDir"].toUInt();
+        }
+
+        // new optional parameter
+        if (bmpMap.contains("compressionThreads"))
+        {
+            if (!bmpMap["compressionThreads"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " bmp compressionThreads to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            unsigned int bmpCompressionThreads = bmpMap["compressionThreads"].toUInt();
+            if (bmpCompressionThreads == 0)
+            {
+                QString errMsgText("Logging Settings: bmp compressionThreads must");
+                errMsgText += " be greater than zero";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.bmp.numberOfCompressors = bmpCompressionThreads;
+        }
+
         // Get jpg values - ignore if not there
         // --------------
         QVariantMap jpgMap = formatMap["jpg"].toMap();
@@ -6406,6 +7175,141 @@ namespace bias
                 videoWriterParams_.jpg.mjpgMaxFramePerFile = maxFramePerFile;
                 }
             }
+
+            // new optional parameter
+            if (jpgMap.contains("fastDct"))
+            {
+                if (!jpgMap["fastDct"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: jpg unable to convert fastDct to bool");
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.jpg.fastDct = jpgMap["fastDct"].toBool();
+            }
+
+            // new optional parameter
+            if (jpgMap.contains("chromaSubsampling"))
+            {
+                JpegSubsampling chromaSubsampling;
+                QString chromaSubsamplingString = jpgMap["chromaSubsampling"].toString();
+                if (!JpegEncoder::subsamplingFromString(chromaSubsamplingString, chromaSubsampling))
+                {
+                    QString errMsgText("Logging Settings: jpg chromaSubsampling must be 444, 422 or 420");
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.jpg.chromaSubsampling = chromaSubsampling;
+            }
+
+            // new optional parameter
+            if (jpgMap.contains("rateControl"))
+            {
+                QVariantMap jpgRateControlMap = jpgMap["rateControl"].toMap();
+
+                if (jpgRateControlMap.contains("on"))
+                {
+                    if (!jpgRateControlMap["on"].canConvert<bool>())
+                    {
+                        QString errMsgText("Logging Settings: jpg unable to convert rateControl on to bool");
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    videoWriterParams_.jpg.rateControl = jpgRateControlMap["on"].toBool();
+                }
+
+                if (jpgRateControlMap.contains("minQuality"))
+                {
+                    if (!jpgRateControlMap["minQuality"].canConvert<unsigned int>())
+                    {
+                        QString errMsgText("Logging Settings: jpg unable to convert");
+                        errMsgText += " rateControl minQuality to unsigned int";
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    unsigned int minQuality = jpgRateControlMap["minQuality"].toUInt();
+                    if (minQuality > videoWriterParams_.jpg.quality)
+                    {
+                        QString errMsgText("Logging Settings: jpg rateControl minQuality must");
+                        errMsgText += " be less than or equal to quality";
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    videoWriterParams_.jpg.minQuality = minQuality;
+                }
+
+                if (jpgRateControlMap.contains("targetBytesPerSec"))
+                {
+                    if (!jpgRateControlMap["targetBytesPerSec"].canConvert<double>())
+                    {
+                        QString errMsgText("Logging Settings: jpg unable to convert");
+                        errMsgText += " rateControl targetBytesPerSec to double";
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    double targetBytesPerSec = jpgRateControlMap["targetBytesPerSec"].toDouble();
+                    if (targetBytesPerSec < 0.0)
+                    {
+                        QString errMsgText("Logging Settings: jpg rateControl targetBytesPerSec");
+                        errMsgText += " must be greater than or equal to 0";
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    videoWriterParams_.jpg.targetBytesPerSec = targetBytesPerSec;
+                }
+
+                if (jpgRateControlMap.contains("targetQueueSize"))
+                {
+                    if (!jpgRateControlMap["targetQueueSize"].canConvert<unsigned int>())
+                    {
+                        QString errMsgText("Logging Settings: jpg unable to convert");
+                        errMsgText += " rateControl targetQueueSize to unsigned int";
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                    videoWriterParams_.jpg.targetQueueSize = jpgRateControlMap["targetQueueSize"].toUInt();
+                }
+            }
         }
 
         // Get fmf values
@@ -6459,19 +7363,232 @@ namespace bias
             return rtnStatus;
         }
         videoWriterParams_.fmf.frameSkip = fmfFrameSkip;
-        
-        // Get ufmf values
-        // ---------------
-        QVariantMap ufmfMap = formatMap["ufmf"].toMap();
-        if (ufmfMap.isEmpty())
+
+        // new optional parameter
+        if (fmfMap.contains("directIO"))
         {
-            QString errMsgText("Logging Settings: ufmf settings not present");
-            if (showErrorDlg)
+            if (!fmfMap["directIO"].canConvert<bool>())
             {
-                QMessageBox::critical(this,errMsgTitle,errMsgText);
-            }
-            rtnStatus.success = false;
-            rtnStatus.message = errMsgText;
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " fmf directIO to bool";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.fmf.directIo = fmfMap["directIO"].toBool();
+        }
+
+        // new optional parameter
+        if (fmfMap.contains("stripeDirs"))
+        {
+            if (!fmfMap["stripeDirs"].canConvert<QStringList>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " fmf stripeDirs to list of strings";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.fmf.stripeDirs = fmfMap["stripeDirs"].toStringList();
+        }
+
+        // new optional parameter
+        if (fmfMap.contains("stripeChunkFrames"))
+        {
+            if (!fmfMap["stripeChunkFrames"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " fmf stripeChunkFrames to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            unsigned int fmfStripeChunkFrames = fmfMap["stripeChunkFrames"].toUInt();
+            if (fmfStripeChunkFrames == 0)
+            {
+                QString errMsgText("Logging Settings: fmf stripeChunkFrames");
+                errMsgText += " must be greater than 0";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.fmf.stripeChunkFrames = fmfStripeChunkFrames;
+        }
+        
+        // Get zfmf values
+        // ---------------
+        // new optional parameter
+        if (formatMap.contains("zfmf"))
+        {
+            QVariantMap zfmfMap = formatMap["zfmf"].toMap();
+
+            if (zfmfMap.contains("frameSkip"))
+            {
+                if (!zfmfMap["frameSkip"].canConvert<unsigned int>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " zfmf frameSkip to unsigned int";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                unsigned int zfmfFrameSkip = zfmfMap["frameSkip"].toUInt();
+                if (zfmfFrameSkip == 0)
+                {
+                    QString errMsgText("Logging Settings: zfmf frameSkip");
+                    errMsgText += " must be greater than 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.zfmf.frameSkip = zfmfFrameSkip;
+            }
+
+            if (zfmfMap.contains("chunkFrames"))
+            {
+                if (!zfmfMap["chunkFrames"].canConvert<unsigned int>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " zfmf chunkFrames to unsigned int";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                unsigned int zfmfChunkFrames = zfmfMap["chunkFrames"].toUInt();
+                if ((zfmfChunkFrames < VideoWriter_zfmf::MIN_CHUNK_FRAMES) || (zfmfChunkFrames > VideoWriter_zfmf::MAX_CHUNK_FRAMES))
+                {
+                    QString errMsgText = QString("Logging Settings: zfmf chunkFrames must be in range [%1,%2]")
+                        .arg(VideoWriter_zfmf::MIN_CHUNK_FRAMES)
+                        .arg(VideoWriter_zfmf::MAX_CHUNK_FRAMES);
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.zfmf.chunkFrames = zfmfChunkFrames;
+            }
+
+            if (zfmfMap.contains("compressionLevel"))
+            {
+                if (!zfmfMap["compressionLevel"].canConvert<unsigned int>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " zfmf compressionLevel to unsigned int";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                unsigned int zfmfCompressionLevel = zfmfMap["compressionLevel"].toUInt();
+                if (zfmfCompressionLevel > VideoWriter_zfmf::MAX_COMPRESSION_LEVEL)
+                {
+                    QString errMsgText = QString("Logging Settings: zfmf compressionLevel must be <= %1")
+                        .arg(VideoWriter_zfmf::MAX_COMPRESSION_LEVEL);
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.zfmf.compressionLevel = zfmfCompressionLevel;
+            }
+
+            if (zfmfMap.contains("compressionThreads"))
+            {
+                if (!zfmfMap["compressionThreads"].canConvert<unsigned int>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " zfmf compressionThreads to unsigned int";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                unsigned int zfmfCompressionThreads = zfmfMap["compressionThreads"].toUInt();
+                if (zfmfCompressionThreads < VideoWriter_zfmf::MIN_NUMBER_OF_COMPRESSORS)
+                {
+                    QString errMsgText = QString("Logging Settings: zfmf compressionThreads must be >= %1")
+                        .arg(VideoWriter_zfmf::MIN_NUMBER_OF_COMPRESSORS);
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.zfmf.numberOfCompressors = zfmfCompressionThreads;
+            }
+
+            if (zfmfMap.contains("directIO"))
+            {
+                if (!zfmfMap["directIO"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " zfmf directIO to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                videoWriterParams_.zfmf.directIo = zfmfMap["directIO"].toBool();
+            }
+        }
+
+        // Get ufmf values
+        // ---------------
+        QVariantMap ufmfMap = formatMap["ufmf"].toMap();
+        if (ufmfMap.isEmpty())
+        {
+            QString errMsgText("Logging Settings: ufmf settings not present");
+            if (showErrorDlg)
+            {
+                QMessageBox::critical(this,errMsgTitle,errMsgText);
+            }
+            rtnStatus.success = false;
+            rtnStatus.message = errMsgText;
             return rtnStatus;
         }
         // ufmf Frame Skip
@@ -6826,6 +7943,685 @@ namespace bias
         // ----------------------------------------------------------------------
         videoWriterParams_.ufmf.dilateWindowSize = ufmfDilateWindowSize;
 
+        // new optional parameter
+        if (ufmfMap.contains("directIO"))
+        {
+            if (!ufmfMap["directIO"].canConvert<bool>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " ufmf directIO to bool";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.ufmf.directIo = ufmfMap["directIO"].toBool();
+        }
+
+        // new optional parameter
+        if (ufmfMap.contains("tightBoxes"))
+        {
+            if (!ufmfMap["tightBoxes"].canConvert<bool>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " ufmf tightBoxes to bool";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.ufmf.tightBoxes = ufmfMap["tightBoxes"].toBool();
+        }
+
+        // new optional parameter
+        if (ufmfMap.contains("tightBoxStats"))
+        {
+            if (!ufmfMap["tightBoxStats"].canConvert<bool>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " ufmf tightBoxStats to bool";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.ufmf.tightBoxStats = ufmfMap["tightBoxStats"].toBool();
+        }
+
+        // new optional parameter
+        if (ufmfMap.contains("compressionLevel"))
+        {
+            if (!ufmfMap["compressionLevel"].canConvert<unsigned int>())
+            {
+                QString errMsgText("Logging Settings: unable to convert");
+                errMsgText += " ufmf compressionLevel to unsigned int";
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            unsigned int ufmfCompressionLevel = ufmfMap["compressionLevel"].toUInt();
+            if (ufmfCompressionLevel > VideoWriter_ufmf::MAX_COMPRESSION_LEVEL)
+            {
+                QString errMsgText("Logging Settings: ufmf compressionLevel");
+                errMsgText += QString(" must be less than or equal to %1").arg(
+                        VideoWriter_ufmf::MAX_COMPRESSION_LEVEL
+                        );
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+            videoWriterParams_.ufmf.compressionLevel = ufmfCompressionLevel;
+        }
+
+        // Get file rollover values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("rollover"))
+        {
+            QVariantMap rolloverMap = formatMap["rollover"].toMap();
+            VideoWriterParams_rollover rolloverParams;
+
+            if (rolloverMap.contains("maxBytes"))
+            {
+                if (!rolloverMap["maxBytes"].canConvert<qulonglong>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " rollover maxBytes to unsigned long long";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                rolloverParams.maxBytes = rolloverMap["maxBytes"].toULongLong();
+                if ((rolloverParams.maxBytes > 0) && (rolloverParams.maxBytes < VideoWriter::MIN_ROLLOVER_MAX_BYTES))
+                {
+                    QString errMsgText("Logging Settings: rollover maxBytes");
+                    errMsgText += QString(" must be 0 or greater than or equal to %1").arg(
+                            VideoWriter::MIN_ROLLOVER_MAX_BYTES
+                            );
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (rolloverMap.contains("maxDuration"))
+            {
+                if (!rolloverMap["maxDuration"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " rollover maxDuration to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                rolloverParams.maxDuration = rolloverMap["maxDuration"].toDouble();
+                if (rolloverParams.maxDuration < 0.0)
+                {
+                    QString errMsgText("Logging Settings: rollover maxDuration");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (rolloverMap.contains("maxFrames"))
+            {
+                if (!rolloverMap["maxFrames"].canConvert<qulonglong>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " rollover maxFrames to unsigned long";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                rolloverParams.maxFrames = (unsigned long)(rolloverMap["maxFrames"].toULongLong());
+            }
+
+            if (rolloverMap.contains("preallocate"))
+            {
+                if (!rolloverMap["preallocate"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " rollover preallocate to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                rolloverParams.preallocate = rolloverMap["preallocate"].toBool();
+            }
+
+            videoWriterParams_.rollover = rolloverParams;
+        }
+
+        // Get pre/post trigger recording values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("trigger"))
+        {
+            QVariantMap triggerMap = formatMap["trigger"].toMap();
+            VideoWriterParams_trigger triggerParams;
+
+            if (triggerMap.contains("enabled"))
+            {
+                if (!triggerMap["enabled"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " trigger enabled to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                triggerParams.enabled = triggerMap["enabled"].toBool();
+            }
+
+            if (triggerMap.contains("preTriggerSec"))
+            {
+                if (!triggerMap["preTriggerSec"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " trigger preTriggerSec to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                triggerParams.preTriggerSec = triggerMap["preTriggerSec"].toDouble();
+                if (triggerParams.preTriggerSec < 0.0)
+                {
+                    QString errMsgText("Logging Settings: trigger preTriggerSec");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (triggerMap.contains("postTriggerSec"))
+            {
+                if (!triggerMap["postTriggerSec"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " trigger postTriggerSec to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                triggerParams.postTriggerSec = triggerMap["postTriggerSec"].toDouble();
+                if (triggerParams.postTriggerSec < 0.0)
+                {
+                    QString errMsgText("Logging Settings: trigger postTriggerSec");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (triggerMap.contains("maxBufferFrames"))
+            {
+                if (!triggerMap["maxBufferFrames"].canConvert<qulonglong>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " trigger maxBufferFrames to unsigned long";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                triggerParams.maxBufferFrames = (unsigned long)(triggerMap["maxBufferFrames"].toULongLong());
+                if (triggerParams.maxBufferFrames < TriggerRecorder::MIN_MAX_BUFFER_FRAMES)
+                {
+                    QString errMsgText("Logging Settings: trigger maxBufferFrames");
+                    errMsgText += QString(" must be greater than or equal to %1").arg(
+                            TriggerRecorder::MIN_MAX_BUFFER_FRAMES
+                            );
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (triggerMap.contains("intervalSec"))
+            {
+                if (!triggerMap["intervalSec"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " trigger intervalSec to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                triggerParams.intervalSec = triggerMap["intervalSec"].toDouble();
+                if (triggerParams.intervalSec < 0.0)
+                {
+                    QString errMsgText("Logging Settings: trigger intervalSec");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            videoWriterParams_.trigger = triggerParams;
+        }
+
+        // Get logging watchdog values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("watchdog"))
+        {
+            QVariantMap watchdogMap = formatMap["watchdog"].toMap();
+            VideoWriterParams_watchdog watchdogParams;
+
+            if (watchdogMap.contains("enabled"))
+            {
+                if (!watchdogMap["enabled"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " watchdog enabled to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                watchdogParams.enabled = watchdogMap["enabled"].toBool();
+            }
+
+            if (watchdogMap.contains("minFreeBytes"))
+            {
+                if (!watchdogMap["minFreeBytes"].canConvert<qulonglong>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " watchdog minFreeBytes to unsigned long long";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                watchdogParams.minFreeBytes = watchdogMap["minFreeBytes"].toULongLong();
+            }
+
+            if (watchdogMap.contains("minRemainingSec"))
+            {
+                if (!watchdogMap["minRemainingSec"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " watchdog minRemainingSec to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                watchdogParams.minRemainingSec = watchdogMap["minRemainingSec"].toDouble();
+                if (watchdogParams.minRemainingSec < 0.0)
+                {
+                    QString errMsgText("Logging Settings: watchdog minRemainingSec");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (watchdogMap.contains("degradeSteps"))
+            {
+                if (!watchdogMap["degradeSteps"].canConvert<QStringList>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " watchdog degradeSteps to list of strings";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                watchdogParams.degradeSteps = watchdogMap["degradeSteps"].toStringList();
+                for (QString step : watchdogParams.degradeSteps)
+                {
+                    if (
+                            (step != LoggingWatchdog::DEGRADE_STEP_FRAME_SKIP) && 
+                            (step != LoggingWatchdog::DEGRADE_STEP_QUALITY) && 
+                            (step != LoggingWatchdog::DEGRADE_STEP_UFMF)
+                       )
+                    {
+                        QString errMsgText("Logging Settings: watchdog degradeSteps");
+                        errMsgText += QString(" unknown step %1").arg(step);
+                        if (showErrorDlg)
+                        {
+                            QMessageBox::critical(this,errMsgTitle,errMsgText);
+                        }
+                        rtnStatus.success = false;
+                        rtnStatus.message = errMsgText;
+                        return rtnStatus;
+                    }
+                }
+            }
+
+            videoWriterParams_.watchdog = watchdogParams;
+        }
+
+        // Get staging values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("staging"))
+        {
+            QVariantMap stagingMap = formatMap["staging"].toMap();
+            VideoWriterParams_staging stagingParams;
+
+            if (stagingMap.contains("enabled"))
+            {
+                if (!stagingMap["enabled"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " staging enabled to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                stagingParams.enabled = stagingMap["enabled"].toBool();
+            }
+
+            if (stagingMap.contains("directory"))
+            {
+                if (!stagingMap["directory"].canConvert<QString>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " staging directory to string";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                stagingParams.directory = stagingMap["directory"].toString();
+            }
+
+            if (stagingMap.contains("maxBytesPerSec"))
+            {
+                if (!stagingMap["maxBytesPerSec"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " staging maxBytesPerSec to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                stagingParams.maxBytesPerSec = stagingMap["maxBytesPerSec"].toDouble();
+                if (stagingParams.maxBytesPerSec < 0.0)
+                {
+                    QString errMsgText("Logging Settings: staging maxBytesPerSec");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (stagingMap.contains("verifyChecksum"))
+            {
+                if (!stagingMap["verifyChecksum"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " staging verifyChecksum to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                stagingParams.verifyChecksum = stagingMap["verifyChecksum"].toBool();
+            }
+
+            if (stagingParams.enabled && !QDir(stagingParams.directory).exists())
+            {
+                QString errMsgText("Logging Settings: staging directory does not exist, ");
+                errMsgText += stagingParams.directory;
+                if (showErrorDlg)
+                {
+                    QMessageBox::critical(this,errMsgTitle,errMsgText);
+                }
+                rtnStatus.success = false;
+                rtnStatus.message = errMsgText;
+                return rtnStatus;
+            }
+
+            videoWriterParams_.staging = stagingParams;
+
+            // Resume any migration left from an earlier run
+            if (stagingParams.enabled && !capturing_)
+            {
+                setupFileMigrator();
+            }
+        }
+
+        // Get checkpoint values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("checkpoint"))
+        {
+            QVariantMap checkpointMap = formatMap["checkpoint"].toMap();
+            VideoWriterParams_checkpoint checkpointParams;
+
+            if (checkpointMap.contains("enabled"))
+            {
+                if (!checkpointMap["enabled"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " checkpoint enabled to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                checkpointParams.enabled = checkpointMap["enabled"].toBool();
+            }
+
+            if (checkpointMap.contains("interval"))
+            {
+                if (!checkpointMap["interval"].canConvert<double>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " checkpoint interval to double";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                checkpointParams.interval = checkpointMap["interval"].toDouble();
+                if (checkpointParams.interval < 0.0)
+                {
+                    QString errMsgText("Logging Settings: checkpoint interval");
+                    errMsgText += " must be greater than or equal to 0";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+            }
+
+            if (checkpointMap.contains("maxFrames"))
+            {
+                if (!checkpointMap["maxFrames"].canConvert<qulonglong>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " checkpoint maxFrames to unsigned long";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                checkpointParams.maxFrames = (unsigned long)(checkpointMap["maxFrames"].toULongLong());
+            }
+
+            videoWriterParams_.checkpoint = checkpointParams;
+        }
+
+        // Get stamp log values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("stampLog"))
+        {
+            QVariantMap stampLogMap = formatMap["stampLog"].toMap();
+            VideoWriterParams_stampLog stampLogParams;
+
+            if (stampLogMap.contains("enabled"))
+            {
+                if (!stampLogMap["enabled"].canConvert<bool>())
+                {
+                    QString errMsgText("Logging Settings: unable to convert");
+                    errMsgText += " stampLog enabled to bool";
+                    if (showErrorDlg)
+                    {
+                        QMessageBox::critical(this,errMsgTitle,errMsgText);
+                    }
+                    rtnStatus.success = false;
+                    rtnStatus.message = errMsgText;
+                    return rtnStatus;
+                }
+                stampLogParams.enabled = stampLogMap["enabled"].toBool();
+            }
+
+            videoWriterParams_.stampLog = stampLogParams;
+        }
+
+        // Get logging subscription values
+        // --------------------------------------------------------------------
+        // new optional parameter
+        if (formatMap.contains("subscription"))
+        {
+            ImageSubscriptionParams subscriptionParams;
+            rtnStatus = setSubscriptionFromMap(
+                    formatMap["subscription"].toMap(),
+                    QString("Logging Settings"),
+                    subscriptionParams,
+                    showErrorDlg
+                    );
+            if (!rtnStatus.success)
+            {
+                return rtnStatus;
+            }
+            logSubscriptionParams_ = subscriptionParams;
+        }
+
         rtnStatus.success = true;
         rtnStatus.message = QString("");
         return rtnStatus;
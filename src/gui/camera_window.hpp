@@ -12,7 +12,8 @@
 #include <QVariantMap>
 #include "ui_camera_window.h"
 #include "camera_facade_fwd.hpp"
-#include "video_writer_params.hpp"
+#include "logging_params.hpp"
+#include "image_subscription.hpp"
 #include "alignment_settings.hpp"
 #include "auto_naming_options.hpp"
 #include "rtn_status.hpp"
@@ -42,6 +43,9 @@ namespace bias
     class Format7SettingsDialog;
     class AlignmentSettingsDialog;
     class ExtCtlHttpServer;
+    class TriggerRecorder;
+    class LoggingWatchdog;
+    class FileMigrator;
     template <class T> class Lockable;
     template <class T> class LockableQueue;
 
@@ -81,6 +85,7 @@ namespace bias
 
             RtnStatus enableLogging(bool showErrorDlg=true);
             RtnStatus disableLogging(bool showErrorDlg=true);
+            RtnStatus triggerRecording(bool showErrorDlg=true);
 
             RtnStatus saveConfiguration(
                     QString filename, 
@@ -128,6 +133,8 @@ namespace bias
             double getFramesPerSec();
             unsigned long getFrameCount();
             float getFormat7PercentSpeed();
+            QVariantMap getLoggingWatchdogStatus();
+            QVariantMap getFileMigrationStatus();
 
         signals:
 
@@ -163,6 +170,14 @@ namespace bias
             void updateDisplayOnTimer();
             void checkDurationOnTimer();
 
+            // Pre/post trigger recording
+            void triggerRecordingOnTimer();
+            void onTriggerRecordingRequest(double timeStamp);
+
+            // Staging and file migration
+            void onVideoSegmentFinished(QString fileName);
+            void fileMigrationError(unsigned int errorId, QString errorMsg);
+
             // Tab changed event
             void tabWidgetChanged(int index);
 
@@ -222,6 +237,7 @@ namespace bias
             bool showCameraLockFailMsg_;
             bool pluginEnabled_;
             bool skippedFramesWarning_;
+            QString loggingWatchdogMsg_;
             unsigned int cameraNumber_;
             unsigned int numberOfCameras_;
             unsigned int format7PercentSpeed_;
@@ -276,6 +292,10 @@ namespace bias
             std::shared_ptr<LockableQueue<StampedImage>> pluginImageQueuePtr_;
 
             QPointer<QThreadPool> threadPoolPtr_;
+            QPointer<QThreadPool> migrationThreadPoolPtr_;
+            QPointer<FileMigrator> fileMigratorPtr_;
+            QDir stagingDestDir_;
+            QString stagingSessionName_;
 
             QPointer<ImageGrabber> imageGrabberPtr_;
             QPointer<ImageDispatcher> imageDispatcherPtr_;
@@ -284,6 +304,9 @@ namespace bias
 
             QPointer<QTimer> imageDisplayTimerPtr_;
             QPointer<QTimer> captureDurationTimerPtr_;
+            QPointer<QTimer> triggerRecordingTimerPtr_;
+            std::shared_ptr<TriggerRecorder> triggerRecorderPtr_;
+            std::shared_ptr<LoggingWatchdog> loggingWatchdogPtr_;
             QDateTime captureStartDateTime_;
             QDateTime captureStopDateTime_;
 
@@ -295,6 +318,9 @@ namespace bias
             QPointer<AlignmentSettingsDialog> alignmentSettingsDialogPtr_;
 
             VideoWriterParams videoWriterParams_;
+            ImageSubscriptionParams logSubscriptionParams_;
+            ImageSubscriptionParams pluginSubscriptionParams_;
+            ImageSubscriptionParams displaySubscriptionParams_;
 
             QPointer<ExtCtlHttpServer> httpServerPtr_;
             unsigned int httpServerPort_;
@@ -310,6 +336,9 @@ namespace bias
             void setDefaultFileDirs();
             void setupImageDisplayTimer();
             void setupCaptureDurationTimer();
+            void setupTriggerRecordingTimer();
+            void setupFileMigrator();
+            void stopFileMigrator();
             void updateWindowTitle();
             
             QPointer<BiasPlugin> getCurrentPlugin();
@@ -408,6 +437,13 @@ namespace bias
             RtnStatus setServerFromMap(QVariantMap serverMap, bool showErrorDlg);
             RtnStatus setConfigFileFromMap(QVariantMap configFileMap, bool showErrorDlg);
             RtnStatus setPluginFromMap(QVariantMap pluginMap, bool showErrorDlg);
+            RtnStatus setSubscriptionFromMap(
+                    QVariantMap subscriptionMap,
+                    QString consumerName,
+                    ImageSubscriptionParams &params,
+                    bool showErrorDlg
+                    );
+            QVariantMap getSubscriptionMap(ImageSubscriptionParams params);
 
             cv::Mat calcHistogram(cv::Mat mat);
             RtnStatus onError(QString message, QString title, bool showErrorDlg);
@@ -0,0 +1,155 @@
+#include "compressed_chunk_zfmf.hpp"
+#include "zfmf_codec.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+
+namespace bias
+{
+    CompressedChunk_zfmf::CompressedChunk_zfmf()
+        : CompressedChunk_zfmf(cv::Size(0,0), 0)
+    { }
+
+
+    CompressedChunk_zfmf::CompressedChunk_zfmf(cv::Size size, unsigned int chunkFrames)
+    {
+        size_ = size;
+        chunkFrames_ = chunkFrames;
+        haveEncoding_ = false;
+        writeIndex_ = 0;
+        compressionLevel_ = 0;
+        frameDataPtr_ = std::make_shared<std::vector<char>>();
+        encodedDataPtr_ = std::make_shared<std::vector<char>>();
+        if (chunkFrames_ > 0)
+        {
+            timeStampVec_.reserve(chunkFrames_);
+            frameDataPtr_ -> resize(size_t(size_.width)*size_.height*chunkFrames_);
+        }
+    }
+
+
+    void CompressedChunk_zfmf::reset()
+    {
+        // Empty the chunk, keeping its buffers, for reuse
+        haveEncoding_ = false;
+        writeIndex_ = 0;
+        timeStampVec_.clear();
+        encodedDataPtr_ -> clear();
+    }
+
+
+    void CompressedChunk_zfmf::addFrame(StampedImage stampedImg)
+    {
+        if (isFull())
+        {
+            return;
+        }
+
+        // copyTo would reallocate the destination rather than write into the 
+        // chunk if the image doesn't match the chunk's frames.
+        if ((stampedImg.image.size() != size_) || (stampedImg.image.type() != CV_8UC1))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            std::string errorMsg("video writer zfmf unable to add frame:\n\n"); 
+            errorMsg += "image size or type doesn't match the first frame";
+            throw RuntimeError(errorId,errorMsg);
+        }
+
+        size_t frameSize = size_t(size_.width)*size_.height;
+        char *framePtr = &(*frameDataPtr_)[0] + timeStampVec_.size()*frameSize;
+        cv::Mat frameMat(size_, CV_8UC1, (void *) framePtr);
+        stampedImg.image.copyTo(frameMat);
+        timeStampVec_.push_back(stampedImg.timeStamp);
+    }
+
+
+    void CompressedChunk_zfmf::encode()
+    {
+        // Codes the frames in place, they are no longer needed
+        if (isEmpty())
+        {
+            return;
+        }
+        uint32_t frameSize = uint32_t(size_.width)*uint32_t(size_.height);
+        ZfmfCodec::encodeChunk(
+                &(*frameDataPtr_)[0],
+                frameSize,
+                timeStampVec_,
+                compressionLevel_,
+                *encodedDataPtr_
+                );
+        haveEncoding_ = true;
+    }
+
+
+    cv::Size CompressedChunk_zfmf::getSize() const
+    {
+        return size_;
+    }
+
+
+    unsigned int CompressedChunk_zfmf::getChunkFrames() const
+    {
+        return chunkFrames_;
+    }
+
+
+    unsigned int CompressedChunk_zfmf::getNumFrames() const
+    {
+        return (unsigned int)(timeStampVec_.size());
+    }
+
+
+    bool CompressedChunk_zfmf::isEmpty() const
+    {
+        return timeStampVec_.empty();
+    }
+
+
+    bool CompressedChunk_zfmf::isFull() const
+    {
+        return (getNumFrames() >= chunkFrames_);
+    }
+
+
+    bool CompressedChunk_zfmf::haveEncoding() const
+    {
+        return haveEncoding_;
+    }
+
+
+    const std::vector<double> &CompressedChunk_zfmf::getTimeStamps() const
+    {
+        return timeStampVec_;
+    }
+
+
+    void CompressedChunk_zfmf::setWriteIndex(unsigned long index)
+    {
+        writeIndex_ = index;
+    }
+
+
+    unsigned long CompressedChunk_zfmf::getWriteIndex() const
+    {
+        return writeIndex_;
+    }
+
+
+    void CompressedChunk_zfmf::setCompressionLevel(unsigned int value)
+    {
+        compressionLevel_ = value;
+    }
+
+
+    unsigned int CompressedChunk_zfmf::getCompressionLevel() const
+    {
+        return compressionLevel_;
+    }
+
+
+    std::shared_ptr<std::vector<char>> CompressedChunk_zfmf::getEncodedDataPtr()
+    {
+        return encodedDataPtr_;
+    }
+
+} // namespace bias
@@ -0,0 +1,67 @@
+#ifndef BIAS_COMPRESSED_CHUNK_ZFMF_HPP
+#define BIAS_COMPRESSED_CHUNK_ZFMF_HPP
+
+#include <vector>
+#include <memory>
+#include <opencv2/core/core.hpp>
+#include "stamped_image.hpp"
+#include "lockable.hpp"
+#include "reorder_ring.hpp"
+
+namespace bias
+{
+    class CompressedChunk_zfmf
+    {
+        // A chunk of consecutive mono8 frames for the zfmf writer. Frames are
+        // copied into the chunk's buffer by the writer and the chunk is coded
+        // as a whole (see ZfmfCodec) by a compressor. Copies share buffers.
+
+        public:
+
+            CompressedChunk_zfmf();
+            CompressedChunk_zfmf(cv::Size size, unsigned int chunkFrames);
+
+            void reset();
+            void addFrame(StampedImage stampedImg);
+            void encode();
+
+            cv::Size getSize() const;
+            unsigned int getChunkFrames() const;
+            unsigned int getNumFrames() const;
+            bool isEmpty() const;
+            bool isFull() const;
+            bool haveEncoding() const;
+            const std::vector<double> &getTimeStamps() const;
+
+            void setWriteIndex(unsigned long index);
+            unsigned long getWriteIndex() const;
+
+            void setCompressionLevel(unsigned int value);
+            unsigned int getCompressionLevel() const;
+
+            std::shared_ptr<std::vector<char>> getEncodedDataPtr();
+
+        private:
+
+            cv::Size size_;
+            unsigned int chunkFrames_;
+            bool haveEncoding_;
+            unsigned long writeIndex_;     // Index of reserved slot in finished chunks ring
+            unsigned int compressionLevel_;
+
+            std::vector<double> timeStampVec_;
+            std::shared_ptr<std::vector<char>> frameDataPtr_;    // Frames back to back
+            std::shared_ptr<std::vector<char>> encodedDataPtr_;  // Coded chunk
+    };
+
+
+    // Typedef for rings and queues of compressed chunk objects
+    typedef LockableQueue<CompressedChunk_zfmf> CompressedChunkQueue_zfmf;
+    typedef std::shared_ptr<CompressedChunkQueue_zfmf> CompressedChunkQueuePtr_zfmf;
+
+    typedef ReorderRing<CompressedChunk_zfmf> CompressedChunkRing_zfmf;
+    typedef std::shared_ptr<CompressedChunkRing_zfmf> CompressedChunkRingPtr_zfmf;
+
+} // namespace bias
+
+#endif // #ifndef BIAS_COMPRESSED_CHUNK_ZFMF_HPP
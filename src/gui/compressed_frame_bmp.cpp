@@ -0,0 +1,101 @@
+#include "compressed_frame_bmp.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <opencv2/highgui/highgui.hpp>
+
+namespace bias
+{
+
+    CompressedFrame_bmp::CompressedFrame_bmp()
+    {
+        writeIndex_ = 0;
+        isWritten_ = false;
+    }
+
+
+    CompressedFrame_bmp::CompressedFrame_bmp(
+            QString fileName, 
+            StampedImage stampedImg, 
+            const std::vector<int> &writeParams
+            ) : CompressedFrame_bmp()
+    {
+        fileName_ = fileName;
+        stampedImg_ = stampedImg;
+        writeParams_ = writeParams;
+    }
+
+
+    QString CompressedFrame_bmp::getFileName() const
+    {
+        return fileName_;
+    }
+
+
+    unsigned long CompressedFrame_bmp::getFrameCount() const
+    {
+        return stampedImg_.frameCount;
+    }
+
+
+    double CompressedFrame_bmp::getTimeStamp() const
+    {
+        return stampedImg_.timeStamp;
+    }
+
+
+    void CompressedFrame_bmp::setRelativePath(QString relPath)
+    {
+        // Path within the log directory, for the index
+        relPath_ = relPath;
+    }
+
+
+    QString CompressedFrame_bmp::getRelativePath() const
+    {
+        return relPath_;
+    }
+
+
+    void CompressedFrame_bmp::setWriteIndex(unsigned long index)
+    {
+        writeIndex_ = index;
+    }
+
+
+    unsigned long CompressedFrame_bmp::getWriteIndex() const
+    {
+        return writeIndex_;
+    }
+
+
+    bool CompressedFrame_bmp::isWritten() const
+    {
+        return isWritten_;
+    }
+
+
+    void CompressedFrame_bmp::write()
+    {
+        bool writeOK = false;
+        std::string errorMsg("writing image ");
+        errorMsg += fileName_.toStdString();
+        try
+        {
+            writeOK = cv::imwrite(fileName_.toStdString(), stampedImg_.image, writeParams_);
+        }
+        catch (cv::Exception &exc)
+        {
+            errorMsg += std::string(" failed - ") + exc.what();
+        }
+        if (!writeOK)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // Image is no longer needed, the frame is kept until it is indexed
+        stampedImg_.image = cv::Mat();
+        isWritten_ = true;
+    }
+
+} // namespace bias
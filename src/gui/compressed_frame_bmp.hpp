@@ -0,0 +1,56 @@
+#ifndef BIAS_COMPRESSED_FRAME_BMP_HPP
+#define BIAS_COMPRESSED_FRAME_BMP_HPP
+#include <opencv2/core/core.hpp>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "stamped_image.hpp"
+#include "lockable.hpp"
+#include "reorder_ring.hpp"
+
+namespace bias
+{
+
+    class CompressedFrame_bmp 
+    {
+        // Image sequence frame - written to its own file (bmp, png or tif
+        // depending on the file extension) by a compressor worker. 
+
+        public:
+            
+            CompressedFrame_bmp();
+            CompressedFrame_bmp(QString fileName, StampedImage stampedImg, const std::vector<int> &writeParams);
+
+            QString getFileName() const;
+            unsigned long getFrameCount() const;
+            double getTimeStamp() const;
+
+            void setRelativePath(QString relPath);
+            QString getRelativePath() const;
+
+            void setWriteIndex(unsigned long index);
+            unsigned long getWriteIndex() const;
+
+            bool isWritten() const;
+            void write();
+
+        protected:
+
+            QString fileName_;
+            QString relPath_;
+            unsigned long writeIndex_;
+            bool isWritten_;
+            StampedImage stampedImg_;
+            std::vector<int> writeParams_;
+
+    };
+
+    typedef LockableQueue<CompressedFrame_bmp> CompressedFrameQueue_bmp;
+    typedef std::shared_ptr<CompressedFrameQueue_bmp> CompressedFrameQueuePtr_bmp;
+
+    typedef ReorderRing<CompressedFrame_bmp> CompressedFrameRing_bmp;
+    typedef std::shared_ptr<CompressedFrameRing_bmp> CompressedFrameRingPtr_bmp;
+
+}
+
+#endif
@@ -1,8 +1,8 @@
 #include "compressed_frame_jpg.hpp"
 #include "basic_types.hpp"
 #include "exception.hpp"
-#include <opencv2/highgui/highgui.hpp>
 #include <iostream>
+#include <fstream>
 
 namespace bias
 {
@@ -23,6 +23,8 @@ namespace bias
         haveFileName_= false;
         haveStampedImg_ = false;
         haveEncoding_ = false;
+        encodedSize_ = 0;
+        writeIndex_ = 0;
     }
 
 
@@ -143,6 +145,18 @@ namespace bias
     }
 
 
+    void CompressedFrame_jpg::setWriteIndex(unsigned long index)
+    {
+        writeIndex_ = index;
+    }
+
+
+    unsigned long CompressedFrame_jpg::getWriteIndex() const
+    {
+        return writeIndex_;
+    }
+
+
     bool CompressedFrame_jpg::haveEncoding() const
     {
         return haveEncoding_;
@@ -153,62 +167,41 @@ namespace bias
         return encodedJpgBuffer_;
     }
 
-    void CompressedFrame_jpg::write()
+    size_t CompressedFrame_jpg::getEncodedSize() const
+    {
+        // Kept after the encoding itself has been written and released
+        return encodedSize_;
+    }
+
+    void CompressedFrame_jpg::write(JpegEncoder &encoder)
     {
-        std::vector<int> compressionParams;
-        compressionParams.push_back(CV_IMWRITE_JPEG_QUALITY);
-        compressionParams.push_back(int(quality_));
+        encode(encoder);
 
-        try
+        std::ofstream imageFile;
+        imageFile.open(fileName_.toStdString(), std::ios::out | std::ios::binary);
+        if (imageFile.is_open())
         {
-            cv::imwrite(fileName_.toStdString(), stampedImg_.image, compressionParams);
+            imageFile.write((const char *)(encodedJpgBuffer_.data()), encodedJpgBuffer_.size());
+            imageFile.close();
         }
-        catch (cv::Exception &exc)
+        if (imageFile.fail())
         {
             unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
-            std::string errorMsg("writing jpg frame failed - "); 
-            errorMsg += exc.what();
+            std::string errorMsg("writing jpg frame failed - unable to write "); 
+            errorMsg += fileName_.toStdString();
             throw RuntimeError(errorId, errorMsg);
         }
-    }
 
-    void CompressedFrame_jpg::encode()
-    {
-        std::vector<int> compressionParams;
-        compressionParams.push_back(CV_IMWRITE_JPEG_QUALITY);
-        compressionParams.push_back(int(quality_));
-        cv::imencode(".jpg", stampedImg_.image, encodedJpgBuffer_, compressionParams);
-        haveEncoding_ = true;
+        // Written frames don't keep their encoding
+        encodedJpgBuffer_ = std::vector<uchar>();
+        haveEncoding_ = false;
     }
 
-    // Compressed frame comparison operator
-    // ----------------------------------------------------------------------------------------
-    bool CompressedFrameCmp_jpg::operator() (
-            const CompressedFrame_jpg &cmpFrame0,
-            const CompressedFrame_jpg &cmpFrame1
-            )
+    void CompressedFrame_jpg::encode(JpegEncoder &encoder)
     {
-        bool haveImage0 = cmpFrame0.haveStampedImage();
-        bool haveImage1 = cmpFrame1.haveStampedImage();
-
-        if ((haveImage0 == false) && (haveImage1 == false))
-        {
-            return false;
-        }
-        else if ((haveImage0 == false) && (haveImage1 == true))
-        {
-            return false;
-        }
-        else if ((haveImage0 == true) && (haveImage1 == false))
-        {
-            return true;
-        }
-        else
-        {
-            unsigned long frameCount0 = cmpFrame0.getFrameCount();
-            unsigned long frameCount1 = cmpFrame1.getFrameCount();
-            return (frameCount0 < frameCount1);
-        }
+        encoder.encode(stampedImg_.image, quality_, encodedJpgBuffer_);
+        encodedSize_ = encodedJpgBuffer_.size();
+        haveEncoding_ = true;
     }
 
 } // namespace bias
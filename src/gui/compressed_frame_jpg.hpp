@@ -6,6 +6,8 @@
 #include <vector>
 #include "stamped_image.hpp"
 #include "lockable.hpp"
+#include "reorder_ring.hpp"
+#include "jpeg_encoder.hpp"
 
 
 
@@ -40,11 +42,15 @@ namespace bias
             void setMjpgFlag(bool value);
             bool getMjpgFlag() const;
 
+            void setWriteIndex(unsigned long index);
+            unsigned long getWriteIndex() const;
+
             bool haveEncoding() const;
             std::vector<uchar> &getEncodedJpgBuffer();
+            size_t getEncodedSize() const;
 
-            void write();
-            void encode();
+            void write(JpegEncoder &encoder);
+            void encode(JpegEncoder &encoder);
 
             static const QString DEFAULT_FILENAME;
             static const unsigned int DEFAULT_QUALITY;
@@ -55,32 +61,23 @@ namespace bias
             bool haveFileName_;
             bool haveStampedImg_;
             bool haveEncoding_;
+            size_t encodedSize_;
 
             QString fileName_;
             unsigned int quality_;
             bool mjpgFlag_;
+            unsigned long writeIndex_;
 
             StampedImage stampedImg_;;
             std::vector<uchar> encodedJpgBuffer_;
 
     };
 
-    class CompressedFrameCmp_jpg 
-        : public std::binary_function<CompressedFrame_jpg, CompressedFrame_jpg, bool>
-    {
-        // Comparison object for Compressed frames
-        public:
-            bool operator() (
-                    const CompressedFrame_jpg &cmpFrame0,
-                    const CompressedFrame_jpg &cmpFrame1
-                    );
-    };
-
     typedef LockableQueue<CompressedFrame_jpg> CompressedFrameQueue_jpg;
     typedef std::shared_ptr<CompressedFrameQueue_jpg> CompressedFrameQueuePtr_jpg;
 
-    typedef LockableSet<CompressedFrame_jpg, CompressedFrameCmp_jpg> CompressedFrameSet_jpg;
-    typedef std::shared_ptr<CompressedFrameSet_jpg> CompressedFrameSetPtr_jpg;
+    typedef ReorderRing<CompressedFrame_jpg> CompressedFrameRing_jpg;
+    typedef std::shared_ptr<CompressedFrameRing_jpg> CompressedFrameRingPtr_jpg;
 
 }
 
@@ -1,6 +1,8 @@
 #include "compressed_frame_ufmf.hpp"
+#include "ufmf_codec.hpp"
 #include <opencv2/imgproc/imgproc.hpp>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <QThread>
 
@@ -12,6 +14,7 @@ namespace bias
     const uchar CompressedFrame_ufmf::FOREGROUND_MEMBER_VALUE = 0;
     const unsigned int CompressedFrame_ufmf::DEFAULT_BOX_LENGTH = 30; 
     const double CompressedFrame_ufmf::DEFAULT_FG_MAX_FRAC_COMPRESS = 0.2;
+    const unsigned int CompressedFrame_ufmf::BOX_HEADER_SIZE = 4*sizeof(uint16_t);
 
 
     // Methods
@@ -37,7 +40,12 @@ namespace bias
         numPix_ = 0;
         numForeground_ = 0;
         numPixWritten_ = 0;
+        numBytesSaved_ = 0;
         numConnectedComp_ = 0;
+        writeIndex_ = 0;
+        tightBoxes_ = false;
+        tightBoxStats_ = false;
+        compressionLevel_ = 0;
         boxLength_ = boxLength;
         boxArea_ = boxLength*boxLength;
         fgMaxFracCompress_ = fgMaxFracCompress;
@@ -88,9 +96,34 @@ namespace bias
     }
 
 
+    unsigned int CompressedFrame_ufmf::getNumBytes() const
+    {
+        // Number of bytes in boxes (headers + image data) 
+        return numConnectedComp_*BOX_HEADER_SIZE + numPixWritten_;
+    }
+
+
+    int CompressedFrame_ufmf::getNumBytesSaved() const
+    {
+        return numBytesSaved_;
+    }
+
+
+    void CompressedFrame_ufmf::setWriteIndex(unsigned long index)
+    {
+        writeIndex_ = index;
+    }
+
+
+    unsigned long CompressedFrame_ufmf::getWriteIndex() const
+    {
+        return writeIndex_;
+    }
+
+
     void CompressedFrame_ufmf::dilateEnabled(bool value)
     {
-        dilateEnabled_ = true;
+        dilateEnabled_ = value;
     }
 
 
@@ -107,6 +140,42 @@ namespace bias
     }
 
 
+    void CompressedFrame_ufmf::setTightBoxes(bool value)
+    {
+        tightBoxes_ = value;
+    }
+
+
+    bool CompressedFrame_ufmf::getTightBoxes() const
+    {
+        return tightBoxes_;
+    }
+
+
+    void CompressedFrame_ufmf::setTightBoxStats(bool value)
+    {
+        tightBoxStats_ = value;
+    }
+
+
+    bool CompressedFrame_ufmf::getTightBoxStats() const
+    {
+        return tightBoxStats_;
+    }
+
+
+    void CompressedFrame_ufmf::setCompressionLevel(unsigned int value)
+    {
+        compressionLevel_ = value;
+    }
+
+
+    unsigned int CompressedFrame_ufmf::getCompressionLevel() const
+    {
+        return compressionLevel_;
+    }
+
+
     std::shared_ptr<std::vector<uint16_t>> CompressedFrame_ufmf::getWriteRowBufPtr()
     {
         return writeRowBufPtr_;
@@ -137,6 +206,12 @@ namespace bias
     }
 
 
+    std::shared_ptr<std::vector<char>> CompressedFrame_ufmf::getCodedDataPtr()
+    {
+        return codedDatBufPtr_;
+    }
+
+
     void CompressedFrame_ufmf::setData(
             StampedImage stampedImg, 
             cv::Mat bgLowerBound,
@@ -188,16 +263,26 @@ namespace bias
         numForeground_ = numPix - cv::countNonZero(membershipImage_);
         numConnectedComp_ = 0;
         numPixWritten_ = 0;
+        numBytesSaved_ = 0;
 
         // Create frame - uncompressed/compressed based on number of foreground pixels
         if (numForeground_ > fgMaxNumCompress)
         {
             createUncompressedFrame();
         }
+        else if (tightBoxes_)
+        {
+            createTightBoxFrame();
+        }
         else 
         {
             createCompressedFrame();
         }
+
+        if (compressionLevel_ > 0)
+        {
+            encodeBoxes();
+        }
         ready_ = true;
 
     } // CompressedFrame_ufmf::compress
@@ -333,6 +418,295 @@ namespace bias
     } // CompressedFrame_ufmf::createCompressedFrame
 
 
+    void CompressedFrame_ufmf::createTightBoxFrame()
+    {
+        // Covers each connected foreground region with a small set of tight
+        // rectangles. The rows of the region's bounding box are grouped into
+        // horizontal bands - a row is merged into the current band when doing
+        // so costs fewer bytes than starting a new box. Pixels are written 
+        // once per region, but a merged band can span pixels already written 
+        // by another region's box, so boxes may overlap. If the boxes would 
+        // take more bytes than the raw image the frame is written uncompressed.
+        QThread *thisThread = QThread::currentThread();
+
+        // The fixed box pass is as costly as compressing the frame so it is
+        // only run when the bytes saved are wanted.
+        unsigned int fixedBoxNumBytes = 0;
+        if (tightBoxStats_)
+        {
+            fixedBoxNumBytes = getFixedBoxNumBytes();
+        }
+
+        isCompressed_ = true;
+        numPixWritten_ = 0;
+        numConnectedComp_ = 0;
+
+        // Label foreground regions, each region is scanned over its own 
+        // pixels only.
+        cv::Mat foregroundImage;
+        cv::Mat labelImage;
+        cv::Mat labelStats;
+        cv::Mat labelCentroids;
+        cv::compare(membershipImage_, FOREGROUND_MEMBER_VALUE, foregroundImage, cv::CMP_EQ);
+        int numLabels = cv::connectedComponentsWithStats(
+                foregroundImage, 
+                labelImage, 
+                labelStats, 
+                labelCentroids, 
+                8, 
+                CV_32S
+                );
+
+        unsigned int imageDatInd = 0;
+        bool boxesFit = true;
+        for (int label=1; label<numLabels; label++)
+        {
+            cv::Rect rect(
+                    labelStats.at<int>(label, cv::CC_STAT_LEFT),
+                    labelStats.at<int>(label, cv::CC_STAT_TOP),
+                    labelStats.at<int>(label, cv::CC_STAT_WIDTH),
+                    labelStats.at<int>(label, cv::CC_STAT_HEIGHT)
+                    );
+            if (!addTightBoxes(labelImage, label, rect, imageDatInd))
+            {
+                boxesFit = false;
+                break;
+            }
+
+            // Yeild to another thread - helps keep frame rate steady
+            thisThread -> yieldCurrentThread();
+        }
+
+        if (boxesFit)
+        {
+            numPixWritten_ = imageDatInd;
+        }
+        else
+        {
+            createUncompressedFrame();
+        }
+        if (tightBoxStats_)
+        {
+            numBytesSaved_ = int(fixedBoxNumBytes) - int(getNumBytes());
+        }
+
+    } // CompressedFrame_ufmf::createTightBoxFrame
+
+
+    bool CompressedFrame_ufmf::addTightBoxes(
+            const cv::Mat &labelImage, 
+            int label, 
+            cv::Rect rect, 
+            unsigned int &imageDatInd
+            )
+    {
+        // Returns false if a box would take the frame past the raw image size
+        bool haveBand = false;
+        unsigned int bandRow = 0;
+        unsigned int bandHgt = 0;
+        unsigned int bandColMin = 0;
+        unsigned int bandColMax = 0;
+
+        unsigned int rowEnd = (unsigned int)(rect.y + rect.height);
+        unsigned int colEnd = (unsigned int)(rect.x + rect.width);
+
+        for (unsigned int row=(unsigned int)(rect.y); row<rowEnd; row++)
+        {
+            // Find extent of remaining foreground in this row of the region
+            const uchar *membershipPtr = membershipImage_.ptr<uchar>(row);
+            const int *labelPtr = labelImage.ptr<int>(row);
+            bool rowEmpty = true;
+            unsigned int colMin = 0;
+            unsigned int colMax = 0;
+            for (unsigned int col=(unsigned int)(rect.x); col<colEnd; col++)
+            {
+                if ((labelPtr[col] == label) && (membershipPtr[col] == FOREGROUND_MEMBER_VALUE))
+                {
+                    if (rowEmpty)
+                    {
+                        colMin = col;
+                        rowEmpty = false;
+                    }
+                    colMax = col;
+                }
+            }
+
+            if (rowEmpty)
+            {
+                if (haveBand)
+                {
+                    if (!addBox(bandRow, bandColMin, bandHgt, bandColMax-bandColMin+1, imageDatInd))
+                    {
+                        return false;
+                    }
+                    haveBand = false;
+                }
+                continue;
+            }
+
+            if (haveBand)
+            {
+                // Compare cost of growing band with cost of starting a new box
+                unsigned int mergedColMin = std::min(colMin, bandColMin);
+                unsigned int mergedColMax = std::max(colMax, bandColMax);
+                unsigned int mergedCost = BOX_HEADER_SIZE + (bandHgt+1)*(mergedColMax-mergedColMin+1);
+                unsigned int splitCost = 2*BOX_HEADER_SIZE + bandHgt*(bandColMax-bandColMin+1) + (colMax-colMin+1);
+                if (mergedCost <= splitCost)
+                {
+                    bandHgt++;
+                    bandColMin = mergedColMin;
+                    bandColMax = mergedColMax;
+                    continue;
+                }
+                if (!addBox(bandRow, bandColMin, bandHgt, bandColMax-bandColMin+1, imageDatInd))
+                {
+                    return false;
+                }
+            }
+
+            haveBand = true;
+            bandRow = row;
+            bandHgt = 1;
+            bandColMin = colMin;
+            bandColMax = colMax;
+        }
+
+        if (haveBand)
+        {
+            return addBox(bandRow, bandColMin, bandHgt, bandColMax-bandColMin+1, imageDatInd);
+        }
+        return true;
+    }
+
+
+    bool CompressedFrame_ufmf::addBox(
+            unsigned int row, 
+            unsigned int col, 
+            unsigned int hgt, 
+            unsigned int wdt, 
+            unsigned int &imageDatInd
+            )
+    {
+        // Box isn't added if the boxes would take more bytes than the raw 
+        // image, which is also the size of the image data buffer.
+        uint64_t numBoxPix = uint64_t(hgt)*uint64_t(wdt);
+        uint64_t numBytes = uint64_t(numConnectedComp_ + 1)*BOX_HEADER_SIZE + imageDatInd + numBoxPix;
+        if ((imageDatInd + numBoxPix > numPix_) || (numBytes > numPix_))
+        {
+            return false;
+        }
+
+        (*writeRowBufPtr_)[numConnectedComp_] = row;
+        (*writeColBufPtr_)[numConnectedComp_] = col;
+        (*writeHgtBufPtr_)[numConnectedComp_] = hgt;
+        (*writeWdtBufPtr_)[numConnectedComp_] = wdt;
+        numConnectedComp_++;
+
+        for (unsigned int i=row; i<row+hgt; i++)
+        {
+            const uchar *imagePtr = stampedImg_.image.ptr<uchar>(i);
+            uchar *membershipPtr = membershipImage_.ptr<uchar>(i);
+            std::copy(imagePtr + col, imagePtr + col + wdt, imageDatBufPtr_ -> begin() + imageDatInd);
+            std::fill_n(membershipPtr + col, wdt, BACKGROUND_MEMBER_VALUE);
+            imageDatInd += wdt;
+        }
+        return true;
+    }
+
+
+    unsigned int CompressedFrame_ufmf::getFixedBoxNumBytes()
+    {
+        // Number of bytes createCompressedFrame would write for the current 
+        // membership image. Only the box extents are computed.
+        unsigned int numRow = (unsigned int) (membershipImage_.rows);
+        unsigned int numCol = (unsigned int) (membershipImage_.cols);
+
+        cv::Mat membershipImage = membershipImage_.clone();
+        std::fill_n(numWriteBufPtr_ -> begin(), numPix_, 0);
+
+        unsigned int numBytes = 0;
+        for (unsigned int row=0; row<numRow; row++)
+        {
+            for (unsigned int col=0; col<numCol; col++)
+            {
+                if (membershipImage.at<uchar>(row,col) == BACKGROUND_MEMBER_VALUE) 
+                { 
+                    continue;
+                }
+
+                unsigned int hgt = std::min(boxLength_, numRow-row);
+                unsigned int wdt = std::min(boxLength_, numCol-col);
+
+                for (unsigned int rowEnd=row; rowEnd<row+hgt; rowEnd++)
+                {
+                    unsigned int numWriteInd = rowEnd*numCol + col;
+                    unsigned int colEnd = col;
+                    while ((colEnd < col+wdt) && ((*numWriteBufPtr_)[numWriteInd] == 0))
+                    {
+                        colEnd++;
+                        numWriteInd++;
+                    }
+                    if (colEnd < col+wdt)
+                    {
+                        if (rowEnd == row)
+                        {
+                            wdt = colEnd - col;
+                        }
+                        else
+                        {
+                            hgt = rowEnd - row;
+                            break;
+                        }
+                    }
+
+                    numWriteInd = rowEnd*numCol + col;
+                    uchar *membershipPtr = membershipImage.ptr<uchar>(rowEnd);
+                    for (colEnd=col; colEnd<col+wdt; colEnd++)
+                    {
+                        (*numWriteBufPtr_)[numWriteInd] = 1;
+                        membershipPtr[colEnd] = BACKGROUND_MEMBER_VALUE;
+                        numWriteInd++;
+                    }
+                }
+                numBytes += BOX_HEADER_SIZE + hgt*wdt;
+            }
+        }
+        return numBytes;
+    }
+
+
+    void CompressedFrame_ufmf::encodeBoxes()
+    {
+        // Serialize boxes as they are written in the frame chunk and code them
+        boxDatBufPtr_ -> resize(getNumBytes());
+        char *boxDatPtr = &(*boxDatBufPtr_)[0];
+        unsigned int dataPos = 0;
+
+        for (unsigned int cc=0; cc<numConnectedComp_; cc++)
+        {
+            uint16_t boxHeader[4];
+            boxHeader[0] = (*writeColBufPtr_)[cc];
+            boxHeader[1] = (*writeRowBufPtr_)[cc];
+            boxHeader[2] = (*writeWdtBufPtr_)[cc];
+            boxHeader[3] = (*writeHgtBufPtr_)[cc];
+            unsigned int boxArea = boxHeader[2]*boxHeader[3];
+
+            std::memcpy(boxDatPtr, boxHeader, BOX_HEADER_SIZE);
+            boxDatPtr += BOX_HEADER_SIZE;
+            std::memcpy(boxDatPtr, &(*imageDatBufPtr_)[dataPos], boxArea);
+            boxDatPtr += boxArea;
+            dataPos += boxArea;
+        }
+
+        UfmfCodec::encode(
+                boxDatBufPtr_ -> data(), 
+                uint32_t(boxDatBufPtr_ -> size()), 
+                compressionLevel_, 
+                *codedDatBufPtr_
+                );
+    }
+
+
     //cv::Mat CompressedFrame_ufmf::getMembershipImage()
     //{
     //    return membershipImage_;
@@ -347,6 +721,8 @@ namespace bias
         writeWdtBufPtr_ = std::make_shared<std::vector<uint16_t>>();
         numWriteBufPtr_ = std::make_shared<std::vector<uint16_t>>();
         imageDatBufPtr_ = std::make_shared<std::vector<uint8_t>>();
+        boxDatBufPtr_ = std::make_shared<std::vector<char>>();
+        codedDatBufPtr_ = std::make_shared<std::vector<char>>();
 
         writeRowBufPtr_ -> resize(numPix_);
         writeColBufPtr_ -> resize(numPix_);
@@ -367,35 +743,4 @@ namespace bias
         std::fill_n(imageDatBufPtr_ -> begin(), numPix_, 0);
     }
 
-
-    // Compressed frame comparison operator
-    // ----------------------------------------------------------------------------------------
-    bool CompressedFrameCmp_ufmf::operator() (
-            const CompressedFrame_ufmf &cmpFrame0,
-            const CompressedFrame_ufmf &cmpFrame1
-            )
-    {
-        bool haveData0 = cmpFrame0.haveData();
-        bool haveData1 = cmpFrame1.haveData();
-
-        if ((haveData0 == false) && (haveData1 == false))
-        {
-            return false;
-        }
-        else if ((haveData0 == false) && (haveData1 == true))
-        {
-            return false;
-        }
-        else if ((haveData0 == true) && (haveData1 == false))
-        {
-            return true;
-        }
-        else
-        {
-            unsigned long frameCount0 = cmpFrame0.getFrameCount();
-            unsigned long frameCount1 = cmpFrame1.getFrameCount();
-            return (frameCount0 < frameCount1);
-        }
-    }
-
 } // namespace bias
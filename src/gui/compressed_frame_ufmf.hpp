@@ -3,10 +3,10 @@
 
 #include <vector>
 #include <memory>
-#include <functional>
 #include <opencv2/core/core.hpp>
 #include "stamped_image.hpp"
 #include "lockable.hpp"
+#include "reorder_ring.hpp"
 
 namespace bias
 {
@@ -39,20 +39,33 @@ namespace bias
             double getTimeStamp() const;
             unsigned long getFrameCount() const;
             unsigned int getNumConnectedComp() const;
+            unsigned int getNumBytes() const;
+            int getNumBytesSaved() const;
+
+            void setWriteIndex(unsigned long index);
+            unsigned long getWriteIndex() const;
 
             void dilateEnabled(bool value);
             void setDilateWindowSize(unsigned int value);
+            void setTightBoxes(bool value);
+            bool getTightBoxes() const;
+            void setTightBoxStats(bool value);
+            bool getTightBoxStats() const;
+            void setCompressionLevel(unsigned int value);
+            unsigned int getCompressionLevel() const;
 
             std::shared_ptr<std::vector<uint16_t>> getWriteRowBufPtr();
             std::shared_ptr<std::vector<uint16_t>> getWriteColBufPtr();
             std::shared_ptr<std::vector<uint16_t>> getWriteHgtBufPtr();
             std::shared_ptr<std::vector<uint16_t>> getWriteWdtBufPtr();
             std::shared_ptr<std::vector<uint8_t>> getImageDataPtr();
+            std::shared_ptr<std::vector<char>> getCodedDataPtr();
 
             static const uchar BACKGROUND_MEMBER_VALUE;
             static const uchar FOREGROUND_MEMBER_VALUE;
             static const unsigned int DEFAULT_BOX_LENGTH; 
             static const double DEFAULT_FG_MAX_FRAC_COMPRESS;
+            static const unsigned int BOX_HEADER_SIZE;
 
             // TEMPORARY REMOVE THIS ???
             // -------------------------------------------------------------
@@ -73,7 +86,9 @@ namespace bias
             unsigned int numPix_;
             unsigned int numForeground_;  // Number of forground pixels
             unsigned int numPixWritten_;  // Number of pixels written
+            int numBytesSaved_;           // Bytes saved by tight boxes w.r.t. fixed boxes
             unsigned long bgUpdateCount_; // Update count of background model used 
+            unsigned long writeIndex_;    // Index of reserved slot in finished frames ring
 
             std::shared_ptr<std::vector<uint16_t>> writeRowBufPtr_;  // Y mins
             std::shared_ptr<std::vector<uint16_t>> writeColBufPtr_;  // X mins
@@ -81,6 +96,8 @@ namespace bias
             std::shared_ptr<std::vector<uint16_t>> writeWdtBufPtr_;  // Widths
             std::shared_ptr<std::vector<uint16_t>> numWriteBufPtr_;  // Number of times pixel written 
             std::shared_ptr<std::vector<uint8_t>>  imageDatBufPtr_;  // Image data 
+            std::shared_ptr<std::vector<char>>     boxDatBufPtr_;    // Box headers and image data
+            std::shared_ptr<std::vector<char>>     codedDatBufPtr_;  // Coded box data
 
             unsigned int boxArea_;           // BoxLength*boxLength
             unsigned int boxLength_;         // Length of boxes or foreground pixels to store
@@ -90,32 +107,40 @@ namespace bias
             bool dilateEnabled_;
             unsigned int dilateWindowSize_;
 
+            bool tightBoxes_;                // Cover foreground regions w/ tight rectangles
+            bool tightBoxStats_;             // Compute bytes saved by tight boxes (costs a fixed box pass)
+            unsigned int compressionLevel_;  // Box data compression level, 0 = off
 
             void allocateBuffers();          
             void resetBuffers(); 
             void createUncompressedFrame();
             void createCompressedFrame();
+            void createTightBoxFrame();
+            bool addTightBoxes(
+                    const cv::Mat &labelImage, 
+                    int label, 
+                    cv::Rect rect, 
+                    unsigned int &imageDatInd
+                    );
+            bool addBox(
+                    unsigned int row, 
+                    unsigned int col, 
+                    unsigned int hgt, 
+                    unsigned int wdt, 
+                    unsigned int &imageDatInd
+                    );
+            unsigned int getFixedBoxNumBytes();
+            void encodeBoxes();
                                       
     };
 
 
-    class CompressedFrameCmp_ufmf 
-        : public std::binary_function<CompressedFrame_ufmf, CompressedFrame_ufmf, bool>
-    {
-        // Comparison object for Compressed frames
-        public:
-            bool operator() (
-                    const CompressedFrame_ufmf &cmpFrame0,
-                    const CompressedFrame_ufmf &cmpFrame1
-                    );
-    };
-
-    // Typedef for sets and queues of compressed frame objects
+    // Typedef for rings and queues of compressed frame objects
     typedef LockableQueue<CompressedFrame_ufmf> CompressedFrameQueue_ufmf;
     typedef std::shared_ptr<CompressedFrameQueue_ufmf> CompressedFrameQueuePtr_ufmf;
 
-    typedef LockableSet<CompressedFrame_ufmf, CompressedFrameCmp_ufmf> CompressedFrameSet_ufmf;
-    typedef std::shared_ptr<CompressedFrameSet_ufmf> CompressedFrameSetPtr_ufmf;
+    typedef ReorderRing<CompressedFrame_ufmf> CompressedFrameRing_ufmf;
+    typedef std::shared_ptr<CompressedFrameRing_ufmf> CompressedFrameRingPtr_ufmf;
 
 } // namespace bias
 
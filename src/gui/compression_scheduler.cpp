@@ -0,0 +1,266 @@
+#include "compression_scheduler.hpp"
+#include "affinity.hpp"
+#include <QRunnable>
+#include <QThread>
+#include <QElapsedTimer>
+#include <algorithm>
+
+namespace bias
+{
+    const unsigned int CompressionScheduler::DEFAULT_MIN_NUMBER_OF_WORKERS = 1;
+    const unsigned int CompressionScheduler::IDLE_TIMEOUT_MS = 2000;
+    const double CompressionScheduler::TARGET_BACKLOG_MS = 20.0;
+    const double CompressionScheduler::DEFAULT_FRAME_COST_MS = 5.0;
+    const double CompressionScheduler::FRAME_COST_SMOOTHING = 0.1;
+
+
+    // CompressionWorker - runs the scheduler's worker loop on the thread pool
+    // ----------------------------------------------------------------------------------
+    class CompressionWorker : public QRunnable
+    {
+        public:
+
+            CompressionWorker(CompressionScheduler *schedulerPtr)
+            {
+                schedulerPtr_ = schedulerPtr;
+            }
+
+            void run()
+            {
+                schedulerPtr_ -> runWorker();
+            }
+
+        private:
+
+            CompressionScheduler *schedulerPtr_;
+    };
+
+
+    // CompressionScheduler
+    // ----------------------------------------------------------------------------------
+    CompressionScheduler &CompressionScheduler::instance()
+    {
+        static CompressionScheduler scheduler;
+        return scheduler;
+    }
+
+
+    CompressionScheduler::CompressionScheduler()
+    {
+        stopped_ = false;
+        numWorkers_ = 0;
+        numIdleWorkers_ = 0;
+        minNumberOfWorkers_ = DEFAULT_MIN_NUMBER_OF_WORKERS;
+        maxNumberOfWorkers_ = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        threadPool_.setMaxThreadCount(maxNumberOfWorkers_);
+    }
+
+
+    CompressionScheduler::~CompressionScheduler()
+    {
+        acquireLock();
+        stopped_ = true;
+        workAvailableCond_.wakeAll();
+        releaseLock();
+        threadPool_.waitForDone();
+    }
+
+
+    void CompressionScheduler::addClient(CompressionClient *clientPtr, unsigned int maxWorkers)
+    {
+        ClientInfo clientInfo;
+        clientInfo.clientPtr = clientPtr;
+        clientInfo.maxWorkers = std::max(maxWorkers, 1u);
+        clientInfo.numActive = 0;
+        clientInfo.frameCostMs = DEFAULT_FRAME_COST_MS;
+        clientInfo.removing = false;
+
+        acquireLock();
+        clientList_.push_back(clientInfo);
+        adjustNumberOfWorkers();
+        releaseLock();
+    }
+
+
+    void CompressionScheduler::removeClient(CompressionClient *clientPtr)
+    {
+        // Blocks until no worker is compressing a frame for the client
+        acquireLock();
+        std::list<ClientInfo>::iterator it;
+        for (it=clientList_.begin(); it!=clientList_.end(); it++)
+        {
+            if (it -> clientPtr == clientPtr)
+            {
+                it -> removing = true;
+                while (it -> numActive > 0)
+                {
+                    clientIdleCond_.wait(&mutex_);
+                }
+                clientList_.erase(it);
+                break;
+            }
+        }
+        releaseLock();
+    }
+
+
+    void CompressionScheduler::stopClient(CompressionClient *clientPtr)
+    {
+        // Wait for frames in progress, then release the slots of those not started
+        removeClient(clientPtr);
+        clientPtr -> skipPendingFrames();
+    }
+
+
+    void CompressionScheduler::notify()
+    {
+        // Called by clients when frames are added to their "to do" queue
+        acquireLock();
+        adjustNumberOfWorkers();
+        releaseLock();
+    }
+
+
+    void CompressionScheduler::setMaxNumberOfWorkers(unsigned int maxNumberOfWorkers)
+    {
+        acquireLock();
+        maxNumberOfWorkers_ = std::max(maxNumberOfWorkers, minNumberOfWorkers_);
+        threadPool_.setMaxThreadCount(std::max(int(maxNumberOfWorkers_), threadPool_.maxThreadCount()));
+        releaseLock();
+    }
+
+
+    unsigned int CompressionScheduler::getMaxNumberOfWorkers()
+    {
+        acquireLock();
+        unsigned int maxNumberOfWorkers = maxNumberOfWorkers_;
+        releaseLock();
+        return maxNumberOfWorkers;
+    }
+
+
+    unsigned int CompressionScheduler::getNumberOfWorkers()
+    {
+        acquireLock();
+        unsigned int numWorkers = numWorkers_;
+        releaseLock();
+        return numWorkers;
+    }
+
+
+    // Private methods - called with lock held except runWorker
+    // ----------------------------------------------------------------------------------
+    bool CompressionScheduler::takeClient(std::list<ClientInfo>::iterator &it)
+    {
+        // Find first client with pending frames which is under its worker limit 
+        // and move it to the back of the list (round robin).
+        for (it=clientList_.begin(); it!=clientList_.end(); it++)
+        {
+            if ((it -> removing) || (it -> numActive >= it -> maxWorkers))
+            {
+                continue;
+            }
+            if (it -> clientPtr -> numFramesPending() > 0)
+            {
+                clientList_.splice(clientList_.end(), clientList_, it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    void CompressionScheduler::adjustNumberOfWorkers()
+    {
+        if (stopped_)
+        {
+            return;
+        }
+
+        // Estimate time needed to clear queued frames and the number of 
+        // workers which could be used 
+        double backlogMs = 0.0;
+        unsigned int numUsable = 0;
+        std::list<ClientInfo>::iterator it;
+        for (it=clientList_.begin(); it!=clientList_.end(); it++)
+        {
+            if (it -> removing)
+            {
+                continue;
+            }
+            unsigned int numPending = it -> clientPtr -> numFramesPending();
+            backlogMs += numPending*(it -> frameCostMs);
+            numUsable += std::min(numPending + it -> numActive, it -> maxWorkers);
+        }
+        if (numUsable == 0)
+        {
+            return;
+        }
+
+        if (numIdleWorkers_ > 0)
+        {
+            workAvailableCond_.wakeOne();
+            return;
+        }
+
+        bool needWorker = (numWorkers_ == 0) || (backlogMs/numWorkers_ > TARGET_BACKLOG_MS);
+        if (needWorker && (numWorkers_ < std::min(maxNumberOfWorkers_, numUsable)))
+        {
+            startWorker();
+        }
+    }
+
+
+    void CompressionScheduler::startWorker()
+    {
+        numWorkers_++;
+        threadPool_.start(new CompressionWorker(this));
+    }
+
+
+    void CompressionScheduler::runWorker()
+    {
+        QThread *thisThread = QThread::currentThread();
+        thisThread -> setPriority(QThread::NormalPriority);
+        ThreadAffinityService::assignThreadAffinity(false,0);
+
+        QElapsedTimer timer;
+
+        acquireLock();
+        while (!stopped_)
+        {
+            std::list<ClientInfo>::iterator it;
+            if (!takeClient(it))
+            {
+                numIdleWorkers_++;
+                bool woken = workAvailableCond_.wait(&mutex_, IDLE_TIMEOUT_MS);
+                numIdleWorkers_--;
+                if ((!woken) && (numWorkers_ > minNumberOfWorkers_))
+                {
+                    break;
+                }
+                continue;
+            }
+
+            it -> numActive++;
+            CompressionClient *clientPtr = it -> clientPtr;
+            releaseLock();
+
+            timer.start();
+            bool haveFrame = clientPtr -> compressNextFrame();
+            double frameCostMs = 1.0e-6*double(timer.nsecsElapsed());
+
+            acquireLock();
+            it -> numActive--;
+            if (haveFrame)
+            {
+                it -> frameCostMs += FRAME_COST_SMOOTHING*(frameCostMs - it -> frameCostMs);
+            }
+            clientIdleCond_.wakeAll();
+            adjustNumberOfWorkers();
+        }
+        numWorkers_--;
+        releaseLock();
+    }
+
+} // namespace bias
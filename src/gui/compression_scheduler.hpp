@@ -0,0 +1,107 @@
+#ifndef BIAS_COMPRESSION_SCHEDULER_HPP
+#define BIAS_COMPRESSION_SCHEDULER_HPP
+
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <list>
+#include "lockable.hpp"
+
+namespace bias
+{
+
+    class CompressionClient
+    {
+        // Interface for the per writer compressors served by the scheduler.
+
+        public:
+
+            virtual ~CompressionClient() {};
+
+            // Compress next frame in the client's "to do" queue. Returns false 
+            // if there was no frame to compress.
+            virtual bool compressNextFrame() = 0;
+
+            // Number of frames waiting in the client's "to do" queue
+            virtual unsigned int numFramesPending() = 0;
+
+            // Release the reserved slots of the frames in the "to do" queue
+            virtual void skipPendingFrames() = 0;
+
+            // True when the "to do" queue is half full. Half full leaves room
+            // for the frames already in progress.
+            bool isBacklogged(unsigned int maxQueueSize)
+            {
+                return (numFramesPending() >= maxQueueSize/2);
+            }
+    };
+
+
+    class CompressionScheduler : public Lockable<Empty>
+    {
+        // Process wide pool of compression workers shared by the ufmf and jpg
+        // writers of all cameras.
+        //
+        // Workers take one frame at a time from the registered clients in 
+        // round robin order, and a client never has more than its maxWorkers 
+        // frames in progress, so a busy camera can't starve the others. The 
+        // cost of each frame is measured and a worker is added when the 
+        // estimated time to clear the queued frames exceeds TARGET_BACKLOG_MS. 
+        // Workers which stay idle for IDLE_TIMEOUT_MS exit.
+
+        public:
+
+            static const unsigned int DEFAULT_MIN_NUMBER_OF_WORKERS;
+            static const unsigned int IDLE_TIMEOUT_MS;
+            static const double TARGET_BACKLOG_MS;
+            static const double DEFAULT_FRAME_COST_MS;
+            static const double FRAME_COST_SMOOTHING;
+
+            static CompressionScheduler &instance();
+
+            void addClient(CompressionClient *clientPtr, unsigned int maxWorkers);
+            void removeClient(CompressionClient *clientPtr);
+            void stopClient(CompressionClient *clientPtr);
+            void notify();
+
+            void setMaxNumberOfWorkers(unsigned int maxNumberOfWorkers);
+            unsigned int getMaxNumberOfWorkers();
+            unsigned int getNumberOfWorkers();
+
+        private:
+
+            struct ClientInfo
+            {
+                CompressionClient *clientPtr;
+                unsigned int maxWorkers;
+                unsigned int numActive;
+                double frameCostMs;
+                bool removing;
+            };
+
+            bool stopped_;
+            unsigned int numWorkers_;
+            unsigned int numIdleWorkers_;
+            unsigned int minNumberOfWorkers_;
+            unsigned int maxNumberOfWorkers_;
+
+            std::list<ClientInfo> clientList_;
+            QThreadPool threadPool_;
+            QWaitCondition workAvailableCond_;
+            QWaitCondition clientIdleCond_;
+
+            CompressionScheduler();
+            ~CompressionScheduler();
+            CompressionScheduler(const CompressionScheduler &) = delete;
+            CompressionScheduler &operator=(const CompressionScheduler &) = delete;
+
+            bool takeClient(std::list<ClientInfo>::iterator &it);
+            void adjustNumberOfWorkers();
+            void startWorker();
+            void runWorker();
+
+            friend class CompressionWorker;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_COMPRESSION_SCHEDULER_HPP
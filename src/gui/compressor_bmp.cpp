@@ -0,0 +1,106 @@
+#include "compressor_bmp.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+
+namespace bias
+{
+    Compressor_bmp::Compressor_bmp(QObject *parent) : QObject(parent)
+    { 
+        initialize(nullptr,nullptr,0);
+    }
+
+    Compressor_bmp::Compressor_bmp(
+            CompressedFrameQueuePtr_bmp framesToDoQueuePtr, 
+            CompressedFrameRingPtr_bmp framesFinishedRingPtr, 
+            unsigned int cameraNumber, 
+            QObject *parent
+            )  : QObject(parent)
+    {
+        initialize(framesToDoQueuePtr,framesFinishedRingPtr,cameraNumber);
+    }
+
+    
+    void Compressor_bmp::initialize(
+            CompressedFrameQueuePtr_bmp framesToDoQueuePtr, 
+            CompressedFrameRingPtr_bmp framesFinishedRingPtr, 
+            unsigned int cameraNumber
+            )
+    {
+        ready_ = false;
+        framesToDoQueuePtr_ = framesToDoQueuePtr;
+        framesFinishedRingPtr_ = framesFinishedRingPtr;
+        if ((framesToDoQueuePtr_ != nullptr) && (framesFinishedRingPtr_ != nullptr))
+        {
+            ready_ = true;
+        }
+        cameraNumber_ = cameraNumber;
+    }
+
+
+    bool Compressor_bmp::compressNextFrame()
+    {
+        CompressedFrame_bmp compressedFrame;
+
+        if (!ready_) 
+        { 
+            return false; 
+        }
+
+        // Get next frame from in waiting queue
+        framesToDoQueuePtr_ -> acquireLock();
+        if (framesToDoQueuePtr_ -> empty())
+        {
+            framesToDoQueuePtr_ -> releaseLock();
+            return false;
+        }
+        compressedFrame = std::move(framesToDoQueuePtr_ -> front());
+        framesToDoQueuePtr_ -> pop();
+        framesToDoQueuePtr_ -> releaseLock();
+
+        try
+        {
+            compressedFrame.write();
+            framesFinishedRingPtr_ -> insert(compressedFrame.getWriteIndex(), std::move(compressedFrame));
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            framesFinishedRingPtr_ -> markSkipped(compressedFrame.getWriteIndex());
+            unsigned int errorId = runtimeError.id();
+            QString errorMsg = QString::fromStdString(runtimeError.what());
+            emit imageLoggingError(errorId, errorMsg);
+        }
+        return true;
+    }
+
+
+    unsigned int Compressor_bmp::numFramesPending()
+    {
+        if (!ready_)
+        {
+            return 0;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        unsigned int numFrames = (unsigned int)(framesToDoQueuePtr_ -> size());
+        framesToDoQueuePtr_ -> releaseLock();
+        return numFrames;
+    }
+
+
+    void Compressor_bmp::skipPendingFrames()
+    {
+        // Stopping - release the reserved slots so the writer isn't held up 
+        if (!ready_)
+        {
+            return;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        while (!(framesToDoQueuePtr_ -> empty()))
+        {
+            CompressedFrame_bmp compressedFrame = framesToDoQueuePtr_ -> front();
+            framesToDoQueuePtr_ -> pop();
+            framesFinishedRingPtr_ -> markSkipped(compressedFrame.getWriteIndex());
+        }
+        framesToDoQueuePtr_ -> releaseLock();
+    }
+
+} // namespace bias
@@ -0,0 +1,52 @@
+#ifndef BIAS_COMPRESSOR_BMP_HPP
+#define BIAS_COMPRESSOR_BMP_HPP
+
+#include <QObject>
+#include "lockable.hpp"
+#include "compressed_frame_bmp.hpp"
+#include "compression_scheduler.hpp"
+
+namespace bias
+{
+    class Compressor_bmp : public QObject, public CompressionClient, public Lockable<Empty>
+    {
+        // Encodes and writes image sequence frames from the writer's "to do" 
+        // queue. Frames are written one at a time by the shared 
+        // CompressionScheduler workers and then placed in the finished ring 
+        // so the writer can index them in order.
+
+        Q_OBJECT
+
+        public:
+
+            Compressor_bmp(QObject *parent=0);
+            Compressor_bmp(
+                    CompressedFrameQueuePtr_bmp framesToDoQueuePtr, 
+                    CompressedFrameRingPtr_bmp framesFinishedRingPtr,
+                    unsigned int cameraNumber, 
+                    QObject *parent=0
+                    );
+
+            virtual bool compressNextFrame();
+            virtual unsigned int numFramesPending();
+            virtual void skipPendingFrames();
+
+        signals:
+            void imageLoggingError(unsigned int errorId, QString errorMsg);
+
+        private:
+
+            bool ready_;
+            unsigned int cameraNumber_;
+            CompressedFrameQueuePtr_bmp framesToDoQueuePtr_;
+            CompressedFrameRingPtr_bmp framesFinishedRingPtr_;
+
+            void initialize(
+                    CompressedFrameQueuePtr_bmp framesToDoQueuePtr, 
+                    CompressedFrameRingPtr_bmp framesFinishedRingPtr,
+                    unsigned int cameraNumber
+                    );
+    };
+
+}
+#endif
@@ -1,43 +1,39 @@
 #include "compressor_jpg.hpp"
-#include "affinity.hpp"
 #include <iostream>
-#include <QThread>
 #include "basic_types.hpp"
+#include "exception.hpp"
 #include "video_writer_jpg.hpp"
 
 namespace bias
 {
     Compressor_jpg::Compressor_jpg(QObject *parent) : QObject(parent)
     { 
-        initialize(nullptr,nullptr,nullptr,0);
+        initialize(nullptr,nullptr,0);
         ready_ = false;
     }
 
     Compressor_jpg::Compressor_jpg(
             CompressedFrameQueuePtr_jpg framesToDoQueuePtr, 
-            CompressedFrameSetPtr_jpg framesFinishedSetPtr, 
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+            CompressedFrameRingPtr_jpg framesFinishedRingPtr, 
             unsigned int cameraNumber, 
             QObject *parent
             )  : QObject(parent)
     {
-        initialize(framesToDoQueuePtr,framesFinishedSetPtr,framesSkippedIndexListPtr,cameraNumber);
+        initialize(framesToDoQueuePtr,framesFinishedRingPtr,cameraNumber);
     }
 
     
     void Compressor_jpg::initialize(
             CompressedFrameQueuePtr_jpg framesToDoQueuePtr, 
-            CompressedFrameSetPtr_jpg framesFinishedSetPtr, 
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+            CompressedFrameRingPtr_jpg framesFinishedRingPtr, 
             unsigned int cameraNumber
             )
     {
         ready_ = false;
-        stopped_ = true;
-        skipReported_ = false;
+        fastDct_ = JpegEncoder::DEFAULT_FAST_DCT;
+        subsampling_ = JpegEncoder::DEFAULT_SUBSAMPLING;
         framesToDoQueuePtr_ = framesToDoQueuePtr;
-        framesFinishedSetPtr_ = framesFinishedSetPtr;
-        framesSkippedIndexListPtr_ = framesSkippedIndexListPtr;
+        framesFinishedRingPtr_ = framesFinishedRingPtr;
         if (framesToDoQueuePtr_ != nullptr) 
         {
             ready_ = true;
@@ -45,93 +41,141 @@ namespace bias
         cameraNumber_ = cameraNumber;
     }
 
-   
-    void Compressor_jpg::stop()
+
+    void Compressor_jpg::setEncoderParams(bool fastDct, JpegSubsampling subsampling)
     {
-        stopped_ = true;
+        acquireLock();
+        fastDct_ = fastDct;
+        subsampling_ = subsampling;
+        encoderPool_.clear();
+        releaseLock();
     }
 
 
-    void Compressor_jpg::run()
+    void Compressor_jpg::setQualityController(JpegQualityControllerPtr controllerPtr)
     {
-        bool done = false;
+        // Set before the compressor is added to the scheduler
+        qualityControllerPtr_ = controllerPtr;
+    }
 
+
+    bool Compressor_jpg::compressNextFrame()
+    {
         CompressedFrame_jpg compressedFrame;
 
         if (!ready_) 
         { 
-            return; 
+            return false; 
         }
 
-        // Set thread priority to idle - only run when no other thread are running
-        QThread *thisThread = QThread::currentThread();
-        thisThread -> setPriority(QThread::NormalPriority);
-        ThreadAffinityService::assignThreadAffinity(false,cameraNumber_);
-
-        acquireLock();
-        stopped_ = false;
-        releaseLock();
-
-        unsigned int framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-
-        while (!done)
+        // Get next frame from in waiting queue
+        framesToDoQueuePtr_ -> acquireLock();
+        if (framesToDoQueuePtr_ -> empty())
         {
-            bool haveNewFrame = false;
-
-            // Get next frame from in waiting queue
-            framesToDoQueuePtr_ -> acquireLock();
-            framesToDoQueuePtr_ -> waitIfEmpty();
-            if (framesToDoQueuePtr_ -> empty())
+            framesToDoQueuePtr_ -> releaseLock();
+            return false;
+        }
+        compressedFrame = std::move(framesToDoQueuePtr_ -> front());
+        framesToDoQueuePtr_ -> pop();
+        framesToDoQueuePtr_ -> releaseLock();
+
+        // Compress the frame and write to file
+        std::shared_ptr<JpegEncoder> encoderPtr = takeEncoder();
+        bool mjpgFlag = compressedFrame.getMjpgFlag();
+        try
+        {
+            if (mjpgFlag)
             {
-                haveNewFrame = false;
+                compressedFrame.encode(*encoderPtr);
             }
             else
             {
-                haveNewFrame = true;
-                compressedFrame = framesToDoQueuePtr_ -> front();
-                framesToDoQueuePtr_ -> pop();
+                compressedFrame.write(*encoderPtr);
             }
-            framesToDoQueuePtr_ -> releaseLock();
+            if (qualityControllerPtr_)
+            {
+                qualityControllerPtr_ -> addEncodedFrame(compressedFrame.getEncodedSize());
+            }
+            if (mjpgFlag)
+            {
+                framesFinishedRingPtr_ -> insert(compressedFrame.getWriteIndex(), std::move(compressedFrame));
+            }
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            if (mjpgFlag)
+            {
+                framesFinishedRingPtr_ -> markSkipped(compressedFrame.getWriteIndex());
+            }
+            unsigned int errorId = runtimeError.id();
+            QString errorMsg = QString::fromStdString(runtimeError.what());
+            emit imageLoggingError(errorId, errorMsg);
+        }
+        returnEncoder(encoderPtr);
+        return true;
+    }
 
-            // Check to see if stop has been called
-            acquireLock();
-            done = stopped_;
-            releaseLock();
 
-            if ((haveNewFrame) && (!done))
-            {
-                // Compress the frame and write to file
-                bool mjpgFlag = compressedFrame.getMjpgFlag();
-                if (mjpgFlag)
-                {
-                    if (framesFinishedSetSize < VideoWriter_jpg::FRAMES_FINISHED_MAX_SET_SIZE)
-                    {
-                        compressedFrame.encode();
-                        framesFinishedSetPtr_ -> acquireLock();
-                        framesFinishedSetPtr_ -> insert(compressedFrame);
-                        framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-                        framesFinishedSetPtr_ -> releaseLock();
-                    }
-                    else
-                    {
-                        framesSkippedIndexListPtr_ -> acquireLock(); 
-                        framesSkippedIndexListPtr_ -> push_back(compressedFrame.getFrameCount());
-                        framesSkippedIndexListPtr_ -> releaseLock();
-                        if (!skipReported_)
-                        {
-                            unsigned int errorId = ERROR_FRAMES_TODO_MAX_QUEUE_SIZE;
-                            QString errorMsg("jpg compressor frames finished set has exceeded the maximum allowed size");
-                            emit imageLoggingError(errorId, errorMsg);
-                            skipReported_ = true;
-                        }
-                    }
-                }
-                else
-                {
-                    compressedFrame.write();
-                }
+    unsigned int Compressor_jpg::numFramesPending()
+    {
+        if (!ready_)
+        {
+            return 0;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        unsigned int numFrames = (unsigned int)(framesToDoQueuePtr_ -> size());
+        framesToDoQueuePtr_ -> releaseLock();
+        return numFrames;
+    }
+
 
+    void Compressor_jpg::skipPendingFrames()
+    {
+        // Stopping - release the reserved slots so the writer isn't held up 
+        if (!ready_)
+        {
+            return;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        while (!(framesToDoQueuePtr_ -> empty()))
+        {
+            CompressedFrame_jpg compressedFrame = framesToDoQueuePtr_ -> front();
+            framesToDoQueuePtr_ -> pop();
+            if (compressedFrame.getMjpgFlag())
+            {
+                framesFinishedRingPtr_ -> markSkipped(compressedFrame.getWriteIndex());
             }
         }
+        framesToDoQueuePtr_ -> releaseLock();
+    }
+
+
+    std::shared_ptr<JpegEncoder> Compressor_jpg::takeEncoder()
+    {
+        std::shared_ptr<JpegEncoder> encoderPtr;
+        acquireLock();
+        if (encoderPool_.empty())
+        {
+            encoderPtr = std::make_shared<JpegEncoder>(fastDct_, subsampling_);
+        }
+        else
+        {
+            encoderPtr = encoderPool_.back();
+            encoderPool_.pop_back();
+        }
+        releaseLock();
+        return encoderPtr;
+    }
+
+
+    void Compressor_jpg::returnEncoder(std::shared_ptr<JpegEncoder> encoderPtr)
+    {
+        acquireLock();
+        if ((encoderPtr -> getFastDct() == fastDct_) && (encoderPtr -> getSubsampling() == subsampling_))
+        {
+            encoderPool_.push_back(encoderPtr);
+        }
+        releaseLock();
     }
+
 } // namespace bias
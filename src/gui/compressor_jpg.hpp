@@ -2,14 +2,16 @@
 #define BIAS_COMPRESSOR_JPG_HPP
 
 #include <QObject>
-#include <QRunnable>
 #include <memory>
 #include "lockable.hpp"
 #include "compressed_frame_jpg.hpp"
+#include "compression_scheduler.hpp"
+#include "jpeg_encoder.hpp"
+#include "jpeg_quality_controller.hpp"
 
 namespace bias
 {
-    class Compressor_jpg : public QObject, public QRunnable, public Lockable<Empty>
+    class Compressor_jpg : public QObject, public CompressionClient, public Lockable<Empty>
     {
         Q_OBJECT
 
@@ -18,13 +20,17 @@ namespace bias
             Compressor_jpg(QObject *parent=0);
             Compressor_jpg(
                     CompressedFrameQueuePtr_jpg framesToDoQueuePtr, 
-                    CompressedFrameSetPtr_jpg framesFinishedSetPtr,
-                    std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+                    CompressedFrameRingPtr_jpg framesFinishedRingPtr,
                     unsigned int cameraNumber, 
                     QObject *parent=0
                     );
 
-            void stop();
+            void setEncoderParams(bool fastDct, JpegSubsampling subsampling);
+            void setQualityController(JpegQualityControllerPtr controllerPtr);
+
+            virtual bool compressNextFrame();
+            virtual unsigned int numFramesPending();
+            virtual void skipPendingFrames();
 
         signals:
             void imageLoggingError(unsigned int errorId, QString errorMsg);
@@ -32,20 +38,24 @@ namespace bias
         private:
 
             bool ready_;
-            bool stopped_;
-            bool skipReported_;
             unsigned int cameraNumber_;
             CompressedFrameQueuePtr_jpg framesToDoQueuePtr_;
-            CompressedFrameSetPtr_jpg framesFinishedSetPtr_;
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr_;
+            CompressedFrameRingPtr_jpg framesFinishedRingPtr_;
+            JpegQualityControllerPtr qualityControllerPtr_;
+
+            // Encoders are reused by the scheduler workers, one per frame in progress
+            bool fastDct_;
+            JpegSubsampling subsampling_;
+            std::vector<std::shared_ptr<JpegEncoder>> encoderPool_;
+
+            std::shared_ptr<JpegEncoder> takeEncoder();
+            void returnEncoder(std::shared_ptr<JpegEncoder> encoderPtr);
 
             void initialize(
                     CompressedFrameQueuePtr_jpg framesToDoQueuePtr, 
-                    CompressedFrameSetPtr_jpg framesFinishedSetPtr, 
-                    std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+                    CompressedFrameRingPtr_jpg framesFinishedRingPtr,
                     unsigned int cameraNumber
                     );
-            void run();
     };
 
 }
@@ -1,137 +1,101 @@
 #include "compressor_ufmf.hpp"
 #include "basic_types.hpp"
 #include "video_writer_ufmf.hpp"
-#include "affinity.hpp"
 #include <iostream>
-#include <QThread>
 
 namespace bias
 {
     Compressor_ufmf::Compressor_ufmf(QObject *parent)
         : QObject(parent)
     { 
-        initialize(nullptr,nullptr,nullptr,0);
+        initialize(nullptr,nullptr,0);
         ready_ = false;
     }
 
     Compressor_ufmf::Compressor_ufmf( 
             CompressedFrameQueuePtr_ufmf framesToDoQueuePtr, 
-            CompressedFrameSetPtr_ufmf framesFinishedSetPtr, 
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+            CompressedFrameRingPtr_ufmf framesFinishedRingPtr, 
             unsigned int cameraNumber,
             QObject *parent
             )  
         : QObject(parent)
     {
-        initialize(framesToDoQueuePtr,framesFinishedSetPtr,framesSkippedIndexListPtr,cameraNumber);
+        initialize(framesToDoQueuePtr,framesFinishedRingPtr,cameraNumber);
     }
 
     
     void Compressor_ufmf::initialize( 
             CompressedFrameQueuePtr_ufmf framesToDoQueuePtr, 
-            CompressedFrameSetPtr_ufmf framesFinishedSetPtr,
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+            CompressedFrameRingPtr_ufmf framesFinishedRingPtr,
             unsigned int cameraNumber
             )
     {
         ready_ = false;
-        stopped_ = true;
-        skipReported_ = false;
         framesToDoQueuePtr_ = framesToDoQueuePtr;
-        framesFinishedSetPtr_ = framesFinishedSetPtr;
-        framesSkippedIndexListPtr_ = framesSkippedIndexListPtr;
-        if ((framesToDoQueuePtr_ != NULL) && (framesFinishedSetPtr_ != NULL))
+        framesFinishedRingPtr_ = framesFinishedRingPtr;
+        if ((framesToDoQueuePtr_ != NULL) && (framesFinishedRingPtr_ != NULL))
         {
             ready_ = true;
         }
         cameraNumber_ = cameraNumber;
     }
 
-   
-    void Compressor_ufmf::stop()
-    {
-        stopped_ = true;
-    }
-
 
-    void Compressor_ufmf::run()
+    bool Compressor_ufmf::compressNextFrame()
     {
-        bool done = false;
-
         CompressedFrame_ufmf compressedFrame;
 
         if (!ready_) 
         { 
-            return; 
+            return false; 
         }
 
-        // Set thread priority to idle - only run when no other thread are running
-        QThread *thisThread = QThread::currentThread();
-        thisThread -> setPriority(QThread::NormalPriority);
-        ThreadAffinityService::assignThreadAffinity(false,cameraNumber_);
-
-        acquireLock();
-        stopped_ = false;
-        releaseLock();
-
-        unsigned int framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-
-        while (!done)
+        // Get next frame from in waiting queue
+        framesToDoQueuePtr_ -> acquireLock();
+        if (framesToDoQueuePtr_ -> empty())
         {
-            bool haveNewFrame = false;
-
-            // Get next frame from in waiting queue
-            framesToDoQueuePtr_ -> acquireLock();
-            framesToDoQueuePtr_ -> waitIfEmpty();
-            if (framesToDoQueuePtr_ -> empty())
-            {
-                haveNewFrame = false;
-            }
-            else
-            {
-                haveNewFrame = true;
-                compressedFrame = framesToDoQueuePtr_ -> front();
-                framesToDoQueuePtr_ -> pop();
-            }
             framesToDoQueuePtr_ -> releaseLock();
+            return false;
+        }
+        compressedFrame = std::move(framesToDoQueuePtr_ -> front());
+        framesToDoQueuePtr_ -> pop();
+        framesToDoQueuePtr_ -> releaseLock();
+
+        // Compress the frame and place it in its reserved slot
+        compressedFrame.compress();
+        framesFinishedRingPtr_ -> insert(compressedFrame.getWriteIndex(), std::move(compressedFrame));
+        return true;
+    }
 
-            // Check to see if stop has been called
-            acquireLock();
-            done = stopped_;
-            releaseLock();
-
-            if ((haveNewFrame) && (!done))
-            {
-                // Compress the frame
-                compressedFrame.compress();
-
-                if (framesFinishedSetSize < VideoWriter_ufmf::FRAMES_FINISHED_MAX_SET_SIZE)
-                {
-                    // Put completed compressed frame into finished set
-                    framesFinishedSetPtr_ -> acquireLock();
-                    framesFinishedSetPtr_ -> insert(compressedFrame);
-                    framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-                    framesFinishedSetPtr_ -> releaseLock();
-                }
-                else
-                {
-                    // Finished frames set is full - skip
-                    framesSkippedIndexListPtr_ -> acquireLock();
-                    framesSkippedIndexListPtr_ -> push_back(compressedFrame.getFrameCount());
-                    framesSkippedIndexListPtr_ -> releaseLock();
-                    if (!skipReported_)
-                    {
-                        unsigned int errorId = ERROR_FRAMES_TODO_MAX_QUEUE_SIZE;
-                        QString errorMsg("jpg compressor frames finished set has exceeded the maximum allowed size");
-                        emit imageLoggingError(errorId, errorMsg);
-                        skipReported_ = true;
-                    }
-                }
 
-            } // if (haveNewFrame) 
+    unsigned int Compressor_ufmf::numFramesPending()
+    {
+        if (!ready_)
+        {
+            return 0;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        unsigned int numFrames = (unsigned int)(framesToDoQueuePtr_ -> size());
+        framesToDoQueuePtr_ -> releaseLock();
+        return numFrames;
+    }
 
-        } // while (!done)  
 
-    } // void Compressor_ufmf::run()
+    void Compressor_ufmf::skipPendingFrames()
+    {
+        // Stopping - release the reserved slots so the writer isn't held up 
+        if (!ready_)
+        {
+            return;
+        }
+        framesToDoQueuePtr_ -> acquireLock();
+        while (!(framesToDoQueuePtr_ -> empty()))
+        {
+            CompressedFrame_ufmf compressedFrame = framesToDoQueuePtr_ -> front();
+            framesToDoQueuePtr_ -> pop();
+            framesFinishedRingPtr_ -> markSkipped(compressedFrame.getWriteIndex());
+        }
+        framesToDoQueuePtr_ -> releaseLock();
+    }
 
 } // namespace bias
@@ -2,16 +2,19 @@
 #define BIAS_COMPRESSOR_UFMF
 
 #include <QObject>
-#include <QRunnable>
 #include <memory>
 #include "lockable.hpp"
 #include "compressed_frame_ufmf.hpp"
+#include "compression_scheduler.hpp"
 
 namespace bias
 {
 
-    class Compressor_ufmf : public QObject, public QRunnable, public Lockable<Empty>
+    class Compressor_ufmf : public QObject, public CompressionClient, public Lockable<Empty>
     {
+        // Compresses frames from the writer's "to do" queue. Frames are 
+        // compressed one at a time by the shared CompressionScheduler workers.
+
         Q_OBJECT
 
         public:
@@ -20,13 +23,14 @@ namespace bias
 
             Compressor_ufmf(
                     CompressedFrameQueuePtr_ufmf framesToDoQueuePtr,
-                    CompressedFrameSetPtr_ufmf framesFinishedSetPtr,
-                    std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+                    CompressedFrameRingPtr_ufmf framesFinishedRingPtr,
                     unsigned int cameraNumber,
                     QObject *parent=0
                     );
 
-            void stop();
+            virtual bool compressNextFrame();
+            virtual unsigned int numFramesPending();
+            virtual void skipPendingFrames();
 
 
         signals:
@@ -36,23 +40,17 @@ namespace bias
         private:
 
             bool ready_;
-            bool stopped_;
-            bool skipReported_;
             unsigned int cameraNumber_;
 
             CompressedFrameQueuePtr_ufmf framesToDoQueuePtr_;
-            CompressedFrameSetPtr_ufmf framesFinishedSetPtr_;
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr_;
+            CompressedFrameRingPtr_ufmf framesFinishedRingPtr_;
 
             void initialize(
                     CompressedFrameQueuePtr_ufmf framesToDoQueuePtr,
-                    CompressedFrameSetPtr_ufmf framesFinishedSetPtr,
-                    std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr,
+                    CompressedFrameRingPtr_ufmf framesFinishedRingPtr,
                     unsigned int cameraNumber
                     );
 
-            void run();
-
     };
 
 } // namespace bias
@@ -0,0 +1,100 @@
+#include "compressor_zfmf.hpp"
+#include "basic_types.hpp"
+
+namespace bias
+{
+    Compressor_zfmf::Compressor_zfmf(QObject *parent)
+        : QObject(parent)
+    { 
+        initialize(nullptr,nullptr,0);
+        ready_ = false;
+    }
+
+    Compressor_zfmf::Compressor_zfmf( 
+            CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr, 
+            CompressedChunkRingPtr_zfmf chunksFinishedRingPtr, 
+            unsigned int cameraNumber,
+            QObject *parent
+            )  
+        : QObject(parent)
+    {
+        initialize(chunksToDoQueuePtr,chunksFinishedRingPtr,cameraNumber);
+    }
+
+    
+    void Compressor_zfmf::initialize( 
+            CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr, 
+            CompressedChunkRingPtr_zfmf chunksFinishedRingPtr,
+            unsigned int cameraNumber
+            )
+    {
+        ready_ = false;
+        chunksToDoQueuePtr_ = chunksToDoQueuePtr;
+        chunksFinishedRingPtr_ = chunksFinishedRingPtr;
+        if ((chunksToDoQueuePtr_ != nullptr) && (chunksFinishedRingPtr_ != nullptr))
+        {
+            ready_ = true;
+        }
+        cameraNumber_ = cameraNumber;
+    }
+
+
+    bool Compressor_zfmf::compressNextFrame()
+    {
+        CompressedChunk_zfmf compressedChunk;
+
+        if (!ready_) 
+        { 
+            return false; 
+        }
+
+        // Get next chunk from in waiting queue
+        chunksToDoQueuePtr_ -> acquireLock();
+        if (chunksToDoQueuePtr_ -> empty())
+        {
+            chunksToDoQueuePtr_ -> releaseLock();
+            return false;
+        }
+        compressedChunk = std::move(chunksToDoQueuePtr_ -> front());
+        chunksToDoQueuePtr_ -> pop();
+        chunksToDoQueuePtr_ -> releaseLock();
+
+        // Compress the chunk and place it in its reserved slot
+        compressedChunk.encode();
+        chunksFinishedRingPtr_ -> insert(compressedChunk.getWriteIndex(), std::move(compressedChunk));
+        return true;
+    }
+
+
+    unsigned int Compressor_zfmf::numFramesPending()
+    {
+        // Number of chunks waiting to be compressed
+        if (!ready_)
+        {
+            return 0;
+        }
+        chunksToDoQueuePtr_ -> acquireLock();
+        unsigned int numChunks = (unsigned int)(chunksToDoQueuePtr_ -> size());
+        chunksToDoQueuePtr_ -> releaseLock();
+        return numChunks;
+    }
+
+
+    void Compressor_zfmf::skipPendingFrames()
+    {
+        // Stopping - release the reserved slots so the writer isn't held up 
+        if (!ready_)
+        {
+            return;
+        }
+        chunksToDoQueuePtr_ -> acquireLock();
+        while (!(chunksToDoQueuePtr_ -> empty()))
+        {
+            CompressedChunk_zfmf compressedChunk = chunksToDoQueuePtr_ -> front();
+            chunksToDoQueuePtr_ -> pop();
+            chunksFinishedRingPtr_ -> markSkipped(compressedChunk.getWriteIndex());
+        }
+        chunksToDoQueuePtr_ -> releaseLock();
+    }
+
+} // namespace bias
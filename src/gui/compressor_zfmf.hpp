@@ -0,0 +1,59 @@
+#ifndef BIAS_COMPRESSOR_ZFMF_HPP
+#define BIAS_COMPRESSOR_ZFMF_HPP
+
+#include <QObject>
+#include <memory>
+#include "lockable.hpp"
+#include "compressed_chunk_zfmf.hpp"
+#include "compression_scheduler.hpp"
+
+namespace bias
+{
+
+    class Compressor_zfmf : public QObject, public CompressionClient, public Lockable<Empty>
+    {
+        // Compresses chunks from the writer's "to do" queue. Chunks are 
+        // compressed one at a time by the shared CompressionScheduler workers
+        // so several chunks of a camera are in progress at once.
+
+        Q_OBJECT
+
+        public:
+
+            Compressor_zfmf(QObject *parent=0);
+
+            Compressor_zfmf(
+                    CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr,
+                    CompressedChunkRingPtr_zfmf chunksFinishedRingPtr,
+                    unsigned int cameraNumber,
+                    QObject *parent=0
+                    );
+
+            virtual bool compressNextFrame();
+            virtual unsigned int numFramesPending();
+            virtual void skipPendingFrames();
+
+
+        signals:
+            void imageLoggingError(unsigned int errorId, QString errorMsg);
+
+
+        private:
+
+            bool ready_;
+            unsigned int cameraNumber_;
+
+            CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr_;
+            CompressedChunkRingPtr_zfmf chunksFinishedRingPtr_;
+
+            void initialize(
+                    CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr,
+                    CompressedChunkRingPtr_zfmf chunksFinishedRingPtr,
+                    unsigned int cameraNumber
+                    );
+
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_COMPRESSOR_ZFMF_HPP
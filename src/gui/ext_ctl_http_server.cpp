@@ -60,6 +60,10 @@ namespace bias
         {
             cmdMap = handleLoggingDisable();
         }
+        else if (name == QString("trigger-recording"))
+        {
+            cmdMap = handleTriggerRecording();
+        }
         else if (name == QString("load-configuration"))
         {
             cmdMap = handleLoadConfiguration(value);
@@ -219,6 +223,17 @@ namespace bias
     }
 
 
+    QVariantMap ExtCtlHttpServer::handleTriggerRecording()
+    {
+        QVariantMap cmdMap;
+        RtnStatus status = cameraWindowPtr_ -> triggerRecording(false);
+        cmdMap.insert("success", status.success);
+        cmdMap.insert("message", status.message);
+        cmdMap.insert("value", "");
+        return cmdMap;
+    }
+
+
     QVariantMap ExtCtlHttpServer::handleSaveConfiguration(QString fileName)
     {
         QVariantMap cmdMap;
@@ -287,6 +302,8 @@ namespace bias
         statusMap.insert("frameCount", qulonglong(frameCount));
         statusMap.insert("framesPerSec", framesPerSec);
         statusMap.insert("timeStamp", timeStamp);
+        statusMap.insert("loggingWatchdog", cameraWindowPtr_ -> getLoggingWatchdogStatus());
+        statusMap.insert("fileMigration", cameraWindowPtr_ -> getFileMigrationStatus());
         cmdMap.insert("success", true);
         cmdMap.insert("message", "");
         cmdMap.insert("value", statusMap);
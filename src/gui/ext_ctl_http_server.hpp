@@ -31,6 +31,7 @@ namespace bias
             QVariantMap handleSetConfiguration(QString jsonConfig);
             QVariantMap handleLoggingEnable();
             QVariantMap handleLoggingDisable();
+            QVariantMap handleTriggerRecording();
             QVariantMap handleSaveConfiguration(QString fileName);
             QVariantMap handleLoadConfiguration(QString fileName);
             QVariantMap handleGetCameraGuid();
@@ -0,0 +1,565 @@
+#include "file_migrator.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include "json.hpp"
+#include "json_utils.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QVariantMap>
+#include <QVariantList>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace bias
+{
+    const bool FileMigrator::DEFAULT_ENABLED = false;
+    const double FileMigrator::DEFAULT_MAX_BYTES_PER_SEC = 0.0;
+    const bool FileMigrator::DEFAULT_VERIFY_CHECKSUM = true;
+    const size_t FileMigrator::COPY_CHUNK_SIZE = 4*1024*1024;
+    const QString FileMigrator::PART_FILE_EXT(".part");
+    const QString FileMigrator::JOURNAL_FILE_NAME("bias_migration_cam%1.json");
+
+
+    // FileMigrationJob
+    // ----------------------------------------------------------------------------------
+    FileMigrationJob::FileMigrationJob()
+    {
+        numBytes = 0;
+    }
+
+
+    // FileMigrationStatus
+    // ----------------------------------------------------------------------------------
+    FileMigrationStatus::FileMigrationStatus()
+    {
+        numberOfFiles = 0;
+        numberOfBytes = 0;
+        numberOfMigrated = 0;
+        numberOfFailed = 0;
+        bytesPerSec = 0.0;
+    }
+
+
+    // FileMigrator
+    // ----------------------------------------------------------------------------------
+    FileMigrator::FileMigrator(
+            VideoWriterParams_staging params,
+            unsigned int cameraNumber,
+            QObject *parent
+            ) : QObject(parent)
+    {
+        params_ = params;
+        cameraNumber_ = cameraNumber;
+        stopped_ = false;
+        QDir stagingDir(params_.directory);
+        journalFileName_ = stagingDir.absoluteFilePath(JOURNAL_FILE_NAME.arg(cameraNumber_));
+        readJournal();
+    }
+
+
+    bool FileMigrator::addFile(QString sourceFileName, QString destFileName)
+    {
+        // Returns false if the file doesn't exist or is already pending
+        QFileInfo sourceInfo(sourceFileName);
+        if (!sourceInfo.exists() || !sourceInfo.isFile())
+        {
+            return false;
+        }
+
+        FileMigrationJob job;
+        job.sourceFileName = sourceInfo.absoluteFilePath();
+        job.destFileName = QFileInfo(destFileName).absoluteFilePath();
+        job.numBytes = uint64_t(sourceInfo.size());
+
+        acquireLock();
+        bool isNew = (pendingSet_.count(job.sourceFileName) == 0);
+        if (isNew)
+        {
+            // Adding a failed file again retries it
+            failedVec_.erase(
+                    std::remove_if(failedVec_.begin(), failedVec_.end(), 
+                        [&job](const FileMigrationJob &failedJob) 
+                        { return failedJob.sourceFileName == job.sourceFileName; }), 
+                    failedVec_.end()
+                    );
+            jobQueue_.push_back(job);
+            pendingSet_.insert(job.sourceFileName);
+            status_.numberOfFiles++;
+            status_.numberOfBytes += job.numBytes;
+            writeJournal();
+            jobWaitCond_.wakeAll();
+        }
+        releaseLock();
+        return isNew;
+    }
+
+
+    unsigned int FileMigrator::addDirectory(QString sourceDirName, QString destDirName)
+    {
+        // Adds all files in the directory and its sub directories
+        unsigned int numAdded = 0;
+        QDir sourceDir(sourceDirName);
+        QDir destDir(destDirName);
+        QFileInfoList entryList = sourceDir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        for (QFileInfo entryInfo : entryList)
+        {
+            QString destName = destDir.absoluteFilePath(entryInfo.fileName());
+            if (entryInfo.isDir())
+            {
+                numAdded += addDirectory(entryInfo.absoluteFilePath(), destName);
+            }
+            else if (addFile(entryInfo.absoluteFilePath(), destName))
+            {
+                numAdded++;
+            }
+        }
+        return numAdded;
+    }
+
+
+    void FileMigrator::stop()
+    {
+        // Stops after the current chunk - partially copied files are
+        // continued when the migrator is restarted.
+        acquireLock();
+        stopped_ = true;
+        jobWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+
+    VideoWriterParams_staging FileMigrator::getParams() const
+    {
+        return params_;
+    }
+
+
+    FileMigrationStatus FileMigrator::getStatus()
+    {
+        acquireLock();
+        FileMigrationStatus status = status_;
+        releaseLock();
+        return status;
+    }
+
+
+    // Private methods
+    // ----------------------------------------------------------------------------------
+    void FileMigrator::run()
+    {
+        QThread *thisThread = QThread::currentThread();
+        thisThread -> setPriority(QThread::LowPriority);
+
+        while (true)
+        {
+            acquireLock();
+            while (jobQueue_.empty() && !stopped_)
+            {
+                jobWaitCond_.wait(&mutex_);
+            }
+            if (stopped_)
+            {
+                releaseLock();
+                break;
+            }
+            FileMigrationJob job = jobQueue_.front();
+            status_.currentFileName = job.sourceFileName;
+            releaseLock();
+
+            bool done = false;
+            bool failed = false;
+            try
+            {
+                done = migrate(job);
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                // Failed files are kept in the staging directory and in the
+                // journal, they are retried when the migrator is restarted.
+                failed = true;
+                unsigned int errorId = runtimeError.id();
+                QString errorMsg = QString::fromStdString(runtimeError.what());
+                acquireLock();
+                status_.lastError = errorMsg;
+                releaseLock();
+                emit fileMigrationError(errorId, errorMsg);
+            }
+
+            if (!done && !failed)
+            {
+                // Stopped part way
+                break;
+            }
+
+            acquireLock();
+            jobQueue_.pop_front();
+            pendingSet_.erase(job.sourceFileName);
+            status_.numberOfFiles--;
+            status_.numberOfBytes -= std::min(status_.numberOfBytes, job.numBytes);
+            status_.currentFileName = QString("");
+            if (failed)
+            {
+                failedVec_.push_back(job);
+                status_.numberOfFailed++;
+            }
+            else
+            {
+                status_.numberOfMigrated++;
+            }
+            writeJournal();
+            releaseLock();
+        }
+    }
+
+
+    bool FileMigrator::isStopped()
+    {
+        acquireLock();
+        bool stopped = stopped_;
+        releaseLock();
+        return stopped;
+    }
+
+
+    bool FileMigrator::migrate(FileMigrationJob job)
+    {
+        // Returns false if stopped before the file was done
+        QString partFileName = job.destFileName + PART_FILE_EXT;
+        if (QFileInfo(job.destFileName).exists())
+        {
+            // Already copied if an earlier run stopped before removing the
+            // staging file, otherwise the destination is never replaced.
+            if (isSameFile(job.sourceFileName, job.destFileName))
+            {
+                // The earlier run may have stopped before the copy was synced
+                QFile destFile(job.destFileName);
+                if (destFile.open(QIODevice::ReadOnly))
+                {
+                    syncFile(destFile);
+                }
+                syncDirectory(QFileInfo(job.destFileName).absolutePath());
+                QFile::remove(job.sourceFileName);
+                return true;
+            }
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: destination file already exists, ");
+            errorMsg += job.destFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        QDir destDir = QFileInfo(job.destFileName).absoluteDir();
+        if (!destDir.exists() && !QDir().mkpath(destDir.absolutePath()))
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: unable to create directory, ");
+            errorMsg += destDir.absolutePath().toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        QFile sourceFile(job.sourceFileName);
+        if (!sourceFile.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: unable to open staging file, ");
+            errorMsg += job.sourceFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // Continue a partial copy left by an earlier run
+        uint64_t sourceSize = uint64_t(sourceFile.size());
+        uint64_t offset = 0;
+        QFileInfo partInfo(partFileName);
+        if (partInfo.exists() && (uint64_t(partInfo.size()) <= sourceSize))
+        {
+            offset = uint64_t(partInfo.size());
+        }
+        else
+        {
+            QFile::remove(partFileName);
+        }
+
+        QFile partFile(partFileName);
+        if (!partFile.open(QIODevice::ReadWrite | QIODevice::Append))
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: unable to open destination file, ");
+            errorMsg += partFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        if (!copyFile(sourceFile, partFile, offset))
+        {
+            return false;
+        }
+
+        if (params_.verifyChecksum)
+        {
+            QByteArray sourceChecksum = getChecksum(sourceFile, sourceSize);
+            QByteArray partChecksum = getChecksum(partFile, sourceSize);
+            if ((sourceChecksum != partChecksum) || (uint64_t(partFile.size()) != sourceSize))
+            {
+                partFile.close();
+                QFile::remove(partFileName);
+                unsigned int errorId = ERROR_FILE_MIGRATION_VERIFY;
+                std::string errorMsg("file migration: checksum mismatch, ");
+                errorMsg += job.destFileName.toStdString();
+                throw RuntimeError(errorId, errorMsg);
+            }
+        }
+        sourceFile.close();
+        partFile.close();
+
+        if (!QFile::rename(partFileName, job.destFileName))
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: unable to rename ");
+            errorMsg += partFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // The rename must be on disk before the only other copy is removed
+        syncDirectory(destDir.absolutePath());
+
+        // Remove the staging copy and its directory if now empty
+        QFile::remove(job.sourceFileName);
+        QDir sourceDir = QFileInfo(job.sourceFileName).absoluteDir();
+        if (sourceDir.absolutePath() != QDir(params_.directory).absolutePath())
+        {
+            QDir().rmdir(sourceDir.absolutePath());
+        }
+        return true;
+    }
+
+
+    bool FileMigrator::copyFile(QFile &sourceFile, QFile &partFile, uint64_t offset)
+    {
+        // Copies from offset to the end of the source file. Throttled to
+        // maxBytesPerSec by sleeping between chunks. Returns false if stopped.
+        uint64_t sourceSize = uint64_t(sourceFile.size());
+        std::vector<char> buffer(COPY_CHUNK_SIZE);
+        QElapsedTimer timer;
+        timer.start();
+        uint64_t bytesCopied = 0;
+
+        sourceFile.seek(qint64(offset));
+        while (offset + bytesCopied < sourceSize)
+        {
+            if (isStopped())
+            {
+                partFile.close();
+                return false;
+            }
+
+            qint64 numRead = sourceFile.read(buffer.data(), qint64(buffer.size()));
+            if ((numRead <= 0) || (partFile.write(buffer.data(), numRead) != numRead))
+            {
+                unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+                std::string errorMsg("file migration: copy failed, ");
+                errorMsg += partFile.fileName().toStdString();
+                throw RuntimeError(errorId, errorMsg);
+            }
+            bytesCopied += uint64_t(numRead);
+
+            double elapsedSec = std::max(1.0e-3*double(timer.elapsed()), 1.0e-3);
+            if (params_.maxBytesPerSec > 0.0)
+            {
+                double targetSec = double(bytesCopied)/params_.maxBytesPerSec;
+                if (targetSec > elapsedSec)
+                {
+                    QThread::msleep((unsigned long)(1000.0*(targetSec - elapsedSec)));
+                    elapsedSec = targetSec;
+                }
+            }
+
+            acquireLock();
+            status_.bytesPerSec = double(bytesCopied)/elapsedSec;
+            releaseLock();
+        }
+
+        // On disk before it is verified and renamed
+        syncFile(partFile);
+        return true;
+    }
+
+
+    void FileMigrator::syncFile(QFile &file)
+    {
+        // QFile::flush only empties Qt's buffer - the data is synced to disk,
+        // and on posix dropped from the page cache so the checksum is read 
+        // back from the disk.
+        bool ok = file.flush();
+#ifdef WIN32
+        ok = ok && (_commit(file.handle()) == 0);
+#else
+        int rtnVal = fsync(file.handle());
+        while ((rtnVal != 0) && (errno == EINTR))
+        {
+            rtnVal = fsync(file.handle());
+        }
+        ok = ok && (rtnVal == 0);
+#ifdef POSIX_FADV_DONTNEED
+        if (ok)
+        {
+            posix_fadvise(file.handle(), 0, 0, POSIX_FADV_DONTNEED);
+        }
+#endif
+#endif
+        if (!ok)
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: sync failed, ");
+            errorMsg += file.fileName().toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void FileMigrator::syncDirectory(QString dirName)
+    {
+        // Makes renames in the directory durable. Directories can't be synced
+        // on windows, where the rename is journaled by the file system.
+#ifndef WIN32
+        int fd = ::open(dirName.toLocal8Bit().constData(), O_RDONLY);
+        bool ok = (fd >= 0);
+        if (ok)
+        {
+            int rtnVal = fsync(fd);
+            while ((rtnVal != 0) && (errno == EINTR))
+            {
+                rtnVal = fsync(fd);
+            }
+            ok = (rtnVal == 0);
+            ::close(fd);
+        }
+        if (!ok)
+        {
+            unsigned int errorId = ERROR_FILE_MIGRATION_COPY;
+            std::string errorMsg("file migration: unable to sync directory, ");
+            errorMsg += dirName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+#endif
+    }
+
+
+    bool FileMigrator::isSameFile(QString fileName0, QString fileName1)
+    {
+        QFile file0(fileName0);
+        QFile file1(fileName1);
+        if (!file0.open(QIODevice::ReadOnly) || !file1.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        if (file0.size() != file1.size())
+        {
+            return false;
+        }
+        uint64_t numBytes = uint64_t(file0.size());
+        return getChecksum(file0, numBytes) == getChecksum(file1, numBytes);
+    }
+
+
+    QByteArray FileMigrator::getChecksum(QFile &file, uint64_t numBytes)
+    {
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        std::vector<char> buffer(COPY_CHUNK_SIZE);
+        uint64_t bytesRead = 0;
+        file.seek(0);
+        while (bytesRead < numBytes)
+        {
+            qint64 numToRead = qint64(std::min(uint64_t(buffer.size()), numBytes - bytesRead));
+            qint64 numRead = file.read(buffer.data(), numToRead);
+            if (numRead <= 0)
+            {
+                break;
+            }
+            hash.addData(buffer.data(), int(numRead));
+            bytesRead += uint64_t(numRead);
+        }
+        return hash.result();
+    }
+
+
+    void FileMigrator::readJournal()
+    {
+        // Pending and failed files from an earlier run
+        QFile journalFile(journalFileName_);
+        if (!journalFile.open(QIODevice::ReadOnly))
+        {
+            return;
+        }
+        QString journalJson = QString::fromUtf8(journalFile.readAll());
+        journalFile.close();
+
+        bool ok = false;
+        QVariantMap journalMap = QtJson::parse(journalJson, ok).toMap();
+        if (!ok)
+        {
+            std::cout << "warning: unable to parse migration journal, " << journalFileName_.toStdString() << std::endl;
+            return;
+        }
+
+        QVariantList fileList = journalMap["files"].toList();
+        for (QVariant fileVariant : fileList)
+        {
+            QVariantMap fileMap = fileVariant.toMap();
+            addFile(fileMap["source"].toString(), fileMap["destination"].toString());
+        }
+    }
+
+
+    void FileMigrator::writeJournal()
+    {
+        // Called with the lock held. Written to a temporary file first - the
+        // new version replaces the old one by rename.
+        QVariantList fileList;
+        std::vector<FileMigrationJob> jobVec(jobQueue_.begin(), jobQueue_.end());
+        jobVec.insert(jobVec.end(), failedVec_.begin(), failedVec_.end());
+        for (const FileMigrationJob &job : jobVec)
+        {
+            QVariantMap fileMap;
+            fileMap.insert("source", job.sourceFileName);
+            fileMap.insert("destination", job.destFileName);
+            fileMap.insert("numberOfBytes", qulonglong(job.numBytes));
+            fileList.append(fileMap);
+        }
+
+        if (fileList.isEmpty())
+        {
+            QFile::remove(journalFileName_);
+            return;
+        }
+
+        QVariantMap journalMap;
+        journalMap.insert("cameraNumber", cameraNumber_);
+        journalMap.insert("files", fileList);
+
+        bool ok = false;
+        QByteArray json = QtJson::serialize(journalMap, ok);
+        QString tmpFileName = journalFileName_ + QString(".tmp");
+        QFile tmpFile(tmpFileName);
+        if (!ok || !tmpFile.open(QIODevice::WriteOnly))
+        {
+            std::cout << "warning: unable to write migration journal, " << journalFileName_.toStdString() << std::endl;
+            return;
+        }
+        tmpFile.write(prettyIndentJson(json));
+        tmpFile.close();
+        QFile::remove(journalFileName_);
+        QFile::rename(tmpFileName, journalFileName_);
+    }
+
+} // namespace bias
@@ -0,0 +1,112 @@
+#ifndef BIAS_FILE_MIGRATOR_HPP
+#define BIAS_FILE_MIGRATOR_HPP
+
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QWaitCondition>
+#include <deque>
+#include <set>
+#include <vector>
+#include <cstdint>
+#include "lockable.hpp"
+#include "logging_params.hpp"
+
+class QFile;
+
+namespace bias
+{
+
+    struct FileMigrationJob
+    {
+        QString sourceFileName;
+        QString destFileName;
+        uint64_t numBytes;
+        FileMigrationJob();
+    };
+
+
+    struct FileMigrationStatus
+    {
+        unsigned long numberOfFiles;     // waiting or being copied
+        uint64_t numberOfBytes;          // left to copy
+        unsigned long numberOfMigrated;
+        unsigned long numberOfFailed;
+        double bytesPerSec;
+        QString currentFileName;
+        QString lastError;
+        FileMigrationStatus();
+    };
+
+
+    class FileMigrator : public QObject, public QRunnable, public Lockable<Empty>
+    {
+        Q_OBJECT
+
+        // Moves finished video files from the fast staging directory to
+        // their final destination on a background thread, so that logging
+        // never waits on slow bulk storage. Files are copied to a ".part"
+        // file at the destination, throttled to maxBytesPerSec, optionally
+        // verified by checksum, renamed into place and then removed from the
+        // staging directory. Existing destination files are never replaced.
+        //
+        // Pending files are kept in a journal in the staging directory. The
+        // journal is read when the migrator is created so migration resumes
+        // after a restart, continuing partially copied files.
+
+        public:
+
+            static const bool DEFAULT_ENABLED;
+            static const double DEFAULT_MAX_BYTES_PER_SEC;
+            static const bool DEFAULT_VERIFY_CHECKSUM;
+            static const size_t COPY_CHUNK_SIZE;
+            static const QString PART_FILE_EXT;
+            static const QString JOURNAL_FILE_NAME;
+
+            FileMigrator(
+                    VideoWriterParams_staging params,
+                    unsigned int cameraNumber,
+                    QObject *parent=0
+                    );
+
+            bool addFile(QString sourceFileName, QString destFileName);
+            unsigned int addDirectory(QString sourceDirName, QString destDirName);
+            void stop();
+
+            VideoWriterParams_staging getParams() const;
+            FileMigrationStatus getStatus();
+
+        signals:
+            void fileMigrationError(unsigned int errorId, QString errorMsg);
+
+        private:
+
+            VideoWriterParams_staging params_;
+            unsigned int cameraNumber_;
+            QString journalFileName_;
+
+            // use lock when accessing these values
+            // -------------------------------------
+            bool stopped_;
+            std::deque<FileMigrationJob> jobQueue_;
+            std::set<QString> pendingSet_;
+            std::vector<FileMigrationJob> failedVec_;
+            QWaitCondition jobWaitCond_;
+            FileMigrationStatus status_;
+            // -------------------------------------
+
+            void run();
+            bool isStopped();
+            bool migrate(FileMigrationJob job);
+            bool copyFile(QFile &sourceFile, QFile &partFile, uint64_t offset);
+            void syncFile(QFile &file);
+            void syncDirectory(QString dirName);
+            bool isSameFile(QString fileName0, QString fileName1);
+            QByteArray getChecksum(QFile &file, uint64_t numBytes);
+            void readJournal();
+            void writeJournal();
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_FILE_MIGRATOR_HPP
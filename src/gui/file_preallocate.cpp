@@ -0,0 +1,82 @@
+#include "file_preallocate.hpp"
+#include <fcntl.h>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace bias
+{
+
+    bool preallocateFile(int fd, uint64_t fileSize, uint64_t numBytes)
+    {
+        // Reserves space from the current end of file up to numBytes
+        if ((fd < 0) || (numBytes <= fileSize))
+        {
+            return false;
+        }
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+        int rtnVal = fallocate(fd, FALLOC_FL_KEEP_SIZE, off_t(fileSize), off_t(numBytes - fileSize));
+        return (rtnVal == 0);
+#else
+        return false;
+#endif
+    }
+
+
+    bool preallocateFile(QString fileName, uint64_t fileSize, uint64_t numBytes)
+    {
+#ifdef __linux__
+        int fd = ::open(fileName.toStdString().c_str(), O_WRONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool rtnVal = preallocateFile(fd, fileSize, numBytes);
+        ::close(fd);
+        return rtnVal;
+#else
+        return false;
+#endif
+    }
+
+
+    bool releasePreallocation(int fd)
+    {
+        // Frees the reserved space past the end of file. Truncating to the
+        // current size leaves the data untouched.
+        if (fd < 0)
+        {
+            return false;
+        }
+#ifdef __linux__
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0)
+        {
+            return false;
+        }
+        return (ftruncate(fd, fileStat.st_size) == 0);
+#else
+        return false;
+#endif
+    }
+
+
+    bool releasePreallocation(QString fileName)
+    {
+#ifdef __linux__
+        int fd = ::open(fileName.toStdString().c_str(), O_WRONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool rtnVal = releasePreallocation(fd);
+        ::close(fd);
+        return rtnVal;
+#else
+        return false;
+#endif
+    }
+
+} // namespace bias
@@ -0,0 +1,24 @@
+#ifndef BIAS_FILE_PREALLOCATE_HPP
+#define BIAS_FILE_PREALLOCATE_HPP
+
+#include <QString>
+#include <cstdint>
+
+namespace bias
+{
+    // Disk space preallocation for video files. Space is reserved past the
+    // end of file without changing the file size, so a partially written
+    // file always ends at its last written byte. The unused part of the 
+    // reservation is released, once the data has been flushed, by 
+    // truncating the file to its current size. Where the platform or file
+    // system doesn't support this the functions do nothing and return false.
+
+    bool preallocateFile(int fd, uint64_t fileSize, uint64_t numBytes);
+    bool preallocateFile(QString fileName, uint64_t fileSize, uint64_t numBytes);
+
+    bool releasePreallocation(int fd);
+    bool releasePreallocation(QString fileName);
+
+} // namespace bias
+
+#endif // #ifndef BIAS_FILE_PREALLOCATE_HPP
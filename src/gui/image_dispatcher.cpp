@@ -1,20 +1,19 @@
 #include "image_dispatcher.hpp"
 #include "stamped_image.hpp"
 #include "affinity.hpp"
+#include "trigger_recorder.hpp"
+#include "staged_file_writer.hpp"
+#include "frame_stamp_log.hpp"
+#include "exception.hpp"
 #include <iostream>
 #include <QThread>
-
-// DEVEL
-// ----------------------------------------------------------------------------
-#include "camera_window.hpp"
-#include <QDir>
-#include <QFileInfo>
-#include <fstream>
-#include <QtDebug>
-// ----------------------------------------------------------------------------
+#include <QThreadPool>
 
 namespace bias
 {
+    const bool ImageDispatcher::DEFAULT_STAMP_LOG_ENABLED = false;
+    const size_t ImageDispatcher::STAMP_LOG_BUFFER_SIZE = 256*1024;
+    const unsigned int ImageDispatcher::STAMP_LOG_NUMBER_OF_BUFFERS = 3;
 
     ImageDispatcher::ImageDispatcher(QObject *parent) : QObject(parent)
     {
@@ -76,6 +75,31 @@ namespace bias
         currentTimeStamp_ = 0.0;
     }
 
+    void ImageDispatcher::setTriggerRecorder(std::shared_ptr<TriggerRecorder> triggerRecorderPtr)
+    {
+        triggerRecorderPtr_ = triggerRecorderPtr;
+    }
+
+    void ImageDispatcher::setStampLogFileName(QString fileName)
+    {
+        stampLogFileName_ = fileName;
+    }
+
+    void ImageDispatcher::setLogSubscription(ImageSubscriptionParams params)
+    {
+        logSubscription_.setParams(params);
+    }
+
+    void ImageDispatcher::setPluginSubscription(ImageSubscriptionParams params)
+    {
+        pluginSubscription_.setParams(params);
+    }
+
+    void ImageDispatcher::setDisplaySubscription(ImageSubscriptionParams params)
+    {
+        displaySubscription_.setParams(params);
+    }
+
     cv::Mat ImageDispatcher::getImage() const
     {
         cv::Mat currentImageCopy = currentImage_.clone();
@@ -123,18 +147,40 @@ namespace bias
         frameCount_ = 0;
         stopped_ = false;
         fpsEstimator_.reset();
+        logSubscription_.reset();
+        pluginSubscription_.reset();
+        displaySubscription_.reset();
         releaseLock();
 
-        // DEVEL - make this non development. Need to pass video file dir as argument
-        // ---------------------------------------------------------------------------
-        CameraWindow* cameraWindowPtr = qobject_cast<CameraWindow *>(parent());
-        QDir videoFileDir = cameraWindowPtr -> getVideoFileDir();
-        QString stampLogName = QString("stamp_log_cam%1.txt").arg(cameraNumber_);
-        QFileInfo stampFileInfo = QFileInfo(videoFileDir, stampLogName);
-        std::string stampFileName = stampFileInfo.absoluteFilePath().toStdString();
-        std::ofstream stampOutStream;
-        stampOutStream.open(stampFileName);
-        // ---------------------------------------------------------------------------
+        // Per-frame time stamp sidecar. Records are copied into staging
+        // buffers which the stamp writer thread writes out, so the dispatcher 
+        // doesn't wait on the disk. The pool is declared first so the writer
+        // is closed before the pool waits for its thread.
+        QThreadPool stampThreadPool;
+        std::shared_ptr<StagedFileWriter> stampWriterPtr;
+        std::vector<char> stampData;
+        FrameStampRecord stampRecord;
+        bool haveStampRecord = false;
+
+        if (!stampLogFileName_.isEmpty())
+        {
+            stampWriterPtr = std::make_shared<StagedFileWriter>(
+                    STAMP_LOG_BUFFER_SIZE, 
+                    STAMP_LOG_NUMBER_OF_BUFFERS
+                    );
+            try
+            {
+                stampWriterPtr -> open(stampLogFileName_);
+                stampThreadPool.start(stampWriterPtr.get());
+                FrameStampLog::getHeader(stampData);
+                stampWriterPtr -> write(&stampData[0], stampData.size());
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                std::cout << "stamp log error: " << runtimeError.what() << std::endl;
+                stampWriterPtr.reset();
+            }
+        }
 
         while (!done) 
         {
@@ -150,42 +196,105 @@ namespace bias
             newImageQueuePtr_ -> pop();
             newImageQueuePtr_ -> releaseLock();
 
-            if (logging_ )
+            // Each consumer gets only the frames and roi it subscribed to.
+            // Roi images are views of the grabbed frame, except for logging
+            // where the writers need continuous image data.
+            bool logFrame = logging_ && logSubscription_.accept(newStampImage);
+
+            if (logFrame && triggerRecorderPtr_)
             {
+                StampedImage logStampImage = logSubscription_.getStampedImage(newStampImage, true);
+                triggerLogVec_.clear();
+                triggerRecorderPtr_ -> process(logStampImage, triggerLogVec_);
+                if (!triggerLogVec_.empty())
+                {
+                    logImageQueuePtr_ -> acquireLock();
+                    for (const StampedImage &stampedImg : triggerLogVec_)
+                    {
+                        logImageQueuePtr_ -> push(stampedImg);
+                    }
+                    logImageQueuePtr_ -> signalNotEmpty();
+                    logImageQueuePtr_ -> releaseLock();
+                }
+            }
+            else if (logFrame)
+            {
+                StampedImage logStampImage = logSubscription_.getStampedImage(newStampImage, true);
                 logImageQueuePtr_ -> acquireLock();
-                logImageQueuePtr_ -> push(newStampImage);
+                logImageQueuePtr_ -> push(logStampImage);
                 logImageQueuePtr_ -> signalNotEmpty();
                 logImageQueuePtr_ -> releaseLock();
             }
 
-            if (pluginEnabled_)
+            if (pluginEnabled_ && pluginSubscription_.accept(newStampImage))
             {
+                StampedImage pluginStampImage = pluginSubscription_.getStampedImage(newStampImage);
                 pluginImageQueuePtr_ -> acquireLock();
-                pluginImageQueuePtr_ -> push(newStampImage);
+                pluginImageQueuePtr_ -> push(pluginStampImage);
                 pluginImageQueuePtr_ -> signalNotEmpty();
                 pluginImageQueuePtr_ -> releaseLock();
             }
 
             acquireLock();
-            currentImage_ = newStampImage.image;
+            if (displaySubscription_.accept(newStampImage))
+            {
+                currentImage_ = displaySubscription_.getImage(newStampImage.image);
+            }
             currentTimeStamp_ = newStampImage.timeStamp;
             frameCount_ = newStampImage.frameCount;
             fpsEstimator_.update(newStampImage.timeStamp);
             done = stopped_;
             releaseLock();
 
-            // DEVEL
-            // ----------------------------------------------------------------
-            stampOutStream << QString::number(currentTimeStamp_,'g',15).toStdString(); 
-            stampOutStream << std::endl;
-            // ----------------------------------------------------------------
+            if (stampWriterPtr)
+            {
+                uint32_t flags = 0;
+                if (haveStampRecord)
+                {
+                    if (newStampImage.frameCount != stampRecord.frameCount + 1)
+                    {
+                        flags |= FRAME_STAMP_FLAG_COUNT_GAP;
+                    }
+                    double dt = newStampImage.timeStamp - stampRecord.timeStamp;
+                    double maxDt = FrameStampLog::TIME_GAP_FACTOR*newStampImage.dtEstimate;
+                    if ((newStampImage.dtEstimate > 0.0) && (dt > maxDt))
+                    {
+                        flags |= FRAME_STAMP_FLAG_TIME_GAP;
+                    }
+                }
+                stampRecord.frameCount = uint64_t(newStampImage.frameCount);
+                stampRecord.timeStamp = newStampImage.timeStamp;
+                stampRecord.hostTimeStamp = newStampImage.hostTimeStamp;
+                stampRecord.dtEstimate = newStampImage.dtEstimate;
+                stampRecord.flags = flags;
+                haveStampRecord = true;
+
+                stampData.clear();
+                FrameStampLog::serialize(stampRecord, stampData);
+                try
+                {
+                    stampWriterPtr -> write(&stampData[0], stampData.size());
+                }
+                catch (RuntimeError &runtimeError)
+                {
+                    std::cout << "stamp log error: " << runtimeError.what() << std::endl;
+                    stampWriterPtr.reset();
+                }
+            }
 
         }
 
-        // DEVEL
-        // --------------------------------------------------------------------
-        stampOutStream.close();
-        // --------------------------------------------------------------------
+        if (stampWriterPtr)
+        {
+            try
+            {
+                stampWriterPtr -> close();
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                std::cout << "stamp log error: " << runtimeError.what() << std::endl;
+            }
+        }
     }
 
 } // namespace bias
@@ -5,20 +5,29 @@
 #include <QMutex>
 #include <QObject>
 #include <QRunnable>
+#include <QString>
 #include <opencv2/core/core.hpp>
+#include <vector>
 #include "fps_estimator.hpp"
 #include "lockable.hpp"
+#include "image_subscription.hpp"
 
 namespace bias
 {
 
     struct StampedImage;
+    class TriggerRecorder;
 
     class ImageDispatcher : public QObject, public QRunnable, public Lockable<Empty>
     {
         Q_OBJECT
 
         public:
+
+            static const bool DEFAULT_STAMP_LOG_ENABLED;
+            static const size_t STAMP_LOG_BUFFER_SIZE;
+            static const unsigned int STAMP_LOG_NUMBER_OF_BUFFERS;
+
             ImageDispatcher(QObject *parent=0);
 
             ImageDispatcher( 
@@ -40,6 +49,20 @@ namespace bias
                     std::shared_ptr<LockableQueue<StampedImage>> pluginImageQueuePtr
                     );
 
+            // Set before starting - when set only triggered clips are logged
+            void setTriggerRecorder(std::shared_ptr<TriggerRecorder> triggerRecorderPtr);
+
+            // Set before starting - per-frame time stamp sidecar (see 
+            // FrameStampLog), empty name disables it
+            void setStampLogFileName(QString fileName);
+
+            // Set before starting - decimation and roi for each consumer. The
+            // log subscription applies before pre/post trigger recording and
+            // before the video writer's frame skip.
+            void setLogSubscription(ImageSubscriptionParams params);
+            void setPluginSubscription(ImageSubscriptionParams params);
+            void setDisplaySubscription(ImageSubscriptionParams params);
+
             // Use lock when calling these methods
             // ----------------------------------
             void stop();
@@ -57,6 +80,12 @@ namespace bias
             std::shared_ptr<LockableQueue<StampedImage>> newImageQueuePtr_;
             std::shared_ptr<LockableQueue<StampedImage>> logImageQueuePtr_;
             std::shared_ptr<LockableQueue<StampedImage>> pluginImageQueuePtr_;
+            std::shared_ptr<TriggerRecorder> triggerRecorderPtr_;
+            std::vector<StampedImage> triggerLogVec_;
+            QString stampLogFileName_;
+            ImageSubscription logSubscription_;
+            ImageSubscription pluginSubscription_;
+            ImageSubscription displaySubscription_;
 
             // use lock when setting these values
             // -----------------------------------
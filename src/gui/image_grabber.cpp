@@ -3,6 +3,7 @@
 #include "camera.hpp"
 #include "stamped_image.hpp"
 #include "affinity.hpp"
+#include "frame_stamp_log.hpp"
 #include <iostream>
 #include <QTime>
 #include <QThread>
@@ -168,6 +169,7 @@ namespace bias {
             {
                 stampImg.image = cameraPtr_ -> grabImage();
                 timeStamp = cameraPtr_ -> getImageTimeStamp();
+                stampImg.hostTimeStamp = FrameStampLog::getHostTimeStamp();
                 error = false;
             }
             catch (RuntimeError &runtimeError)
@@ -3,6 +3,7 @@
 #include "exception.hpp"
 #include "stamped_image.hpp"
 #include "video_writer.hpp"
+#include "logging_watchdog.hpp"
 #include "affinity.hpp"
 #include <QThread>
 #include <queue>
@@ -40,6 +41,9 @@ namespace bias
         videoWriterPtr_ = videoWriterPtr;
         logImageQueuePtr_ = logImageQueuePtr;
         logQueueSize_ = 0;
+        watchdogPtr_.reset();
+        fallbackWriterPtr_.reset();
+        degradeLevel_ = 0;
         if ((logImageQueuePtr_ != NULL) && (videoWriterPtr_ != NULL))
         {
             ready_ = true;
@@ -55,6 +59,16 @@ namespace bias
         stopped_ = true;
     }
 
+    void ImageLogger::setWatchdog(std::shared_ptr<LoggingWatchdog> watchdogPtr)
+    {
+        watchdogPtr_ = watchdogPtr;
+    }
+
+    void ImageLogger::setFallbackWriter(std::shared_ptr<VideoWriter> fallbackWriterPtr)
+    {
+        fallbackWriterPtr_ = fallbackWriterPtr;
+    }
+
     unsigned int ImageLogger::getLogQueueSize()
     {
         return logQueueSize_;
@@ -123,6 +137,11 @@ namespace bias
                     QString errorMsg = QString::fromStdString(runtimeError.what());
                     emit imageLoggingError(errorId, errorMsg);
                 }
+
+                if (watchdogPtr_)
+                {
+                    updateWatchdog(newStampedImage, logQueueSize);
+                }
             }
 
             acquireLock();
@@ -146,6 +165,85 @@ namespace bias
     }  // void ImageLogger::run()
 
 
+    void ImageLogger::updateWatchdog(const StampedImage &stampedImg, unsigned int logQueueSize)
+    {
+        LoggingWatchdogAction action = watchdogPtr_ -> update(
+                stampedImg, 
+                logQueueSize, 
+                MAX_LOG_QUEUE_SIZE, 
+                videoWriterPtr_ -> getNumberOfBytesWritten()
+                );
+
+        if (action == WATCHDOG_ACTION_WARNING)
+        {
+            unsigned int errorId = ERROR_LOGGING_WATCHDOG_WARNING;
+            QString errorMsg = watchdogPtr_ -> getMessage();
+            emit imageLoggingError(errorId, errorMsg);
+        }
+        else if (action == WATCHDOG_ACTION_DEGRADE)
+        {
+            QString stepMsg;
+            try
+            {
+                stepMsg = degrade();
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                unsigned int errorId = runtimeError.id();
+                QString errorMsg = QString::fromStdString(runtimeError.what());
+                emit imageLoggingError(errorId, errorMsg);
+            }
+            watchdogPtr_ -> setDegradeLevel(degradeLevel_);
+
+            unsigned int errorId = ERROR_LOGGING_WATCHDOG_DEGRADE;
+            QString errorMsg = watchdogPtr_ -> getMessage() + QString(", ") + stepMsg;
+            emit imageLoggingError(errorId, errorMsg);
+        }
+    }
+
+
+    QString ImageLogger::degrade()
+    {
+        // Applies the next degrade step which has an effect. Steps which 
+        // can't be applied, e.g. quality for a format without a quality 
+        // setting, are skipped.
+        QStringList degradeSteps = watchdogPtr_ -> getParams().degradeSteps;
+        unsigned int numDegradeSteps = (unsigned int)(degradeSteps.size());
+        while (degradeLevel_ < numDegradeSteps)
+        {
+            QString step = degradeSteps[degradeLevel_];
+            degradeLevel_++;
+
+            if (step == LoggingWatchdog::DEGRADE_STEP_FRAME_SKIP)
+            {
+                unsigned int frameSkip = 2*(videoWriterPtr_ -> getFrameSkip());
+                videoWriterPtr_ -> setFrameSkip(frameSkip);
+                return QString("frame skip increased to %1").arg(frameSkip);
+            }
+            else if (step == LoggingWatchdog::DEGRADE_STEP_QUALITY)
+            {
+                if (videoWriterPtr_ -> reduceQuality())
+                {
+                    // Quality can be reduced again by a later step
+                    degradeLevel_--;
+                    return QString("video quality reduced");
+                }
+            }
+            else if ((step == LoggingWatchdog::DEGRADE_STEP_UFMF) && fallbackWriterPtr_)
+            {
+                // Close the current file and continue in the fallback format
+                unsigned int frameSkip = videoWriterPtr_ -> getFrameSkip();
+                videoWriterPtr_ -> finish();
+                videoWriterPtr_ = fallbackWriterPtr_;
+                videoWriterPtr_ -> setFrameSkip(frameSkip);
+                fallbackWriterPtr_.reset();
+                return QString("switched to ufmf, ") + videoWriterPtr_ -> getFileName();
+            }
+        }
+        return QString("no degrade steps left");
+    }
+
+
 
 } // namespace bias
 
@@ -19,6 +19,7 @@ namespace bias
 {
 
     class VideoWriter;
+    class LoggingWatchdog;
 
     struct StampedImage;
 
@@ -44,6 +45,10 @@ namespace bias
 
             void stop();
 
+            // Optional - set before the logger is started
+            void setWatchdog(std::shared_ptr<LoggingWatchdog> watchdogPtr);
+            void setFallbackWriter(std::shared_ptr<VideoWriter> fallbackWriterPtr);
+
             unsigned int getLogQueueSize();
 
 
@@ -64,7 +69,13 @@ namespace bias
             std::shared_ptr<VideoWriter> videoWriterPtr_;
             std::shared_ptr<LockableQueue<StampedImage>> logImageQueuePtr_;
 
+            std::shared_ptr<LoggingWatchdog> watchdogPtr_;
+            std::shared_ptr<VideoWriter> fallbackWriterPtr_;
+            unsigned int degradeLevel_;
+
             void run();
+            void updateWatchdog(const StampedImage &stampedImg, unsigned int logQueueSize);
+            QString degrade();
     };
 
 } // namespace bias
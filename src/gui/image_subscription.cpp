@@ -0,0 +1,149 @@
+#include "image_subscription.hpp"
+#include <sstream>
+#include <algorithm>
+
+namespace bias
+{
+
+    const unsigned int ImageSubscription::DEFAULT_DIVISOR = 1;
+    const double ImageSubscription::DEFAULT_MAX_FPS = 0.0;
+
+
+    // ImageSubscriptionParams
+    // ----------------------------------------------------------------------------------
+    ImageSubscriptionParams::ImageSubscriptionParams()
+    {
+        divisor = ImageSubscription::DEFAULT_DIVISOR;
+        maxFps = ImageSubscription::DEFAULT_MAX_FPS;
+        roi = cv::Rect(0,0,0,0);
+    }
+
+
+    bool ImageSubscriptionParams::isFullRate() const
+    {
+        return (divisor <= 1) && (maxFps <= 0.0);
+    }
+
+
+    bool ImageSubscriptionParams::isFullFrame() const
+    {
+        return (roi.width <= 0) || (roi.height <= 0);
+    }
+
+
+    std::string ImageSubscriptionParams::toString()
+    {
+        std::stringstream ss;
+        ss << "divisor: " << divisor << std::endl;
+        ss << "maxFps: " << maxFps << std::endl;
+        ss << "roi: " << roi.x << ", " << roi.y << ", " << roi.width << ", " << roi.height << std::endl;
+        return ss.str();
+    }
+
+
+    // ImageSubscription
+    // ----------------------------------------------------------------------------------
+    ImageSubscription::ImageSubscription()
+    {
+        ImageSubscriptionParams params;
+        setParams(params);
+    }
+
+
+    ImageSubscription::ImageSubscription(ImageSubscriptionParams params)
+    {
+        setParams(params);
+    }
+
+
+    void ImageSubscription::setParams(ImageSubscriptionParams params)
+    {
+        params_ = params;
+        params_.divisor = std::max(params_.divisor, 1u);
+        reset();
+    }
+
+
+    ImageSubscriptionParams ImageSubscription::getParams() const
+    {
+        return params_;
+    }
+
+
+    void ImageSubscription::reset()
+    {
+        count_ = 0;
+        numberAccepted_ = 0;
+        haveLastTimeStamp_ = false;
+        lastTimeStamp_ = 0.0;
+    }
+
+
+    bool ImageSubscription::accept(const StampedImage &stampedImg)
+    {
+        if (params_.isFullRate())
+        {
+            numberAccepted_++;
+            return true;
+        }
+
+        bool isAccepted = (count_%params_.divisor == 0);
+        count_++;
+
+        // Half a frame interval of slack so jitter in the time stamps 
+        // doesn't drop every other frame at rates close to the frame rate.
+        if (isAccepted && (params_.maxFps > 0.0) && haveLastTimeStamp_)
+        {
+            double minDt = 1.0/params_.maxFps - 0.5*stampedImg.dtEstimate;
+            isAccepted = (stampedImg.timeStamp - lastTimeStamp_ >= minDt);
+            if (!isAccepted)
+            {
+                // Try again on the next frame
+                count_ = 0;
+            }
+        }
+
+        if (isAccepted)
+        {
+            haveLastTimeStamp_ = true;
+            lastTimeStamp_ = stampedImg.timeStamp;
+            numberAccepted_++;
+        }
+        return isAccepted;
+    }
+
+
+    cv::Mat ImageSubscription::getImage(const cv::Mat &image, bool continuous) const
+    {
+        if (params_.isFullFrame())
+        {
+            return image;
+        }
+        cv::Rect roi = params_.roi & cv::Rect(0, 0, image.cols, image.rows);
+        if (roi.area() == 0)
+        {
+            return image;
+        }
+        cv::Mat roiImage = image(roi);
+        if (continuous && !roiImage.isContinuous())
+        {
+            roiImage = roiImage.clone();
+        }
+        return roiImage;
+    }
+
+
+    StampedImage ImageSubscription::getStampedImage(const StampedImage &stampedImg, bool continuous) const
+    {
+        StampedImage roiStampedImg = stampedImg;
+        roiStampedImg.image = getImage(stampedImg.image, continuous);
+        return roiStampedImg;
+    }
+
+
+    unsigned long ImageSubscription::getNumberAccepted() const
+    {
+        return numberAccepted_;
+    }
+
+} // namespace bias
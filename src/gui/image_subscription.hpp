@@ -0,0 +1,67 @@
+#ifndef BIAS_IMAGE_SUBSCRIPTION_HPP
+#define BIAS_IMAGE_SUBSCRIPTION_HPP
+
+#include "stamped_image.hpp"
+#include <opencv2/core/core.hpp>
+#include <string>
+
+namespace bias
+{
+
+    struct ImageSubscriptionParams
+    {
+        // Frames passed to one consumer of the image dispatcher. A frame is
+        // passed when it is the divisor'th frame since the last one passed
+        // and at least 1/maxFps after it (maxFps = 0 for no limit). An roi
+        // with zero width or height is the full frame.
+        unsigned int divisor;
+        double maxFps;
+        cv::Rect roi;
+        ImageSubscriptionParams();
+        bool isFullRate() const;
+        bool isFullFrame() const;
+        std::string toString();
+    };
+
+
+    class ImageSubscription
+    {
+        // Decimation and roi for one consumer (logging, plugin or display)
+        // applied by the image dispatcher before the frame is queued, so
+        // consumers only receive the frames and pixels they use. Roi images
+        // are views of the grabbed frame (no copy) unless a continuous image
+        // is requested. The roi is clipped to the frame; an roi outside the 
+        // frame gives the full frame.
+        //
+        // Used from the dispatcher thread only.
+
+        public:
+
+            static const unsigned int DEFAULT_DIVISOR;
+            static const double DEFAULT_MAX_FPS;
+
+            ImageSubscription();
+            ImageSubscription(ImageSubscriptionParams params);
+
+            void setParams(ImageSubscriptionParams params);
+            ImageSubscriptionParams getParams() const;
+            void reset();
+
+            bool accept(const StampedImage &stampedImg);
+            cv::Mat getImage(const cv::Mat &image, bool continuous=false) const;
+            StampedImage getStampedImage(const StampedImage &stampedImg, bool continuous=false) const;
+
+            unsigned long getNumberAccepted() const;
+
+        private:
+
+            ImageSubscriptionParams params_;
+            unsigned long count_;
+            unsigned long numberAccepted_;
+            bool haveLastTimeStamp_;
+            double lastTimeStamp_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_IMAGE_SUBSCRIPTION_HPP
@@ -0,0 +1,227 @@
+#include "jpeg_encoder.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <opencv2/highgui/highgui.hpp>
+#include <string>
+
+namespace bias
+{
+    // Constants
+    // -------------------------------------------------------------------------------------------------------
+    const bool JpegEncoder::DEFAULT_FAST_DCT = false;
+    const JpegSubsampling JpegEncoder::DEFAULT_SUBSAMPLING = JPEG_SUBSAMPLING_420;
+    const double JpegEncoder::OUTPUT_BUFFER_MARGIN = 1.25;
+
+    // Public methods
+    // -------------------------------------------------------------------------------------------------------
+
+    JpegEncoder::JpegEncoder() : JpegEncoder(DEFAULT_FAST_DCT, DEFAULT_SUBSAMPLING) 
+    { }
+
+
+    JpegEncoder::JpegEncoder(bool fastDct, JpegSubsampling subsampling)
+    {
+        setFastDct(fastDct);
+        setSubsampling(subsampling);
+        lastEncodedSize_ = 0;
+        compressionParams_.resize(2);
+        compressionParams_[0] = CV_IMWRITE_JPEG_QUALITY;
+        compressionParams_[1] = 0;
+#ifdef WITH_TURBOJPEG
+        handle_ = tjInitCompress();
+#endif
+    }
+
+
+    JpegEncoder::~JpegEncoder()
+    {
+#ifdef WITH_TURBOJPEG
+        if (handle_ != nullptr)
+        {
+            tjDestroy(handle_);
+        }
+#endif
+    }
+
+
+    void JpegEncoder::setFastDct(bool fastDct)
+    {
+        fastDct_ = fastDct;
+    }
+
+
+    bool JpegEncoder::getFastDct() const
+    {
+        return fastDct_;
+    }
+
+
+    void JpegEncoder::setSubsampling(JpegSubsampling subsampling)
+    {
+        if (subsampling < NUMBER_OF_JPEG_SUBSAMPLING)
+        {
+            subsampling_ = subsampling;
+        }
+        else
+        {
+            subsampling_ = DEFAULT_SUBSAMPLING;
+        }
+    }
+
+
+    JpegSubsampling JpegEncoder::getSubsampling() const
+    {
+        return subsampling_;
+    }
+
+
+    void JpegEncoder::encode(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer)
+    {
+        quality = (quality <= 100) ? quality : 100;
+#ifdef WITH_TURBOJPEG
+        if (encodeTurbo(image, quality, jpgBuffer))
+        {
+            return;
+        }
+#endif
+        encodeOpenCV(image, quality, jpgBuffer);
+    }
+
+
+    bool JpegEncoder::haveTurboJpeg()
+    {
+#ifdef WITH_TURBOJPEG
+        return true;
+#else
+        return false;
+#endif
+    }
+
+
+    QString JpegEncoder::subsamplingToString(JpegSubsampling subsampling)
+    {
+        switch (subsampling)
+        {
+            case JPEG_SUBSAMPLING_444:
+                return QString("444");
+
+            case JPEG_SUBSAMPLING_422:
+                return QString("422");
+
+            case JPEG_SUBSAMPLING_420:
+            default:
+                return QString("420");
+        }
+    }
+
+
+    bool JpegEncoder::subsamplingFromString(QString subsamplingString, JpegSubsampling &subsampling)
+    {
+        for (int i=0; i<int(NUMBER_OF_JPEG_SUBSAMPLING); i++)
+        {
+            if (subsamplingString == subsamplingToString(JpegSubsampling(i)))
+            {
+                subsampling = JpegSubsampling(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Private methods
+    // -------------------------------------------------------------------------------------------------------
+
+#ifdef WITH_TURBOJPEG
+    bool JpegEncoder::encodeTurbo(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer)
+    {
+        // Returns false for images libjpeg-turbo can't take directly
+        int pixelFormat;
+        int subsampling = int(subsampling_);
+        if (handle_ == nullptr)
+        {
+            return false;
+        }
+        switch (image.type())
+        {
+            case CV_8UC1:
+                pixelFormat = TJPF_GRAY;
+                subsampling = TJSAMP_GRAY;
+                break;
+
+            case CV_8UC3:
+                pixelFormat = TJPF_BGR;
+                break;
+
+            case CV_8UC4:
+                pixelFormat = TJPF_BGRX;
+                break;
+
+            default:
+                return false;
+        }
+
+        // Sized for the worst case. The buffer is swapped with the caller's
+        // after each frame, so it only regrows when the caller's is smaller.
+        unsigned long maxSize = tjBufSize(image.cols, image.rows, subsampling);
+        if (outputBuffer_.size() < maxSize)
+        {
+            outputBuffer_.resize(size_t(maxSize));
+        }
+
+        int flags = TJFLAG_NOREALLOC;
+        if (fastDct_)
+        {
+            flags |= TJFLAG_FASTDCT;
+        }
+
+        unsigned char *outputBufferPtr = outputBuffer_.data();
+        unsigned long encodedSize = (unsigned long)(outputBuffer_.size());
+        int rval = tjCompress2(
+                handle_, 
+                image.data, 
+                image.cols, 
+                int(image.step), 
+                image.rows, 
+                pixelFormat,
+                &outputBufferPtr, 
+                &encodedSize, 
+                subsampling, 
+                int(quality), 
+                flags
+                );
+        if (rval != 0)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            std::string errorMsg("encoding jpg frame failed - "); 
+            errorMsg += tjGetErrorStr();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        outputBuffer_.resize(size_t(encodedSize));
+        jpgBuffer.swap(outputBuffer_);
+        lastEncodedSize_ = encodedSize;
+        return true;
+    }
+#endif
+
+
+    void JpegEncoder::encodeOpenCV(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer)
+    {
+        // Size the output from the previous frame so imencode doesn't regrow it
+        jpgBuffer.clear();
+        jpgBuffer.reserve(size_t(OUTPUT_BUFFER_MARGIN*lastEncodedSize_));
+        compressionParams_[1] = int(quality);
+        try
+        {
+            cv::imencode(".jpg", image, jpgBuffer, compressionParams_);
+        }
+        catch (cv::Exception &exc)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            std::string errorMsg("encoding jpg frame failed - "); 
+            errorMsg += exc.what();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        lastEncodedSize_ = jpgBuffer.size();
+    }
+
+} // namespace bias
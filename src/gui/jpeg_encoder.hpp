@@ -0,0 +1,79 @@
+#ifndef BIAS_JPEG_ENCODER_HPP
+#define BIAS_JPEG_ENCODER_HPP
+#include <opencv2/core/core.hpp>
+#include <QString>
+#include <vector>
+
+#ifdef WITH_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+namespace bias
+{
+
+    // Chroma subsampling for color images. Values match libjpeg-turbo's TJSAMP.
+    enum JpegSubsampling
+    {
+        JPEG_SUBSAMPLING_444=0,
+        JPEG_SUBSAMPLING_422,
+        JPEG_SUBSAMPLING_420,
+        NUMBER_OF_JPEG_SUBSAMPLING,
+    };
+
+
+    class JpegEncoder
+    {
+        // Reusable jpeg encoder. The codec state and output buffer are kept
+        // between frames so an encoder should be reused by one thread at a
+        // time rather than created per frame. With libjpeg-turbo frames are 
+        // encoded into the output buffer, which is swapped with the caller's
+        // buffer rather than copied.
+        //
+        // With WITH_TURBOJPEG frames are encoded directly with libjpeg-turbo
+        // and the fast DCT and chroma subsampling settings are applied.
+        // Otherwise cv::imencode is used and these settings are ignored.
+
+        public:
+
+            static const bool DEFAULT_FAST_DCT;
+            static const JpegSubsampling DEFAULT_SUBSAMPLING;
+            static const double OUTPUT_BUFFER_MARGIN;
+
+            JpegEncoder();
+            JpegEncoder(bool fastDct, JpegSubsampling subsampling);
+            ~JpegEncoder();
+
+            void setFastDct(bool fastDct);
+            bool getFastDct() const;
+
+            void setSubsampling(JpegSubsampling subsampling);
+            JpegSubsampling getSubsampling() const;
+
+            void encode(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer);
+
+            static bool haveTurboJpeg();
+            static QString subsamplingToString(JpegSubsampling subsampling);
+            static bool subsamplingFromString(QString subsamplingString, JpegSubsampling &subsampling);
+
+        private:
+
+            bool fastDct_;
+            JpegSubsampling subsampling_;
+            size_t lastEncodedSize_;
+            std::vector<int> compressionParams_;
+
+#ifdef WITH_TURBOJPEG
+            tjhandle handle_;
+            std::vector<uchar> outputBuffer_;
+
+            bool encodeTurbo(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer);
+#endif
+            void encodeOpenCV(const cv::Mat &image, unsigned int quality, std::vector<uchar> &jpgBuffer);
+
+            JpegEncoder(const JpegEncoder &) = delete;
+            JpegEncoder &operator=(const JpegEncoder &) = delete;
+    };
+
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "jpeg_quality_controller.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace bias
+{
+    const unsigned int JpegQualityController::UPDATE_INTERVAL_FRAMES = 10;
+    const double JpegQualityController::MIN_UPDATE_INTERVAL = 0.1;
+    const double JpegQualityController::RATE_SMOOTHING = 0.3;
+    const double JpegQualityController::RATE_TOLERANCE = 0.05;
+    const double JpegQualityController::RATE_GAIN = 20.0;
+    const double JpegQualityController::QUEUE_GAIN = 10.0;
+    const double JpegQualityController::QUEUE_LOW_FRACTION = 0.25;
+    const unsigned int JpegQualityController::MAX_QUALITY_STEP = 10;
+
+
+    JpegQualityController::JpegQualityController(
+            unsigned int minQuality,
+            unsigned int maxQuality,
+            double targetBytesPerSec,
+            unsigned int targetQueueSize
+            )
+    {
+        minQuality_ = std::min(minQuality, maxQuality);
+        maxQuality_ = maxQuality;
+        targetBytesPerSec_ = std::max(targetBytesPerSec, 0.0);
+        targetQueueSize_ = targetQueueSize;
+
+        quality_ = maxQuality_;
+        frameCount_ = 0;
+        haveLastUpdate_ = false;
+        lastUpdateTime_ = 0.0;
+        bytesSinceUpdate_ = 0;
+        bytesPerSec_ = 0.0;
+    }
+
+
+    void JpegQualityController::addEncodedFrame(size_t numBytes)
+    {
+        acquireLock();
+        bytesSinceUpdate_ += numBytes;
+        releaseLock();
+    }
+
+
+    unsigned int JpegQualityController::update(double timeStamp, unsigned int queueSize)
+    {
+        // Data rate is measured against frame time stamps, i.e. bytes per
+        // second of recording, and is updated every few frames. 
+        acquireLock();
+        frameCount_++;
+        if (!haveLastUpdate_)
+        {
+            haveLastUpdate_ = true;
+            lastUpdateTime_ = timeStamp;
+            bytesSinceUpdate_ = 0;
+        }
+
+        double dt = timeStamp - lastUpdateTime_;
+        if ((frameCount_ >= UPDATE_INTERVAL_FRAMES) && (dt >= MIN_UPDATE_INTERVAL))
+        {
+            double bytesPerSec = double(bytesSinceUpdate_)/dt;
+            if (bytesPerSec_ > 0.0)
+            {
+                bytesPerSec_ = RATE_SMOOTHING*bytesPerSec + (1.0 - RATE_SMOOTHING)*bytesPerSec_;
+            }
+            else
+            {
+                bytesPerSec_ = bytesPerSec;
+            }
+            bytesSinceUpdate_ = 0;
+            lastUpdateTime_ = timeStamp;
+            frameCount_ = 0;
+
+            // Take the more cautious of the two controllers 
+            int rateStep = getRateStep();
+            int queueStep = getQueueStep(queueSize);
+            int step = 0;
+            if ((targetBytesPerSec_ > 0.0) && (targetQueueSize_ > 0))
+            {
+                step = std::min(rateStep, queueStep);
+            }
+            else if (targetBytesPerSec_ > 0.0)
+            {
+                step = rateStep;
+            }
+            else if (targetQueueSize_ > 0)
+            {
+                step = queueStep;
+            }
+
+            int quality = int(quality_) + step;
+            quality = std::max(quality, int(minQuality_));
+            quality = std::min(quality, int(maxQuality_));
+            quality_ = (unsigned int)(quality);
+        }
+        unsigned int quality = quality_;
+        releaseLock();
+        return quality;
+    }
+
+
+    void JpegQualityController::setMaxQuality(unsigned int maxQuality)
+    {
+        // Upper bound can be lowered while running, e.g. by the logging 
+        // watchdog.
+        acquireLock();
+        maxQuality_ = std::max(maxQuality, minQuality_);
+        quality_ = std::min(quality_, maxQuality_);
+        releaseLock();
+    }
+
+
+    unsigned int JpegQualityController::getQuality()
+    {
+        acquireLock();
+        unsigned int quality = quality_;
+        releaseLock();
+        return quality;
+    }
+
+
+    double JpegQualityController::getBytesPerSec()
+    {
+        acquireLock();
+        double bytesPerSec = bytesPerSec_;
+        releaseLock();
+        return bytesPerSec;
+    }
+
+
+    int JpegQualityController::getRateStep() const
+    {
+        // Step down in proportion to the excess rate, step up by one 
+        if ((targetBytesPerSec_ <= 0.0) || (bytesPerSec_ <= 0.0))
+        {
+            return 0;
+        }
+        double ratio = bytesPerSec_/targetBytesPerSec_;
+        if (ratio > 1.0 + RATE_TOLERANCE)
+        {
+            int step = int(std::ceil(RATE_GAIN*(ratio - 1.0)));
+            return -std::min(step, int(MAX_QUALITY_STEP));
+        }
+        if (ratio < 1.0 - 2.0*RATE_TOLERANCE)
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+
+    int JpegQualityController::getQueueStep(unsigned int queueSize) const
+    {
+        if (targetQueueSize_ == 0)
+        {
+            return 0;
+        }
+        double fraction = double(queueSize)/double(targetQueueSize_);
+        if (fraction > 1.0)
+        {
+            int step = int(std::ceil(QUEUE_GAIN*(fraction - 1.0)));
+            return -std::min(step, int(MAX_QUALITY_STEP));
+        }
+        if (fraction < QUEUE_LOW_FRACTION)
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+} // namespace bias
@@ -0,0 +1,69 @@
+#ifndef BIAS_JPEG_QUALITY_CONTROLLER_HPP
+#define BIAS_JPEG_QUALITY_CONTROLLER_HPP
+#include "lockable.hpp"
+#include <memory>
+#include <cstdint>
+
+namespace bias
+{
+
+    class JpegQualityController : public Lockable<Empty>
+    {
+        // Feedback control of jpeg quality for the jpg video writer. The 
+        // quality is lowered when the encoded data rate exceeds the target 
+        // rate or when the number of frames waiting to be compressed/written
+        // exceeds the target queue size, and is raised again, one step at a 
+        // time, when both are comfortably below target. A target of 0 is 
+        // ignored. The quality always stays within [minQuality, maxQuality].
+        //
+        // update is called by the writer for each new frame, addEncodedFrame
+        // by the compressor threads.
+
+        public:
+
+            static const unsigned int UPDATE_INTERVAL_FRAMES;
+            static const double MIN_UPDATE_INTERVAL;
+            static const double RATE_SMOOTHING;
+            static const double RATE_TOLERANCE;
+            static const double RATE_GAIN;
+            static const double QUEUE_GAIN;
+            static const double QUEUE_LOW_FRACTION;
+            static const unsigned int MAX_QUALITY_STEP;
+
+            JpegQualityController(
+                    unsigned int minQuality,
+                    unsigned int maxQuality,
+                    double targetBytesPerSec,
+                    unsigned int targetQueueSize
+                    );
+
+            void addEncodedFrame(size_t numBytes);
+            unsigned int update(double timeStamp, unsigned int queueSize);
+
+            void setMaxQuality(unsigned int maxQuality);
+            unsigned int getQuality();
+            double getBytesPerSec();
+
+        private:
+
+            unsigned int minQuality_;
+            unsigned int maxQuality_;
+            double targetBytesPerSec_;
+            unsigned int targetQueueSize_;
+
+            unsigned int quality_;
+            unsigned int frameCount_;
+            bool haveLastUpdate_;
+            double lastUpdateTime_;
+            uint64_t bytesSinceUpdate_;
+            double bytesPerSec_;
+
+            int getRateStep() const;
+            int getQueueStep(unsigned int queueSize) const;
+    };
+
+    typedef std::shared_ptr<JpegQualityController> JpegQualityControllerPtr;
+
+} // namespace bias
+
+#endif // #ifndef BIAS_JPEG_QUALITY_CONTROLLER_HPP
@@ -0,0 +1,154 @@
+#include "logging_params.hpp"
+#include "trigger_recorder.hpp"
+#include "logging_watchdog.hpp"
+#include "file_migrator.hpp"
+#include "image_dispatcher.hpp"
+#include <sstream>
+
+namespace bias
+{
+
+    // trigger
+    // ------------------------------------------------------------------------
+    VideoWriterParams_trigger::VideoWriterParams_trigger()
+    {
+        enabled = TriggerRecorder::DEFAULT_ENABLED;
+        preTriggerSec = TriggerRecorder::DEFAULT_PRE_TRIGGER_SEC;
+        postTriggerSec = TriggerRecorder::DEFAULT_POST_TRIGGER_SEC;
+        maxBufferFrames = TriggerRecorder::DEFAULT_MAX_BUFFER_FRAMES;
+        intervalSec = TriggerRecorder::DEFAULT_INTERVAL_SEC;
+    }
+
+
+    std::string VideoWriterParams_trigger::toString()
+    {
+        std::stringstream ss;
+        ss << "enabled: " << std::boolalpha << enabled << std::noboolalpha << std::endl;
+        ss << "preTriggerSec: " << preTriggerSec << std::endl;
+        ss << "postTriggerSec: " << postTriggerSec << std::endl;
+        ss << "maxBufferFrames: " << maxBufferFrames << std::endl;
+        ss << "intervalSec: " << intervalSec << std::endl;
+        return ss.str();
+    }
+
+
+    // watchdog
+    // ------------------------------------------------------------------------
+    VideoWriterParams_watchdog::VideoWriterParams_watchdog()
+    {
+        enabled = LoggingWatchdog::DEFAULT_ENABLED;
+        minFreeBytes = LoggingWatchdog::DEFAULT_MIN_FREE_BYTES;
+        minRemainingSec = LoggingWatchdog::DEFAULT_MIN_REMAINING_SEC;
+        degradeSteps = QStringList();
+    }
+
+
+    std::string VideoWriterParams_watchdog::toString()
+    {
+        std::stringstream ss;
+        ss << "enabled: " << std::boolalpha << enabled << std::noboolalpha << std::endl;
+        ss << "minFreeBytes: " << minFreeBytes << std::endl;
+        ss << "minRemainingSec: " << minRemainingSec << std::endl;
+        ss << "degradeSteps: " << degradeSteps.join(", ").toStdString() << std::endl;
+        return ss.str();
+    }
+
+
+    // staging
+    // ------------------------------------------------------------------------
+    VideoWriterParams_staging::VideoWriterParams_staging()
+    {
+        enabled = FileMigrator::DEFAULT_ENABLED;
+        directory = QString("");
+        maxBytesPerSec = FileMigrator::DEFAULT_MAX_BYTES_PER_SEC;
+        verifyChecksum = FileMigrator::DEFAULT_VERIFY_CHECKSUM;
+    }
+
+
+    std::string VideoWriterParams_staging::toString()
+    {
+        std::stringstream ss;
+        ss << "enabled: " << std::boolalpha << enabled << std::noboolalpha << std::endl;
+        ss << "directory: " << directory.toStdString() << std::endl;
+        ss << "maxBytesPerSec: " << maxBytesPerSec << std::endl;
+        ss << "verifyChecksum: " << std::boolalpha << verifyChecksum << std::noboolalpha << std::endl;
+        return ss.str();
+    }
+
+
+    // stampLog
+    // ------------------------------------------------------------------------
+    VideoWriterParams_stampLog::VideoWriterParams_stampLog()
+    {
+        enabled = ImageDispatcher::DEFAULT_STAMP_LOG_ENABLED;
+    }
+
+
+    std::string VideoWriterParams_stampLog::toString()
+    {
+        std::stringstream ss;
+        ss << "enabled: " << std::boolalpha << enabled << std::noboolalpha << std::endl;
+        return ss.str();
+    }
+
+
+    // VideoWriterParams
+    // ------------------------------------------------------------------------
+    std::string VideoWriterParams::toString()
+    {
+        std::stringstream ss; 
+        std::string sepString = "----------------------------------";
+        ss << "bmp" << std::endl;
+        ss << sepString << std::endl;
+        ss << bmp.toString() << std::endl;
+
+        ss << "jpg" << std::endl;
+        ss << sepString << std::endl;
+        ss << jpg.toString() << std::endl;
+
+        ss << "avi" << std::endl;
+        ss << sepString << std::endl;
+        ss << avi.toString() << std::endl;
+
+        ss << "fmf" << std::endl;
+        ss << sepString << std::endl;
+        ss << fmf.toString() << std::endl;
+
+        ss << "ufmf" << std::endl;
+        ss << sepString << std::endl;
+        ss << ufmf.toString() << std::endl;
+
+        ss << "zfmf" << std::endl;
+        ss << sepString << std::endl;
+        ss << zfmf.toString() << std::endl;
+
+        ss << "rollover" << std::endl;
+        ss << sepString << std::endl;
+        ss << rollover.toString() << std::endl;
+
+        ss << "trigger" << std::endl;
+        ss << sepString << std::endl;
+        ss << trigger.toString() << std::endl;
+
+        ss << "watchdog" << std::endl;
+        ss << sepString << std::endl;
+        ss << watchdog.toString() << std::endl;
+
+        ss << "staging" << std::endl;
+        ss << sepString << std::endl;
+        ss << staging.toString() << std::endl;
+
+        ss << "checkpoint" << std::endl;
+        ss << sepString << std::endl;
+        ss << checkpoint.toString() << std::endl;
+
+        ss << "stampLog" << std::endl;
+        ss << sepString << std::endl;
+        ss << stampLog.toString() << std::endl;
+
+        return ss.str();
+
+    }
+
+
+} // namespace bias
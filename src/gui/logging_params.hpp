@@ -0,0 +1,84 @@
+#ifndef BIAS_LOGGING_PARAMS_HPP
+#define BIAS_LOGGING_PARAMS_HPP
+#include <QString>
+#include <QStringList>
+#include <string>
+#include "video_writer_params.hpp"
+
+namespace bias
+{
+
+    // Logging parameters used by the gui along with those of the video
+    // writers, see video_writer_params.hpp.
+
+    struct VideoWriterParams_trigger
+    {
+        // Pre/post trigger recording, intervalSec = 0 disables timer triggers
+        bool enabled;
+        double preTriggerSec;
+        double postTriggerSec;
+        unsigned long maxBufferFrames;
+        double intervalSec;
+        VideoWriterParams_trigger();
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams_watchdog
+    {
+        // Logging watchdog, degradeSteps are applied in order from the list
+        // "frameSkip", "quality", "ufmf"
+        bool enabled;
+        unsigned long long minFreeBytes;
+        double minRemainingSec;
+        QStringList degradeSteps;
+        VideoWriterParams_watchdog();
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams_staging
+    {
+        // Two tier logging - files are written to the staging directory and 
+        // moved to the video file directory when finished. maxBytesPerSec = 0
+        // disables throttling.
+        bool enabled;
+        QString directory;
+        double maxBytesPerSec;
+        bool verifyChecksum;
+        VideoWriterParams_staging();
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams_stampLog
+    {
+        // Per-frame time stamp sidecar written by the image dispatcher to the
+        // video file directory while capturing
+        bool enabled;
+        VideoWriterParams_stampLog();
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams
+    {
+        VideoWriterParams_bmp bmp;
+        VideoWriterParams_jpg jpg;
+        VideoWriterParams_avi avi;
+        VideoWriterParams_fmf fmf;
+        VideoWriterParams_ufmf ufmf;
+        VideoWriterParams_zfmf zfmf;
+        VideoWriterParams_rollover rollover;
+        VideoWriterParams_trigger trigger;
+        VideoWriterParams_watchdog watchdog;
+        VideoWriterParams_staging staging;
+        VideoWriterParams_checkpoint checkpoint;
+        VideoWriterParams_stampLog stampLog;
+        std::string toString();
+    };
+
+
+} // namespace bias
+
+#endif // #ifndef BIAS_LOGGING_PARAMS_HPP
@@ -3,7 +3,7 @@
 
 #include <QDialog>
 #include "ui_logging_settings_dialog.h"
-#include "video_writer_params.hpp"
+#include "logging_params.hpp"
 
 namespace bias
 {
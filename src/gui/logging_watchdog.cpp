@@ -0,0 +1,259 @@
+#include "logging_watchdog.hpp"
+#include "stamped_image.hpp"
+#include <algorithm>
+
+namespace bias
+{
+    const bool LoggingWatchdog::DEFAULT_ENABLED = true;
+    const unsigned long long LoggingWatchdog::DEFAULT_MIN_FREE_BYTES = 1024ULL*1024ULL*1024ULL;
+    const double LoggingWatchdog::DEFAULT_MIN_REMAINING_SEC = 600.0;
+    const double LoggingWatchdog::CHECK_INTERVAL = 1.0;
+    const double LoggingWatchdog::DEGRADE_HOLD_SEC = 10.0;
+    const double LoggingWatchdog::QUEUE_WARNING_FRACTION = 0.25;
+    const QString LoggingWatchdog::DEGRADE_STEP_FRAME_SKIP("frameSkip");
+    const QString LoggingWatchdog::DEGRADE_STEP_QUALITY("quality");
+    const QString LoggingWatchdog::DEGRADE_STEP_UFMF("ufmf");
+
+    enum LoggingWatchdogWarning
+    {
+        WATCHDOG_WARNING_NONE=0,
+        WATCHDOG_WARNING_QUEUE,
+        WATCHDOG_WARNING_DISK_SPACE,
+        WATCHDOG_WARNING_PLANNED_DURATION,
+    };
+
+
+    // LoggingWatchdogStatus
+    // ----------------------------------------------------------------------------------
+    LoggingWatchdogStatus::LoggingWatchdogStatus()
+    {
+        warning = false;
+        framesPerSec = 0.0;
+        writeFramesPerSec = 0.0;
+        requiredBytesPerSec = 0.0;
+        achievedBytesPerSec = 0.0;
+        freeBytes = 0;
+        remainingSec = -1.0;
+        queueSize = 0;
+        degradeLevel = 0;
+    }
+
+
+    // LoggingWatchdog
+    // ----------------------------------------------------------------------------------
+    LoggingWatchdog::LoggingWatchdog(
+            VideoWriterParams_watchdog params,
+            QString videoFileDir,
+            VideoFileFormat videoFileFormat,
+            double plannedDurationSec
+            )
+    {
+        params_ = params;
+        storageInfo_.setPath(videoFileDir);
+        compressionEstimate_ = getCompressionEstimate(videoFileFormat);
+        plannedDurationSec_ = plannedDurationSec;
+
+        isFirst_ = true;
+        firstTimeStamp_ = 0.0;
+        lastCheckTime_ = 0.0;
+        lastDegradeTime_ = 0.0;
+        framesSinceCheck_ = 0;
+        lastBytesWritten_ = 0;
+        imageBytes_ = 0.0;
+        lastQueueSize_ = 0;
+        lastWarningType_ = WATCHDOG_WARNING_NONE;
+    }
+
+
+    LoggingWatchdogAction LoggingWatchdog::update(
+            const StampedImage &stampedImg,
+            unsigned int queueSize,
+            unsigned int maxQueueSize,
+            uint64_t bytesWritten
+            )
+    {
+        if (isFirst_)
+        {
+            isFirst_ = false;
+            firstTimeStamp_ = stampedImg.timeStamp;
+            lastCheckTime_ = stampedImg.timeStamp;
+            lastDegradeTime_ = stampedImg.timeStamp - DEGRADE_HOLD_SEC;
+            lastCheckDateTime_ = QDateTime::currentDateTime();
+            lastBytesWritten_ = bytesWritten;
+            imageBytes_ = double(stampedImg.image.total()*stampedImg.image.elemSize());
+            return WATCHDOG_ACTION_NONE;
+        }
+
+        framesSinceCheck_++;
+        if (stampedImg.timeStamp - lastCheckTime_ < CHECK_INTERVAL)
+        {
+            return WATCHDOG_ACTION_NONE;
+        }
+        return check(stampedImg.timeStamp, queueSize, maxQueueSize, bytesWritten);
+    }
+
+
+    void LoggingWatchdog::setDegradeLevel(unsigned int degradeLevel)
+    {
+        // Number of degrade steps used by the logger
+        acquireLock();
+        status_.degradeLevel = degradeLevel;
+        releaseLock();
+    }
+
+
+    VideoWriterParams_watchdog LoggingWatchdog::getParams() const
+    {
+        return params_;
+    }
+
+
+    LoggingWatchdogStatus LoggingWatchdog::getStatus()
+    {
+        acquireLock();
+        LoggingWatchdogStatus status = status_;
+        releaseLock();
+        return status;
+    }
+
+
+    QString LoggingWatchdog::getMessage()
+    {
+        acquireLock();
+        QString message = status_.message;
+        releaseLock();
+        return message;
+    }
+
+
+    double LoggingWatchdog::getCompressionEstimate(VideoFileFormat videoFileFormat)
+    {
+        // Rough encoded size relative to the raw image, used until the
+        // writer reports the bytes it has written.
+        switch (videoFileFormat)
+        {
+            case VIDEOFILE_FORMAT_UFMF:
+            case VIDEOFILE_FORMAT_JPG:
+                return 0.1;
+
+            case VIDEOFILE_FORMAT_AVI:
+                return 0.05;
+
+            case VIDEOFILE_FORMAT_ZFMF:
+                return 0.5;
+
+            default:
+                return 1.0;
+        }
+    }
+
+
+    // Private methods
+    // ----------------------------------------------------------------------------------
+    LoggingWatchdogAction LoggingWatchdog::check(
+            double timeStamp,
+            unsigned int queueSize,
+            unsigned int maxQueueSize,
+            uint64_t bytesWritten
+            )
+    {
+        QDateTime currentDateTime = QDateTime::currentDateTime();
+        double dt = timeStamp - lastCheckTime_;
+        double wallDt = std::max(0.001*double(lastCheckDateTime_.msecsTo(currentDateTime)), 0.001);
+        double frames = double(framesSinceCheck_);
+
+        // Rates - camera rate from the frame time stamps, writer rates from
+        // the wall clock. Frame skip is included in the measured bytes.
+        LoggingWatchdogStatus status = getStatus();
+        status.framesPerSec = frames/dt;
+        status.writeFramesPerSec = frames/wallDt;
+        double bytesPerFrame = imageBytes_*compressionEstimate_;
+        if (bytesWritten > lastBytesWritten_)
+        {
+            bytesPerFrame = double(bytesWritten - lastBytesWritten_)/frames;
+        }
+        status.requiredBytesPerSec = status.framesPerSec*bytesPerFrame;
+        status.achievedBytesPerSec = status.writeFramesPerSec*bytesPerFrame;
+        status.queueSize = queueSize;
+
+        storageInfo_.refresh();
+        status.remainingSec = -1.0;
+        status.freeBytes = 0;
+        if (storageInfo_.isValid())
+        {
+            status.freeBytes = uint64_t(std::max(storageInfo_.bytesAvailable(), qint64(0)));
+            if (status.requiredBytesPerSec > 0.0)
+            {
+                status.remainingSec = double(status.freeBytes)/status.requiredBytesPerSec;
+            }
+        }
+
+        // Queue filling up comes first - frames will be lost within seconds
+        int warningType = WATCHDOG_WARNING_NONE;
+        QString message;
+        double captureLeftSec = plannedDurationSec_ - (timeStamp - firstTimeStamp_);
+        bool haveRemaining = (status.remainingSec >= 0.0);
+
+        if ((queueSize > QUEUE_WARNING_FRACTION*maxQueueSize) && (queueSize > lastQueueSize_))
+        {
+            warningType = WATCHDOG_WARNING_QUEUE;
+            message = QString("logging falling behind: queue %1 frames, writing %2 of %3 frames/sec")
+                .arg(queueSize)
+                .arg(status.writeFramesPerSec, 0, 'f', 1)
+                .arg(status.framesPerSec, 0, 'f', 1);
+        }
+        else if (
+                (storageInfo_.isValid() && (status.freeBytes < params_.minFreeBytes)) ||
+                (haveRemaining && (status.remainingSec < params_.minRemainingSec))
+                )
+        {
+            warningType = WATCHDOG_WARNING_DISK_SPACE;
+            message = QString("low disk space: %1 MB free, about %2 min remaining")
+                .arg(status.freeBytes/(1024*1024))
+                .arg(status.remainingSec/60.0, 0, 'f', 1);
+        }
+        else if ((plannedDurationSec_ > 0.0) && haveRemaining && (status.remainingSec < captureLeftSec))
+        {
+            warningType = WATCHDOG_WARNING_PLANNED_DURATION;
+            message = QString("disk will be full before the end of capture: about %1 of %2 min remaining")
+                .arg(status.remainingSec/60.0, 0, 'f', 1)
+                .arg(captureLeftSec/60.0, 0, 'f', 1);
+        }
+        status.warning = (warningType != WATCHDOG_WARNING_NONE);
+        if (status.warning)
+        {
+            status.message = message;
+        }
+
+        acquireLock();
+        status_ = status;
+        releaseLock();
+
+        lastCheckTime_ = timeStamp;
+        lastCheckDateTime_ = currentDateTime;
+        lastBytesWritten_ = bytesWritten;
+        lastQueueSize_ = queueSize;
+        framesSinceCheck_ = 0;
+
+        // Degrade while there are steps left, giving each step time to act
+        int lastWarningType = lastWarningType_;
+        lastWarningType_ = warningType;
+        if (!status.warning)
+        {
+            return WATCHDOG_ACTION_NONE;
+        }
+        unsigned int numDegradeSteps = (unsigned int)(params_.degradeSteps.size());
+        bool haveSteps = (status.degradeLevel < numDegradeSteps);
+        if (haveSteps && (timeStamp - lastDegradeTime_ >= DEGRADE_HOLD_SEC))
+        {
+            lastDegradeTime_ = timeStamp;
+            return WATCHDOG_ACTION_DEGRADE;
+        }
+        if (warningType != lastWarningType)
+        {
+            return WATCHDOG_ACTION_WARNING;
+        }
+        return WATCHDOG_ACTION_NONE;
+    }
+
+} // namespace bias
@@ -0,0 +1,122 @@
+#ifndef BIAS_LOGGING_WATCHDOG_HPP
+#define BIAS_LOGGING_WATCHDOG_HPP
+
+#include "lockable.hpp"
+#include "basic_types.hpp"
+#include "logging_params.hpp"
+#include <QString>
+#include <QDateTime>
+#include <QStorageInfo>
+#include <cstdint>
+
+namespace bias
+{
+
+    struct StampedImage;
+
+    enum LoggingWatchdogAction
+    {
+        WATCHDOG_ACTION_NONE=0,
+        WATCHDOG_ACTION_WARNING,
+        WATCHDOG_ACTION_DEGRADE,
+    };
+
+
+    struct LoggingWatchdogStatus
+    {
+        bool warning;
+        QString message;
+        double framesPerSec;             // camera frame rate
+        double writeFramesPerSec;        // frames taken from the log queue
+        double requiredBytesPerSec;      // data rate needed to keep up
+        double achievedBytesPerSec;      // data rate accepted by the writer
+        uint64_t freeBytes;
+        double remainingSec;             // until the disk is full
+        unsigned int queueSize;
+        unsigned int degradeLevel;
+        LoggingWatchdogStatus();
+    };
+
+
+    class LoggingWatchdog : public Lockable<Empty>
+    {
+        // Watches a logging run from the image logger thread. update is
+        // called for every frame taken from the log queue. Once per check
+        // interval (camera time) the camera frame rate, the rate at which the
+        // writer takes frames and bytes, and the free space on the video
+        // file's disk are measured. The bytes needed per frame are estimated
+        // from the image size and format until the writer reports bytes.
+        //
+        // update returns a warning when the disk will be full within
+        // minRemainingSec, before the end of a timed capture, or the log
+        // queue is filling up, and asks for the logging to be degraded (see
+        // VideoWriterParams_watchdog::degradeSteps) before frames are lost.
+        // Warnings are only returned when the warning changes.
+
+        public:
+
+            static const bool DEFAULT_ENABLED;
+            static const unsigned long long DEFAULT_MIN_FREE_BYTES;
+            static const double DEFAULT_MIN_REMAINING_SEC;
+            static const double CHECK_INTERVAL;
+            static const double DEGRADE_HOLD_SEC;
+            static const double QUEUE_WARNING_FRACTION;
+            static const QString DEGRADE_STEP_FRAME_SKIP;
+            static const QString DEGRADE_STEP_QUALITY;
+            static const QString DEGRADE_STEP_UFMF;
+
+            LoggingWatchdog(
+                    VideoWriterParams_watchdog params,
+                    QString videoFileDir,
+                    VideoFileFormat videoFileFormat,
+                    double plannedDurationSec=0.0
+                    );
+
+            LoggingWatchdogAction update(
+                    const StampedImage &stampedImg,
+                    unsigned int queueSize,
+                    unsigned int maxQueueSize,
+                    uint64_t bytesWritten
+                    );
+            void setDegradeLevel(unsigned int degradeLevel);
+
+            VideoWriterParams_watchdog getParams() const;
+            LoggingWatchdogStatus getStatus();
+            QString getMessage();
+
+            static double getCompressionEstimate(VideoFileFormat videoFileFormat);
+
+        private:
+
+            VideoWriterParams_watchdog params_;
+            QStorageInfo storageInfo_;
+            double compressionEstimate_;
+            double plannedDurationSec_;
+
+            bool isFirst_;
+            double firstTimeStamp_;
+            double lastCheckTime_;
+            double lastDegradeTime_;
+            QDateTime lastCheckDateTime_;
+            unsigned long framesSinceCheck_;
+            uint64_t lastBytesWritten_;
+            double imageBytes_;
+            unsigned int lastQueueSize_;
+            int lastWarningType_;
+
+            // use lock when setting these values
+            // -----------------------------------
+            LoggingWatchdogStatus status_;
+            // -----------------------------------
+
+            LoggingWatchdogAction check(
+                    double timeStamp,
+                    unsigned int queueSize,
+                    unsigned int maxQueueSize,
+                    uint64_t bytesWritten
+                    );
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_LOGGING_WATCHDOG_HPP
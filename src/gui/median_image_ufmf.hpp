@@ -0,0 +1,18 @@
+#ifndef BIAS_MEDIAN_IMAGE_UFMF_HPP
+#define BIAS_MEDIAN_IMAGE_UFMF_HPP
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace bias
+{
+    struct MedianImage_ufmf
+    {
+        // Background median image passed from the median thread to the writer, 
+        // where it is written as a keyframe. When keyframe compression is 
+        // enabled codedData holds the coded image data (see UfmfCodec).
+        cv::Mat image;
+        std::vector<char> codedData;
+    };
+}
+
+#endif // #ifndef BIAS_MEDIAN_IMAGE_UFMF_HPP
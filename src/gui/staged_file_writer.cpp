@@ -0,0 +1,796 @@
+#include "staged_file_writer.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include "file_preallocate.hpp"
+#include <QThread>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace bias
+{
+    const size_t StagedFileWriter::DEFAULT_BUFFER_SIZE = 4*1024*1024;
+    const unsigned int StagedFileWriter::DEFAULT_NUMBER_OF_BUFFERS = 3;
+    const unsigned int StagedFileWriter::MIN_NUMBER_OF_BUFFERS = 2;
+    const size_t StagedFileWriter::DIRECT_IO_ALIGNMENT = 4096;
+
+
+    // StagedWriteJob
+    // ----------------------------------------------------------------------------------
+    StagedWriteJob::StagedWriteJob()
+    {
+        type = STAGED_JOB_STOP;
+        bufferIndex = 0;
+        offset = 0;
+        size = 0;
+    }
+
+
+    // StagedFileWriter
+    // ----------------------------------------------------------------------------------
+    StagedFileWriter::StagedFileWriter()
+    {
+        initialize(DEFAULT_BUFFER_SIZE, DEFAULT_NUMBER_OF_BUFFERS);
+    }
+
+
+    StagedFileWriter::StagedFileWriter(size_t bufferSize, unsigned int numberOfBuffers)
+    {
+        initialize(bufferSize, numberOfBuffers);
+    }
+
+
+    StagedFileWriter::~StagedFileWriter()
+    {
+        if (isOpen_)
+        {
+            try
+            {
+                close();
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                std::cout << "warning: " << runtimeError.what() << std::endl;
+            }
+        }
+        freeBuffers();
+    }
+
+
+    void StagedFileWriter::initialize(size_t bufferSize, unsigned int numberOfBuffers)
+    {
+        // Buffers are a multiple of the direct I/O alignment so that every full
+        // buffer starts and ends on an aligned file offset.
+        bufferSize_ = DIRECT_IO_ALIGNMENT*((bufferSize + DIRECT_IO_ALIGNMENT - 1)/DIRECT_IO_ALIGNMENT);
+        if (bufferSize_ == 0)
+        {
+            bufferSize_ = DIRECT_IO_ALIGNMENT;
+        }
+        numberOfBuffers_ = (numberOfBuffers < MIN_NUMBER_OF_BUFFERS) ? MIN_NUMBER_OF_BUFFERS : numberOfBuffers;
+
+        isOpen_ = false;
+        directIo_ = false;
+        fd_ = -1;
+        patchFd_ = -1;
+        readFd_ = -1;
+        journalFd_ = -1;
+        preallocateSize_ = 0;
+        currentBuffer_ = 0;
+        currentFill_ = 0;
+        currentOffset_ = 0;
+        running_ = false;
+        numJobsPending_ = 0;
+        errorFlag_ = false;
+
+        setAutoDelete(false);
+    }
+
+
+    void StagedFileWriter::open(QString fileName, bool directIo)
+    {
+        if (isOpen_)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("staged file writer is already open");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        fileName_ = fileName;
+        directIo_ = false;
+        std::string fileNameStd = fileName.toStdString();
+
+#ifdef WIN32
+        fd_ = _open(fileNameStd.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+        patchFd_ = fd_;
+        if (directIo)
+        {
+            std::cout << "warning: direct I/O not supported, using buffered writes" << std::endl;
+        }
+#else
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+        if (directIo)
+        {
+            fd_ = ::open(fileNameStd.c_str(), flags | O_DIRECT, 0644);
+            if (fd_ >= 0)
+            {
+                directIo_ = true;
+            }
+            else if (errno == EINVAL)
+            {
+                // File system doesn't support O_DIRECT
+                std::cout << "warning: direct I/O not supported for " << fileNameStd;
+                std::cout << ", using buffered writes" << std::endl;
+            }
+        }
+#else
+        if (directIo)
+        {
+            std::cout << "warning: direct I/O not supported, using buffered writes" << std::endl;
+        }
+#endif
+        if (!directIo_)
+        {
+            fd_ = ::open(fileNameStd.c_str(), flags, 0644);
+            patchFd_ = fd_;
+        }
+        else
+        {
+            // Patches of already written data are small and unaligned - they go
+            // through a second, buffered, descriptor.
+            patchFd_ = ::open(fileNameStd.c_str(), O_WRONLY);
+        }
+#endif
+
+        if ((fd_ < 0) || (patchFd_ < 0))
+        {
+            std::string sysErrorMsg(std::strerror(errno));
+            closeFiles();
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("staged file writer unable to open file:\n\n");
+            errorMsg += fileNameStd + std::string(", ") + sysErrorMsg;
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        allocateBuffers();
+
+        jobQueue_.acquireLock();
+        jobQueue_.clear();
+        jobQueue_.releaseLock();
+
+        freeQueue_.acquireLock();
+        freeQueue_.clear();
+        for (unsigned int i=1; i<numberOfBuffers_; i++)
+        {
+            freeQueue_.push(i);
+        }
+        freeQueue_.releaseLock();
+
+        currentBuffer_ = 0;
+        currentFill_ = 0;
+        currentOffset_ = 0;
+        preallocateSize_ = 0;
+
+        // Set running here rather than in run so that close can't miss the
+        // writer thread if it hasn't been scheduled yet.
+        acquireLock();
+        running_ = true;
+        numJobsPending_ = 0;
+        errorFlag_ = false;
+        errorMsg_ = std::string("");
+        releaseLock();
+
+        isOpen_ = true;
+    }
+
+
+    void StagedFileWriter::write(const void *data, size_t size)
+    {
+        const char *srcPtr = (const char *) data;
+        while (size > 0)
+        {
+            size_t numToCopy = bufferSize_ - currentFill_;
+            if (numToCopy > size)
+            {
+                numToCopy = size;
+            }
+            std::memcpy(bufferPtrVec_[currentBuffer_] + currentFill_, srcPtr, numToCopy);
+            currentFill_ += numToCopy;
+            srcPtr += numToCopy;
+            size -= numToCopy;
+
+            if (currentFill_ == bufferSize_)
+            {
+                submitCurrentBuffer(bufferSize_);
+            }
+        }
+    }
+
+
+    void StagedFileWriter::writePatch(uint64_t pos, const void *data, size_t size)
+    {
+        // Overwrite data which has already been written, e.g. header fields
+        // which aren't known until the end of the file.
+        if (pos + size > tell())
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            std::string errorMsg("staged file writer patch extends past end of file");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        const char *srcPtr = (const char *) data;
+
+        if (pos < currentOffset_)
+        {
+            // Part of patch is in buffers which have been submitted - queue it
+            // so that it is applied after those buffers have been written.
+            size_t numToQueue = size;
+            if (pos + size > currentOffset_)
+            {
+                numToQueue = size_t(currentOffset_ - pos);
+            }
+            StagedWriteJob job;
+            job.type = STAGED_JOB_PATCH;
+            job.offset = pos;
+            job.size = numToQueue;
+            job.patchData.assign(srcPtr, srcPtr + numToQueue);
+            pushJob(job);
+
+            pos += numToQueue;
+            srcPtr += numToQueue;
+            size -= numToQueue;
+        }
+
+        if (size > 0)
+        {
+            // Remainder of patch is still in the current staging buffer
+            size_t bufferPos = size_t(pos - currentOffset_);
+            std::memcpy(bufferPtrVec_[currentBuffer_] + bufferPos, srcPtr, size);
+        }
+    }
+
+
+    void StagedFileWriter::read(uint64_t pos, void *data, size_t size)
+    {
+        // Read back data which has already been written, e.g. to merge index
+        // chunks at close. 
+        if (pos + size > tell())
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_FINISH;
+            std::string errorMsg("staged file writer read extends past end of file");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        char *dstPtr = (char *) data;
+
+        if (pos < currentOffset_)
+        {
+            // Part of the data has been submitted - wait until it is on disk
+            size_t numToRead = size;
+            if (pos + size > currentOffset_)
+            {
+                numToRead = size_t(currentOffset_ - pos);
+            }
+            waitForJobs();
+
+            if (readFd_ < 0)
+            {
+#ifdef WIN32
+                readFd_ = _open(fileName_.toStdString().c_str(), _O_RDONLY | _O_BINARY);
+#else
+                readFd_ = ::open(fileName_.toStdString().c_str(), O_RDONLY);
+#endif
+            }
+
+            bool readOk = (readFd_ >= 0);
+            uint64_t readPos = pos;
+            char *readPtr = dstPtr;
+            size_t numLeft = numToRead;
+#ifdef WIN32
+            readOk = readOk && (_lseeki64(readFd_, (__int64)(readPos), SEEK_SET) >= 0);
+#endif
+            while (readOk && (numLeft > 0))
+            {
+#ifdef WIN32
+                int numRead = _read(readFd_, readPtr, (unsigned int)(numLeft));
+#else
+                ssize_t numRead = pread(readFd_, readPtr, numLeft, off_t(readPos));
+                if ((numRead < 0) && (errno == EINTR))
+                {
+                    continue;
+                }
+#endif
+                if (numRead <= 0)
+                {
+                    readOk = false;
+                    break;
+                }
+                readPtr += numRead;
+                readPos += numRead;
+                numLeft -= numRead;
+            }
+            if (!readOk)
+            {
+                unsigned int errorId = ERROR_VIDEO_WRITER_FINISH;
+                std::string errorMsg("staged file writer unable to read back data");
+                throw RuntimeError(errorId, errorMsg);
+            }
+
+            pos += numToRead;
+            dstPtr += numToRead;
+            size -= numToRead;
+        }
+
+        if (size > 0)
+        {
+            size_t bufferPos = size_t(pos - currentOffset_);
+            std::memcpy(dstPtr, bufferPtrVec_[currentBuffer_] + bufferPos, size);
+        }
+    }
+
+
+    uint64_t StagedFileWriter::tell() const
+    {
+        return currentOffset_ + currentFill_;
+    }
+
+
+    bool StagedFileWriter::preallocate(uint64_t numBytes)
+    {
+        // Reserves disk space for a file of numBytes. Whatever isn't used is 
+        // released again on close.
+        if ((!isOpen_) || (numBytes <= tell()))
+        {
+            return false;
+        }
+        bool rtnVal = preallocateFile(patchFd_, tell(), numBytes);
+        if (rtnVal)
+        {
+            preallocateSize_ = numBytes;
+        }
+        return rtnVal;
+    }
+
+
+    void StagedFileWriter::openJournal(QString journalFileName)
+    {
+        if ((!isOpen_) || (journalFd_ >= 0))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("staged file writer journal requires an open file without a journal");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        std::string journalFileNameStd = journalFileName.toStdString();
+#ifdef WIN32
+        journalFd_ = _open(journalFileNameStd.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        journalFd_ = ::open(journalFileNameStd.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (journalFd_ < 0)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("staged file writer unable to open journal:\n\n");
+            errorMsg += journalFileNameStd + std::string(", ") + std::strerror(errno);
+            throw RuntimeError(errorId, errorMsg);
+        }
+        journalFileName_ = journalFileName;
+    }
+
+
+    void StagedFileWriter::checkpoint(const std::vector<char> &record)
+    {
+        // Queued behind the buffers and patches submitted so far, so the
+        // writer thread syncs exactly those before writing the record. Data
+        // still in the current staging buffer isn't covered - callers use
+        // getSubmittedSize to describe the checkpoint.
+        if ((journalFd_ < 0) || record.empty())
+        {
+            return;
+        }
+        StagedWriteJob job;
+        job.type = STAGED_JOB_CHECKPOINT;
+        job.size = record.size();
+        job.patchData = record;
+        pushJob(job);
+        checkError(ERROR_VIDEO_WRITER_ADD_FRAME);
+    }
+
+
+    uint64_t StagedFileWriter::getSubmittedSize() const
+    {
+        return currentOffset_;
+    }
+
+
+    void StagedFileWriter::close()
+    {
+        if (!isOpen_)
+        {
+            return;
+        }
+
+        // Submit partially filled buffer. For direct I/O this is padded out
+        // to the alignment and the file is truncated afterwards.
+        uint64_t fileSize = tell();
+        size_t submitSize = currentFill_;
+        if (directIo_)
+        {
+            submitSize = DIRECT_IO_ALIGNMENT*((currentFill_ + DIRECT_IO_ALIGNMENT - 1)/DIRECT_IO_ALIGNMENT);
+            std::memset(bufferPtrVec_[currentBuffer_] + currentFill_, 0, submitSize - currentFill_);
+        }
+        if (submitSize > 0)
+        {
+            StagedWriteJob job;
+            job.type = STAGED_JOB_BUFFER;
+            job.bufferIndex = currentBuffer_;
+            job.offset = currentOffset_;
+            job.size = submitSize;
+            pushJob(job);
+        }
+
+        // Stop writer thread and wait for it to finish all queued jobs
+        StagedWriteJob stopJob;
+        stopJob.type = STAGED_JOB_STOP;
+        pushJob(stopJob);
+
+        acquireLock();
+        while (running_)
+        {
+            runningWaitCond_.wait(&mutex_);
+        }
+        releaseLock();
+
+        if (submitSize != currentFill_)
+        {
+#ifdef WIN32
+            int rtnVal = _chsize_s(patchFd_, (__int64)(fileSize));
+#else
+            int rtnVal = ftruncate(patchFd_, off_t(fileSize));
+#endif
+            if (rtnVal != 0)
+            {
+                setError(std::string("unable to truncate file: ") + std::strerror(errno));
+            }
+        }
+
+        if (preallocateSize_ > fileSize)
+        {
+            releasePreallocation(patchFd_);
+        }
+        preallocateSize_ = 0;
+
+        closeFiles();
+        isOpen_ = false;
+        currentFill_ = 0;
+
+        // File is complete - the journal is only needed for recovery
+        acquireLock();
+        bool errorFlag = errorFlag_;
+        releaseLock();
+        if (!journalFileName_.isEmpty() && !errorFlag)
+        {
+            std::remove(journalFileName_.toStdString().c_str());
+        }
+        journalFileName_ = QString();
+
+        checkError(ERROR_VIDEO_WRITER_FINISH);
+    }
+
+
+    bool StagedFileWriter::isOpen() const
+    {
+        return isOpen_;
+    }
+
+
+    bool StagedFileWriter::isDirectIo() const
+    {
+        return directIo_;
+    }
+
+
+    QString StagedFileWriter::getFileName() const
+    {
+        return fileName_;
+    }
+
+
+    void StagedFileWriter::allocateBuffers()
+    {
+        if (!bufferPtrVec_.empty())
+        {
+            return;
+        }
+        for (unsigned int i=0; i<numberOfBuffers_; i++)
+        {
+            void *bufferPtr = nullptr;
+#ifdef WIN32
+            bufferPtr = _aligned_malloc(bufferSize_, DIRECT_IO_ALIGNMENT);
+#else
+            if (posix_memalign(&bufferPtr, DIRECT_IO_ALIGNMENT, bufferSize_) != 0)
+            {
+                bufferPtr = nullptr;
+            }
+#endif
+            if (bufferPtr == nullptr)
+            {
+                freeBuffers();
+                closeFiles();
+                unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+                std::string errorMsg("staged file writer unable to allocate buffers");
+                throw RuntimeError(errorId, errorMsg);
+            }
+            bufferPtrVec_.push_back((char *) bufferPtr);
+        }
+    }
+
+
+    void StagedFileWriter::freeBuffers()
+    {
+        for (unsigned int i=0; i<bufferPtrVec_.size(); i++)
+        {
+#ifdef WIN32
+            _aligned_free(bufferPtrVec_[i]);
+#else
+            std::free(bufferPtrVec_[i]);
+#endif
+        }
+        bufferPtrVec_.clear();
+    }
+
+
+    void StagedFileWriter::submitCurrentBuffer(size_t size)
+    {
+        StagedWriteJob job;
+        job.type = STAGED_JOB_BUFFER;
+        job.bufferIndex = currentBuffer_;
+        job.offset = currentOffset_;
+        job.size = size;
+        pushJob(job);
+
+        currentOffset_ += size;
+        currentFill_ = 0;
+
+        // Get next free buffer - waits if all buffers are in flight
+        freeQueue_.acquireLock();
+        while (freeQueue_.empty())
+        {
+            freeQueue_.waitIfEmpty();
+        }
+        currentBuffer_ = freeQueue_.front();
+        freeQueue_.pop();
+        freeQueue_.releaseLock();
+
+        checkError(ERROR_VIDEO_WRITER_ADD_FRAME);
+    }
+
+
+    void StagedFileWriter::pushJob(const StagedWriteJob &job)
+    {
+        acquireLock();
+        numJobsPending_++;
+        releaseLock();
+
+        jobQueue_.acquireLock();
+        jobQueue_.push(job);
+        jobQueue_.wakeOne();
+        jobQueue_.releaseLock();
+    }
+
+
+    void StagedFileWriter::checkError(unsigned int errorId)
+    {
+        acquireLock();
+        bool errorFlag = errorFlag_;
+        std::string errorMsg = errorMsg_;
+        releaseLock();
+
+        if (errorFlag)
+        {
+            std::string msg("staged file writer error:\n\n");
+            msg += errorMsg;
+            throw RuntimeError(errorId, msg);
+        }
+    }
+
+
+    void StagedFileWriter::waitForJobs()
+    {
+        acquireLock();
+        while (running_ && (numJobsPending_ > 0))
+        {
+            runningWaitCond_.wait(&mutex_);
+        }
+        releaseLock();
+    }
+
+
+    void StagedFileWriter::closeFiles()
+    {
+#ifdef WIN32
+        if (readFd_ >= 0) { _close(readFd_); }
+        if (journalFd_ >= 0) { _close(journalFd_); }
+        if (fd_ >= 0) { _close(fd_); }
+#else
+        if (readFd_ >= 0) { ::close(readFd_); }
+        if (journalFd_ >= 0) { ::close(journalFd_); }
+        if ((patchFd_ >= 0) && (patchFd_ != fd_)) { ::close(patchFd_); }
+        if (fd_ >= 0) { ::close(fd_); }
+#endif
+        fd_ = -1;
+        patchFd_ = -1;
+        readFd_ = -1;
+        journalFd_ = -1;
+    }
+
+
+    bool StagedFileWriter::writeAt(int fd, const char *data, size_t size, uint64_t offset)
+    {
+#ifdef WIN32
+        if (_lseeki64(fd, (__int64)(offset), SEEK_SET) < 0)
+        {
+            return false;
+        }
+        while (size > 0)
+        {
+            int numWritten = _write(fd, data, (unsigned int)(size));
+            if (numWritten <= 0)
+            {
+                return false;
+            }
+            data += numWritten;
+            size -= numWritten;
+        }
+#else
+        while (size > 0)
+        {
+            ssize_t numWritten = pwrite(fd, data, size, off_t(offset));
+            if (numWritten < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += numWritten;
+            offset += numWritten;
+            size -= numWritten;
+        }
+#endif
+        return true;
+    }
+
+
+    bool StagedFileWriter::syncFile(int fd)
+    {
+#ifdef WIN32
+        return (_commit(fd) == 0);
+#else
+        int rtnVal = fsync(fd);
+        while ((rtnVal != 0) && (errno == EINTR))
+        {
+            rtnVal = fsync(fd);
+        }
+        return (rtnVal == 0);
+#endif
+    }
+
+
+    void StagedFileWriter::setError(std::string msg)
+    {
+        acquireLock();
+        if (!errorFlag_)
+        {
+            errorFlag_ = true;
+            errorMsg_ = msg;
+        }
+        releaseLock();
+    }
+
+
+    void StagedFileWriter::run()
+    {
+        bool done = false;
+        bool errorFlag = false;
+
+        QThread *thisThread = QThread::currentThread();
+        thisThread -> setPriority(QThread::NormalPriority);
+
+        while (!done)
+        {
+            StagedWriteJob job;
+
+            jobQueue_.acquireLock();
+            jobQueue_.waitIfEmpty();
+            if (jobQueue_.empty())
+            {
+                jobQueue_.releaseLock();
+                continue;
+            }
+            job = jobQueue_.front();
+            jobQueue_.pop();
+            jobQueue_.releaseLock();
+
+            switch (job.type)
+            {
+                case STAGED_JOB_BUFFER:
+                    if (!errorFlag)
+                    {
+                        if (!writeAt(fd_, bufferPtrVec_[job.bufferIndex], job.size, job.offset))
+                        {
+                            setError(std::string("write failed: ") + std::strerror(errno));
+                            errorFlag = true;
+                        }
+                    }
+                    // Always return the buffer so the producer can't deadlock
+                    freeQueue_.acquireLock();
+                    freeQueue_.push(job.bufferIndex);
+                    freeQueue_.wakeOne();
+                    freeQueue_.releaseLock();
+                    break;
+
+                case STAGED_JOB_PATCH:
+                    if (!errorFlag)
+                    {
+                        if (!writeAt(patchFd_, &job.patchData[0], job.size, job.offset))
+                        {
+                            setError(std::string("patch write failed: ") + std::strerror(errno));
+                            errorFlag = true;
+                        }
+                    }
+                    break;
+
+                case STAGED_JOB_CHECKPOINT:
+                    if (!errorFlag)
+                    {
+                        // Video data first so the record never describes
+                        // data which isn't on disk.
+                        bool syncOk = syncFile(fd_);
+                        if (syncOk && (patchFd_ != fd_))
+                        {
+                            syncOk = syncFile(patchFd_);
+                        }
+                        syncOk = syncOk && writeAt(journalFd_, &job.patchData[0], job.size, 0);
+                        syncOk = syncOk && syncFile(journalFd_);
+                        if (!syncOk)
+                        {
+                            setError(std::string("checkpoint failed: ") + std::strerror(errno));
+                            errorFlag = true;
+                        }
+                    }
+                    break;
+
+                case STAGED_JOB_STOP:
+                default:
+                    done = true;
+                    break;
+            }
+
+            acquireLock();
+            numJobsPending_--;
+            runningWaitCond_.wakeAll();
+            releaseLock();
+        }
+
+        acquireLock();
+        running_ = false;
+        runningWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+} // namespace bias
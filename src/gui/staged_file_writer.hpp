@@ -0,0 +1,129 @@
+#ifndef BIAS_STAGED_FILE_WRITER_HPP
+#define BIAS_STAGED_FILE_WRITER_HPP
+
+#include <QRunnable>
+#include <QString>
+#include <QWaitCondition>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "lockable.hpp"
+
+namespace bias
+{
+
+    enum StagedWriteJobType
+    {
+        STAGED_JOB_BUFFER=0,
+        STAGED_JOB_PATCH,
+        STAGED_JOB_CHECKPOINT,
+        STAGED_JOB_STOP,
+    };
+
+
+    struct StagedWriteJob
+    {
+        StagedWriteJobType type;
+        unsigned int bufferIndex;
+        uint64_t offset;
+        size_t size;
+        std::vector<char> patchData;
+        StagedWriteJob();
+    };
+
+
+    class StagedFileWriter : public QRunnable, public Lockable<Empty>
+    {
+        // Sequential file writer. Data is serialized by the calling thread
+        // into a small set of large aligned staging buffers. Full buffers are
+        // written to disk by the writer thread (run) with one pwrite each so
+        // that the calling thread never blocks on the disk unless all buffers
+        // are in flight. Optionally the file is opened with O_DIRECT.
+        //
+        // open, write, writePatch, read, tell and close must all be called from
+        // the same (producer) thread. Errors are thrown as RuntimeError.
+        //
+        // checkpoint makes everything submitted so far durable (fsync) and then
+        // writes a record to the journal file opened with openJournal and
+        // syncs that too. The journal is removed when the file is closed
+        // without errors.
+
+        public:
+
+            static const size_t DEFAULT_BUFFER_SIZE;
+            static const unsigned int DEFAULT_NUMBER_OF_BUFFERS;
+            static const unsigned int MIN_NUMBER_OF_BUFFERS;
+            static const size_t DIRECT_IO_ALIGNMENT;
+
+            StagedFileWriter();
+            StagedFileWriter(size_t bufferSize, unsigned int numberOfBuffers);
+            virtual ~StagedFileWriter();
+
+            void open(QString fileName, bool directIo=false);
+            void write(const void *data, size_t size);
+            void writePatch(uint64_t pos, const void *data, size_t size);
+            void read(uint64_t pos, void *data, size_t size);
+            uint64_t tell() const;
+            bool preallocate(uint64_t numBytes);
+            void openJournal(QString journalFileName);
+            void checkpoint(const std::vector<char> &record);
+            uint64_t getSubmittedSize() const;
+            void close();
+
+            bool isOpen() const;
+            bool isDirectIo() const;
+            QString getFileName() const;
+
+        private:
+
+            size_t bufferSize_;
+            unsigned int numberOfBuffers_;
+            std::vector<char*> bufferPtrVec_;
+
+            QString fileName_;
+            bool isOpen_;
+            bool directIo_;
+            int fd_;
+            int patchFd_;
+            int readFd_;
+            int journalFd_;
+            QString journalFileName_;
+            uint64_t preallocateSize_;
+
+            // Producer state
+            unsigned int currentBuffer_;
+            size_t currentFill_;
+            uint64_t currentOffset_;
+
+            // Writer thread state - guarded by lock
+            bool running_;
+            unsigned int numJobsPending_;
+            bool errorFlag_;
+            std::string errorMsg_;
+            QWaitCondition runningWaitCond_;
+
+            LockableQueue<StagedWriteJob> jobQueue_;
+            LockableQueue<unsigned int> freeQueue_;
+
+            void initialize(size_t bufferSize, unsigned int numberOfBuffers);
+            void allocateBuffers();
+            void freeBuffers();
+            void submitCurrentBuffer(size_t size);
+            void pushJob(const StagedWriteJob &job);
+            void checkError(unsigned int errorId);
+            void waitForJobs();
+            void closeFiles();
+
+            bool writeAt(int fd, const char *data, size_t size, uint64_t offset);
+            bool syncFile(int fd);
+            void setError(std::string msg);
+
+            void run();
+    };
+
+    typedef std::shared_ptr<StagedFileWriter> StagedFileWriterPtr;
+
+} // namespace bias
+
+#endif // #ifndef BIAS_STAGED_FILE_WRITER_HPP
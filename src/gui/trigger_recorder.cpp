@@ -0,0 +1,236 @@
+#include "trigger_recorder.hpp"
+#include <algorithm>
+
+namespace bias
+{
+
+    const bool TriggerRecorder::DEFAULT_ENABLED = false;
+    const double TriggerRecorder::DEFAULT_PRE_TRIGGER_SEC = 2.0;
+    const double TriggerRecorder::DEFAULT_POST_TRIGGER_SEC = 3.0;
+    const unsigned long TriggerRecorder::DEFAULT_MAX_BUFFER_FRAMES = 2000;
+    const double TriggerRecorder::DEFAULT_INTERVAL_SEC = 0.0;
+    const unsigned long TriggerRecorder::MIN_MAX_BUFFER_FRAMES = 2;
+    const unsigned int TriggerRecorder::FLUSH_FRAMES_PER_FRAME = 4;
+
+
+    TriggerRecorder::TriggerRecorder()
+    {
+        VideoWriterParams_trigger params;
+        setParams(params);
+    }
+
+
+    TriggerRecorder::TriggerRecorder(VideoWriterParams_trigger params)
+    {
+        setParams(params);
+    }
+
+
+    void TriggerRecorder::setParams(VideoWriterParams_trigger params)
+    {
+        params_ = params;
+        params_.maxBufferFrames = std::max(params_.maxBufferFrames, MIN_MAX_BUFFER_FRAMES);
+        reset();
+    }
+
+
+    VideoWriterParams_trigger TriggerRecorder::getParams()
+    {
+        return params_;
+    }
+
+
+    void TriggerRecorder::trigger()
+    {
+        // Trigger time is taken from the next frame
+        acquireLock();
+        triggerNow_ = true;
+        numberOfTriggers_++;
+        releaseLock();
+    }
+
+
+    void TriggerRecorder::trigger(double timeStamp)
+    {
+        acquireLock();
+        triggerTimeVec_.push_back(timeStamp);
+        numberOfTriggers_++;
+        releaseLock();
+    }
+
+
+    void TriggerRecorder::process(const StampedImage &stampedImg, std::vector<StampedImage> &logVec)
+    {
+        double timeStamp = stampedImg.timeStamp;
+
+        // Pick up triggers received since the last frame
+        std::vector<double> triggerTimeVec;
+        acquireLock();
+        if (triggerNow_)
+        {
+            triggerTimeVec_.push_back(timeStamp);
+            triggerNow_ = false;
+        }
+        triggerTimeVec.swap(triggerTimeVec_);
+        releaseLock();
+
+        for (double triggerTime : triggerTimeVec)
+        {
+            startOrExtendClip(triggerTime);
+        }
+
+        // Allocate ring slots on first frame
+        if (ringVec_.empty())
+        {
+            ringVec_.resize(params_.maxBufferFrames);
+            ringHead_ = 0;
+            ringCount_ = 0;
+        }
+
+        // Drop frames which can no longer be part of a clip
+        double keepTime = recording_ ? clipStartTime_ : timeStamp - params_.preTriggerSec;
+        while ((ringCount_ > 0) && (ringFront().timeStamp < keepTime))
+        {
+            ringPopFront();
+        }
+
+        // If the ring is full release the oldest frame, or overwrite it if it
+        // isn't part of the current clip.
+        if (ringCount_ == ringVec_.size())
+        {
+            if (recording_ && (ringFront().timeStamp <= clipStopTime_))
+            {
+                logVec.push_back(ringFront());
+            }
+            ringPopFront();
+        }
+        ringPushBack(stampedImg);
+
+        // Release clip frames - the clip is done when the oldest frame in
+        // the ring is past the clip stop time.
+        bool clipDone = false;
+        if (recording_)
+        {
+            unsigned int numFlushed = 0;
+            while ((ringCount_ > 0) && (numFlushed < FLUSH_FRAMES_PER_FRAME))
+            {
+                if (ringFront().timeStamp > clipStopTime_)
+                {
+                    clipDone = true;
+                    break;
+                }
+                logVec.push_back(ringFront());
+                ringPopFront();
+                numFlushed++;
+            }
+            if (clipDone)
+            {
+                recording_ = false;
+            }
+        }
+
+        acquireLock();
+        isRecording_ = recording_;
+        releaseLock();
+    }
+
+
+    void TriggerRecorder::reset()
+    {
+        ringVec_.clear();
+        ringHead_ = 0;
+        ringCount_ = 0;
+        recording_ = false;
+        clipStartTime_ = 0.0;
+        clipStopTime_ = 0.0;
+
+        acquireLock();
+        triggerNow_ = false;
+        triggerTimeVec_.clear();
+        numberOfTriggers_ = 0;
+        numberOfClips_ = 0;
+        isRecording_ = false;
+        releaseLock();
+    }
+
+
+    bool TriggerRecorder::isRecording()
+    {
+        acquireLock();
+        bool isRecording = isRecording_;
+        releaseLock();
+        return isRecording;
+    }
+
+
+    unsigned long TriggerRecorder::getNumberOfTriggers()
+    {
+        acquireLock();
+        unsigned long numberOfTriggers = numberOfTriggers_;
+        releaseLock();
+        return numberOfTriggers;
+    }
+
+
+    unsigned long TriggerRecorder::getNumberOfClips()
+    {
+        acquireLock();
+        unsigned long numberOfClips = numberOfClips_;
+        releaseLock();
+        return numberOfClips;
+    }
+
+
+    unsigned long TriggerRecorder::getBufferSize()
+    {
+        return params_.maxBufferFrames;
+    }
+
+
+    // Private methods
+    // ------------------------------------------------------------------------
+
+    void TriggerRecorder::startOrExtendClip(double triggerTime)
+    {
+        double stopTime = triggerTime + params_.postTriggerSec;
+        if (recording_)
+        {
+            // Overlapping trigger - merge into the current clip
+            clipStopTime_ = std::max(clipStopTime_, stopTime);
+        }
+        else
+        {
+            recording_ = true;
+            clipStartTime_ = triggerTime - params_.preTriggerSec;
+            clipStopTime_ = stopTime;
+
+            acquireLock();
+            numberOfClips_++;
+            releaseLock();
+        }
+    }
+
+
+    StampedImage &TriggerRecorder::ringFront()
+    {
+        return ringVec_[ringHead_];
+    }
+
+
+    void TriggerRecorder::ringPopFront()
+    {
+        // Release the slot's reference to the image
+        ringVec_[ringHead_].image.release();
+        ringHead_ = (ringHead_ + 1) % ringVec_.size();
+        ringCount_--;
+    }
+
+
+    void TriggerRecorder::ringPushBack(const StampedImage &stampedImg)
+    {
+        unsigned long ringTail = (ringHead_ + ringCount_) % ringVec_.size();
+        ringVec_[ringTail] = stampedImg;
+        ringCount_++;
+    }
+
+} // namespace bias
@@ -0,0 +1,83 @@
+#ifndef BIAS_TRIGGER_RECORDER_HPP
+#define BIAS_TRIGGER_RECORDER_HPP
+
+#include "lockable.hpp"
+#include "stamped_image.hpp"
+#include "logging_params.hpp"
+#include <vector>
+
+namespace bias
+{
+
+    class TriggerRecorder : public Lockable<Empty>
+    {
+        // Pre/post trigger recording. The dispatcher passes every frame to
+        // process which keeps the last preTriggerSec seconds of frames in a
+        // fixed size ring. When a trigger arrives the frames in the ring from
+        // preTriggerSec before the trigger onwards, followed by the frames up
+        // to postTriggerSec after it, are handed back for logging. Triggers
+        // arriving while a clip is being recorded extend the clip.
+        //
+        // The ring backlog is released at FLUSH_FRAMES_PER_FRAME frames per
+        // new frame so the log queue isn't flooded when a trigger arrives.
+        // The images are shared with the grabber (no copies).
+        //
+        // trigger may be called from any thread, process only from the
+        // dispatcher thread.
+
+        public:
+
+            static const bool DEFAULT_ENABLED;
+            static const double DEFAULT_PRE_TRIGGER_SEC;
+            static const double DEFAULT_POST_TRIGGER_SEC;
+            static const unsigned long DEFAULT_MAX_BUFFER_FRAMES;
+            static const double DEFAULT_INTERVAL_SEC;
+            static const unsigned long MIN_MAX_BUFFER_FRAMES;
+            static const unsigned int FLUSH_FRAMES_PER_FRAME;
+
+            TriggerRecorder();
+            TriggerRecorder(VideoWriterParams_trigger params);
+
+            void setParams(VideoWriterParams_trigger params);
+            VideoWriterParams_trigger getParams();
+
+            void trigger();
+            void trigger(double timeStamp);
+            void process(const StampedImage &stampedImg, std::vector<StampedImage> &logVec);
+            void reset();
+
+            bool isRecording();
+            unsigned long getNumberOfTriggers();
+            unsigned long getNumberOfClips();
+            unsigned long getBufferSize();
+
+        private:
+
+            VideoWriterParams_trigger params_;
+
+            // Ring - accessed from the dispatcher thread only
+            std::vector<StampedImage> ringVec_;
+            unsigned long ringHead_;
+            unsigned long ringCount_;
+            bool recording_;
+            double clipStartTime_;
+            double clipStopTime_;
+
+            // use lock when setting these values
+            // -----------------------------------
+            bool triggerNow_;
+            std::vector<double> triggerTimeVec_;
+            unsigned long numberOfTriggers_;
+            unsigned long numberOfClips_;
+            bool isRecording_;
+            // -----------------------------------
+
+            void startOrExtendClip(double triggerTime);
+            StampedImage &ringFront();
+            void ringPopFront();
+            void ringPushBack(const StampedImage &stampedImg);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_TRIGGER_RECORDER_HPP
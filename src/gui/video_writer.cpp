@@ -1,7 +1,12 @@
 #include "video_writer.hpp"
 #include "stamped_image.hpp"
+#include "json.hpp"
+#include "json_utils.hpp"
 #include <iostream>
 #include <QDir>
+#include <QFile>
+#include <QVariantMap>
+#include <QVariantList>
 #include <QtDebug>
 
 namespace bias
@@ -9,6 +14,31 @@ namespace bias
     const unsigned int DEFAULT_FRAME_SKIP = 1;
     const QString DUMMY_FILENAME("dummy_filename");
 
+    const unsigned long long VideoWriter::DEFAULT_ROLLOVER_MAX_BYTES = 0;
+    const double VideoWriter::DEFAULT_ROLLOVER_MAX_DURATION = 0.0;
+    const unsigned long VideoWriter::DEFAULT_ROLLOVER_MAX_FRAMES = 0;
+    const bool VideoWriter::DEFAULT_ROLLOVER_PREALLOCATE = true;
+    const unsigned long long VideoWriter::MIN_ROLLOVER_MAX_BYTES = 1024*1024;
+    const QString VideoWriter::MANIFEST_FILE_SUFFIX("_manifest");
+    const QString VideoWriter::MANIFEST_FILE_EXT(".json");
+    const bool VideoWriter::DEFAULT_CHECKPOINT_ENABLED = false;
+    const double VideoWriter::DEFAULT_CHECKPOINT_INTERVAL = 1.0;
+    const unsigned long VideoWriter::DEFAULT_CHECKPOINT_MAX_FRAMES = 0;
+
+
+    // VideoSegmentInfo
+    // ----------------------------------------------------------------------------------
+    VideoSegmentInfo::VideoSegmentInfo()
+    {
+        numFrames = 0;
+        firstTimeStamp = 0.0;
+        lastTimeStamp = 0.0;
+        numBytes = 0;
+    }
+
+
+    // VideoWriter
+    // ----------------------------------------------------------------------------------
     VideoWriter::VideoWriter(QObject *parent) 
         : VideoWriter(DUMMY_FILENAME,0, parent) 
     {}
@@ -22,6 +52,11 @@ namespace bias
         frameCount_ = 0;
         frameSkip_ = DEFAULT_FRAME_SKIP;
         addVersionNumber_ = true;
+        sourceFrameNumbers_ = false;
+        segmentOpen_ = false;
+        haveCheckpoint_ = false;
+        checkpointTimeStamp_ = 0.0;
+        checkpointNumFrames_ = 0;
     }
 
     VideoWriter::~VideoWriter() 
@@ -50,6 +85,16 @@ namespace bias
         addVersionNumber_ = value;
     }
 
+    void VideoWriter::setSourceFrameNumbers(bool value)
+    {
+        sourceFrameNumbers_ = value;
+    }
+
+    unsigned long VideoWriter::getImageNumber(const StampedImage &stampedImg) const
+    {
+        return sourceFrameNumbers_ ? stampedImg.frameCount : frameCount_;
+    }
+
     void VideoWriter::addFrame(StampedImage stampedImg)
     {
         std::cout << __PRETTY_FUNCTION__;
@@ -83,6 +128,67 @@ namespace bias
 
     void VideoWriter::finish() {};
 
+
+    uint64_t VideoWriter::getNumberOfBytesWritten() const
+    {
+        // Sum over the file segments - 0 for writers which don't report 
+        // their file sizes.
+        uint64_t numBytes = 0;
+        for (const VideoSegmentInfo &segment : segmentVec_)
+        {
+            numBytes += segment.numBytes;
+        }
+        return numBytes;
+    }
+
+
+    bool VideoWriter::reduceQuality()
+    {
+        return false;
+    }
+
+
+    bool VideoWriter::isBacklogged()
+    {
+        return false;
+    }
+
+
+    void VideoWriter::setRolloverParams(VideoWriterParams_rollover params)
+    {
+        rolloverParams_ = params;
+    }
+
+
+    VideoWriterParams_rollover VideoWriter::getRolloverParams() const
+    {
+        return rolloverParams_;
+    }
+
+
+    bool VideoWriter::isRolloverEnabled() const
+    {
+        return rolloverParams_.isEnabled();
+    }
+
+
+    std::vector<VideoSegmentInfo> VideoWriter::getSegmentInfo() const
+    {
+        return segmentVec_;
+    }
+
+
+    void VideoWriter::setCheckpointParams(VideoWriterParams_checkpoint params)
+    {
+        checkpointParams_ = params;
+    }
+
+
+    VideoWriterParams_checkpoint VideoWriter::getCheckpointParams() const
+    {
+        return checkpointParams_;
+    }
+
     unsigned int VideoWriter::getNextVersionNumber()
     {
         unsigned int nextVerNum = 0;
@@ -114,6 +220,249 @@ namespace bias
         return fileInfo.absoluteFilePath();
     }
 
+    bool VideoWriter::isRolloverDue(double timeStamp, uint64_t numBytes) const
+    {
+        // Checked before a frame is written to the current segment. numBytes 
+        // is the segment size including the frame, if known by the writer.
+        if ((!segmentOpen_) || (!rolloverParams_.isEnabled()))
+        {
+            return false;
+        }
+
+        const VideoSegmentInfo &segment = segmentVec_.back();
+        if (segment.numFrames == 0)
+        {
+            return false;
+        }
+        if ((rolloverParams_.maxFrames > 0) && (segment.numFrames >= rolloverParams_.maxFrames))
+        {
+            return true;
+        }
+        if ((rolloverParams_.maxBytes > 0) && (numBytes > rolloverParams_.maxBytes))
+        {
+            return true;
+        }
+        if ((rolloverParams_.maxDuration > 0.0) && (timeStamp - segment.firstTimeStamp >= rolloverParams_.maxDuration))
+        {
+            return true;
+        }
+        return false;
+    }
+
+
+    void VideoWriter::beginSegment(QString fileName)
+    {
+        VideoSegmentInfo segment;
+        segment.fileName = fileName;
+        segmentVec_.push_back(segment);
+        segmentOpen_ = true;
+        writeManifest();
+    }
+
+
+    void VideoWriter::addSegmentFrame(double timeStamp, uint64_t numBytes)
+    {
+        if (!segmentOpen_)
+        {
+            return;
+        }
+        VideoSegmentInfo &segment = segmentVec_.back();
+        if (segment.numFrames == 0)
+        {
+            segment.firstTimeStamp = timeStamp;
+        }
+        segment.lastTimeStamp = timeStamp;
+        segment.numFrames++;
+        segment.numBytes = numBytes;
+    }
+
+
+    void VideoWriter::endSegment(uint64_t numBytes, bool isFileClosed)
+    {
+        if (!segmentOpen_)
+        {
+            return;
+        }
+        segmentVec_.back().numBytes = numBytes;
+        segmentOpen_ = false;
+        writeManifest();
+        if (isFileClosed)
+        {
+            emit segmentFinished(segmentVec_.back().fileName);
+        }
+    }
+
+
+    unsigned int VideoWriter::getNumberOfSegments() const
+    {
+        return (unsigned int)(segmentVec_.size());
+    }
+
+
+    QString VideoWriter::getSegmentFileName(QString firstFileName, unsigned int segmentNumber) const
+    {
+        // The first segment keeps the original file name, following segments
+        // get a segment number, e.g. movie_v001.fmf, movie_v001_s001.fmf, ...
+        if (segmentNumber == 0)
+        {
+            return firstFileName;
+        }
+        QFileInfo fileInfo(firstFileName);
+        QDir filePath = QDir(fileInfo.absolutePath());
+        QString segStr = QString("_s%1").arg(segmentNumber,3,10,QChar('0'));
+        fileInfo = QFileInfo(filePath, fileInfo.baseName() + segStr + "." + fileInfo.suffix());
+        return fileInfo.absoluteFilePath();
+    }
+
+
+    uint64_t VideoWriter::getPreallocateSize() const
+    {
+        // Space to reserve for a new segment - the size limit if there is 
+        // one, otherwise the size of the largest completed segment.
+        uint64_t numBytes = 0;
+        if ((!rolloverParams_.preallocate) || (!rolloverParams_.isEnabled()))
+        {
+            return numBytes;
+        }
+        if (rolloverParams_.maxBytes > 0)
+        {
+            numBytes = uint64_t(rolloverParams_.maxBytes);
+        }
+        else
+        {
+            for (unsigned int i=0; i<segmentVec_.size(); i++)
+            {
+                if (segmentVec_[i].numBytes > numBytes)
+                {
+                    numBytes = segmentVec_[i].numBytes;
+                }
+            }
+        }
+        return numBytes;
+    }
+
+
+    QString VideoWriter::getManifestFileName() const
+    {
+        if (!manifestFileName_.isEmpty())
+        {
+            return manifestFileName_;
+        }
+        if (segmentVec_.empty())
+        {
+            return QString("");
+        }
+        QFileInfo fileInfo(segmentVec_.front().fileName);
+        QDir filePath = QDir(fileInfo.absolutePath());
+        fileInfo = QFileInfo(filePath, fileInfo.baseName() + MANIFEST_FILE_SUFFIX + MANIFEST_FILE_EXT);
+        return fileInfo.absoluteFilePath();
+    }
+
+
+    void VideoWriter::writeManifest()
+    {
+        // Manifest is only written for sessions which may span several files.
+        // It is rewritten whenever a segment is opened or closed - the new 
+        // version replaces the old one by rename. 
+        if (!rolloverParams_.isEnabled())
+        {
+            return;
+        }
+        QString manifestFileName = getManifestFileName();
+        if (manifestFileName.isEmpty())
+        {
+            return;
+        }
+
+        QVariantMap rolloverMap;
+        rolloverMap.insert("maxBytes", qulonglong(rolloverParams_.maxBytes));
+        rolloverMap.insert("maxDuration", rolloverParams_.maxDuration);
+        rolloverMap.insert("maxFrames", qulonglong(rolloverParams_.maxFrames));
+        rolloverMap.insert("preallocate", rolloverParams_.preallocate);
+
+        QVariantList segmentList;
+        for (unsigned int i=0; i<segmentVec_.size(); i++)
+        {
+            const VideoSegmentInfo &segment = segmentVec_[i];
+            bool isClosed = (i+1 < segmentVec_.size()) || (!segmentOpen_);
+            QVariantMap segmentMap;
+            segmentMap.insert("fileName", QFileInfo(segment.fileName).fileName());
+            segmentMap.insert("numberOfFrames", qulonglong(segment.numFrames));
+            segmentMap.insert("firstTimeStamp", segment.firstTimeStamp);
+            segmentMap.insert("lastTimeStamp", segment.lastTimeStamp);
+            segmentMap.insert("numberOfBytes", qulonglong(segment.numBytes));
+            segmentMap.insert("closed", isClosed);
+            segmentList.append(segmentMap);
+        }
+
+        QVariantMap manifestMap;
+        manifestMap.insert("cameraNumber", cameraNumber_);
+        manifestMap.insert("rollover", rolloverMap);
+        manifestMap.insert("numberOfSegments", (unsigned int)(segmentVec_.size()));
+        manifestMap.insert("segments", segmentList);
+
+        if (!writeJsonFile(manifestFileName, manifestMap))
+        {
+            std::cout << "warning: unable to write video manifest, " << manifestFileName.toStdString() << std::endl;
+        }
+    }
+
+
+    bool VideoWriter::writeJsonFile(QString fileName, QVariantMap jsonMap) const
+    {
+        // Written to a temporary file first - the new version replaces the 
+        // old one by rename.
+        bool ok = false;
+        QByteArray json = QtJson::serialize(jsonMap, ok);
+        if (!ok)
+        {
+            return false;
+        }
+
+        QString tmpFileName = fileName + QString(".tmp");
+        QFile tmpFile(tmpFileName);
+        if (!tmpFile.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+        tmpFile.write(prettyIndentJson(json));
+        tmpFile.close();
+
+        QFile::remove(fileName);
+        return QFile::rename(tmpFileName, fileName);
+    }
+
+
+    bool VideoWriter::isCheckpointDue(double timeStamp, unsigned long numFrames)
+    {
+        // The first frame after a file is opened (haveCheckpoint_ cleared by
+        // the writer) only sets the baseline.
+        if (!checkpointParams_.enabled)
+        {
+            return false;
+        }
+        if (!haveCheckpoint_)
+        {
+            markCheckpoint(timeStamp, numFrames);
+            return false;
+        }
+
+        double interval = checkpointParams_.interval;
+        unsigned long maxFrames = checkpointParams_.maxFrames;
+        bool timeDue = (interval > 0.0) && (timeStamp - checkpointTimeStamp_ >= interval);
+        bool framesDue = (maxFrames > 0) && (numFrames - checkpointNumFrames_ >= maxFrames);
+        return timeDue || framesDue;
+    }
+
+
+    void VideoWriter::markCheckpoint(double timeStamp, unsigned long numFrames)
+    {
+        haveCheckpoint_ = true;
+        checkpointTimeStamp_ = timeStamp;
+        checkpointNumFrames_ = numFrames;
+    }
+
+
     QFileInfo VideoWriter::getFileInfo(unsigned int verNum)
     {
         QFileInfo fileInfo(fileName_);
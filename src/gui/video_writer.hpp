@@ -1,13 +1,29 @@
 #ifndef BIAS_VIDEO_WRITER_HPP
 #define BIAS_VIDEO_WRITER_HPP
 #include "stamped_image.hpp"
+#include "video_writer_params.hpp"
 #include <QString>
 #include <QObject>
 #include <QFileInfo>
+#include <QVariantMap>
 #include <opencv2/core/core.hpp>
+#include <vector>
+#include <cstdint>
 
 namespace bias
 {
+    struct VideoSegmentInfo
+    {
+        // File segment written by a video writer with rollover enabled
+        QString fileName;
+        unsigned long numFrames;
+        double firstTimeStamp;
+        double lastTimeStamp;
+        uint64_t numBytes;
+        VideoSegmentInfo();
+    };
+
+
     class VideoWriter : public QObject
     {
         Q_OBJECT 
@@ -21,15 +37,48 @@ namespace bias
             virtual void setSize(cv::Size size);
             virtual void setFrameSkip(unsigned int frameSkip);
             virtual void setVersioning(bool value);
+            void setSourceFrameNumbers(bool value);
             virtual unsigned int getNextVersionNumber();
             virtual void addFrame(StampedImage stampedImg);
             virtual QString getFileName() const;
             virtual cv::Size getSize() const;
             virtual unsigned int getFrameSkip() const;
+
+            // Writes the frames in progress and closes the output, which is 
+            // complete when finish returns. No frames are added after it.
             virtual void finish();
 
+            // Used by the logging watchdog. reduceQuality returns false if
+            // the writer has no quality setting or it is at its minimum.
+            virtual uint64_t getNumberOfBytesWritten() const;
+            virtual bool reduceQuality();
+
+            // Used by offline tools, which wait while this is true rather 
+            // than have addFrame skip frames because a queue is full.
+            virtual bool isBacklogged();
+
+            virtual void setRolloverParams(VideoWriterParams_rollover params);
+            VideoWriterParams_rollover getRolloverParams() const;
+            bool isRolloverEnabled() const;
+            std::vector<VideoSegmentInfo> getSegmentInfo() const;
+
+            void setCheckpointParams(VideoWriterParams_checkpoint params);
+            VideoWriterParams_checkpoint getCheckpointParams() const;
+
+            static const unsigned long long DEFAULT_ROLLOVER_MAX_BYTES;
+            static const double DEFAULT_ROLLOVER_MAX_DURATION;
+            static const unsigned long DEFAULT_ROLLOVER_MAX_FRAMES;
+            static const bool DEFAULT_ROLLOVER_PREALLOCATE;
+            static const unsigned long long MIN_ROLLOVER_MAX_BYTES;
+            static const QString MANIFEST_FILE_SUFFIX;
+            static const QString MANIFEST_FILE_EXT;
+            static const bool DEFAULT_CHECKPOINT_ENABLED;
+            static const double DEFAULT_CHECKPOINT_INTERVAL;
+            static const unsigned long DEFAULT_CHECKPOINT_MAX_FRAMES;
+
         signals:
             void imageLoggingError(unsigned int errorId, QString errorMsg);
+            void segmentFinished(QString fileName);
 
         protected:
 
@@ -40,8 +89,46 @@ namespace bias
             unsigned int cameraNumber_;
             bool addVersionNumber_;
 
+            // Image sequence writers name their files from the image's 
+            // own frame number, rather than the frames added, when set.
+            bool sourceFrameNumbers_;
+            unsigned long getImageNumber(const StampedImage &stampedImg) const;
+
+            VideoWriterParams_rollover rolloverParams_;
+            std::vector<VideoSegmentInfo> segmentVec_;
+            bool segmentOpen_;
+            QString manifestFileName_;
+
+            VideoWriterParams_checkpoint checkpointParams_;
+            bool haveCheckpoint_;
+            double checkpointTimeStamp_;
+            unsigned long checkpointNumFrames_;
+
             QString getUniqueFileName();
             QFileInfo getFileInfo(unsigned int verNum);
+
+            // File segments - writers call beginSegment when a file is 
+            // opened, addSegmentFrame for each frame written and endSegment 
+            // when the file is closed. A manifest listing the segments is
+            // written alongside the files when rollover is enabled.
+            // segmentFinished is emitted by endSegment unless the file is 
+            // still being written by another thread.
+            bool isRolloverDue(double timeStamp, uint64_t numBytes) const;
+            void beginSegment(QString fileName);
+            void addSegmentFrame(double timeStamp, uint64_t numBytes);
+            void endSegment(uint64_t numBytes, bool isFileClosed=true);
+            unsigned int getNumberOfSegments() const;
+            QString getSegmentFileName(QString firstFileName, unsigned int segmentNumber) const;
+            uint64_t getPreallocateSize() const;
+            QString getManifestFileName() const;
+            void writeManifest();
+            bool writeJsonFile(QString fileName, QVariantMap jsonMap) const;
+
+            // Checkpoints - writers which support crash safe recording call
+            // isCheckpointDue after each frame written and markCheckpoint
+            // once the checkpoint has been made. 
+            bool isCheckpointDue(double timeStamp, unsigned long numFrames);
+            void markCheckpoint(double timeStamp, unsigned long numFrames);
     };
 
 } // namespace bias
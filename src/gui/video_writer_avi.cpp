@@ -3,6 +3,7 @@
 #include "exception.hpp"
 #include <QFileInfo>
 #include <QDir>
+#include <QThreadPool>
 #include <iostream>
 
 namespace bias
@@ -13,6 +14,9 @@ namespace bias
     const double VideoWriter_avi::DEFAULT_FPS = 30.0;
     const double VideoWriter_avi::MIN_ALLOWED_DT_ESTIMATE = 0.00001; 
     const unsigned int VideoWriter_avi::DEFAULT_FRAME_SKIP = 1;
+    const unsigned int VideoWriter_avi::DEFAULT_NUMBER_OF_ENCODERS = 0;
+    const unsigned int VideoWriter_avi::DEFAULT_ENCODE_QUEUE_SIZE = 100;
+    const unsigned long VideoWriter_avi::PARALLEL_SEGMENT_MAX_FRAMES = 1000;
     const int VideoWriter_avi::DEFAULT_FOURCC = CV_FOURCC('X','V','I','D');
     const VideoWriterParams_avi VideoWriter_avi::DEFAULT_PARAMS = 
         VideoWriterParams_avi();
@@ -34,22 +38,69 @@ namespace bias
         : VideoWriter(fileName,cameraNumber,parent)
     {
         isFirst_ = true;
+        isColorImage_ = false;
         fps_ = DEFAULT_FPS;
         fourcc_ = stringToFourcc(params.codec);
+        numberOfEncoders_ = params.numberOfEncoders;
+        encodeQueueSize_ = params.encodeQueueSize;
+        dropReported_ = false;
+        encodeErrorReported_ = false;
         setFrameSkip(params.frameSkip);
     }
 
 
     VideoWriter_avi::~VideoWriter_avi() 
     {
-        videoWriterMutexPtr_ -> lock();
-        bool isOpened = videoWriter_.isOpened();
-        if (isOpened)
+        closeFile();
+        stopEncoders();
+    };
+
+
+    void VideoWriter_avi::finish()
+    {
+        closeFile();
+        if (encoderVec_.empty())
         {
-            videoWriter_.release();
+            return;
         }
-        videoWriterMutexPtr_ -> unlock();
-    };
+
+        // Wait for the encoders to work through their queues. Segment sizes 
+        // are only known once the files have been written. 
+        for (auto encoderPtr : encoderVec_)
+        {
+            encoderPtr -> waitForIdle();
+        }
+        updateSegmentSizes();
+
+        unsigned long numDropped = getNumberOfDroppedFrames();
+        if (numDropped > 0)
+        {
+            std::cout << "warning: avi encoder dropped " << numDropped << " frames" << std::endl;
+        }
+    }
+
+
+    bool VideoWriter_avi::isBacklogged()
+    {
+        // With several encoders frames only back up when all of them are busy
+        if (!encoderPtr_)
+        {
+            return false;
+        }
+        return (getLeastBusyEncoder() -> getQueueSize() >= encodeQueueSize_/2);
+    }
+
+
+    unsigned long VideoWriter_avi::getNumberOfDroppedFrames()
+    {
+        // Frames refused because the encode queue was full
+        unsigned long numDropped = 0;
+        for (auto encoderPtr : encoderVec_)
+        {
+            numDropped += encoderPtr -> getNumberDropped();
+        }
+        return numDropped;
+    }
 
 
     void VideoWriter_avi::addFrame(StampedImage stampedImg)
@@ -62,7 +113,45 @@ namespace bias
         if (frameCount_%frameSkip_==0)
         {
             //std::cout << "add frame: " << frameCount_ << std::endl;
-            videoWriter_ << stampedImg.image;
+            // File size is only looked up when there is a size limit
+            uint64_t numBytes = (rolloverParams_.maxBytes > 0) ? getFileSize() : 0;
+            if (isRolloverDue(stampedImg.timeStamp, numBytes))
+            {
+                closeFile();
+                openFile(getSegmentFileName(firstFileName_, getNumberOfSegments()));
+            }
+            if (encoderVec_.empty())
+            {
+                videoWriter_ << stampedImg.image;
+                addSegmentFrame(stampedImg.timeStamp, 0);
+            }
+            else
+            {
+                checkEncoders();
+                if ((encoderVec_.size() > 1) && (encoderPtr_ -> getQueueSize() >= encodeQueueSize_))
+                {
+                    // The segment's encoder has fallen behind - start a new 
+                    // segment on another encoder rather than drop frames while
+                    // it is idle.
+                    if (getLeastBusyEncoder() -> getQueueSize() < encodeQueueSize_)
+                    {
+                        closeFile();
+                        openFile(getSegmentFileName(firstFileName_, getNumberOfSegments()));
+                    }
+                }
+                if (encoderPtr_ -> push(stampedImg.image))
+                {
+                    addSegmentFrame(stampedImg.timeStamp, 0);
+                }
+                else if (!dropReported_)
+                {
+                    std::cout << "warning: logging overflow - skipped frame -" << std::endl;
+                    unsigned int errorId = ERROR_FRAMES_TODO_MAX_QUEUE_SIZE;
+                    QString errorMsg("avi encode queue has exceeded the maximum allowed size");
+                    emit imageLoggingError(errorId, errorMsg);
+                    dropReported_ = true;
+                }
+            }
         }
         frameCount_++;
     }
@@ -70,8 +159,6 @@ namespace bias
 
     void VideoWriter_avi::setupOutput(StampedImage stampedImg)
     {
-        std::string incrFileName = getUniqueFileName().toStdString();
-        
         setSize(stampedImg.image.size());
 
         if (stampedImg.dtEstimate > MIN_ALLOWED_DT_ESTIMATE)
@@ -83,27 +170,72 @@ namespace bias
             fps_ = 1.0;
         }
 
-        bool isColorImage;
         if (stampedImg.image.channels() > 1)
         {
-            isColorImage = true;
+            isColorImage_ = true;
         }
         else
         {
-            isColorImage = false;
+            isColorImage_ = false;
         }
 
+        if (numberOfEncoders_ > 0)
+        {
+            // Parallel encoding needs segments - split by frames if no
+            // rollover limit is set.
+            if ((numberOfEncoders_ > 1) && (!rolloverParams_.isEnabled()))
+            {
+                rolloverParams_.maxFrames = PARALLEL_SEGMENT_MAX_FRAMES;
+                std::cout << "avi: no rollover limit set for parallel encoding, using segments of ";
+                std::cout << PARALLEL_SEGMENT_MAX_FRAMES << " frames" << std::endl;
+            }
+            startEncoders();
+        }
+
+        firstFileName_ = getUniqueFileName();
+        openFile(firstFileName_);
+    }
+
+
+    void VideoWriter_avi::openFile(QString fileName)
+    {
         bool openOK= true;
+
+        if (!encoderVec_.empty())
+        {
+            // Segments are handed to the least busy encoder. An encoder still 
+            // busy with its previous segment opens the new one after it.
+            bool isFirstSegment = (getNumberOfSegments() == 0);
+            encoderPtr_ = getLeastBusyEncoder();
+            encoderPtr_ -> open(fileName);
+            if (isFirstSegment)
+            {
+                // Report open errors (e.g. codec not available) right away
+                encoderPtr_ -> waitForIdle();
+                if (encoderPtr_ -> haveError())
+                {
+                    isFirst_ = false;
+                    encodeErrorReported_ = true;
+                    unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+                    std::string errorMsg("video writer unable to open file:\n\n"); 
+                    errorMsg += encoderPtr_ -> getErrorMsg();
+                    throw RuntimeError(errorId, errorMsg); 
+                }
+            }
+            currentFileName_ = fileName;
+            beginSegment(fileName);
+            return;
+        }
         
         videoWriterMutexPtr_ -> lock();
         try
         {
             openOK = videoWriter_.open(
-                    incrFileName,
+                    fileName.toStdString(),
                     fourcc_,
                     fps_,
                     size_,
-                    isColorImage
+                    isColorImage_
                     );
         }
         catch (cv::Exception &e)
@@ -139,6 +271,141 @@ namespace bias
             throw RuntimeError(errorId, errorMsg); 
         }
 
+        // The file is owned by cv::VideoWriter so it isn't preallocated
+        currentFileName_ = fileName;
+        beginSegment(fileName);
+    }
+
+
+    void VideoWriter_avi::closeFile()
+    {
+        if (!encoderVec_.empty())
+        {
+            // Size filled in by finish once the encoder is done
+            if (encoderPtr_)
+            {
+                encoderPtr_ -> close();
+                encoderPtr_.reset();
+                endSegment(0, false);
+            }
+            return;
+        }
+
+        videoWriterMutexPtr_ -> lock();
+        bool isOpened = videoWriter_.isOpened();
+        if (isOpened)
+        {
+            videoWriter_.release();
+        }
+        videoWriterMutexPtr_ -> unlock();
+
+        if (isOpened)
+        {
+            endSegment(getFileSize());
+        }
+    }
+
+
+    uint64_t VideoWriter_avi::getFileSize() const
+    {
+        // Size on disk so far - the encoder may still have buffered data
+        if (currentFileName_.isEmpty())
+        {
+            return 0;
+        }
+        return uint64_t(QFileInfo(currentFileName_).size());
+    }
+
+
+    void VideoWriter_avi::startEncoders()
+    {
+        threadPoolPtr_ = new QThreadPool(this);
+        threadPoolPtr_ -> setMaxThreadCount(numberOfEncoders_);
+        for (unsigned int i=0; i<numberOfEncoders_; i++)
+        {
+            AviEncoderPtr encoderPtr = std::make_shared<AviEncoder>(
+                    fourcc_, 
+                    fps_, 
+                    size_, 
+                    isColorImage_, 
+                    encodeQueueSize_, 
+                    videoWriterMutexPtr_
+                    );
+            encoderVec_.push_back(encoderPtr);
+            threadPoolPtr_ -> start(encoderPtr.get());
+        }
+    }
+
+
+    void VideoWriter_avi::stopEncoders()
+    {
+        // Encoders finish their queued frames before stopping
+        for (auto encoderPtr : encoderVec_)
+        {
+            encoderPtr -> stop();
+        }
+        if (!threadPoolPtr_.isNull())
+        {
+            threadPoolPtr_ -> waitForDone();
+        }
+    }
+
+
+    void VideoWriter_avi::checkEncoders()
+    {
+        // Encoder errors are reported once 
+        if (encodeErrorReported_)
+        {
+            return;
+        }
+        for (auto encoderPtr : encoderVec_)
+        {
+            if (encoderPtr -> haveError())
+            {
+                encodeErrorReported_ = true;
+                unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+                std::string errorMsg("video writer avi encoder failed:\n\n"); 
+                errorMsg += encoderPtr -> getErrorMsg();
+                throw RuntimeError(errorId, errorMsg); 
+            }
+        }
+    }
+
+
+    AviEncoderPtr VideoWriter_avi::getLeastBusyEncoder()
+    {
+        // Encoder with the fewest queued frames, idle encoders first. Ties 
+        // go to the encoders in turn, starting after the current segment's.
+        unsigned int numEncoders = (unsigned int)(encoderVec_.size());
+        unsigned int start = getNumberOfSegments()%numEncoders;
+        AviEncoderPtr bestEncoderPtr;
+        unsigned int bestQueueSize = 0;
+        bool bestIsIdle = false;
+        for (unsigned int i=0; i<numEncoders; i++)
+        {
+            AviEncoderPtr encoderPtr = encoderVec_[(start + i)%numEncoders];
+            unsigned int queueSize = encoderPtr -> getQueueSize();
+            bool isIdle = encoderPtr -> isIdle();
+            bool isBetter = (!bestEncoderPtr) || (isIdle && !bestIsIdle);
+            isBetter = isBetter || ((isIdle == bestIsIdle) && (queueSize < bestQueueSize));
+            if (isBetter)
+            {
+                bestEncoderPtr = encoderPtr;
+                bestQueueSize = queueSize;
+                bestIsIdle = isIdle;
+            }
+        }
+        return bestEncoderPtr;
+    }
+
+
+    void VideoWriter_avi::updateSegmentSizes()
+    {
+        for (auto &segment : segmentVec_)
+        {
+            segment.numBytes = uint64_t(QFileInfo(segment.fileName).size());
+        }
+        writeManifest();
     }
 
 
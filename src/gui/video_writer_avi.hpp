@@ -3,12 +3,16 @@
 
 #include "video_writer.hpp"
 #include "video_writer_params.hpp"
+#include "avi_encoder.hpp"
 #include <opencv2/highgui/highgui.hpp>
 #include <QString>
 #include <QStringList>
 #include <QMap>
 #include <QPointer>
 #include <QMutex>
+#include <vector>
+
+class QThreadPool;
 
 namespace bias
 {
@@ -27,12 +31,18 @@ namespace bias
                     );
             virtual ~VideoWriter_avi();
             virtual void addFrame(StampedImage stampedImg);
+            virtual void finish();
+            virtual bool isBacklogged();
+            unsigned long getNumberOfDroppedFrames();
 
             // Static variables 
             static const int DEFAULT_FOURCC;
             static const double DEFAULT_FPS;
             static const double MIN_ALLOWED_DT_ESTIMATE;
             static const unsigned int DEFAULT_FRAME_SKIP;
+            static const unsigned int DEFAULT_NUMBER_OF_ENCODERS;
+            static const unsigned int DEFAULT_ENCODE_QUEUE_SIZE;
+            static const unsigned long PARALLEL_SEGMENT_MAX_FRAMES;
             static const VideoWriterParams_avi DEFAULT_PARAMS;
 
             // Static methods
@@ -48,8 +58,32 @@ namespace bias
             int fourcc_;
             double fps_;
             bool isFirst_;
+            bool isColorImage_;
+            QString firstFileName_;
+            QString currentFileName_;
             cv::VideoWriter videoWriter_;
+
+            // Encoder threads - with none frames are encoded on the logger
+            // thread. With several, consecutive segments are encoded in 
+            // parallel. A segment is cut short when its encoder's queue is
+            // full and another encoder has room.
+            unsigned int numberOfEncoders_;
+            unsigned int encodeQueueSize_;
+            std::vector<AviEncoderPtr> encoderVec_;
+            AviEncoderPtr encoderPtr_;
+            QPointer<QThreadPool> threadPoolPtr_;
+            bool dropReported_;
+            bool encodeErrorReported_;
+
             void setupOutput(StampedImage stampedImage);
+            void openFile(QString fileName);
+            void closeFile();
+            uint64_t getFileSize() const;
+            void startEncoders();
+            void stopEncoders();
+            void checkEncoders();
+            AviEncoderPtr getLeastBusyEncoder();
+            void updateSegmentSizes();
             static QMutex *videoWriterMutexPtr_;
             
     };
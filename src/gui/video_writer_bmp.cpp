@@ -1,19 +1,31 @@
 #include "video_writer_bmp.hpp"
 #include "basic_types.hpp"
 #include "exception.hpp"
+#include "compression_scheduler.hpp"
+#include "image_sequence_index.hpp"
 #include <iostream>
 #include <QFileInfo>
 #include <stdexcept>
 #include <opencv2/highgui/highgui.hpp>
 #include <QtDebug>
+#include <algorithm>
 
 namespace bias
 {
 
     const QString VideoWriter_bmp::IMAGE_FILE_BASE = QString("image_");
-    const QString VideoWriter_bmp::IMAGE_FILE_EXT = QString(".bmp");
+    const QString VideoWriter_bmp::IMAGE_DIR_BASE = QString("images_");
+    const QString VideoWriter_bmp::INDEX_FILE_NAME = QString("index.bin");
     const QString DUMMY_FILENAME("dummy.bmp");
     const unsigned int VideoWriter_bmp::DEFAULT_FRAME_SKIP = 1;
+    const QString VideoWriter_bmp::DEFAULT_IMAGE_FORMAT = QString("bmp");
+    const unsigned int VideoWriter_bmp::DEFAULT_PNG_COMPRESSION = 1;
+    const unsigned int VideoWriter_bmp::MAX_PNG_COMPRESSION = 9;
+    const unsigned long VideoWriter_bmp::DEFAULT_FRAMES_PER_DIR = 0;
+    const unsigned int VideoWriter_bmp::DEFAULT_NUMBER_OF_COMPRESSORS = 4;
+    const unsigned int VideoWriter_bmp::FRAMES_TODO_MAX_QUEUE_SIZE = 250;
+    const unsigned int VideoWriter_bmp::FRAMES_FINISHED_RING_SIZE = 512;
+    const unsigned long VideoWriter_bmp::INDEX_FLUSH_INTERVAL = 100;
     const VideoWriterParams_bmp VideoWriter_bmp::DEFAULT_PARAMS = 
         VideoWriterParams_bmp();
 
@@ -30,10 +42,25 @@ namespace bias
             ) : VideoWriter(fileName,cameraNumber,parent) 
     {
         isFirst_ = true;
+        skipReported_ = false;
         setFrameSkip(params.frameSkip);
+        imageFormat_ = params.imageFormat;
+        pngCompression_ = params.pngCompression;
+        framesPerDir_ = params.framesPerDir;
+        numberOfCompressors_ = params.numberOfCompressors;
+        currentImageDir_ = -1;
+        numIndexed_ = 0;
+
+        framesToDoQueuePtr_ = std::make_shared<CompressedFrameQueue_bmp>();
+        framesFinishedRingPtr_ = std::make_shared<CompressedFrameRing_bmp>(FRAMES_FINISHED_RING_SIZE);
     }
 
-    VideoWriter_bmp::~VideoWriter_bmp() {}
+    VideoWriter_bmp::~VideoWriter_bmp() 
+    {
+        stopCompressors();
+        clearFinishedFrames();
+        indexFile_.close();
+    }
 
 
     void VideoWriter_bmp::setFileName(QString fileName)
@@ -46,35 +73,100 @@ namespace bias
 
     void VideoWriter_bmp::addFrame(StampedImage stampedImg)
     {
+        bool skipFrame = false;
+
         if (isFirst_)
         {
-            setupOutput();
+            setupOutput(stampedImg);
+            startCompressors();
             isFirst_= false;
         }
 
-        QString imageFileName = IMAGE_FILE_BASE;  
-        imageFileName += QString::number(frameCount_);
-        imageFileName += IMAGE_FILE_EXT;
-        QFileInfo imageFileInfo(logDir_,imageFileName);
-        QString fullPathName = imageFileInfo.absoluteFilePath();
         if (frameCount_%frameSkip_==0) 
         {
-            try
+            QString relPath = getImageRelativePath(getImageNumber(stampedImg));
+            QString fullPathName = logDir_.absoluteFilePath(relPath);
+
+            // Finished frames are put back into order for the index
+            unsigned long writeIndex = 0;
+            bool haveNewFrame = false;
+            framesToDoQueuePtr_ -> acquireLock();
+            if (
+                    (framesToDoQueuePtr_ -> size() < FRAMES_TODO_MAX_QUEUE_SIZE) && 
+                    (framesFinishedRingPtr_ -> reserve(writeIndex))
+               )
             {
-                cv::imwrite(fullPathName.toStdString(), stampedImg.image);
+                CompressedFrame_bmp compressedFrame(fullPathName, stampedImg, writeParams_);
+                compressedFrame.setRelativePath(relPath);
+                compressedFrame.setWriteIndex(writeIndex);
+                framesToDoQueuePtr_ -> push(compressedFrame);
+                haveNewFrame = true;
             }
-            catch (cv::Exception &exc)
+            else
             {
-                unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
-                std::string errorMsg("adding frame failed - "); 
-                errorMsg += exc.what();
-                throw RuntimeError(errorId, errorMsg);
+                skipFrame = true;
+            }
+            framesToDoQueuePtr_ -> releaseLock();
+            if (haveNewFrame)
+            {
+                CompressionScheduler::instance().notify();
             }
         }
 
+        if ((skipFrame) && (!skipReported_))
+        { 
+            std::cout << "warning: logging overflow - skipped frame -" << std::endl;
+            unsigned int errorId = ERROR_FRAMES_TODO_MAX_QUEUE_SIZE;
+            QString errorMsg("logger framesToDoQueue has exceeded the maximum allowed size");
+            emit imageLoggingError(errorId, errorMsg);
+            skipReported_ = true;
+        }
+
+        clearFinishedFrames();
         frameCount_++;
     }
 
+
+    void VideoWriter_bmp::finish()
+    {
+        bool finished = false;
+        while (!finished)
+        {
+            framesToDoQueuePtr_ -> acquireLock();
+            if ( (framesToDoQueuePtr_ -> size()) == 0)
+            {
+                finished = true;
+            }
+            framesToDoQueuePtr_ -> releaseLock();
+        }
+        while (clearFinishedFrames() > 0);
+
+        // Close the index so the image sequence is complete when finish 
+        // returns. Errors are reported by imageLoggingError.
+        stopCompressors();
+        if (indexFile_.is_open())
+        {
+            indexFile_.close();
+            if (indexFile_.fail())
+            {
+                unsigned int errorId = ERROR_VIDEO_WRITER_FINISH;
+                QString errorMsg("video writer bmp unable to write image index");
+                emit imageLoggingError(errorId, errorMsg);
+            }
+        }
+    }
+
+
+    bool VideoWriter_bmp::isBacklogged()
+    {
+        if (compressorPtr_.isNull())
+        {
+            return false;
+        }
+        return compressorPtr_ -> isBacklogged(FRAMES_TODO_MAX_QUEUE_SIZE);
+    }
+
+
     unsigned int VideoWriter_bmp::getNextVersionNumber()
     {
         unsigned int nextVerNum = 0;
@@ -95,7 +187,22 @@ namespace bias
         return nextVerNum;
     }
 
-    void VideoWriter_bmp::setupOutput()
+
+    QStringList VideoWriter_bmp::getListOfAllowedImageFormats()
+    {
+        QStringList formatList;
+        formatList << QString("bmp") << QString("png") << QString("tif");
+        return formatList;
+    }
+
+
+    bool VideoWriter_bmp::isAllowedImageFormat(QString imageFormat)
+    {
+        return getListOfAllowedImageFormats().contains(imageFormat);
+    }
+
+
+    void VideoWriter_bmp::setupOutput(StampedImage stampedImg)
     {
         if (!baseDir_.exists())
         {
@@ -106,6 +213,30 @@ namespace bias
             throw RuntimeError(errorId, errorMsg);
         }
 
+        if (!isAllowedImageFormat(imageFormat_))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("image format "); 
+            errorMsg += imageFormat_.toStdString();
+            errorMsg += std::string(" is not supported");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // 16 bit images need a lossless format which can hold them 
+        if ((stampedImg.image.depth() == CV_16U) && (imageFormat_ == QString("bmp")))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("bmp images can't hold 16 bit data - use png or tif"); 
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        writeParams_.clear();
+        if (imageFormat_ == QString("png"))
+        {
+            writeParams_.push_back(CV_IMWRITE_PNG_COMPRESSION);
+            writeParams_.push_back(int(std::min(pngCompression_, MAX_PNG_COMPRESSION)));
+        }
+
         unsigned int verNum = getNextVersionNumber();
         QString logDirName = getLogDirName(verNum);
         logDir_ = getLogDir(verNum);
@@ -138,6 +269,21 @@ namespace bias
             throw RuntimeError(errorId, errorMsg);
         }
 
+        QString indexFileName = logDir_.absoluteFilePath(INDEX_FILE_NAME);
+        indexFile_.open(indexFileName.toStdString(), std::ios::out | std::ios::binary);
+        if (!indexFile_.is_open())
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("unable to create index file, "); 
+            errorMsg += indexFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        std::vector<char> header;
+        ImageSequenceIndex::getHeader(header);
+        indexFile_.write(&header[0], header.size());
+        indexFile_.flush();
+        numIndexed_ = 0;
+        currentImageDir_ = -1;
     }
 
     QString VideoWriter_bmp::getUniqueDirName()
@@ -169,4 +315,113 @@ namespace bias
         return logDir;
     }
 
+
+    QString VideoWriter_bmp::getImageRelativePath(unsigned long frameNumber)
+    {
+        // image_N.ext, or images_DDDDDD/image_N.ext when split into 
+        // subdirectories. Subdirectories are created as they are reached.
+        QString imageFileName = IMAGE_FILE_BASE;  
+        imageFileName += QString::number(frameNumber);
+        imageFileName += QString(".") + imageFormat_;
+        if (framesPerDir_ == 0)
+        {
+            checkIndexPath(imageFileName);
+            return imageFileName;
+        }
+
+        long imageDir = long(frameNumber/framesPerDir_);
+        QString imageDirName = IMAGE_DIR_BASE + QString("%1").arg(imageDir,6,10,QChar('0'));
+        QString relPath = imageDirName + QString("/") + imageFileName;
+        checkIndexPath(relPath);
+        if (imageDir != currentImageDir_)
+        {
+            if (!logDir_.exists(imageDirName) && !logDir_.mkdir(imageDirName))
+            {
+                unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+                std::string errorMsg("unable to create image directory, "); 
+                errorMsg += imageDirName.toStdString();
+                throw RuntimeError(errorId, errorMsg);
+            }
+            currentImageDir_ = imageDir;
+        }
+        return relPath;
+    }
+
+
+    void VideoWriter_bmp::checkIndexPath(QString relPath)
+    {
+        // Index entries have a fixed size path field
+        if (!ImageSequenceIndex::fitsPath(relPath.toStdString()))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
+            std::string errorMsg("image path too long for index, "); 
+            errorMsg += relPath.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void VideoWriter_bmp::startCompressors()
+    {
+        framesToDoQueuePtr_ -> clear();
+        framesFinishedRingPtr_ -> reset();
+        compressorPtr_ = new Compressor_bmp(
+                framesToDoQueuePtr_, 
+                framesFinishedRingPtr_, 
+                cameraNumber_
+                );
+        connect(
+                compressorPtr_,
+                SIGNAL(imageLoggingError(unsigned int, QString)),
+                this,
+                SLOT(onCompressorError(unsigned int, QString))
+               );
+        CompressionScheduler::instance().addClient(compressorPtr_, numberOfCompressors_);
+    }
+
+
+    void VideoWriter_bmp::stopCompressors()
+    {
+        if (compressorPtr_.isNull())
+        {
+            return;
+        }
+
+        CompressionScheduler::instance().stopClient(compressorPtr_);
+        delete compressorPtr_;
+    }
+
+
+    unsigned int VideoWriter_bmp::clearFinishedFrames()
+    {
+        // Index contiguous written frames 
+        framesFinishedRingPtr_ -> drain([this](CompressedFrame_bmp &frame)
+        {
+            ImageSequenceIndexEntry indexEntry;
+            indexEntry.frameCount = frame.getFrameCount();
+            indexEntry.timeStamp = frame.getTimeStamp();
+            if (!indexEntry.setPath(frame.getRelativePath().toStdString()))
+            {
+                // Checked when the path was made, kept out of the index if not
+                return;
+            }
+            indexFile_.write((const char *) &indexEntry, sizeof(ImageSequenceIndexEntry));
+
+            numIndexed_++;
+            if (numIndexed_%INDEX_FLUSH_INTERVAL == 0)
+            {
+                indexFile_.flush();
+            }
+        });
+        return (unsigned int)(framesFinishedRingPtr_ -> pending());
+    }
+
+
+    // Private slots
+    // ----------------------------------------------------------------------------------
+    void VideoWriter_bmp::onCompressorError(unsigned int errorId, QString errorMsg)
+    {
+        emit imageLoggingError(errorId, errorMsg);
+    }
+
 } // namespace bias
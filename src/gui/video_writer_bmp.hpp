@@ -2,14 +2,25 @@
 #define BIAS_VIDEO_WRITER_BMP_HPP
 #include "video_writer.hpp"
 #include "video_writer_params.hpp"
+#include "compressed_frame_bmp.hpp"
+#include "compressor_bmp.hpp"
 #include <QDir>
 #include <QString>
+#include <QStringList>
+#include <QPointer>
 #include <vector>
+#include <fstream>
 
 namespace bias
 {
     class VideoWriter_bmp : public VideoWriter
     {
+        // Image sequence writer - one file per frame in bmp, png or tif 
+        // format. Images are encoded and written by the shared compression
+        // workers. Files may be split over subdirectories of framesPerDir 
+        // frames and a binary index (frame count, time stamp, path) is 
+        // written in frame order.
+
         Q_OBJECT 
 
         public:
@@ -24,23 +35,62 @@ namespace bias
             virtual ~VideoWriter_bmp();
             virtual void setFileName(QString fileName);
             virtual void addFrame(StampedImage stampedImg);
+            virtual void finish();
+            virtual bool isBacklogged();
             virtual unsigned int getNextVersionNumber();
 
             static const QString IMAGE_FILE_BASE;
-            static const QString IMAGE_FILE_EXT;
+            static const QString IMAGE_DIR_BASE;
+            static const QString INDEX_FILE_NAME;
             static const unsigned int DEFAULT_FRAME_SKIP;
+            static const QString DEFAULT_IMAGE_FORMAT;
+            static const unsigned int DEFAULT_PNG_COMPRESSION;
+            static const unsigned int MAX_PNG_COMPRESSION;
+            static const unsigned long DEFAULT_FRAMES_PER_DIR;
+            static const unsigned int DEFAULT_NUMBER_OF_COMPRESSORS;
+            static const unsigned int FRAMES_TODO_MAX_QUEUE_SIZE;
+            static const unsigned int FRAMES_FINISHED_RING_SIZE;
+            static const unsigned long INDEX_FLUSH_INTERVAL;
             static const VideoWriterParams_bmp DEFAULT_PARAMS;
 
+            static QStringList getListOfAllowedImageFormats();
+            static bool isAllowedImageFormat(QString imageFormat);
+
         protected:
 
             bool isFirst_;
+            bool skipReported_;
             QDir baseDir_;
             QDir logDir_;
             QString baseName_;
-            void setupOutput();
+
+            QString imageFormat_;
+            unsigned int pngCompression_;
+            unsigned long framesPerDir_;
+            unsigned int numberOfCompressors_;
+            std::vector<int> writeParams_;
+
+            long currentImageDir_;
+            unsigned long numIndexed_;
+            std::ofstream indexFile_;
+
+            QPointer<Compressor_bmp> compressorPtr_;
+            CompressedFrameQueuePtr_bmp framesToDoQueuePtr_;
+            CompressedFrameRingPtr_bmp framesFinishedRingPtr_;
+
+            void setupOutput(StampedImage stampedImg);
             QString getUniqueDirName();
             QString getLogDirName(unsigned int verNum);
             QDir getLogDir(unsigned int verNum);
+            QString getImageRelativePath(unsigned long frameNumber);
+            void checkIndexPath(QString relPath);
+
+            void startCompressors();
+            void stopCompressors();
+            unsigned int clearFinishedFrames();
+
+        private slots:
+            void onCompressorError(unsigned int errorId, QString errorMsg);
 
     };
    
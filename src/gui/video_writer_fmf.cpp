@@ -1,14 +1,28 @@
 #include "video_writer_fmf.hpp"
 #include "basic_types.hpp"
 #include "exception.hpp"
+#include "fmf_stripe_reader.hpp"
+#include "recording_journal.hpp"
+#include <QDir>
+#include <QVariantMap>
+#include <QVariantList>
+#include <QThreadPool>
 #include <iostream>
+#include <algorithm>
 #include <stdint.h>
 #include <stdexcept>
 
 namespace bias
 {
     const unsigned int VideoWriter_fmf::DEFAULT_FRAME_SKIP = 1;
+    const bool VideoWriter_fmf::DEFAULT_DIRECT_IO = false;
+    const unsigned int VideoWriter_fmf::DEFAULT_STRIPE_CHUNK_FRAMES = 16;
     const unsigned int VideoWriter_fmf::FMF_VERSION = 1;
+    const uint64_t VideoWriter_fmf::FMF_HEADER_SIZE = 3*sizeof(uint32_t) + 2*sizeof(uint64_t);
+    const uint64_t VideoWriter_fmf::FMF_NUM_FRAMES_POS = 3*sizeof(uint32_t) + sizeof(uint64_t);
+    const size_t VideoWriter_fmf::BUFFER_SIZE = 8*1024*1024;
+    const unsigned int VideoWriter_fmf::NUMBER_OF_BUFFERS = 8;
+    const unsigned int VideoWriter_fmf::MIN_FRAMES_PER_BUFFER = 4;
     const QString DUMMY_FILENAME("dummy.fmf");
     const VideoWriterParams_fmf VideoWriter_fmf::DEFAULT_PARAMS =
         VideoWriterParams_fmf();
@@ -25,30 +39,35 @@ namespace bias
             ) : VideoWriter(fileName, cameraNumber, parent)
     {
         numWritten_ = 0;
+        bytesPerChunk_ = 0;
+        checkpointSequence_ = 0;
         isFirst_ = true;
+        directIo_ = params.directIo;
+        stripeDirs_ = params.stripeDirs;
+        stripeChunkFrames_ = std::max(params.stripeChunkFrames, 1U);
         setFrameSkip(params.frameSkip);
-    }
 
-    VideoWriter_fmf::~VideoWriter_fmf()
-    {
-        file_.close();
+        // One writer thread per stripe
+        threadPoolPtr_ = new QThreadPool(this);
+        threadPoolPtr_ -> setMaxThreadCount(1 + stripeDirs_.size());
     }
 
-    void VideoWriter_fmf::finish()
+    VideoWriter_fmf::~VideoWriter_fmf()
     {
         try
         {
-            file_.seekp(20);
-            file_.write((char*) &numWritten_, sizeof(uint64_t));
+            closeFile();
         }
-        catch (std::ifstream::failure &exc)
+        catch (RuntimeError &runtimeError)
         {
-            unsigned int errorId = ERROR_VIDEO_WRITER_FINISH;
-            std::string errorMsg("video writer finish - failed");
-            errorMsg +=  "to write number frames:\n\n"; 
-            errorMsg += exc.what();
-            throw RuntimeError(errorId, errorMsg); 
+            std::cout << "error: " << runtimeError.what() << std::endl;
         }
+        threadPoolPtr_ -> waitForDone();
+    }
+
+    void VideoWriter_fmf::finish()
+    {
+        closeFile();
     }
 
     void VideoWriter_fmf::addFrame(StampedImage stampedImg)
@@ -60,19 +79,29 @@ namespace bias
         }
         if (frameCount_%frameSkip_==0)
         {
-            try
+            if (isRolloverDue(stampedImg.timeStamp, getNumberOfBytes() + bytesPerChunk_))
             {
-                file_.write((char*) &stampedImg.timeStamp, sizeof(double));
-                file_.write((char*) stampedImg.image.data, size_.width*size_.height*sizeof(char)); 
+                // Start next segment - the frame goes into the new file
+                closeFile();
+                openFile(getSegmentFileName(firstFileName_, getNumberOfSegments()));
             }
-            catch (std::ifstream::failure &exc)
+
+            // Only blocks when all staging buffers are waiting to be written 
+            size_t stripe = size_t((numWritten_/stripeChunkFrames_)%fileWriterVec_.size());
+            StagedFileWriterPtr fileWriterPtr = fileWriterVec_[stripe];
+            fileWriterPtr -> write((char*) &stampedImg.timeStamp, sizeof(double));
+            fileWriterPtr -> write((char*) stampedImg.image.data, size_.width*size_.height*sizeof(char)); 
+            numWrittenVec_[stripe]++;
+            numWritten_++;
+
+            addSegmentFrame(stampedImg.timeStamp, getNumberOfBytes());
+
+            // Keep the header frame count close behind the data on disk
+            if (isCheckpointDue(stampedImg.timeStamp, (unsigned long)(numWritten_)))
             {
-                unsigned int errorId = ERROR_VIDEO_WRITER_ADD_FRAME;
-                std::string errorMsg("video writer add frame failed:\n\n"); 
-                errorMsg += exc.what();
-                throw RuntimeError(errorId, errorMsg); 
+                writeCheckpoint();
+                markCheckpoint(stampedImg.timeStamp, (unsigned long)(numWritten_));
             }
-            numWritten_++;
         }
         else 
         {
@@ -100,58 +129,185 @@ namespace bias
             throw RuntimeError(errorId,errorMsg);
         }
 
-        // Set error control state, set exceptions mask
-        file_.clear();
-        file_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-       
-        // Get unique name for file and open for reading
-        QString incrFileName = getUniqueFileName();
+        setSize(stampedImg.image.size());
+        bytesPerChunk_ = uint64_t(size_.width)*uint64_t(size_.height) + sizeof(double);
 
-        try
+        for (QString stripeDir : stripeDirs_)
         {
-            file_.open(incrFileName.toStdString(), std::ios::binary | std::ios::out);
+            if (!QDir(stripeDir).exists())
+            {
+                unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+                std::string errorMsg("video writer fmf setup failed:\n\n"); 
+                errorMsg += "stripe directory does not exist, ";
+                errorMsg += stripeDir.toStdString();
+                throw RuntimeError(errorId,errorMsg);
+            }
         }
-        catch (std::ifstream::failure &exc)
+
+        // Staging buffers hold at least a few frames each so writes stay large
+        size_t bufferSize = std::max(BUFFER_SIZE, size_t(MIN_FRAMES_PER_BUFFER*bytesPerChunk_));
+        size_t numStripes = 1 + size_t(stripeDirs_.size());
+        for (size_t i=0; i<numStripes; i++)
         {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to open file:\n\n"); 
-            errorMsg += exc.what();
-            throw RuntimeError(errorId, errorMsg); 
+            fileWriterVec_.push_back(std::make_shared<StagedFileWriter>(bufferSize, NUMBER_OF_BUFFERS));
         }
+        numWrittenVec_.resize(fileWriterVec_.size(), 0);
+
+        // Get unique name for file and open for writing. Further segments, 
+        // if any, are named after the first.
+        firstFileName_ = getUniqueFileName();
+        openFile(firstFileName_);
+    }
+
+
+    void VideoWriter_fmf::openFile(QString fileName)
+    {
+        // Each stripe is a complete fmf file. The first stripe is fileName.
+        currentFileName_ = fileName;
+        numWritten_ = 0;
+        haveCheckpoint_ = false;
+        uint64_t preallocateSize = getPreallocateSize()/fileWriterVec_.size();
 
-        if (!file_.is_open())
+        for (size_t i=0; i<fileWriterVec_.size(); i++)
         {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to open file:\n\n"); 
-            errorMsg += "no exception thrown";
-            throw RuntimeError(errorId, errorMsg); 
+            QString stripeDir = (i > 0) ? stripeDirs_[int(i)-1] : QString();
+            QString stripeFileName = FmfStripeReader::getStripeFileName(fileName, stripeDir, (unsigned int)(i));
+            StagedFileWriterPtr fileWriterPtr = fileWriterVec_[i];
+            fileWriterPtr -> open(stripeFileName, directIo_);
+            if (checkpointParams_.enabled)
+            {
+                fileWriterPtr -> openJournal(RecordingJournal::getFileName(stripeFileName));
+            }
+            threadPoolPtr_ -> start(fileWriterPtr.get());
+            numWrittenVec_[i] = 0;
+
+            // Cast values to integers with specific widths
+            uint32_t fmfVersion = uint32_t(FMF_VERSION);
+            uint32_t width = uint32_t(size_.width);
+            uint32_t height = uint32_t(size_.height);
+            uint64_t bytesPerChunk = bytesPerChunk_;
+
+            // Add fmf header to file
+            fileWriterPtr -> write((char*) &fmfVersion, sizeof(uint32_t));
+            fileWriterPtr -> write((char*) &height, sizeof(uint32_t));
+            fileWriterPtr -> write((char*) &width, sizeof(uint32_t));
+            fileWriterPtr -> write((char*) &bytesPerChunk, sizeof(uint64_t));
+            fileWriterPtr -> write((char*) &numWrittenVec_[i], sizeof(uint64_t));
+
+            if (preallocateSize > 0)
+            {
+                fileWriterPtr -> preallocate(preallocateSize);
+            }
         }
 
-        setSize(stampedImg.image.size());
+        beginSegment(fileName);
+        writeStripeManifest(false);
+    }
 
-        // Cast values to integers with specific widths
-        uint32_t fmfVersion = uint32_t(FMF_VERSION);
-        uint32_t width = uint32_t(size_.width);
-        uint32_t height = uint32_t(size_.height);
-        uint64_t bytesPerChunk = uint64_t(width)*uint64_t(height) + sizeof(double);
 
-        // Add fmf header to file
-        try 
+    void VideoWriter_fmf::closeFile()
+    {
+        // Final frame counts, then flush staging buffers and stop writer threads
+        if (fileWriterVec_.empty() || (!(fileWriterVec_.front() -> isOpen())))
         {
-            file_.write((char*) &fmfVersion, sizeof(uint32_t));
-            file_.write((char*) &height, sizeof(uint32_t));
-            file_.write((char*) &width, sizeof(uint32_t));
-            file_.write((char*) &bytesPerChunk, sizeof(uint64_t));
-            file_.write((char*) &numWritten_, sizeof(uint64_t));
+            return;
         }
-        catch (std::ifstream::failure &exc)
+        writeNumberOfFrames();
+        uint64_t fileSize = getNumberOfBytes();
+        for (StagedFileWriterPtr fileWriterPtr : fileWriterVec_)
         {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to write fmf header:\n\n"); 
-            errorMsg += exc.what();
-            throw RuntimeError(errorId, errorMsg); 
+            fileWriterPtr -> close();
         }
+        endSegment(fileSize);
+        writeStripeManifest(true);
+    }
+
+
+    void VideoWriter_fmf::writeNumberOfFrames()
+    {
+        for (size_t i=0; i<fileWriterVec_.size(); i++)
+        {
+            fileWriterVec_[i] -> writePatch(FMF_NUM_FRAMES_POS, &numWrittenVec_[i], sizeof(uint64_t));
+        }
+    }
+
 
+    void VideoWriter_fmf::writeCheckpoint()
+    {
+        // Frames still in a staging buffer aren't on disk yet, so each 
+        // stripe's header and journal get the number of frames which have 
+        // been submitted to its writer thread. The checkpoint job syncs
+        // them before the journal record is written.
+        for (size_t i=0; i<fileWriterVec_.size(); i++)
+        {
+            StagedFileWriterPtr fileWriterPtr = fileWriterVec_[i];
+            uint64_t submittedSize = fileWriterPtr -> getSubmittedSize();
+            uint64_t numFrames = 0;
+            if (submittedSize > FMF_HEADER_SIZE)
+            {
+                numFrames = std::min((submittedSize - FMF_HEADER_SIZE)/bytesPerChunk_, numWrittenVec_[i]);
+            }
+            fileWriterPtr -> writePatch(FMF_NUM_FRAMES_POS, &numFrames, sizeof(uint64_t));
+
+            RecordingJournalRecord record;
+            record.format = JOURNAL_FORMAT_FMF;
+            record.sequence = ++checkpointSequence_;
+            record.numFrames = numFrames;
+            record.dataEnd = FMF_HEADER_SIZE + numFrames*bytesPerChunk_;
+            std::vector<char> recordData;
+            RecordingJournal::serialize(record, recordData);
+            fileWriterPtr -> checkpoint(recordData);
+        }
+    }
+
+
+    void VideoWriter_fmf::writeStripeManifest(bool isClosed)
+    {
+        // Lists the stripe files of the current file for FmfStripeReader
+        if (!isStriped())
+        {
+            return;
+        }
+
+        QVariantList stripeList;
+        for (size_t i=0; i<fileWriterVec_.size(); i++)
+        {
+            QVariantMap stripeMap;
+            stripeMap.insert("fileName", fileWriterVec_[i] -> getFileName());
+            stripeMap.insert("numberOfFrames", qulonglong(numWrittenVec_[i]));
+            stripeList.append(stripeMap);
+        }
+
+        QVariantMap manifestMap;
+        manifestMap.insert("cameraNumber", cameraNumber_);
+        manifestMap.insert("chunkFrames", stripeChunkFrames_);
+        manifestMap.insert("numberOfFrames", qulonglong(numWritten_));
+        manifestMap.insert("numberOfStripes", (unsigned int)(fileWriterVec_.size()));
+        manifestMap.insert("closed", isClosed);
+        manifestMap.insert("stripes", stripeList);
+
+        QString manifestFileName = FmfStripeReader::getManifestFileName(currentFileName_);
+        if (!writeJsonFile(manifestFileName, manifestMap))
+        {
+            std::cout << "warning: unable to write stripe manifest, " << manifestFileName.toStdString() << std::endl;
+        }
+    }
+
+
+    uint64_t VideoWriter_fmf::getNumberOfBytes() const
+    {
+        uint64_t numBytes = 0;
+        for (StagedFileWriterPtr fileWriterPtr : fileWriterVec_)
+        {
+            numBytes += fileWriterPtr -> tell();
+        }
+        return numBytes;
+    }
+
+
+    bool VideoWriter_fmf::isStriped() const
+    {
+        return fileWriterVec_.size() > 1;
     }
 
 
@@ -3,7 +3,13 @@
 
 #include "video_writer.hpp"
 #include "video_writer_params.hpp"
-#include <fstream>
+#include "staged_file_writer.hpp"
+#include <QPointer>
+#include <QStringList>
+#include <cstdint>
+#include <vector>
+
+class QThreadPool;
 
 namespace bias 
 {
@@ -24,14 +30,43 @@ namespace bias
             virtual void addFrame(StampedImage stampedImg);
 
             static const unsigned int DEFAULT_FRAME_SKIP;
+            static const bool DEFAULT_DIRECT_IO;
+            static const unsigned int DEFAULT_STRIPE_CHUNK_FRAMES;
             static const unsigned int FMF_VERSION;
+            static const uint64_t FMF_HEADER_SIZE;
+            static const uint64_t FMF_NUM_FRAMES_POS;
+            static const size_t BUFFER_SIZE;
+            static const unsigned int NUMBER_OF_BUFFERS;
+            static const unsigned int MIN_FRAMES_PER_BUFFER;
             static const VideoWriterParams_fmf DEFAULT_PARAMS;
 
         private:
             bool isFirst_;
-            std::fstream file_;
+            bool directIo_;
+            QString firstFileName_;
             uint64_t numWritten_;
+            uint64_t bytesPerChunk_;
+            uint64_t checkpointSequence_;
+
+            // Frames are copied into the file writers' staging buffers and 
+            // written out on their own threads. With striping there is one 
+            // file writer per stripe directory and chunks of stripeChunkFrames
+            // frames go to the stripes in turn.
+            QStringList stripeDirs_;
+            unsigned int stripeChunkFrames_;
+            std::vector<StagedFileWriterPtr> fileWriterVec_;
+            std::vector<uint64_t> numWrittenVec_;
+            QString currentFileName_;
+            QPointer<QThreadPool> threadPoolPtr_;
+
             void setupOutput(StampedImage stampImg);
+            void openFile(QString fileName);
+            void closeFile();
+            void writeNumberOfFrames();
+            void writeCheckpoint();
+            void writeStripeManifest(bool isClosed);
+            uint64_t getNumberOfBytes() const;
+            bool isStriped() const;
     };
 
 } // namespace bias
@@ -4,10 +4,13 @@
 #include <iostream>
 #include <sstream>
 #include <QFileInfo>
-#include <QThreadPool>
+#include "compression_scheduler.hpp"
+#include "mjpg_index.hpp"
+#include "file_preallocate.hpp"
 #include <stdexcept>
 #include <opencv2/highgui/highgui.hpp>
 #include <vector>
+#include <algorithm>
 #include <QtDebug>
 
 namespace bias
@@ -16,12 +19,13 @@ namespace bias
     const QString VideoWriter_jpg::IMAGE_FILE_EXT = QString(".jpg");
     const QString VideoWriter_jpg::MJPG_FILE_EXT = QString(".mjpg");
     const QString VideoWriter_jpg::MJPG_INDEX_EXT = QString(".txt");
+    const QString VideoWriter_jpg::MJPG_BINARY_INDEX_EXT = QString(".bin");
     const QString VideoWriter_jpg::MJPG_FILE_NAME = QString("movie");
     const QString VideoWriter_jpg::MJPG_INDEX_NAME = QString("index");
     const std::string VideoWriter_jpg::MJPG_BOUNDARY_MARKER = std::string("--boundary\r\n");
     const QString DUMMY_FILENAME("dummy.jpg");
     const unsigned int VideoWriter_jpg::FRAMES_TODO_MAX_QUEUE_SIZE = 250;
-    const unsigned int VideoWriter_jpg::FRAMES_FINISHED_MAX_SET_SIZE = 250;
+    const unsigned int VideoWriter_jpg::FRAMES_FINISHED_RING_SIZE = 512;
     const unsigned int VideoWriter_jpg::DEFAULT_FRAME_SKIP = 1;
     const unsigned int VideoWriter_jpg::DEFAULT_QUALITY = 90;
     const unsigned int VideoWriter_jpg::MIN_QUALITY = 0;
@@ -31,6 +35,14 @@ namespace bias
     const bool VideoWriter_jpg::DEFAULT_MJPG_MAX_FRAME_PER_FILE_FLAG = false;
     const unsigned long VideoWriter_jpg::DEFAULT_MJPG_MAX_FRAME_PER_FILE = 5000000;
     const unsigned long VideoWriter_jpg::MJPG_MINVAL_MAX_FRAME_PER_FILE = 10;
+    const unsigned long VideoWriter_jpg::MJPG_INDEX_FLUSH_INTERVAL = 100;
+    const bool VideoWriter_jpg::DEFAULT_FAST_DCT = false;
+    const JpegSubsampling VideoWriter_jpg::DEFAULT_CHROMA_SUBSAMPLING = JPEG_SUBSAMPLING_420;
+    const bool VideoWriter_jpg::DEFAULT_RATE_CONTROL = false;
+    const unsigned int VideoWriter_jpg::DEFAULT_RATE_CONTROL_MIN_QUALITY = 50;
+    const double VideoWriter_jpg::DEFAULT_RATE_CONTROL_TARGET_BYTES_PER_SEC = 0.0;
+    const unsigned int VideoWriter_jpg::DEFAULT_RATE_CONTROL_TARGET_QUEUE_SIZE = 100;
+    const unsigned int VideoWriter_jpg::REDUCE_QUALITY_STEP = 10;
     const VideoWriterParams_jpg VideoWriter_jpg::DEFAULT_PARAMS = VideoWriterParams_jpg();
 
     // VideoWriter_jpg methods
@@ -48,11 +60,11 @@ namespace bias
         //std::cout << params.toString() << std::endl;
 
         isFirst_ = true;
-        skipReported_ = false;;
-        nextFrameToWrite_ = 0;
+        skipReported_ = false;
 
         movieFileCount_ = 0;
         movieFileFrameCount_ = 0;
+        moviePreallocateSize_ = 0;
 
         setFrameSkip(params.frameSkip);
         quality_ = params.quality;
@@ -60,12 +72,15 @@ namespace bias
         mjpgMaxFramePerFileFlag_ = params.mjpgMaxFramePerFileFlag;
         mjpgMaxFramePerFile_ = params.mjpgMaxFramePerFile;
         numberOfCompressors_ = params.numberOfCompressors; 
+        fastDct_ = params.fastDct;
+        chromaSubsampling_ = params.chromaSubsampling;
+        rateControl_ = params.rateControl;
+        minQuality_ = params.minQuality;
+        targetBytesPerSec_ = params.targetBytesPerSec;
+        targetQueueSize_ = params.targetQueueSize;
 
-        threadPoolPtr_ = new QThreadPool(this);
-        threadPoolPtr_ -> setMaxThreadCount(numberOfCompressors_);
         framesToDoQueuePtr_ = std::make_shared<CompressedFrameQueue_jpg>();
-        framesFinishedSetPtr_ = std::make_shared<CompressedFrameSet_jpg>();
-        framesSkippedIndexListPtr_ = std::make_shared<Lockable<std::list<unsigned long>>>();
+        framesFinishedRingPtr_ = std::make_shared<CompressedFrameRing_jpg>(FRAMES_FINISHED_RING_SIZE);
     }
 
 
@@ -74,8 +89,14 @@ namespace bias
         stopCompressors();
         if (mjpgFlag_)
         {
-            movieFile_.close();
-            indexFile_.close();
+            try
+            {
+                closeMovieFiles();
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                std::cout << "error: " << runtimeError.what() << std::endl;
+            }
         }
     }
 
@@ -100,42 +121,54 @@ namespace bias
         }
 
         QString imageFileName = IMAGE_FILE_BASE;  
-        imageFileName += QString::number(frameCount_);
+        imageFileName += QString::number(getImageNumber(stampedImg));
         imageFileName += IMAGE_FILE_EXT;
         QFileInfo imageFileInfo(logDir_,imageFileName);
         QString fullPathName = imageFileInfo.absoluteFilePath();
 
-        framesToDoQueuePtr_  -> acquireLock();
-        framesToDoQueuePtr_  -> releaseLock();
-
         if (frameCount_%frameSkip_==0) 
         {
+            // Mjpg frames reserve a slot in the finished ring so that they can 
+            // be written to the movie file in order. 
+            unsigned long writeIndex = 0;
+            bool haveNewFrame = false;
             framesToDoQueuePtr_ -> acquireLock();
             unsigned int framesToDoQueueSize = framesToDoQueuePtr_ -> size();
-            if (framesToDoQueueSize < FRAMES_TODO_MAX_QUEUE_SIZE)
+
+            // With rate control the quality follows the data rate and the 
+            // number of frames in flight, for mjpg those not yet written too.
+            unsigned int quality = quality_;
+            if (qualityControllerPtr_)
             {
-                CompressedFrame_jpg compressedFrame(fullPathName, stampedImg, quality_, mjpgFlag_);
+                unsigned int queueSize = framesToDoQueueSize;
+                if (mjpgFlag_)
+                {
+                    queueSize = (unsigned int)(framesFinishedRingPtr_ -> pending());
+                }
+                quality = qualityControllerPtr_ -> update(stampedImg.timeStamp, queueSize);
+            }
+
+            if (
+                    (framesToDoQueueSize < FRAMES_TODO_MAX_QUEUE_SIZE) && 
+                    ((!mjpgFlag_) || (framesFinishedRingPtr_ -> reserve(writeIndex)))
+               )
+            {
+                CompressedFrame_jpg compressedFrame(fullPathName, stampedImg, quality, mjpgFlag_);
+                compressedFrame.setWriteIndex(writeIndex);
                 framesToDoQueuePtr_ -> push(compressedFrame);
-                framesToDoQueuePtr_ -> wakeOne();
+                haveNewFrame = true;
             }
             else
             { 
                 skipFrame = true;
             }
             framesToDoQueuePtr_ -> releaseLock();
-
-            if (skipFrame)
+            if (haveNewFrame)
             {
-                framesSkippedIndexListPtr_ -> acquireLock();
-                framesSkippedIndexListPtr_ -> push_back(stampedImg.frameCount);
-                framesSkippedIndexListPtr_ -> releaseLock();
+                CompressionScheduler::instance().notify();
             }
         }
 
-        framesSkippedIndexListPtr_ -> acquireLock();
-        unsigned int framesSkippedIndexListSize = framesSkippedIndexListPtr_ -> size();
-        framesSkippedIndexListPtr_ -> releaseLock();
-
         if ((skipFrame) && (!skipReported_))
         { 
             std::cout << "warning: logging overflow - skipped frame -" << std::endl;
@@ -164,6 +197,53 @@ namespace bias
             framesToDoQueuePtr_ -> releaseLock();
         }
         while (clearFinishedFrames() > 0);
+
+        // Wait for images still being written then close the movie files, 
+        // so the output is complete when finish returns. Errors are reported
+        // by imageLoggingError.
+        stopCompressors();
+        if (mjpgFlag_)
+        {
+            try
+            {
+                closeMovieFiles();
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                unsigned int errorId = runtimeError.id();
+                QString errorMsg = QString::fromStdString(runtimeError.what());
+                emit imageLoggingError(errorId, errorMsg);
+            }
+        }
+    }
+
+
+    bool VideoWriter_jpg::isBacklogged()
+    {
+        if (compressorPtr_.isNull())
+        {
+            return false;
+        }
+        return compressorPtr_ -> isBacklogged(FRAMES_TODO_MAX_QUEUE_SIZE);
+    }
+
+
+    bool VideoWriter_jpg::reduceQuality()
+    {
+        // Lowers the quality (the upper bound with rate control) by one step,
+        // not below the rate control minimum. 
+        unsigned int minQuality = rateControl_ ? minQuality_ : MIN_QUALITY;
+        minQuality = std::max(minQuality, REDUCE_QUALITY_STEP);
+        if (quality_ <= minQuality)
+        {
+            return false;
+        }
+        quality_ = std::max(quality_ - REDUCE_QUALITY_STEP, minQuality);
+        if (qualityControllerPtr_)
+        {
+            qualityControllerPtr_ -> setMaxQuality(quality_);
+        }
+        return true;
     }
 
 
@@ -232,18 +312,89 @@ namespace bias
 
         if (mjpgFlag_)
         {
-            QString movieFileName = getMovieFileName(); 
-            QString indexFileName = getIndexFileName();
-            movieFile_.open(movieFileName.toStdString(), std::ios::out | std::ios::binary);
-            indexFile_.open(indexFileName.toStdString(), std::ios::out);
+            manifestFileName_ = logDir_.absoluteFilePath(MJPG_FILE_NAME + MANIFEST_FILE_SUFFIX + MANIFEST_FILE_EXT);
+            openMovieFiles();
+        }
+    }
+
+
+    void VideoWriter_jpg::openMovieFiles()
+    {
+        QString movieFileName = getMovieFileName(); 
+        QString indexFileName = getIndexFileName(MJPG_INDEX_EXT);
+        QString binaryIndexFileName = getIndexFileName(MJPG_BINARY_INDEX_EXT);
+        movieFile_.open(movieFileName.toStdString(), std::ios::out | std::ios::binary);
+        indexFile_.open(indexFileName.toStdString(), std::ios::out);
+        binaryIndexFile_.open(binaryIndexFileName.toStdString(), std::ios::out | std::ios::binary);
+
+        std::vector<char> header;
+        MjpgIndex::getHeader(header);
+        binaryIndexFile_.write(&header[0], header.size());
+        binaryIndexFile_.flush();
+
+        movieFileName_ = movieFileName;
+        beginSegment(movieFileName);
+
+        moviePreallocateSize_ = getPreallocateSize();
+        if (!preallocateFile(movieFileName, 0, moviePreallocateSize_))
+        {
+            moviePreallocateSize_ = 0;
+        }
+    }
+
+
+    void VideoWriter_jpg::closeMovieFiles()
+    {
+        if (!movieFile_.is_open())
+        {
+            return;
+        }
+        uint64_t movieFileSize = uint64_t(movieFile_.tellp());
+
+        // Movie data is flushed before the index
+        movieFile_.close();
+        bool movieOk = !movieFile_.fail();
+        indexFile_.close();
+        bool indexOk = !indexFile_.fail();
+        binaryIndexFile_.close();
+        bool binaryIndexOk = !binaryIndexFile_.fail();
+
+        if (moviePreallocateSize_ > 0)
+        {
+            releasePreallocation(movieFileName_);
+            moviePreallocateSize_ = 0;
+        }
+        endSegment(movieFileSize);
+
+        if (!(movieOk && indexOk && binaryIndexOk))
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_FINISH;
+            std::string errorMsg("video writer mjpg unable to close movie files, "); 
+            errorMsg += movieFileName_.toStdString();
+            throw RuntimeError(errorId, errorMsg);
         }
     }
 
 
+    void VideoWriter_jpg::nextMovieFiles()
+    {
+        closeMovieFiles();
+        movieFileCount_ += 1;
+        movieFileFrameCount_ = 0;
+        openMovieFiles();
+    }
+
+
+    bool VideoWriter_jpg::isNumberedMovieFile() const
+    {
+        return mjpgMaxFramePerFileFlag_ || isRolloverEnabled();
+    }
+
+
     QString VideoWriter_jpg::getMovieFileName()
     {
         QString movieFileName;
-        if (mjpgMaxFramePerFileFlag_)
+        if (isNumberedMovieFile())
         { 
             QString incrFileName = QString("%1_%2%3").arg(MJPG_FILE_NAME).arg(movieFileCount_).arg(MJPG_FILE_EXT);
             movieFileName = logDir_.absoluteFilePath(incrFileName);
@@ -256,17 +407,17 @@ namespace bias
     }
 
 
-    QString VideoWriter_jpg::getIndexFileName()
+    QString VideoWriter_jpg::getIndexFileName(QString indexExt)
     {
         QString indexFileName;
-        if (mjpgMaxFramePerFileFlag_)
+        if (isNumberedMovieFile())
         {
-            QString incrFileName = QString("%1_%2%3").arg(MJPG_INDEX_NAME).arg(movieFileCount_).arg(MJPG_INDEX_EXT);
+            QString incrFileName = QString("%1_%2%3").arg(MJPG_INDEX_NAME).arg(movieFileCount_).arg(indexExt);
             indexFileName = logDir_.absoluteFilePath(incrFileName);
         }
         else
         {
-            indexFileName = logDir_.absoluteFilePath(MJPG_INDEX_NAME + MJPG_INDEX_EXT);
+            indexFileName = logDir_.absoluteFilePath(MJPG_INDEX_NAME + indexExt);
         }
         return indexFileName;
     }
@@ -307,144 +458,82 @@ namespace bias
     void VideoWriter_jpg::startCompressors()
     {
         framesToDoQueuePtr_ -> clear();
-        compressorPtrVec_.resize(numberOfCompressors_);
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
+        framesFinishedRingPtr_ -> reset();
+        compressorPtr_ = new Compressor_jpg(
+                framesToDoQueuePtr_, 
+                framesFinishedRingPtr_, 
+                cameraNumber_
+                );
+        compressorPtr_ -> setEncoderParams(fastDct_, chromaSubsampling_);
+        if (rateControl_)
         {
-            compressorPtrVec_[i] = new Compressor_jpg(
-                    framesToDoQueuePtr_, 
-                    framesFinishedSetPtr_, 
-                    framesSkippedIndexListPtr_, 
-                    cameraNumber_
+            // Configured quality is the upper bound
+            qualityControllerPtr_ = std::make_shared<JpegQualityController>(
+                    minQuality_, 
+                    quality_, 
+                    targetBytesPerSec_, 
+                    targetQueueSize_
                     );
-            threadPoolPtr_ -> start(compressorPtrVec_[i]);
-            connect(
-                    compressorPtrVec_[i],
-                    SIGNAL(imageLoggingError(unsigned int, QString)),
-                    this,
-                    SLOT(onCompressorError(unsigned int, QString))
-                   );
+            compressorPtr_ -> setQualityController(qualityControllerPtr_);
         }
+        connect(
+                compressorPtr_,
+                SIGNAL(imageLoggingError(unsigned int, QString)),
+                this,
+                SLOT(onCompressorError(unsigned int, QString))
+               );
+        CompressionScheduler::instance().addClient(compressorPtr_, numberOfCompressors_);
     }
 
 
     void VideoWriter_jpg::stopCompressors()
     {
-        // Send all compressor threads a stop signal 
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
+        if (compressorPtr_.isNull())
         {
-            if (!(compressorPtrVec_[i].isNull()))
-            { 
-                compressorPtrVec_[i] -> acquireLock();
-                compressorPtrVec_[i] -> stop();
-                compressorPtrVec_[i] -> releaseLock();
-            }
+            return;
         }
 
-        // Wait until all compressor threads are null
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
-        {
-            while (!(compressorPtrVec_[i].isNull()))
-            {
-                framesToDoQueuePtr_ -> acquireLock();
-                framesToDoQueuePtr_ -> wakeOne();
-                framesToDoQueuePtr_ -> releaseLock();
-            }
-        }
+        CompressionScheduler::instance().stopClient(compressorPtr_);
+        delete compressorPtr_;
     }
 
     unsigned int VideoWriter_jpg::clearFinishedFrames()
     {
-        framesFinishedSetPtr_ -> acquireLock();
-        bool framesFinishedSetEmpty = framesFinishedSetPtr_ -> empty();
-        framesFinishedSetPtr_ -> releaseLock();
-
-        if (!framesFinishedSetEmpty)
+        // Write contiguous finished frames to the movie file
+        framesFinishedRingPtr_ -> drain([this](CompressedFrame_jpg &frame)
         {
-            bool writeDone = false;
-            while ( (!writeDone) && (!framesFinishedSetEmpty) ) 
+            if (frame.haveEncoding())
             {
-                // Handle skipped frames. 
-                // --------------------------------------------------------------------------------
-                framesSkippedIndexListPtr_ -> acquireLock();
-                if (framesSkippedIndexListPtr_ -> size() > 0)
-
-                {
-                    std::list<unsigned long>::iterator skippedIndexIt = framesSkippedIndexListPtr_ -> begin();
-                    bool done = false;
-
-                    while (!done)
-                    {
-                        if (*skippedIndexIt == nextFrameToWrite_)
-                        {
-                            nextFrameToWrite_ += frameSkip_;
-                        }
-                        else if (*skippedIndexIt < nextFrameToWrite_)
-                        {
-                            if (framesSkippedIndexListPtr_ -> size() > 1)
-                            {
-                                skippedIndexIt++;
-                            }
-                            else
-                            {
-                                done = true;
-                            }
-                            framesSkippedIndexListPtr_ -> pop_front();
-                        }
-                        else
-                        {
-                            done = true;
-                        }
-                    }
-                }
-                framesSkippedIndexListPtr_ -> releaseLock();
-
-                // Write next frame to file
-                // --------------------------------------------------------------------------------
-                framesFinishedSetPtr_ -> acquireLock();
-                CompressedFrameSet_jpg::iterator frameIt = framesFinishedSetPtr_ -> begin();
-                CompressedFrame_jpg compressedFrame = *frameIt;
-
-                if (compressedFrame.getFrameCount() == nextFrameToWrite_)
+                uint64_t numBytes = uint64_t(movieFile_.tellp()) + MJPG_BOUNDARY_MARKER.size();
+                numBytes += frame.getEncodedJpgBuffer().size();
+                if (isRolloverDue(frame.getTimeStamp(), numBytes))
                 {
-                    framesFinishedSetPtr_ -> erase(frameIt);
-                    nextFrameToWrite_ += frameSkip_;
-                    writeCompressedMjpgFrame(compressedFrame);
-
-                    movieFileFrameCount_ += 1;
-                    if ((mjpgMaxFramePerFileFlag_) && (movieFileFrameCount_ >= mjpgMaxFramePerFile_)) { 
-                        movieFile_.close();
-                        indexFile_.close();
-                        movieFileCount_ += 1;
-                        movieFileFrameCount_ = 0;
-                        QString movieFileName = getMovieFileName(); 
-                        QString indexFileName = getIndexFileName();
-                        movieFile_.open(movieFileName.toStdString(), std::ios::out | std::ios::binary);
-                        indexFile_.open(indexFileName.toStdString(), std::ios::out);
-                    }
+                    nextMovieFiles();
                 }
-                else
-                {
-                    writeDone = true;
-                }
-                framesFinishedSetEmpty = framesFinishedSetPtr_ -> empty();
-                framesFinishedSetPtr_ -> releaseLock();
-
-            } // while ( (!writeDone) && (!framesFinishedSetEmpty) ) 
+            }
 
-        } // if (!(framesFinishedSetPtr_ 
+            writeCompressedMjpgFrame(frame);
 
-        framesFinishedSetPtr_ -> acquireLock();
-        unsigned int framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-        framesFinishedSetPtr_ -> releaseLock();
-        return framesFinishedSetSize;
+            movieFileFrameCount_ += 1;
+            if ((mjpgMaxFramePerFileFlag_) && (movieFileFrameCount_ >= mjpgMaxFramePerFile_)) { 
+                nextMovieFiles();
+            }
+            else if (movieFileFrameCount_%MJPG_INDEX_FLUSH_INTERVAL == 0)
+            {
+                // Keep the binary index close behind the movie data on disk
+                movieFile_.flush();
+                binaryIndexFile_.flush();
+            }
+        });
+        return (unsigned int)(framesFinishedRingPtr_ -> pending());
     }
 
-    void VideoWriter_jpg::writeCompressedMjpgFrame(CompressedFrame_jpg frame)
+    void VideoWriter_jpg::writeCompressedMjpgFrame(CompressedFrame_jpg &frame)
     {
         if (frame.haveEncoding())
         {
             movieFile_.write(MJPG_BOUNDARY_MARKER.c_str(),MJPG_BOUNDARY_MARKER.size());
-            std::vector<uchar> jpgBuffer = frame.getEncodedJpgBuffer();
+            std::vector<uchar> &jpgBuffer = frame.getEncodedJpgBuffer();
             std::ofstream::pos_type frameBeginPos = movieFile_.tellp();
             movieFile_.write((const char *) &jpgBuffer[0],jpgBuffer.size());
             std::ofstream::pos_type frameEndPos = movieFile_.tellp();
@@ -453,9 +542,24 @@ namespace bias
             ss << frame.getFrameCount()  << " "; 
             ss << frame.getTimeStamp()   << " ";
             ss << frameBeginPos          << " ";
-            ss << frameEndPos            << std::endl;;
+            ss << frameEndPos;
+            if (rateControl_)
+            {
+                ss << " " << frame.getQuality();
+            }
+            ss << std::endl;
             std::string indexData = ss.str();
             indexFile_.write(indexData.c_str(), indexData.size());
+
+            MjpgIndexEntry indexEntry;
+            indexEntry.frameCount = frame.getFrameCount();
+            indexEntry.timeStamp = frame.getTimeStamp();
+            indexEntry.offset = uint64_t(frameBeginPos);
+            indexEntry.size = uint64_t(frameEndPos - frameBeginPos);
+            indexEntry.quality = uint32_t(frame.getQuality());
+            binaryIndexFile_.write((const char *) &indexEntry, sizeof(MjpgIndexEntry));
+
+            addSegmentFrame(frame.getTimeStamp(), uint64_t(frameEndPos));
         }
     }
 
@@ -4,6 +4,7 @@
 #include "video_writer_params.hpp"
 #include "compressed_frame_jpg.hpp"
 #include "compressor_jpg.hpp"
+#include "jpeg_quality_controller.hpp"
 #include <QPointer>
 #include <QDir>
 #include <QString>
@@ -13,8 +14,6 @@
 #include <string>
 #include <fstream>
 
-class QThreadPool;
-
 namespace bias
 {
 
@@ -37,16 +36,19 @@ namespace bias
             virtual unsigned int getNextVersionNumber();
             virtual void addFrame(StampedImage stampedImg);
             virtual void finish();
+            virtual bool isBacklogged();
+            virtual bool reduceQuality();
 
             static const QString IMAGE_FILE_BASE;
             static const QString IMAGE_FILE_EXT;
             static const QString MJPG_FILE_EXT; 
             static const QString MJPG_INDEX_EXT; 
+            static const QString MJPG_BINARY_INDEX_EXT; 
             static const QString MJPG_FILE_NAME;
             static const QString MJPG_INDEX_NAME;
             static const std::string MJPG_BOUNDARY_MARKER;
             static const unsigned int FRAMES_TODO_MAX_QUEUE_SIZE;
-            static const unsigned int FRAMES_FINISHED_MAX_SET_SIZE;
+            static const unsigned int FRAMES_FINISHED_RING_SIZE;
             static const unsigned int DEFAULT_FRAME_SKIP;
             static const unsigned int DEFAULT_QUALITY;
             static const unsigned int MIN_QUALITY;
@@ -56,6 +58,14 @@ namespace bias
             static const bool DEFAULT_MJPG_MAX_FRAME_PER_FILE_FLAG;
             static const unsigned long DEFAULT_MJPG_MAX_FRAME_PER_FILE;
             static const unsigned long MJPG_MINVAL_MAX_FRAME_PER_FILE;
+            static const unsigned long MJPG_INDEX_FLUSH_INTERVAL;
+            static const bool DEFAULT_FAST_DCT;
+            static const JpegSubsampling DEFAULT_CHROMA_SUBSAMPLING;
+            static const bool DEFAULT_RATE_CONTROL;
+            static const unsigned int DEFAULT_RATE_CONTROL_MIN_QUALITY;
+            static const double DEFAULT_RATE_CONTROL_TARGET_BYTES_PER_SEC;
+            static const unsigned int DEFAULT_RATE_CONTROL_TARGET_QUEUE_SIZE;
+            static const unsigned int REDUCE_QUALITY_STEP;
             static const VideoWriterParams_jpg DEFAULT_PARAMS;
 
 
@@ -71,33 +81,44 @@ namespace bias
             QString baseName_;
             QDir logDir_;
             unsigned int numberOfCompressors_;
-            unsigned long nextFrameToWrite_;
+            bool fastDct_;
+            JpegSubsampling chromaSubsampling_;
+
+            bool rateControl_;
+            unsigned int minQuality_;
+            double targetBytesPerSec_;
+            unsigned int targetQueueSize_;
+            JpegQualityControllerPtr qualityControllerPtr_;
 
             std::ofstream movieFile_;
             std::ofstream indexFile_;
+            std::ofstream binaryIndexFile_;
 
             unsigned int movieFileCount_;
             unsigned long movieFileFrameCount_;
+            QString movieFileName_;
+            uint64_t moviePreallocateSize_;
 
-            std::vector<QPointer<Compressor_jpg>> compressorPtrVec_;
+            QPointer<Compressor_jpg> compressorPtr_;
 
             CompressedFrameQueuePtr_jpg framesToDoQueuePtr_;
-            CompressedFrameSetPtr_jpg framesFinishedSetPtr_;
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr_;
-
-            QPointer<QThreadPool> threadPoolPtr_;
+            CompressedFrameRingPtr_jpg framesFinishedRingPtr_;
 
             void setupOutput();
             QString getUniqueDirName();
             QString getLogDirName(unsigned int verNum);
             QDir getLogDir(unsigned int verNum);
             QString getMovieFileName();
-            QString getIndexFileName();
+            QString getIndexFileName(QString indexExt);
+            void openMovieFiles();
+            void closeMovieFiles();
+            void nextMovieFiles();
+            bool isNumberedMovieFile() const;
 
             void startCompressors();
             void stopCompressors();
             unsigned int clearFinishedFrames();
-            void writeCompressedMjpgFrame(CompressedFrame_jpg frame);
+            void writeCompressedMjpgFrame(CompressedFrame_jpg &frame);
 
 
         private slots:
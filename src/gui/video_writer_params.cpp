@@ -4,6 +4,7 @@
 #include "video_writer_avi.hpp"
 #include "video_writer_fmf.hpp"
 #include "video_writer_ufmf.hpp"
+#include "video_writer_zfmf.hpp"
 #include "background_histogram_ufmf.hpp"
 #include <sstream>
 
@@ -15,12 +16,20 @@ namespace bias
     VideoWriterParams_bmp::VideoWriterParams_bmp()
     {
         frameSkip = VideoWriter_bmp::DEFAULT_FRAME_SKIP;
+        imageFormat = VideoWriter_bmp::DEFAULT_IMAGE_FORMAT;
+        pngCompression = VideoWriter_bmp::DEFAULT_PNG_COMPRESSION;
+        framesPerDir = VideoWriter_bmp::DEFAULT_FRAMES_PER_DIR;
+        numberOfCompressors = VideoWriter_bmp::DEFAULT_NUMBER_OF_COMPRESSORS;
     }
 
     std::string VideoWriterParams_bmp::toString()
     {
         std::stringstream ss;
         ss << "frameSkip: " << frameSkip << std::endl;
+        ss << "imageFormat: " << imageFormat.toStdString() << std::endl;
+        ss << "pngCompression: " << pngCompression << std::endl;
+        ss << "framesPerDir: " << framesPerDir << std::endl;
+        ss << "numberOfCompressors: " << numberOfCompressors << std::endl;
         return ss.str();
     }
 
@@ -35,6 +44,12 @@ namespace bias
         mjpgFlag = VideoWriter_jpg::DEFAULT_MJPG_FLAG;
         mjpgMaxFramePerFileFlag = VideoWriter_jpg::DEFAULT_MJPG_MAX_FRAME_PER_FILE_FLAG;
         mjpgMaxFramePerFile = VideoWriter_jpg::DEFAULT_MJPG_MAX_FRAME_PER_FILE;
+        fastDct = VideoWriter_jpg::DEFAULT_FAST_DCT;
+        chromaSubsampling = VideoWriter_jpg::DEFAULT_CHROMA_SUBSAMPLING;
+        rateControl = VideoWriter_jpg::DEFAULT_RATE_CONTROL;
+        minQuality = VideoWriter_jpg::DEFAULT_RATE_CONTROL_MIN_QUALITY;
+        targetBytesPerSec = VideoWriter_jpg::DEFAULT_RATE_CONTROL_TARGET_BYTES_PER_SEC;
+        targetQueueSize = VideoWriter_jpg::DEFAULT_RATE_CONTROL_TARGET_QUEUE_SIZE;
     }
 
     
@@ -47,6 +62,12 @@ namespace bias
         ss << "mjpgFlag: " << std::boolalpha << mjpgFlag << std::noboolalpha << std::endl;
         ss << "mjpgMaxFramePerFileFlag: " << std::boolalpha << mjpgMaxFramePerFileFlag << std::noboolalpha << std::endl;
         ss << "mjpgMaxFramePerFile: " << mjpgMaxFramePerFile << std::endl;
+        ss << "fastDct: " << std::boolalpha << fastDct << std::noboolalpha << std::endl;
+        ss << "chromaSubsampling: " << JpegEncoder::subsamplingToString(chromaSubsampling).toStdString() << std::endl;
+        ss << "rateControl: " << std::boolalpha << rateControl << std::noboolalpha << std::endl;
+        ss << "minQuality: " << minQuality << std::endl;
+        ss << "targetBytesPerSec: " << targetBytesPerSec << std::endl;
+        ss << "targetQueueSize: " << targetQueueSize << std::endl;
         return ss.str();
     }
 
@@ -59,6 +80,8 @@ namespace bias
         unsigned int fourcc = VideoWriter_avi::DEFAULT_FOURCC;
         //codec = fourccToQString(fourcc); 
         codec = VideoWriter_avi::fourccToString(fourcc); 
+        numberOfEncoders = VideoWriter_avi::DEFAULT_NUMBER_OF_ENCODERS;
+        encodeQueueSize = VideoWriter_avi::DEFAULT_ENCODE_QUEUE_SIZE;
     }
 
     std::string VideoWriterParams_avi::toString()
@@ -66,6 +89,8 @@ namespace bias
         std::stringstream ss;
         ss << "frameSkip: " << frameSkip << std::endl;
         ss << "codec: " << codec.toStdString() << std::endl;
+        ss << "numberOfEncoders: " << numberOfEncoders << std::endl;
+        ss << "encodeQueueSize: " << encodeQueueSize << std::endl;
         return ss.str();
     }
 
@@ -75,6 +100,8 @@ namespace bias
     VideoWriterParams_fmf::VideoWriterParams_fmf()
     {
         frameSkip = VideoWriter_fmf::DEFAULT_FRAME_SKIP;
+        directIo = VideoWriter_fmf::DEFAULT_DIRECT_IO;
+        stripeChunkFrames = VideoWriter_fmf::DEFAULT_STRIPE_CHUNK_FRAMES;
     }
 
 
@@ -82,6 +109,9 @@ namespace bias
     {
         std::stringstream ss;
         ss << "frameSkip: " << frameSkip << std::endl;
+        ss << "directIo: " << std::boolalpha << directIo << std::noboolalpha << std::endl;
+        ss << "stripeDirs: " << stripeDirs.join(", ").toStdString() << std::endl;
+        ss << "stripeChunkFrames: " << stripeChunkFrames << std::endl;
         return ss.str();
     }
 
@@ -98,6 +128,10 @@ namespace bias
         numberOfCompressors = VideoWriter_ufmf::DEFAULT_NUMBER_OF_COMPRESSORS;
         dilateState = VideoWriter_ufmf::DEFAULT_DILATE_STATE;
         dilateWindowSize = VideoWriter_ufmf::DEFAULT_DILATE_WINDOW_SIZE;
+        directIo = VideoWriter_ufmf::DEFAULT_DIRECT_IO;
+        tightBoxes = VideoWriter_ufmf::DEFAULT_TIGHT_BOXES;
+        tightBoxStats = VideoWriter_ufmf::DEFAULT_TIGHT_BOX_STATS;
+        compressionLevel = VideoWriter_ufmf::DEFAULT_COMPRESSION_LEVEL;
     }
 
 
@@ -111,38 +145,83 @@ namespace bias
         ss << "numberOfCompressors: " << numberOfCompressors << std::endl;
         ss << "dilateState: " << std::boolalpha << dilateState << std::noboolalpha << std::endl;
         ss << "dilateWindowSize: " << dilateWindowSize << std::endl;
+        ss << "directIo: " << std::boolalpha << directIo << std::noboolalpha << std::endl;
+        ss << "tightBoxes: " << std::boolalpha << tightBoxes << std::noboolalpha << std::endl;
+        ss << "tightBoxStats: " << std::boolalpha << tightBoxStats << std::noboolalpha << std::endl;
+        ss << "compressionLevel: " << compressionLevel << std::endl;
         return ss.str();
     }
 
 
-    // VideoWriterParams
+    // zfmf
     // ------------------------------------------------------------------------
-    std::string VideoWriterParams::toString()
+    VideoWriterParams_zfmf::VideoWriterParams_zfmf()
     {
-        std::stringstream ss; 
-        std::string sepString = "----------------------------------";
-        ss << "bmp" << std::endl;
-        ss << sepString << std::endl;
-        ss << bmp.toString() << std::endl;
+        frameSkip = VideoWriter_zfmf::DEFAULT_FRAME_SKIP;
+        chunkFrames = VideoWriter_zfmf::DEFAULT_CHUNK_FRAMES;
+        compressionLevel = VideoWriter_zfmf::DEFAULT_COMPRESSION_LEVEL;
+        numberOfCompressors = VideoWriter_zfmf::DEFAULT_NUMBER_OF_COMPRESSORS;
+        directIo = VideoWriter_zfmf::DEFAULT_DIRECT_IO;
+    }
+
+
+    std::string VideoWriterParams_zfmf::toString()
+    {
+        std::stringstream ss;
+        ss << "frameSkip: " << frameSkip << std::endl;
+        ss << "chunkFrames: " << chunkFrames << std::endl;
+        ss << "compressionLevel: " << compressionLevel << std::endl;
+        ss << "numberOfCompressors: " << numberOfCompressors << std::endl;
+        ss << "directIo: " << std::boolalpha << directIo << std::noboolalpha << std::endl;
+        return ss.str();
+    }
+
 
-        ss << "jpg" << std::endl;
-        ss << sepString << std::endl;
-        ss << jpg.toString() << std::endl;
+    // rollover
+    // ------------------------------------------------------------------------
+    VideoWriterParams_rollover::VideoWriterParams_rollover()
+    {
+        maxBytes = VideoWriter::DEFAULT_ROLLOVER_MAX_BYTES;
+        maxDuration = VideoWriter::DEFAULT_ROLLOVER_MAX_DURATION;
+        maxFrames = VideoWriter::DEFAULT_ROLLOVER_MAX_FRAMES;
+        preallocate = VideoWriter::DEFAULT_ROLLOVER_PREALLOCATE;
+    }
 
-        ss << "avi" << std::endl;
-        ss << sepString << std::endl;
-        ss << avi.toString() << std::endl;
 
-        ss << "fmf" << std::endl;
-        ss << sepString << std::endl;
-        ss << fmf.toString() << std::endl;
+    bool VideoWriterParams_rollover::isEnabled() const
+    {
+        return (maxBytes > 0) || (maxDuration > 0.0) || (maxFrames > 0);
+    }
 
-        ss << "ufmf" << std::endl;
-        ss << sepString << std::endl;
-        ss << ufmf.toString() << std::endl;
 
+    std::string VideoWriterParams_rollover::toString()
+    {
+        std::stringstream ss;
+        ss << "maxBytes: " << maxBytes << std::endl;
+        ss << "maxDuration: " << maxDuration << std::endl;
+        ss << "maxFrames: " << maxFrames << std::endl;
+        ss << "preallocate: " << std::boolalpha << preallocate << std::noboolalpha << std::endl;
         return ss.str();
+    }
+
+
+    // checkpoint
+    // ------------------------------------------------------------------------
+    VideoWriterParams_checkpoint::VideoWriterParams_checkpoint()
+    {
+        enabled = VideoWriter::DEFAULT_CHECKPOINT_ENABLED;
+        interval = VideoWriter::DEFAULT_CHECKPOINT_INTERVAL;
+        maxFrames = VideoWriter::DEFAULT_CHECKPOINT_MAX_FRAMES;
+    }
+
 
+    std::string VideoWriterParams_checkpoint::toString()
+    {
+        std::stringstream ss;
+        ss << "enabled: " << std::boolalpha << enabled << std::noboolalpha << std::endl;
+        ss << "interval: " << interval << std::endl;
+        ss << "maxFrames: " << maxFrames << std::endl;
+        return ss.str();
     }
 
 
@@ -1,7 +1,9 @@
 #ifndef BIAS_VIDEO_WRITER_PARAMS_HPP
 #define BIAS_VIDEO_WRITER_PARAMS_HPP
 #include <QString>
+#include <QStringList>
 #include <string>
+#include "jpeg_encoder.hpp"
 
 namespace bias
 {
@@ -10,6 +12,10 @@ namespace bias
     struct VideoWriterParams_bmp
     {
         unsigned int frameSkip;
+        QString imageFormat;
+        unsigned int pngCompression;
+        unsigned long framesPerDir;
+        unsigned int numberOfCompressors;
         VideoWriterParams_bmp();
         std::string toString();
     };
@@ -22,6 +28,12 @@ namespace bias
         bool mjpgFlag; 
         bool mjpgMaxFramePerFileFlag;
         unsigned long mjpgMaxFramePerFile;
+        bool fastDct;
+        JpegSubsampling chromaSubsampling;
+        bool rateControl;
+        unsigned int minQuality;
+        double targetBytesPerSec;
+        unsigned int targetQueueSize;
         VideoWriterParams_jpg();
         std::string toString();
     };
@@ -30,6 +42,8 @@ namespace bias
     {
         unsigned int frameSkip;
         QString codec;
+        unsigned int numberOfEncoders;
+        unsigned int encodeQueueSize;
         VideoWriterParams_avi();
         std::string toString();
     };
@@ -38,6 +52,9 @@ namespace bias
     struct VideoWriterParams_fmf
     {
         unsigned int frameSkip;
+        bool directIo;
+        QStringList stripeDirs;  // additional stripe directories, empty = no striping
+        unsigned int stripeChunkFrames;
         VideoWriterParams_fmf();
         std::string toString();
     };
@@ -53,18 +70,50 @@ namespace bias
         unsigned int medianUpdateInterval;
         unsigned int dilateWindowSize;
         bool dilateState;
+        bool directIo;
+        bool tightBoxes;
+        bool tightBoxStats;
+        unsigned int compressionLevel;
         VideoWriterParams_ufmf();
         std::string toString();
     };
 
 
-    struct VideoWriterParams
+    struct VideoWriterParams_zfmf
+    {
+        unsigned int frameSkip;
+        unsigned int chunkFrames;
+        unsigned int compressionLevel;
+        unsigned int numberOfCompressors;
+        bool directIo;
+        VideoWriterParams_zfmf();
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams_rollover
+    {
+        // Limits for starting a new file segment, 0 = no limit
+        unsigned long long maxBytes;
+        double maxDuration;
+        unsigned long maxFrames;
+        bool preallocate;
+        VideoWriterParams_rollover();
+        bool isEnabled() const;
+        std::string toString();
+    };
+
+
+    struct VideoWriterParams_checkpoint
     {
-        VideoWriterParams_bmp bmp;
-        VideoWriterParams_jpg jpg;
-        VideoWriterParams_avi avi;
-        VideoWriterParams_fmf fmf;
-        VideoWriterParams_ufmf ufmf;
+        // Crash safe recording for fmf and ufmf - header/index fields and a
+        // journal are synced to disk every interval seconds and every 
+        // maxFrames frames, 0 = no limit. Off by default as each checkpoint
+        // costs an fsync of the file and journal.
+        bool enabled;
+        double interval;
+        unsigned long maxFrames;
+        VideoWriterParams_checkpoint();
         std::string toString();
     };
 
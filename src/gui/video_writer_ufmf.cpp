@@ -5,6 +5,9 @@
 #include "background_data_ufmf.hpp"
 #include "background_histogram_ufmf.hpp"
 #include "background_median_ufmf.hpp"
+#include "ufmf_codec.hpp"
+#include "compression_scheduler.hpp"
+#include "recording_journal.hpp"
 #include <QThreadPool>
 #include <QFileInfo>
 #include <QDir>
@@ -15,10 +18,16 @@ namespace bias
     // Static Constants
     // ----------------------------------------------------------------------------------
     const unsigned int VideoWriter_ufmf::FRAMES_TODO_MAX_QUEUE_SIZE   = 250;
-    const unsigned int VideoWriter_ufmf::FRAMES_FINISHED_MAX_SET_SIZE = 250;
+    const unsigned int VideoWriter_ufmf::FRAMES_FINISHED_RING_SIZE    = 512;
     const unsigned int VideoWriter_ufmf::FRAMES_WAIT_MAX_QUEUE_SIZE   =  50;
 
     const unsigned int VideoWriter_ufmf::DEFAULT_FRAME_SKIP = 1;
+    const bool VideoWriter_ufmf::DEFAULT_DIRECT_IO = false;
+    const bool VideoWriter_ufmf::DEFAULT_TIGHT_BOXES = false;
+    const bool VideoWriter_ufmf::DEFAULT_TIGHT_BOX_STATS = false;
+
+    const unsigned int VideoWriter_ufmf::DEFAULT_COMPRESSION_LEVEL = 0;
+    const unsigned int VideoWriter_ufmf::MAX_COMPRESSION_LEVEL = UfmfCodec::MAX_LEVEL;
 
     const unsigned int VideoWriter_ufmf::DEFAULT_BACKGROUND_THRESHOLD = 40;
     const unsigned int VideoWriter_ufmf::MIN_BACKGROUND_THRESHOLD = 1;
@@ -48,6 +57,7 @@ namespace bias
     const unsigned int VideoWriter_ufmf::KEYFRAME_CHUNK_ID   = 0;
     const unsigned int VideoWriter_ufmf::FRAME_CHUNK_ID      = 1;
     const unsigned int VideoWriter_ufmf::INDEX_DICT_CHUNK_ID = 2;
+    const unsigned int VideoWriter_ufmf::INDEX_CHUNK_ID      = 3;
 
     const char VideoWriter_ufmf::CHAR_FOR_DICT  = 'd';
     const char VideoWriter_ufmf::CHAR_FOR_ARRAY = 'a';
@@ -84,38 +94,44 @@ namespace bias
         numberOfCompressors_ = params.numberOfCompressors;
         dilateState_ = params.dilateState;
         dilateWindowSize_ = params.dilateWindowSize; 
+        directIo_ = params.directIo;
+        tightBoxes_ = params.tightBoxes;
+        tightBoxStats_ = params.tightBoxStats;
+        compressionLevel_ = std::min(params.compressionLevel, MAX_COMPRESSION_LEVEL);
 
         // ----------------------------------------------------------------------------
         //std::cout << params.toString() << std::endl;
         // -----------------------------------------------------------------------------
 
-        // Create thread pool for background modelling
+        // Create thread pool for background modelling and file writer. Frames 
+        // are compressed on the shared CompressionScheduler workers.
         threadPoolPtr_ = new QThreadPool(this);
-        unsigned int maxThreadCount = numberOfCompressors_ + BASE_NUMBER_OF_THREADS;
-        threadPoolPtr_ -> setMaxThreadCount(maxThreadCount);
+        threadPoolPtr_ -> setMaxThreadCount(BASE_NUMBER_OF_THREADS);
 
         // Create queue for images sent to background modeler
         bgImageQueuePtr_ = std::make_shared<LockableQueue<StampedImage>>();
         bgNewDataQueuePtr_ = std::make_shared<LockableQueue<BackgroundData_ufmf>>();
         bgOldDataQueuePtr_ = std::make_shared<LockableQueue<BackgroundData_ufmf>>();
-        medianMatQueuePtr_ = std::make_shared<LockableQueue<cv::Mat>>();
+        medianMatQueuePtr_ = std::make_shared<LockableQueue<MedianImage_ufmf>>();
 
-        // Create "to do" queue and "finished" set for frame compressors
+        // Create "to do" queue and "finished" ring for frame compressors
         framesToDoQueuePtr_ = std::make_shared<CompressedFrameQueue_ufmf>();
         framesWaitQueuePtr_ = std::make_shared<CompressedFrameQueue_ufmf>();
-        framesFinishedSetPtr_ = std::make_shared<CompressedFrameSet_ufmf>();
-        framesSkippedIndexListPtr_ = std::make_shared<Lockable<std::list<unsigned long>>>();
+        framesFinishedRingPtr_ = std::make_shared<CompressedFrameRing_ufmf>(FRAMES_FINISHED_RING_SIZE);
 
         isFixedSize_ = false;
         colorCoding_ = QString(DEFAULT_COLOR_CODING);
 
         indexLocation_ = 0;
-        nextFrameToWrite_ = 0;
+        checkpointSequence_ = 0;
         numKeyFramesWritten_ = 0;
         bgUpdateCount_ = 0;
         bgModelFrameCount_ = 0;
         bgModelTimeStamp_ = 0.0;
 
+        lastFrameBytesSaved_ = 0;
+        totalBytesSaved_ = 0;
+
     }
 
 
@@ -123,8 +139,15 @@ namespace bias
     {
         stopBackgroundModeling();
         stopCompressors();
+        try
+        {
+            finishWriting();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            std::cout << "error: " << runtimeError.what() << std::endl;
+        }
         threadPoolPtr_ -> waitForDone();
-        finishWriting();
     } 
 
 
@@ -153,7 +176,7 @@ namespace bias
             // Start background model and frame compressors
             startBackgroundModeling();
             startCompressors();
-            writeKeyFrame();
+            writeKeyFrame(bgModelTimeStamp_);
 
             isFirst_ = false;
         }
@@ -176,7 +199,8 @@ namespace bias
             medianMatQueuePtr_ -> acquireLock();
             if (!(medianMatQueuePtr_ -> empty()))
             {
-                bgMedianImage_ = medianMatQueuePtr_ -> front();
+                bgMedianImage_ = medianMatQueuePtr_ -> front().image;
+                keyFrameCodedData_.swap(medianMatQueuePtr_ -> front().codedData);
                 medianMatQueuePtr_ -> pop();
                 haveNewMedianImage = true;
             }
@@ -191,18 +215,21 @@ namespace bias
                 bgUpdateCount_++;
                 bgModelTimeStamp_ = currentImage_.timeStamp;
                 bgModelFrameCount_ = currentImage_.frameCount;
-                writeKeyFrame();
+                writeKeyFrame(bgModelTimeStamp_);
             }
 
             // Create compressed frame and set its data using the current frame 
             CompressedFrame_ufmf compressedFrame(boxLength_);
             compressedFrame.dilateEnabled(dilateState_);
             compressedFrame.setDilateWindowSize(dilateWindowSize_);
+            compressedFrame.setTightBoxes(tightBoxes_);
+            compressedFrame.setTightBoxStats(tightBoxStats_);
+            compressedFrame.setCompressionLevel(compressionLevel_);
 
             if (!(framesWaitQueuePtr_ -> empty()))
             {
                 // Take pre-allocated compressed frame if available
-                compressedFrame = framesWaitQueuePtr_ -> front();
+                compressedFrame = std::move(framesWaitQueuePtr_ -> front());
                 framesWaitQueuePtr_ -> pop();
             }
 
@@ -213,27 +240,29 @@ namespace bias
                     bgUpdateCount_
                     );
 
+            unsigned long writeIndex = 0;
+            bool haveNewFrame = false;
             framesToDoQueuePtr_ -> acquireLock();
             unsigned int framesToDoQueueSize = framesToDoQueuePtr_ -> size();
-            if (framesToDoQueueSize < FRAMES_TODO_MAX_QUEUE_SIZE)
+            if (
+                    (framesToDoQueueSize < FRAMES_TODO_MAX_QUEUE_SIZE) && 
+                    (framesFinishedRingPtr_ -> reserve(writeIndex))
+               )
             {
                 // Insert new (uncalculated) compressed frame into "to do" queue.
+                compressedFrame.setWriteIndex(writeIndex);
                 framesToDoQueuePtr_ -> push(compressedFrame);
-                framesToDoQueuePtr_ -> wakeOne();
+                haveNewFrame = true;
             }
             else
             {
+                // Queue or ring is full - skip frame
                 skipFrame = true;
             }
             framesToDoQueuePtr_ -> releaseLock();
-
-            if (skipFrame)
+            if (haveNewFrame)
             {
-                // Queue is full - skip frame
-                framesSkippedIndexListPtr_ -> acquireLock();
-                framesSkippedIndexListPtr_ -> push_back(stampedImg.frameCount);
-                framesSkippedIndexListPtr_ -> releaseLock();
-                skipReported_ = true;
+                CompressionScheduler::instance().notify();
             }
 
 
@@ -269,84 +298,58 @@ namespace bias
 
     void VideoWriter_ufmf::finish()
     {
+        // Writes the remaining frames, the index and closes the file so it is
+        // complete when finish returns. Errors are reported by imageLoggingError.
         while (clearFinishedFrames() > 0);
+        stopBackgroundModeling();
+        stopCompressors();
+        try
+        {
+            finishWriting();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            unsigned int errorId = runtimeError.id();
+            QString errorMsg = QString::fromStdString(runtimeError.what());
+            emit imageLoggingError(errorId, errorMsg);
+        }
     }
 
 
-    unsigned int VideoWriter_ufmf::clearFinishedFrames()
+    bool VideoWriter_ufmf::isBacklogged()
     {
-        framesFinishedSetPtr_ -> acquireLock();
-        bool framesFinishedSetEmpty = framesFinishedSetPtr_ -> empty();
-        framesFinishedSetPtr_ -> releaseLock();
-
-        if (!framesFinishedSetEmpty)
+        if (compressorPtr_.isNull())
         {
-            bool writeDone = false;
-            while ( (!writeDone) && (!framesFinishedSetEmpty) ) 
-            {
-                // Handle skipped frames. 
-                // --------------------------------------------------------------------------------
-                framesSkippedIndexListPtr_ -> acquireLock();
-                if (framesSkippedIndexListPtr_ -> size() > 0)
+            return false;
+        }
+        return compressorPtr_ -> isBacklogged(FRAMES_TODO_MAX_QUEUE_SIZE);
+    }
 
-                {
-                    std::list<unsigned long>::iterator skippedIndexIt = framesSkippedIndexListPtr_ -> begin();
-                    bool done = false;
-
-                    while (!done)
-                    {
-                        if (*skippedIndexIt == nextFrameToWrite_)
-                        {
-                            nextFrameToWrite_ += frameSkip_;
-                        }
-                        else if (*skippedIndexIt < nextFrameToWrite_)
-                        {
-                            if (framesSkippedIndexListPtr_ -> size() > 1)
-                            {
-                                skippedIndexIt++;
-                            }
-                            else
-                            {
-                                done = true;
-                            }
-                            framesSkippedIndexListPtr_ -> pop_front();
-                        }
-                        else
-                        {
-                            done = true;
-                        }
-                    }
-                }
-                framesSkippedIndexListPtr_ -> releaseLock();
 
-                // Write next frame to file
-                // --------------------------------------------------------------------------------
-                framesFinishedSetPtr_ -> acquireLock();
-                CompressedFrameSet_ufmf::iterator frameIt = framesFinishedSetPtr_ -> begin();
-                CompressedFrame_ufmf compressedFrame = *frameIt;
+    int VideoWriter_ufmf::getLastFrameBytesSaved() const
+    {
+        // Bytes saved by tight boxes, w.r.t. fixed size boxes, in last frame written.
+        // Only computed when tightBoxStats is set, otherwise 0.
+        return lastFrameBytesSaved_;
+    }
 
-                if (compressedFrame.getFrameCount() == nextFrameToWrite_)
-                {
-                    framesWaitQueuePtr_ -> push(compressedFrame);
-                    framesFinishedSetPtr_ -> erase(frameIt);
-                    nextFrameToWrite_ += frameSkip_;
-                    writeCompressedFrame(compressedFrame);
-                }
-                else
-                {
-                    writeDone = true;
-                }
-                framesFinishedSetEmpty = framesFinishedSetPtr_ -> empty();
-                framesFinishedSetPtr_ -> releaseLock();
 
-            } // while ( (!writeDone) && (!framesFinishedSetEmpty) ) 
+    int64_t VideoWriter_ufmf::getTotalBytesSaved() const
+    {
+        return totalBytesSaved_;
+    }
 
-        } // if (!(framesFinishedSetPtr_ 
 
-        framesFinishedSetPtr_ -> acquireLock();
-        unsigned int framesFinishedSetSize = framesFinishedSetPtr_ -> size();
-        framesFinishedSetPtr_ -> releaseLock();
-        return framesFinishedSetSize;
+    unsigned int VideoWriter_ufmf::clearFinishedFrames()
+    {
+        // Write contiguous finished frames to file and return the compressed 
+        // frames to the wait queue for reuse. 
+        framesFinishedRingPtr_ -> drain([this](CompressedFrame_ufmf &frame)
+        {
+            writeCompressedFrame(frame);
+            framesWaitQueuePtr_ -> push(std::move(frame));
+        });
+        return (unsigned int)(framesFinishedRingPtr_ -> pending());
     }
 
 
@@ -372,298 +375,181 @@ namespace bias
 
     void VideoWriter_ufmf::setupOutputFile(StampedImage stampedImg) 
     {
+        // Get unique name for file and open for writing. The file writer 
+        // serializes into staging buffers which are written out on its own thread.
+        firstFileName_ = getUniqueFileName();
 
-        // Set error control state, set exceptions mask
-        file_.clear();
-        file_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-        // Get unique name for file and open for reading
-        QString incrFileName = getUniqueFileName();
-
-        try
-        {
-            file_.open(incrFileName.toStdString(), std::ios::binary | std::ios::out);
-        }
-        catch (std::ifstream::failure &exc)
-        {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to open file:\n\n"); 
-            errorMsg += exc.what();
-            throw RuntimeError(errorId, errorMsg); 
-        }
+        fileWriterPtr_ = std::make_shared<StagedFileWriter>(
+                StagedFileWriter::DEFAULT_BUFFER_SIZE,
+                StagedFileWriter::DEFAULT_NUMBER_OF_BUFFERS
+                );
+        openOutputFile(firstFileName_);
 
-        if (!file_.is_open())
-        {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to open file:\n\n"); 
-            errorMsg += "no exception thrown";
-            throw RuntimeError(errorId, errorMsg); 
-        }
         setSize(stampedImg.image.size());
 
     }
 
 
-    void VideoWriter_ufmf::writeHeader()
+    void VideoWriter_ufmf::openOutputFile(QString fileName)
     {
-        try 
+        // The file writer, and its staging buffers, are reused for each segment
+        fileWriterPtr_ -> open(fileName, directIo_);
+        if (checkpointParams_.enabled)
         {
-            
-            QByteArray headerStrArray = UFMF_HEADER_STRING.toLatin1();
-            unsigned int headerStrLen = UFMF_HEADER_STRING.size();
-            file_.write((char*) headerStrArray.data(), headerStrLen*sizeof(char));
-
-            uint32_t ufmf_version = uint32_t(UFMF_VERSION_NUMBER);
-            file_.write((char*) &ufmf_version, sizeof(uint32_t));
-
-            indexLocationPtr_ = file_.tellp();
-            uint64_t indexLocation_uint64 = uint64_t(indexLocation_);
-            file_.write((char*) &indexLocation_uint64, sizeof(uint64_t));
-
-            if (isFixedSize_)
-            {
-                uint16_t boxLength_uint16 = uint16_t(boxLength_);
-                file_.write((char*) &boxLength_uint16, sizeof(uint16_t)); 
-                file_.write((char*) &boxLength_uint16, sizeof(uint16_t));
-            }
-            else
-            {
-                uint16_t width = uint16_t(size_.width);
-                file_.write((char*) &width, sizeof(uint16_t));
-
-                uint16_t height = uint16_t(size_.height);
-                file_.write((char*) &height, sizeof(uint16_t));
-            }
-
-            uint8_t isFixedSize_uint8 = uint8_t(isFixedSize_);
-            file_.write((char*) &isFixedSize_uint8, sizeof(uint8_t));
-
-            uint8_t colorCodingLength = uint8_t(colorCoding_.size());
-            file_.write((char*) &colorCodingLength, sizeof(uint8_t));
-
-            QByteArray colorCodingArray = colorCoding_.toLatin1();
-            file_.write((char*) colorCodingArray.data(), colorCodingLength*sizeof(char));
+            fileWriterPtr_ -> openJournal(RecordingJournal::getFileName(fileName));
         }
-        catch (std::ifstream::failure &exc)
+        threadPoolPtr_ -> start(fileWriterPtr_.get());
+        beginSegment(fileName);
+        haveCheckpoint_ = false;
+
+        uint64_t preallocateSize = getPreallocateSize();
+        if (preallocateSize > 0)
         {
-            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
-            std::string errorMsg("video writer unable to write ufmf header:\n\n"); 
-            errorMsg += exc.what();
-            throw RuntimeError(errorId, errorMsg); 
+            fileWriterPtr_ -> preallocate(preallocateSize);
         }
     }
 
-    void VideoWriter_ufmf::finishWriting()
-    {
-        // Move to end of filed
-        file_.seekp(0, std::ios_base::end);
-
-        // Write index
-        // --------------------------------------------------------------------
 
-        // Write index chunk identifier and save index location
-        uint8_t chunkId = uint8_t(INDEX_DICT_CHUNK_ID);
-        file_.write((char*) &chunkId, sizeof(uint8_t));
-        indexLocation_ = file_.tellp();
+    void VideoWriter_ufmf::startNextSegment(double timeStamp)
+    {
+        // Close the current file with its index and continue in a new file. 
+        // Each segment is a complete ufmf file starting with a copy of the 
+        // current keyframe, stamped no later than its first frame.
+        finishWriting();
+        index_.clear();
+        indexLocation_ = 0;
 
-        // Write char for dict and number of keys
-        file_.write((char*) &CHAR_FOR_DICT, sizeof(char));
-        uint8_t numKeys = 2;
-        file_.write((char*) &numKeys, sizeof(uint8_t));
+        openOutputFile(getSegmentFileName(firstFileName_, getNumberOfSegments()));
+        writeHeader();
+        writeKeyFrame(std::min(bgModelTimeStamp_, timeStamp));
+    }
 
-        // Write index -> frame
-        // --------------------------------------------------------------------
 
-        // Write length of key and key for frame
-        const char frameString[] = "frame"; 
-        uint16_t frameStringLength = uint16_t(sizeof(frameString)-1);
-        file_.write((char*) &frameStringLength, sizeof(uint16_t));
-        file_.write((char*) frameString, frameStringLength*sizeof(char));
+    void VideoWriter_ufmf::writeHeader()
+    {
+        QByteArray headerStrArray = UFMF_HEADER_STRING.toLatin1();
+        unsigned int headerStrLen = UFMF_HEADER_STRING.size();
+        fileWriterPtr_ -> write((char*) headerStrArray.data(), headerStrLen*sizeof(char));
 
-        // Write char for dict and number of keys
-        file_.write((char*) &CHAR_FOR_DICT, sizeof(char));
-        numKeys = 2;
-        file_.write((char*) &numKeys, sizeof(uint8_t));
+        // Coded data is flagged by version number as other readers can't decode it
+        uint32_t ufmf_version = uint32_t(UFMF_VERSION_NUMBER);
+        if (compressionLevel_ > 0)
+        {
+            ufmf_version = uint32_t(UfmfCodec::CODED_VERSION_NUMBER);
+        }
+        fileWriterPtr_ -> write((char*) &ufmf_version, sizeof(uint32_t));
 
-        // Write index -> frame -> location
-        // --------------------------------------------------------------------
+        indexLocationPtr_ = fileWriterPtr_ -> tell();
+        uint64_t indexLocation_uint64 = uint64_t(indexLocation_);
+        fileWriterPtr_ -> write((char*) &indexLocation_uint64, sizeof(uint64_t));
 
-        // Write length of key and key for location
-        const char locString[] = "loc";
-        uint16_t locStringLength = uint16_t(sizeof(locString) - 1);
-        file_.write((char*) &locStringLength, sizeof(uint16_t));
-        file_.write((char*) locString, locStringLength*sizeof(char));
-
-        // Write char for array and data type
-        file_.write((char*) &CHAR_FOR_ARRAY, sizeof(char));
-        file_.write((char*) &CHAR_FOR_DTYPE_UINT64, sizeof(char));
-
-        // Write number of bytes and frame positions
-        uint32_t numBytes = uint32_t(framePosList_.size()*sizeof(uint64_t)); 
-        file_.write((char*) &numBytes, sizeof(uint32_t));
-        for ( 
-                std::list<std::streampos>::iterator it=framePosList_.begin(); 
-                it!=framePosList_.end(); 
-                it++
-            )
+        if (isFixedSize_)
         {
-            uint64_t pos = *it;
-            file_.write((char*) &pos, sizeof(uint64_t));
+            uint16_t boxLength_uint16 = uint16_t(boxLength_);
+            fileWriterPtr_ -> write((char*) &boxLength_uint16, sizeof(uint16_t)); 
+            fileWriterPtr_ -> write((char*) &boxLength_uint16, sizeof(uint16_t));
         }
-        // End write index -> frame -> location
-        // --------------------------------------------------------------------
+        else
+        {
+            uint16_t width = uint16_t(size_.width);
+            fileWriterPtr_ -> write((char*) &width, sizeof(uint16_t));
 
-        // Write index -> frame -> timestamp
-        // --------------------------------------------------------------------
-        
-        // Write key length and key for timestamp
-        const char timeStampString[] = "timestamp";
-        uint16_t timeStampStringLength = uint16_t(sizeof(timeStampString)-1);
-        file_.write((char*) &timeStampStringLength, sizeof(uint16_t));
-        file_.write((char*) timeStampString, timeStampStringLength*sizeof(char));
-
-        // Write char for array and data type
-        file_.write((char*) &CHAR_FOR_ARRAY, sizeof(char));
-        file_.write((char*) &CHAR_FOR_DTYPE_DOUBLE, sizeof(char));
-
-        // Write number of bytes and time stamps
-        numBytes = uint32_t(frameTimeStampList_.size()*sizeof(double));
-        file_.write((char*) &numBytes, sizeof(uint32_t));
-        for (
-                std::list<double>::iterator it=frameTimeStampList_.begin(); 
-                it!=frameTimeStampList_.end(); 
-                it++
-            )
-        { 
-            double ts = *it;
-            file_.write((char*) &ts, sizeof(double));
+            uint16_t height = uint16_t(size_.height);
+            fileWriterPtr_ -> write((char*) &height, sizeof(uint16_t));
         }
-        // End write index -> frame -> timestamp
-        // --------------------------------------------------------------------
 
-        // End write index -> frame
-        // --------------------------------------------------------------------
+        uint8_t isFixedSize_uint8 = uint8_t(isFixedSize_);
+        fileWriterPtr_ -> write((char*) &isFixedSize_uint8, sizeof(uint8_t));
 
-        // Write index -> keyframe
-        // --------------------------------------------------------------------
+        uint8_t colorCodingLength = uint8_t(colorCoding_.size());
+        fileWriterPtr_ -> write((char*) &colorCodingLength, sizeof(uint8_t));
 
-        // Write key length and key for keyframe
-        const char keyFrameString[] = "keyframe";
-        uint16_t keyFrameStringLength = uint16_t(sizeof(keyFrameString)-1);
-        file_.write((char*) &keyFrameStringLength, sizeof(uint16_t)); 
-        file_.write((char*) keyFrameString, keyFrameStringLength*sizeof(char));
+        QByteArray colorCodingArray = colorCoding_.toLatin1();
+        fileWriterPtr_ -> write((char*) colorCodingArray.data(), colorCodingLength*sizeof(char));
+    }
 
-        // Write char for dict and number of keys
-        file_.write((char*) &CHAR_FOR_DICT, sizeof(char)); 
-        numKeys = 1;
-        file_.write((char*) &numKeys, sizeof(uint8_t));
+    void VideoWriter_ufmf::finishWriting()
+    {
+        if ((!fileWriterPtr_) || (!(fileWriterPtr_ -> isOpen())))
+        {
+            return;
+        }
 
-        // Write index -> keyframe -> mean
+        // Write index
         // --------------------------------------------------------------------
 
-        // Write length of key and key for mean
-        const char meanString[] = "mean";
-        uint16_t meanStringLength = uint16_t(sizeof(meanString)-1);
-        file_.write((char*) &meanStringLength, sizeof(uint16_t));
-        file_.write((char*) meanString, meanStringLength*sizeof(char));
-
-        // Write char for dict and number of keys
-        file_.write((char*) &CHAR_FOR_DICT, sizeof(char));
-        numKeys = 2;
-        file_.write((char*) &numKeys, sizeof(uint8_t));
-
-        // Write index -> keyframe -> mean -> loc
-        // --------------------------------------------------------------------
+        // Write index chunk identifier and save index location
+        uint8_t chunkId = uint8_t(INDEX_DICT_CHUNK_ID);
+        fileWriterPtr_ -> write((char*) &chunkId, sizeof(uint8_t));
+        indexLocation_ = fileWriterPtr_ -> tell();
 
-        // Write key length and key for location
-        file_.write((char*) &locStringLength, sizeof(uint16_t));
-        file_.write((char*) locString, locStringLength*sizeof(char));
-
-        // Write char for array and data type
-        file_.write((char*) &CHAR_FOR_ARRAY, sizeof(char));
-        file_.write((char*) &CHAR_FOR_DTYPE_UINT64, sizeof(char));
-
-        // Write number of bytes and keyframe positions
-        numBytes = uint32_t(bgKeyFramePosList_.size()*sizeof(uint64_t));
-        file_.write((char*) &numBytes, sizeof(uint32_t));
-        for (
-                std::list<std::streampos>::iterator it = bgKeyFramePosList_.begin();
-                it != bgKeyFramePosList_.end();
-                it++
-            )
-        {
-            uint64_t pos = *it;
-            file_.write((char*) &pos, sizeof(uint64_t));
-        }
-        // End write index -> keyframe -> mean -> loc
-        // --------------------------------------------------------------------
-        
-        // Write index -> keyframe -> mean -> timestamp
-        // --------------------------------------------------------------------
+        // Write each index array - entries which have been checkpointed to 
+        // index chunks are read back from the file and merged with the entries 
+        // still in memory.
+        std::vector<char> prefix;
+        std::vector<char> chunkArray;
+        const std::vector<UfmfIndexChunkInfo> &chunkInfoVec = index_.chunkInfoVec();
 
-        // write key length and key for time stamp
-        file_.write((char*) &timeStampStringLength, sizeof(uint16_t));
-        file_.write((char*) timeStampString, timeStampStringLength*sizeof(char));
-
-        // Write char for array and data type
-        file_.write((char*) &CHAR_FOR_ARRAY, sizeof(char));
-        file_.write((char*) &CHAR_FOR_DTYPE_DOUBLE, sizeof(char));
-
-        // Write number of bytes and keyframe time stamps
-        numBytes = uint32_t(bgKeyFrameTimeStampList_.size()*sizeof(double));
-        file_.write((char*) &numBytes, sizeof(uint32_t));
-        for (
-                std::list<double>::iterator it = bgKeyFrameTimeStampList_.begin(); 
-                it != bgKeyFrameTimeStampList_.end();
-                it++
-            )
+        for (int i=0; i<NUMBER_OF_UFMF_INDEX_ARRAY; i++)
         {
-            double ts = *it;
-            file_.write((char*) &ts, sizeof(double));
-        }
-        // End write index -> keyframe -> mean -> timestamp
-        // --------------------------------------------------------------------
+            UfmfIndexArray array = UfmfIndexArray(i);
+            UfmfIndex::getDictArrayPrefix(array, index_.arrayNumBytes(array), prefix);
+            fileWriterPtr_ -> write(&prefix[0], prefix.size());
 
-        // End write index -> keyframe -> mean
-        // --------------------------------------------------------------------
-        
-        // End write index -> keyframe
-        // --------------------------------------------------------------------
+            for (unsigned int j=0; j<chunkInfoVec.size(); j++)
+            {
+                uint32_t numBytes = UfmfIndex::chunkArrayNumBytes(chunkInfoVec[j], array);
+                if (numBytes > 0)
+                {
+                    chunkArray.resize(numBytes);
+                    fileWriterPtr_ -> read(chunkInfoVec[j].arrayLoc(array), &chunkArray[0], numBytes);
+                    fileWriterPtr_ -> write(&chunkArray[0], numBytes);
+                }
+            }
 
-        // End index
-        // --------------------------------------------------------------------
+            const char *pendingPtr = nullptr;
+            size_t numPendingBytes = index_.pendingArray(array, &pendingPtr);
+            if (numPendingBytes > 0)
+            {
+                fileWriterPtr_ -> write(pendingPtr, numPendingBytes);
+            }
+        }
 
         // Write the index location
-        file_.seekp(indexLocationPtr_, std::ios_base::beg);
         uint64_t indexLocation_uint64 = uint64_t(indexLocation_);
-        file_.write((char*) &indexLocation_uint64, sizeof(uint64_t));
+        fileWriterPtr_ -> writePatch(indexLocationPtr_, &indexLocation_uint64, sizeof(uint64_t));
 
-        // Close the file
-        file_.close();
+        // Close the file - flushes staging buffers and stops the writer thread
+        uint64_t fileSize = fileWriterPtr_ -> tell();
+        fileWriterPtr_ -> close();
+        endSegment(fileSize);
     }
 
 
-    void VideoWriter_ufmf::writeCompressedFrame(CompressedFrame_ufmf frame)
+    void VideoWriter_ufmf::writeCompressedFrame(CompressedFrame_ufmf &frame)
     {
         if (!frame.isReady()) { return; }
 
         // Get position and time stamp for index
         double timeStamp = frame.getTimeStamp();
-        std::streampos filePosBegin = file_.tellp();
+        if (isRolloverDue(timeStamp, fileWriterPtr_ -> tell()))
+        {
+            startNextSegment(timeStamp);
+        }
+        uint64_t filePosBegin = fileWriterPtr_ -> tell();
 
-        framePosList_.push_back(filePosBegin);
-        frameTimeStampList_.push_back(timeStamp);
+        index_.addFrame(filePosBegin, timeStamp);
 
         // Write keyframe chunk identifier
         uint8_t chunkId = uint8_t(FRAME_CHUNK_ID);
-        file_.write((char*) &chunkId, sizeof(uint8_t));
+        fileWriterPtr_ -> write((char*) &chunkId, sizeof(uint8_t));
 
         // Write time stamp
-        file_.write((char*) &timeStamp, sizeof(double));
+        fileWriterPtr_ -> write((char*) &timeStamp, sizeof(double));
 
         // Write number of connected components
         uint32_t numConnectedComp = uint32_t(frame.getNumConnectedComp());
-        file_.write((char*) &numConnectedComp, sizeof(uint32_t));
+        fileWriterPtr_ -> write((char*) &numConnectedComp, sizeof(uint32_t));
 
         // Write each box
         std::shared_ptr<std::vector<uint16_t>> writeColBufPtr;
@@ -680,62 +566,156 @@ namespace bias
 
         unsigned int dataPos = 0;
 
-        for (unsigned int cc=0; cc<numConnectedComp; cc++)
+        if (compressionLevel_ > 0)
+        {
+            // Boxes have already been coded by the compressor thread
+            std::shared_ptr<std::vector<char>> codedDataPtr = frame.getCodedDataPtr();
+            fileWriterPtr_ -> write(&(*codedDataPtr)[0], codedDataPtr -> size());
+        }
+        else
+        {
+            for (unsigned int cc=0; cc<numConnectedComp; cc++)
+            {
+                uint16_t col = (*writeColBufPtr)[cc];
+                uint16_t row = (*writeRowBufPtr)[cc];
+                uint16_t wdt = (*writeWdtBufPtr)[cc];
+                uint16_t hgt = (*writeHgtBufPtr)[cc];
+                unsigned int boxArea = (*writeHgtBufPtr)[cc]*(*writeWdtBufPtr)[cc];
+
+                fileWriterPtr_ -> write((char*) &col, sizeof(uint16_t));
+                fileWriterPtr_ -> write((char*) &row, sizeof(uint16_t));
+                fileWriterPtr_ -> write((char*) &wdt, sizeof(uint16_t));
+                fileWriterPtr_ -> write((char*) &hgt, sizeof(uint16_t));
+                fileWriterPtr_ -> write((char*) &(*imageDataPtr)[dataPos], boxArea*sizeof(uint8_t));
+                dataPos += boxArea;
+            }
+        }
+
+        lastFrameBytesSaved_ = frame.getNumBytesSaved();
+        totalBytesSaved_ += lastFrameBytesSaved_;
+
+        // Checkpoint index when enough entries have accumulated
+        if (index_.isChunkFull())
+        {
+            writeIndexChunk();
+        }
+
+        addSegmentFrame(timeStamp, fileWriterPtr_ -> tell());
+
+        if (isCheckpointDue(timeStamp, index_.numFrames()))
+        {
+            writeCheckpoint();
+            markCheckpoint(timeStamp, index_.numFrames());
+        }
+    }
+
+
+    void VideoWriter_ufmf::writeIndexChunk()
+    {
+        // Write pending index entries as an index chunk and drop them from memory
+        uint64_t chunkLoc = fileWriterPtr_ -> tell();
+        index_.takeChunk(chunkLoc, indexChunkData_);
+        fileWriterPtr_ -> write(&indexChunkData_[0], indexChunkData_.size());
+
+        // Point the header's index location at the latest index chunk so an 
+        // unfinished file can be recovered. Replaced by the index dictionary 
+        // location in finishWriting.
+        uint64_t indexLocation_uint64 = chunkLoc + sizeof(uint8_t);
+        fileWriterPtr_ -> writePatch(indexLocationPtr_, &indexLocation_uint64, sizeof(uint64_t));
+    }
+
+
+    void VideoWriter_ufmf::writeCheckpoint()
+    {
+        // Pending index entries go out as an index chunk. Only chunks which
+        // have been submitted to the writer thread are synced by the 
+        // checkpoint, so the header and journal point at the last of those -
+        // the chunk written here is covered by the next checkpoint.
+        if (index_.havePending())
+        {
+            writeIndexChunk();
+        }
+
+        uint64_t submittedSize = fileWriterPtr_ -> getSubmittedSize();
+        uint64_t indexLocation_uint64 = 0;
+        uint64_t numFrames = 0;
+        for (const UfmfIndexChunkInfo &chunkInfo : index_.chunkInfoVec())
         {
-            uint16_t col = (*writeColBufPtr)[cc];
-            uint16_t row = (*writeRowBufPtr)[cc];
-            uint16_t wdt = (*writeWdtBufPtr)[cc];
-            uint16_t hgt = (*writeHgtBufPtr)[cc];
-            unsigned int boxArea = (*writeHgtBufPtr)[cc]*(*writeWdtBufPtr)[cc];
-
-            file_.write((char*) &col, sizeof(uint16_t));
-            file_.write((char*) &row, sizeof(uint16_t));
-            file_.write((char*) &wdt, sizeof(uint16_t));
-            file_.write((char*) &hgt, sizeof(uint16_t));
-            file_.write((char*) &(*imageDataPtr)[dataPos], boxArea*sizeof(uint8_t));
-            dataPos += boxArea;
+            if (chunkInfo.endLoc() > submittedSize)
+            {
+                break;
+            }
+            indexLocation_uint64 = chunkInfo.loc + sizeof(uint8_t);
+            numFrames += chunkInfo.numFrames;
+        }
+        if (indexLocation_uint64 > 0)
+        {
+            fileWriterPtr_ -> writePatch(indexLocationPtr_, &indexLocation_uint64, sizeof(uint64_t));
         }
 
-        // Calculate frame size
-        std::streampos filePosEnd = file_.tellp();
-        unsigned long frameSize = (unsigned long)(filePosEnd) - (unsigned long)(filePosBegin);
+        RecordingJournalRecord record;
+        record.format = JOURNAL_FORMAT_UFMF;
+        record.sequence = ++checkpointSequence_;
+        record.numFrames = numFrames;
+        record.dataEnd = submittedSize;
+        record.indexLocation = indexLocation_uint64;
+        std::vector<char> recordData;
+        RecordingJournal::serialize(record, recordData);
+        fileWriterPtr_ -> checkpoint(recordData);
     }
 
 
-    void VideoWriter_ufmf::writeKeyFrame()
+    void VideoWriter_ufmf::writeKeyFrame(double timeStamp)
     {
         // Get position and time stamp for index
-        bgKeyFramePosList_.push_back(file_.tellp());
-        bgKeyFrameTimeStampList_.push_back(bgModelTimeStamp_);
+        index_.addKeyFrame(fileWriterPtr_ -> tell(), timeStamp);
 
         // Write keyframe chunk identifier
         uint8_t chunkId = uint8_t(KEYFRAME_CHUNK_ID);
-        file_.write((char*) &chunkId, sizeof(uint8_t));
+        fileWriterPtr_ -> write((char*) &chunkId, sizeof(uint8_t));
 
         // Write keyframe type
         const char keyFrameType[] = "mean";
         uint8_t keyFrameTypeLength = sizeof(keyFrameType)-1;
-        file_.write((char*) &keyFrameTypeLength, sizeof(uint8_t));
-        file_.write((char*) keyFrameType, keyFrameTypeLength*sizeof(char));
+        fileWriterPtr_ -> write((char*) &keyFrameTypeLength, sizeof(uint8_t));
+        fileWriterPtr_ -> write((char*) keyFrameType, keyFrameTypeLength*sizeof(char));
 
         // Discrepancy ... what about number of points/boxes
 
         // Write char specifying data type
-        file_.write((char*) &CHAR_FOR_DTYPE_UINT8, sizeof(char));
+        fileWriterPtr_ -> write((char*) &CHAR_FOR_DTYPE_UINT8, sizeof(char));
 
         // Write width and height
         uint16_t width = uint16_t(bgMedianImage_.cols);
-        file_.write((char*) &width, sizeof(uint16_t));
+        fileWriterPtr_ -> write((char*) &width, sizeof(uint16_t));
 
         uint16_t height = uint16_t(bgMedianImage_.rows);
-        file_.write((char*) &height, sizeof(uint16_t));
+        fileWriterPtr_ -> write((char*) &height, sizeof(uint16_t));
 
         // Write timestamp
-        file_.write((char*) &bgModelTimeStamp_, sizeof(double));
+        fileWriterPtr_ -> write((char*) &timeStamp, sizeof(double));
 
         // Write the frame data
         unsigned int numPixel = bgMedianImage_.rows*bgMedianImage_.cols;
-        file_.write((char*) bgMedianImage_.data, numPixel*sizeof(char));
+        if (compressionLevel_ > 0)
+        {
+            // Keyframes are normally coded by the median thread - except the first
+            if (keyFrameCodedData_.empty())
+            {
+                UfmfCodec::encode(
+                        (const char *) bgMedianImage_.data, 
+                        numPixel, 
+                        compressionLevel_, 
+                        keyFrameCodedData_
+                        );
+            }
+            fileWriterPtr_ -> write(&keyFrameCodedData_[0], keyFrameCodedData_.size());
+            keyFrameCodedData_.clear();
+        }
+        else
+        {
+            fileWriterPtr_ -> write((char*) bgMedianImage_.data, numPixel*sizeof(char));
+        }
 
     }
 
@@ -763,6 +743,7 @@ namespace bias
                 medianMatQueuePtr_,
                 cameraNumber_ 
                 );
+        bgMedianPtr_ -> setCompressionLevel(compressionLevel_);
 
         threadPoolPtr_ -> start(bgHistogramPtr_);
         threadPoolPtr_ -> start(bgMedianPtr_);
@@ -799,51 +780,33 @@ namespace bias
     void VideoWriter_ufmf::startCompressors()
     {
         framesToDoQueuePtr_ -> clear();
-        framesFinishedSetPtr_ -> clear();
+        framesFinishedRingPtr_ -> reset();
 
-        // Create compressor threads and start on thread pool
-        compressorPtrVec_.resize(numberOfCompressors_);
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
-        {
-            compressorPtrVec_[i] = new Compressor_ufmf(
-                    framesToDoQueuePtr_,
-                    framesFinishedSetPtr_,
-                    framesSkippedIndexListPtr_,
-                    cameraNumber_
-                    );
-            threadPoolPtr_ -> start(compressorPtrVec_[i]);
-            connect(
-                    compressorPtrVec_[i],
-                    SIGNAL(imageLoggingError(unsigned int, QString)),
-                    this,
-                    SLOT(onCompressorError(unsigned int, QString))
-                   );
-        }
+        // Register compressor with the shared scheduler. The number of 
+        // compressors is the most frames this camera may have in progress.
+        compressorPtr_ = new Compressor_ufmf(
+                framesToDoQueuePtr_,
+                framesFinishedRingPtr_,
+                cameraNumber_
+                );
+        connect(
+                compressorPtr_,
+                SIGNAL(imageLoggingError(unsigned int, QString)),
+                this,
+                SLOT(onCompressorError(unsigned int, QString))
+               );
+        CompressionScheduler::instance().addClient(compressorPtr_, numberOfCompressors_);
     }
 
     void VideoWriter_ufmf::stopCompressors()
     {
-        // Send all compressor threads a stop signal 
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
+        if (compressorPtr_.isNull())
         {
-            if (!(compressorPtrVec_[i].isNull()))
-            { 
-                compressorPtrVec_[i] -> acquireLock();
-                compressorPtrVec_[i] -> stop();
-                compressorPtrVec_[i] -> releaseLock();
-            }
+            return;
         }
 
-        // Wait until all compressor threads are null
-        for (unsigned int i=0; i<compressorPtrVec_.size(); i++)
-        {
-            while (!(compressorPtrVec_[i].isNull()))
-            {
-                framesToDoQueuePtr_ -> acquireLock();
-                framesToDoQueuePtr_ -> wakeOne();
-                framesToDoQueuePtr_ -> releaseLock();
-            }
-        }
+        CompressionScheduler::instance().stopClient(compressorPtr_);
+        delete compressorPtr_;
     }
 
     // Private slots
@@ -5,12 +5,15 @@
 #include "video_writer_params.hpp"
 #include "compressor_ufmf.hpp"
 #include "compressed_frame_ufmf.hpp"
+#include "staged_file_writer.hpp"
+#include "ufmf_index.hpp"
+#include "median_image_ufmf.hpp"
 #include <memory>
 #include <vector>
 #include <list>
 #include <QPointer>
 #include <opencv2/core/core.hpp>
-#include <fstream>
+#include <cstdint>
 
 class QThreadPool;
 
@@ -40,13 +43,23 @@ namespace bias
             virtual ~VideoWriter_ufmf();
             virtual void addFrame(StampedImage stampedImg);
             virtual void finish();
+            virtual bool isBacklogged();
+
+            int getLastFrameBytesSaved() const;
+            int64_t getTotalBytesSaved() const;
 
             // Static members
             static const unsigned int FRAMES_TODO_MAX_QUEUE_SIZE;
-            static const unsigned int FRAMES_FINISHED_MAX_SET_SIZE;
+            static const unsigned int FRAMES_FINISHED_RING_SIZE;
             static const unsigned int FRAMES_WAIT_MAX_QUEUE_SIZE;
 
             static const unsigned int DEFAULT_FRAME_SKIP;
+            static const bool DEFAULT_DIRECT_IO;
+            static const bool DEFAULT_TIGHT_BOXES;
+            static const bool DEFAULT_TIGHT_BOX_STATS;
+
+            static const unsigned int DEFAULT_COMPRESSION_LEVEL;
+            static const unsigned int MAX_COMPRESSION_LEVEL;
 
             static const unsigned int DEFAULT_BACKGROUND_THRESHOLD;
             static const unsigned int MIN_BACKGROUND_THRESHOLD;
@@ -75,6 +88,7 @@ namespace bias
             static const unsigned int KEYFRAME_CHUNK_ID;
             static const unsigned int FRAME_CHUNK_ID;
             static const unsigned int INDEX_DICT_CHUNK_ID;
+            static const unsigned int INDEX_CHUNK_ID;
 
             static const char CHAR_FOR_DICT;
             static const char CHAR_FOR_ARRAY;
@@ -98,23 +112,28 @@ namespace bias
 
             bool dilateState_;
             unsigned int dilateWindowSize_;
+            bool directIo_;
+            bool tightBoxes_;
+            bool tightBoxStats_;
+            unsigned int compressionLevel_;
 
-            std::fstream file_;
-            std::streampos indexLocation_;
-            std::streampos indexLocationPtr_;
+            int lastFrameBytesSaved_;
+            int64_t totalBytesSaved_;
+
+            StagedFileWriterPtr fileWriterPtr_;
+            QString firstFileName_;
+            uint64_t indexLocation_;
+            uint64_t indexLocationPtr_;
+            uint64_t checkpointSequence_;
 
-            unsigned long nextFrameToWrite_;
             unsigned long numKeyFramesWritten_;
 
             double bgModelTimeStamp_;
             unsigned long bgUpdateCount_;
             unsigned long bgModelFrameCount_;
 
-            std::list<std::streampos> framePosList_;
-            std::list<std::streampos> bgKeyFramePosList_; 
-
-            std::list<double> frameTimeStampList_;
-            std::list<double> bgKeyFrameTimeStampList_;
+            UfmfIndex index_;
+            std::vector<char> indexChunkData_;
 
             StampedImage currentImage_;
 
@@ -122,29 +141,33 @@ namespace bias
             cv::Mat bgUpperBoundImage_;
             cv::Mat bgLowerBoundImage_;
             cv::Mat bgMembershipImage_;
+            std::vector<char> keyFrameCodedData_;
 
             QPointer<QThreadPool> threadPoolPtr_;
             QPointer<BackgroundHistogram_ufmf> bgHistogramPtr_;
             QPointer<BackgroundMedian_ufmf> bgMedianPtr_;
 
-            std::vector<QPointer<Compressor_ufmf>> compressorPtrVec_;
+            QPointer<Compressor_ufmf> compressorPtr_;
 
             std::shared_ptr<LockableQueue<StampedImage>> bgImageQueuePtr_;
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgNewDataQueuePtr_;
             std::shared_ptr<LockableQueue<BackgroundData_ufmf>> bgOldDataQueuePtr_;
-            std::shared_ptr<LockableQueue<cv::Mat>> medianMatQueuePtr_;
+            std::shared_ptr<LockableQueue<MedianImage_ufmf>> medianMatQueuePtr_;
 
             CompressedFrameQueuePtr_ufmf framesToDoQueuePtr_;
             CompressedFrameQueuePtr_ufmf framesWaitQueuePtr_;
-            CompressedFrameSetPtr_ufmf framesFinishedSetPtr_;
-            std::shared_ptr<Lockable<std::list<unsigned long>>> framesSkippedIndexListPtr_;
+            CompressedFrameRingPtr_ufmf framesFinishedRingPtr_;
 
             unsigned int clearFinishedFrames();
             void checkImageFormat(StampedImage stampedImg);
             void setupOutputFile(StampedImage stampedImg);
+            void openOutputFile(QString fileName);
+            void startNextSegment(double timeStamp);
             void writeHeader();
-            void writeKeyFrame();
-            void writeCompressedFrame(CompressedFrame_ufmf frame);
+            void writeKeyFrame(double timeStamp);
+            void writeCompressedFrame(CompressedFrame_ufmf &frame);
+            void writeIndexChunk();
+            void writeCheckpoint();
             void finishWriting();
 
             void startBackgroundModeling();
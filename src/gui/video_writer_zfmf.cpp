@@ -0,0 +1,411 @@
+#include "video_writer_zfmf.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include "lockable.hpp"
+#include "compression_scheduler.hpp"
+#include <QThreadPool>
+#include <algorithm>
+#include <iostream>
+
+namespace bias
+{
+    // Static Constants
+    // ----------------------------------------------------------------------------------
+    const unsigned int VideoWriter_zfmf::CHUNKS_TODO_MAX_QUEUE_SIZE = 8;
+    const unsigned int VideoWriter_zfmf::CHUNKS_FINISHED_RING_SIZE  = 16;
+    const unsigned int VideoWriter_zfmf::CHUNKS_WAIT_MAX_QUEUE_SIZE = 8;
+
+    const unsigned int VideoWriter_zfmf::DEFAULT_FRAME_SKIP = 1;
+    const bool VideoWriter_zfmf::DEFAULT_DIRECT_IO = false;
+
+    const unsigned int VideoWriter_zfmf::DEFAULT_CHUNK_FRAMES = 32;
+    const unsigned int VideoWriter_zfmf::MIN_CHUNK_FRAMES = 1;
+    const unsigned int VideoWriter_zfmf::MAX_CHUNK_FRAMES = 1024;
+    const uint64_t VideoWriter_zfmf::MAX_CHUNK_BYTES = 32*1024*1024;
+
+    const unsigned int VideoWriter_zfmf::DEFAULT_COMPRESSION_LEVEL = 1;
+    const unsigned int VideoWriter_zfmf::MAX_COMPRESSION_LEVEL = ZfmfCodec::MAX_LEVEL;
+
+    const unsigned int VideoWriter_zfmf::DEFAULT_NUMBER_OF_COMPRESSORS = 4;
+    const unsigned int VideoWriter_zfmf::MIN_NUMBER_OF_COMPRESSORS = 1;
+
+    const VideoWriterParams_zfmf VideoWriter_zfmf::DEFAULT_PARAMS = 
+        VideoWriterParams_zfmf();
+
+    const QString VideoWriter_zfmf::DUMMY_FILENAME("dummy.zfmf");
+
+
+    // Methods
+    // ----------------------------------------------------------------------------------
+    VideoWriter_zfmf::VideoWriter_zfmf(QObject *parent) 
+        : VideoWriter_zfmf(DEFAULT_PARAMS, DUMMY_FILENAME, 0, parent) 
+    {} 
+
+
+    VideoWriter_zfmf::VideoWriter_zfmf(
+            VideoWriterParams_zfmf params,
+            QString fileName,
+            unsigned int cameraNumber,
+            QObject *parent
+            )
+        : VideoWriter(fileName,cameraNumber,parent)
+    {
+        isFirst_ = true;
+        skipReported_ = false;
+        directIo_ = params.directIo;
+        chunkFrames_ = std::max(std::min(params.chunkFrames, MAX_CHUNK_FRAMES), MIN_CHUNK_FRAMES);
+        compressionLevel_ = std::min(params.compressionLevel, MAX_COMPRESSION_LEVEL);
+        numberOfCompressors_ = std::max(params.numberOfCompressors, MIN_NUMBER_OF_COMPRESSORS);
+        setFrameSkip(params.frameSkip);
+        numWritten_ = 0;
+
+        // Thread for the file writer. Chunks are compressed on the shared 
+        // CompressionScheduler workers.
+        threadPoolPtr_ = new QThreadPool(this);
+        threadPoolPtr_ -> setMaxThreadCount(1);
+
+        chunksToDoQueuePtr_ = std::make_shared<CompressedChunkQueue_zfmf>();
+        chunksWaitQueuePtr_ = std::make_shared<CompressedChunkQueue_zfmf>();
+        chunksFinishedRingPtr_ = std::make_shared<CompressedChunkRing_zfmf>(CHUNKS_FINISHED_RING_SIZE);
+    }
+
+
+    VideoWriter_zfmf::~VideoWriter_zfmf()
+    {
+        stopCompressors();
+        try
+        {
+            closeFile();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            std::cout << "error: " << runtimeError.what() << std::endl;
+        }
+        threadPoolPtr_ -> waitForDone();
+    }
+
+
+    void VideoWriter_zfmf::addFrame(StampedImage stampedImg)
+    {
+        bool skipFrame = false;
+
+        if (isFirst_)
+        {
+            checkImageFormat(stampedImg);
+            setupOutputFile(stampedImg);
+            startCompressors();
+            newChunk();
+            isFirst_ = false;
+        }
+
+        if (frameCount_%frameSkip_==0)
+        {
+            currentChunk_.addFrame(stampedImg);
+            if (currentChunk_.isFull())
+            {
+                skipFrame = !submitChunk();
+                newChunk();
+            }
+        }
+
+        // Write finished chunks in order
+        clearFinishedChunks();
+        frameCount_++;
+
+        // Report skipped chunk
+        if ((skipFrame)  && (!skipReported_))
+        { 
+            std::cout << "warning: logging overflow - skipped frames -" << std::endl;
+            unsigned int errorId = ERROR_FRAMES_TODO_MAX_QUEUE_SIZE;
+            QString errorMsg("logger chunksToDoQueue has exceeded the maximum allowed size");
+            emit imageLoggingError(errorId, errorMsg);
+            skipReported_ = true;
+        }
+    }
+
+
+    void VideoWriter_zfmf::finish()
+    {
+        // Submit the partial chunk and wait for all chunks to be written
+        if (!isFirst_ && !currentChunk_.isEmpty())
+        {
+            submitChunk();
+            newChunk();
+        }
+        bool finished = false;
+        while (!finished)
+        {
+            chunksToDoQueuePtr_ -> acquireLock();
+            if ( (chunksToDoQueuePtr_ -> size()) == 0)
+            {
+                finished = true;
+            }
+            chunksToDoQueuePtr_ -> releaseLock();
+        }
+        while (clearFinishedChunks() > 0);
+
+        // Write the index and close the file so it is complete when finish
+        // returns. Errors are reported by imageLoggingError.
+        stopCompressors();
+        try
+        {
+            closeFile();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            unsigned int errorId = runtimeError.id();
+            QString errorMsg = QString::fromStdString(runtimeError.what());
+            emit imageLoggingError(errorId, errorMsg);
+        }
+    }
+
+
+    bool VideoWriter_zfmf::isBacklogged()
+    {
+        if (compressorPtr_.isNull())
+        {
+            return false;
+        }
+        return compressorPtr_ -> isBacklogged(CHUNKS_TODO_MAX_QUEUE_SIZE);
+    }
+
+
+    void VideoWriter_zfmf::checkImageFormat(StampedImage stampedImg)
+    {
+        if (stampedImg.image.channels() != 1)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("video writer zfmf setup failed:\n\n"); 
+            errorMsg += "images must be single channel";
+            throw RuntimeError(errorId,errorMsg);
+        }
+
+        if (stampedImg.image.depth() != CV_8U)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("video writer zfmf setup failed:\n\n"); 
+            errorMsg += "image depth must be CV_8U";
+            throw RuntimeError(errorId,errorMsg);
+        }
+
+        uint64_t frameSize = uint64_t(stampedImg.image.cols)*uint64_t(stampedImg.image.rows);
+        if (frameSize > ZfmfCodec::MAX_CHUNK_BYTES)
+        {
+            unsigned int errorId = ERROR_VIDEO_WRITER_INITIALIZE;
+            std::string errorMsg("video writer zfmf setup failed:\n\n"); 
+            errorMsg += "image too large";
+            throw RuntimeError(errorId,errorMsg);
+        }
+    }
+
+
+    void VideoWriter_zfmf::setupOutputFile(StampedImage stampedImg)
+    {
+        setSize(stampedImg.image.size());
+        firstFileName_ = getUniqueFileName();
+
+        // Chunk buffers are allocated up front and about CHUNKS_TODO_MAX_QUEUE_SIZE 
+        // + CHUNKS_FINISHED_RING_SIZE + CHUNKS_WAIT_MAX_QUEUE_SIZE of them are 
+        // in use, so large frames get shorter chunks.
+        uint64_t frameSize = uint64_t(size_.width)*uint64_t(size_.height);
+        uint64_t maxChunkFrames = std::max(MAX_CHUNK_BYTES/frameSize, uint64_t(MIN_CHUNK_FRAMES));
+        if (chunkFrames_ > maxChunkFrames)
+        {
+            std::cout << "zfmf: chunkFrames reduced from " << chunkFrames_ << " to ";
+            std::cout << maxChunkFrames << " for the image size" << std::endl;
+            chunkFrames_ = (unsigned int)(maxChunkFrames);
+        }
+
+        fileWriterPtr_ = std::make_shared<StagedFileWriter>(
+                StagedFileWriter::DEFAULT_BUFFER_SIZE,
+                StagedFileWriter::DEFAULT_NUMBER_OF_BUFFERS
+                );
+        openFile(firstFileName_);
+    }
+
+
+    void VideoWriter_zfmf::openFile(QString fileName)
+    {
+        // The file writer, and its staging buffers, are reused for each segment
+        fileWriterPtr_ -> open(fileName, directIo_);
+        threadPoolPtr_ -> start(fileWriterPtr_.get());
+        beginSegment(fileName);
+
+        uint64_t preallocateSize = getPreallocateSize();
+        if (preallocateSize > 0)
+        {
+            fileWriterPtr_ -> preallocate(preallocateSize);
+        }
+
+        numWritten_ = 0;
+        chunkInfoVec_.clear();
+        writeHeader();
+    }
+
+
+    void VideoWriter_zfmf::closeFile()
+    {
+        if ((!fileWriterPtr_) || (!(fileWriterPtr_ -> isOpen())))
+        {
+            return;
+        }
+
+        // Write the chunk index and patch the header
+        uint64_t indexLocation = fileWriterPtr_ -> tell();
+        std::vector<char> indexData;
+        ZfmfCodec::getIndex(chunkInfoVec_, indexData);
+        fileWriterPtr_ -> write(&indexData[0], indexData.size());
+        fileWriterPtr_ -> writePatch(ZfmfCodec::NUM_FRAMES_POS, &numWritten_, sizeof(uint64_t));
+        fileWriterPtr_ -> writePatch(ZfmfCodec::INDEX_LOCATION_POS, &indexLocation, sizeof(uint64_t));
+
+        // Close the file - flushes staging buffers and stops the writer thread
+        uint64_t fileSize = fileWriterPtr_ -> tell();
+        fileWriterPtr_ -> close();
+        endSegment(fileSize);
+    }
+
+
+    void VideoWriter_zfmf::writeHeader()
+    {
+        // Frame count and index location are patched in closeFile
+        ZfmfHeader header;
+        header.height = uint32_t(size_.height);
+        header.width = uint32_t(size_.width);
+        header.chunkFrames = uint32_t(chunkFrames_);
+        std::vector<char> headerData;
+        ZfmfCodec::getHeader(header, headerData);
+        fileWriterPtr_ -> write(&headerData[0], headerData.size());
+    }
+
+
+    void VideoWriter_zfmf::writeChunk(CompressedChunk_zfmf &chunk)
+    {
+        if (!chunk.haveEncoding()) { return; }
+
+        const std::vector<double> &timeStampVec = chunk.getTimeStamps();
+        if (isRolloverDue(timeStampVec.front(), fileWriterPtr_ -> tell()))
+        {
+            // Segments start on a chunk boundary
+            closeFile();
+            openFile(getSegmentFileName(firstFileName_, getNumberOfSegments()));
+        }
+
+        ZfmfChunkInfo chunkInfo;
+        chunkInfo.loc = fileWriterPtr_ -> tell();
+        chunkInfo.firstFrame = numWritten_;
+        chunkInfo.numFrames = uint32_t(timeStampVec.size());
+        chunkInfoVec_.push_back(chunkInfo);
+
+        std::shared_ptr<std::vector<char>> encodedDataPtr = chunk.getEncodedDataPtr();
+        fileWriterPtr_ -> write(&(*encodedDataPtr)[0], encodedDataPtr -> size());
+        numWritten_ += chunkInfo.numFrames;
+
+        uint64_t numBytes = fileWriterPtr_ -> tell();
+        for (double timeStamp : timeStampVec)
+        {
+            addSegmentFrame(timeStamp, numBytes);
+        }
+    }
+
+
+    void VideoWriter_zfmf::newChunk()
+    {
+        // Take a chunk from the wait queue for reuse if available
+        if (chunksWaitQueuePtr_ -> empty())
+        {
+            currentChunk_ = CompressedChunk_zfmf(size_, chunkFrames_);
+        }
+        else
+        {
+            currentChunk_ = std::move(chunksWaitQueuePtr_ -> front());
+            chunksWaitQueuePtr_ -> pop();
+            currentChunk_.reset();
+        }
+        currentChunk_.setCompressionLevel(compressionLevel_);
+    }
+
+
+    bool VideoWriter_zfmf::submitChunk()
+    {
+        // Insert current chunk into the "to do" queue - false if the queue or 
+        // ring is full and the chunk is skipped.
+        unsigned long writeIndex = 0;
+        bool haveNewChunk = false;
+        chunksToDoQueuePtr_ -> acquireLock();
+        unsigned int chunksToDoQueueSize = chunksToDoQueuePtr_ -> size();
+        if (
+                (chunksToDoQueueSize < CHUNKS_TODO_MAX_QUEUE_SIZE) && 
+                (chunksFinishedRingPtr_ -> reserve(writeIndex))
+           )
+        {
+            currentChunk_.setWriteIndex(writeIndex);
+            chunksToDoQueuePtr_ -> push(currentChunk_);
+            haveNewChunk = true;
+        }
+        chunksToDoQueuePtr_ -> releaseLock();
+        if (haveNewChunk)
+        {
+            CompressionScheduler::instance().notify();
+        }
+        return haveNewChunk;
+    }
+
+
+    unsigned int VideoWriter_zfmf::clearFinishedChunks()
+    {
+        // Write contiguous finished chunks to file and return them to the 
+        // wait queue for reuse.
+        chunksFinishedRingPtr_ -> drain([this](CompressedChunk_zfmf &chunk)
+        {
+            writeChunk(chunk);
+            if (chunksWaitQueuePtr_ -> size() < CHUNKS_WAIT_MAX_QUEUE_SIZE)
+            {
+                chunksWaitQueuePtr_ -> push(std::move(chunk));
+            }
+        });
+        return (unsigned int)(chunksFinishedRingPtr_ -> pending());
+    }
+
+
+    void VideoWriter_zfmf::startCompressors()
+    {
+        chunksToDoQueuePtr_ -> clear();
+        chunksFinishedRingPtr_ -> reset();
+
+        // Register compressor with the shared scheduler. The number of 
+        // compressors is the most chunks this camera may have in progress.
+        compressorPtr_ = new Compressor_zfmf(
+                chunksToDoQueuePtr_,
+                chunksFinishedRingPtr_,
+                cameraNumber_
+                );
+        connect(
+                compressorPtr_,
+                SIGNAL(imageLoggingError(unsigned int, QString)),
+                this,
+                SLOT(onCompressorError(unsigned int, QString))
+               );
+        CompressionScheduler::instance().addClient(compressorPtr_, numberOfCompressors_);
+    }
+
+
+    void VideoWriter_zfmf::stopCompressors()
+    {
+        if (compressorPtr_.isNull())
+        {
+            return;
+        }
+
+        CompressionScheduler::instance().stopClient(compressorPtr_);
+        delete compressorPtr_;
+    }
+
+
+    // Private slots
+    // ----------------------------------------------------------------------------------
+    void VideoWriter_zfmf::onCompressorError(unsigned int errorId, QString errorMsg)
+    {
+        emit imageLoggingError(errorId, errorMsg);
+    }
+
+} // namespace bias
@@ -0,0 +1,109 @@
+#ifndef BIAS_VIDEO_WRITER_ZFMF_HPP
+#define BIAS_VIDEO_WRITER_ZFMF_HPP
+
+#include "video_writer.hpp"
+#include "video_writer_params.hpp"
+#include "compressor_zfmf.hpp"
+#include "compressed_chunk_zfmf.hpp"
+#include "staged_file_writer.hpp"
+#include "zfmf_codec.hpp"
+#include <QPointer>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+class QThreadPool;
+
+namespace bias
+{
+
+    class VideoWriter_zfmf : public VideoWriter
+    {
+        // Lossless compressed fmf (see ZfmfCodec). Frames are collected into
+        // chunks which are compressed in parallel by the shared 
+        // CompressionScheduler workers and written in order, with a chunk 
+        // index, by a StagedFileWriter.
+
+        Q_OBJECT
+
+        public:
+
+            VideoWriter_zfmf(QObject *parent=0);
+            VideoWriter_zfmf(
+                    VideoWriterParams_zfmf params,
+                    QString fileName,
+                    unsigned int cameraNumber,
+                    QObject *parent=0
+                    );
+
+            virtual ~VideoWriter_zfmf();
+            virtual void addFrame(StampedImage stampedImg);
+            virtual void finish();
+            virtual bool isBacklogged();
+
+            static const unsigned int CHUNKS_TODO_MAX_QUEUE_SIZE;
+            static const unsigned int CHUNKS_FINISHED_RING_SIZE;
+            static const unsigned int CHUNKS_WAIT_MAX_QUEUE_SIZE;
+
+            static const unsigned int DEFAULT_FRAME_SKIP;
+            static const bool DEFAULT_DIRECT_IO;
+
+            static const unsigned int DEFAULT_CHUNK_FRAMES;
+            static const unsigned int MIN_CHUNK_FRAMES;
+            static const unsigned int MAX_CHUNK_FRAMES;
+            static const uint64_t MAX_CHUNK_BYTES;
+
+            static const unsigned int DEFAULT_COMPRESSION_LEVEL;
+            static const unsigned int MAX_COMPRESSION_LEVEL;
+
+            static const unsigned int DEFAULT_NUMBER_OF_COMPRESSORS;
+            static const unsigned int MIN_NUMBER_OF_COMPRESSORS;
+
+            static const VideoWriterParams_zfmf DEFAULT_PARAMS;
+            static const QString DUMMY_FILENAME;
+
+        protected:
+
+            bool isFirst_;
+            bool skipReported_;
+            bool directIo_;
+            unsigned int chunkFrames_;
+            unsigned int compressionLevel_;
+            unsigned int numberOfCompressors_;
+
+            StagedFileWriterPtr fileWriterPtr_;
+            QString firstFileName_;
+            uint64_t numWritten_;
+            std::vector<ZfmfChunkInfo> chunkInfoVec_;
+
+            CompressedChunk_zfmf currentChunk_;
+
+            QPointer<QThreadPool> threadPoolPtr_;
+            QPointer<Compressor_zfmf> compressorPtr_;
+
+            CompressedChunkQueuePtr_zfmf chunksToDoQueuePtr_;
+            CompressedChunkQueuePtr_zfmf chunksWaitQueuePtr_;
+            CompressedChunkRingPtr_zfmf chunksFinishedRingPtr_;
+
+            void checkImageFormat(StampedImage stampedImg);
+            void setupOutputFile(StampedImage stampedImg);
+            void openFile(QString fileName);
+            void closeFile();
+            void writeHeader();
+            void writeChunk(CompressedChunk_zfmf &chunk);
+
+            void newChunk();
+            bool submitChunk();
+            unsigned int clearFinishedChunks();
+
+            void startCompressors();
+            void stopCompressors();
+
+
+        private slots:
+            void onCompressorError(unsigned int errorId, QString errorMsg);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_WRITER_ZFMF_HPP
@@ -59,6 +59,7 @@ namespace bias
         signals:
 
             void setCaptureDurationRequest(unsigned long);
+            void triggerRecordingRequest(double timeStamp);
 
         protected:
 
@@ -109,6 +109,7 @@ namespace bias
                     triggerData.threshold = double(threshold);
                     triggerData.signal = signalMax;
                     emit triggerFired(triggerData);
+                    emit triggerRecordingRequest(triggerData.timeStamp);
                 }
             }
             releaseLock();
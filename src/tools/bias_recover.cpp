@@ -0,0 +1,674 @@
+#include "ufmf_index.hpp"
+#include "ufmf_codec.hpp"
+#include "recording_journal.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+// ------------------------------------------------------------------------
+// bias_recover - repairs fmf and ufmf files which were not closed properly,
+// e.g. after a crash or power loss.
+//
+// ufmf - by default the index chunks written during logging are used and 
+// only the frames after the last index chunk are scanned. If the header 
+// doesn't lead to a valid index chunk the checkpoint journal is tried. With
+// --scan the whole file is scanned. Any incomplete chunk at the end of the
+// file is truncated and a standard index dictionary is appended.
+//
+// fmf - the frame count from the checkpoint journal (or the header if there
+// is no journal) is trusted and the frames after it are scanned while their
+// time stamps are valid and increasing. With --scan all frames are scanned.
+// The file is truncated to whole frames and the header frame count is set.
+//
+// The checkpoint journal (file.journal) is removed once the file has been
+// repaired.
+// ------------------------------------------------------------------------
+
+using namespace bias;
+
+const uint8_t KEYFRAME_CHUNK_ID = 0;
+const uint8_t FRAME_CHUNK_ID = 1;
+const uint64_t INDEX_LOCATION_POS = 8;
+const uint32_t FMF_VERSION = 1;
+const uint64_t FMF_HEADER_SIZE = 3*sizeof(uint32_t) + 2*sizeof(uint64_t);
+const uint64_t FMF_NUM_FRAMES_POS = 3*sizeof(uint32_t) + sizeof(uint64_t);
+
+
+struct UfmfHeader
+{
+    uint32_t version;
+    uint64_t indexLocation;
+    uint16_t maxWidth;
+    uint16_t maxHeight;
+    bool isFixedSize;
+    std::string colorCoding;
+    uint64_t dataLocation;
+};
+
+
+struct FmfHeader
+{
+    uint32_t version;
+    uint32_t height;
+    uint32_t width;
+    uint64_t bytesPerChunk;
+    uint64_t numFrames;
+};
+
+
+template <class T>
+bool readValue(std::fstream &file, T &value)
+{
+    file.read((char*) &value, sizeof(T));
+    return bool(file);
+}
+
+
+uint64_t getFileSize(std::fstream &file)
+{
+    file.clear();
+    file.seekg(0, std::ios_base::end);
+    return uint64_t(file.tellg());
+}
+
+
+bool readJournal(std::string fileName, RecordingJournalFormat format, uint64_t fileSize, RecordingJournalRecord &record)
+{
+    // Checkpoint left by the writer - only used if it belongs to this format
+    // and describes data which is in the file.
+    QString journalFileName = RecordingJournal::getFileName(QString::fromStdString(fileName));
+    if (!RecordingJournal::read(journalFileName, record))
+    {
+        return false;
+    }
+    return (record.format == uint32_t(format)) && (record.dataEnd <= fileSize);
+}
+
+
+void removeJournal(std::string fileName)
+{
+    QString journalFileName = RecordingJournal::getFileName(QString::fromStdString(fileName));
+    if (QFile::exists(journalFileName) && !QFile::remove(journalFileName))
+    {
+        std::cout << "warning: unable to remove " << journalFileName.toStdString() << std::endl;
+    }
+}
+
+
+unsigned int getBytesPerPixel(std::string colorCoding)
+{
+    if ((colorCoding == "MONO16") || (colorCoding == "YUV422"))
+    {
+        return 2;
+    }
+    if ((colorCoding == "RGB8") || (colorCoding == "BGR8"))
+    {
+        return 3;
+    }
+    return 1;
+}
+
+
+bool readHeader(std::fstream &file, UfmfHeader &header)
+{
+    char headerStr[4];
+    uint8_t isFixedSize = 0;
+    uint8_t colorCodingLength = 0;
+
+    file.seekg(0, std::ios_base::beg);
+    file.read(headerStr, sizeof(headerStr));
+    if ((!file) || (std::strncmp(headerStr, "ufmf", sizeof(headerStr)) != 0))
+    {
+        return false;
+    }
+    bool ok = readValue(file, header.version);
+    ok = ok && readValue(file, header.indexLocation);
+    ok = ok && readValue(file, header.maxWidth);
+    ok = ok && readValue(file, header.maxHeight);
+    ok = ok && readValue(file, isFixedSize);
+    ok = ok && readValue(file, colorCodingLength);
+    if (!ok)
+    {
+        return false;
+    }
+    std::vector<char> colorCoding(colorCodingLength);
+    if (colorCodingLength > 0)
+    {
+        file.read(&colorCoding[0], colorCodingLength);
+    }
+    header.isFixedSize = (isFixedSize != 0);
+    header.colorCoding = std::string(colorCoding.begin(), colorCoding.end());
+    header.dataLocation = uint64_t(file.tellg());
+    return bool(file);
+}
+
+
+bool readChunkInfo(std::fstream &file, uint64_t fileSize, uint64_t loc, UfmfIndexChunkInfo &chunkInfo, uint64_t &prevChunkLoc)
+{
+    // Reads and validates index chunk header at loc
+    if (loc + UfmfIndex::CHUNK_HEADER_SIZE > fileSize)
+    {
+        return false;
+    }
+    char data[32];
+    file.clear();
+    file.seekg(loc, std::ios_base::beg);
+    file.read(data, UfmfIndex::CHUNK_HEADER_SIZE);
+    if ((!file) || (!UfmfIndex::parseChunkHeader(data, chunkInfo, prevChunkLoc)))
+    {
+        return false;
+    }
+    chunkInfo.loc = loc;
+    return (chunkInfo.endLoc() <= fileSize) && (prevChunkLoc < loc);
+}
+
+
+bool getIndexChunks(std::fstream &file, uint64_t fileSize, const UfmfHeader &header, std::vector<UfmfIndexChunkInfo> &chunkInfoVec)
+{
+    // Follows the chain of index chunks back from the one the header points at
+    chunkInfoVec.clear();
+    if (header.indexLocation < header.dataLocation + 1)
+    {
+        return false;
+    }
+    uint64_t loc = header.indexLocation - 1;
+    while (loc != 0)
+    {
+        UfmfIndexChunkInfo chunkInfo;
+        uint64_t prevChunkLoc = 0;
+        if (!readChunkInfo(file, fileSize, loc, chunkInfo, prevChunkLoc))
+        {
+            chunkInfoVec.clear();
+            return false;
+        }
+        chunkInfoVec.insert(chunkInfoVec.begin(), chunkInfo);
+        loc = prevChunkLoc;
+    }
+    return true;
+}
+
+
+bool skipCodedBlock(std::fstream &file, uint64_t fileSize, uint64_t &blockEnd)
+{
+    // Reads header of coded block at current position and gets its end
+    char data[16];
+    uint8_t coding = 0;
+    uint32_t rawSize = 0;
+    uint32_t codedSize = 0;
+    file.read(data, UfmfCodec::CODED_HEADER_SIZE);
+    if ((!file) || (!UfmfCodec::parseHeader(data, coding, rawSize, codedSize)))
+    {
+        return false;
+    }
+    blockEnd = uint64_t(file.tellg()) + codedSize;
+    return (blockEnd <= fileSize);
+}
+
+
+uint64_t scanChunks(std::fstream &file, uint64_t fileSize, const UfmfHeader &header, uint64_t loc, UfmfIndex &index)
+{
+    // Scans frame and keyframe chunks from loc and adds them to the index.
+    // Returns the location just after the last complete chunk.
+    unsigned int bytesPerPixel = getBytesPerPixel(header.colorCoding);
+    bool isCoded = (header.version == UfmfCodec::CODED_VERSION_NUMBER);
+
+    while (loc < fileSize)
+    {
+        uint8_t chunkId = 0;
+        uint64_t chunkEnd = 0;
+        double timeStamp = 0.0;
+
+        file.clear();
+        file.seekg(loc, std::ios_base::beg);
+        if (!readValue(file, chunkId))
+        {
+            break;
+        }
+
+        if (chunkId == KEYFRAME_CHUNK_ID)
+        {
+            uint8_t typeLength = 0;
+            char dtype = 0;
+            uint16_t width = 0;
+            uint16_t height = 0;
+            if (!readValue(file, typeLength)) { break; }
+            file.seekg(typeLength, std::ios_base::cur);
+            bool ok = readValue(file, dtype);
+            ok = ok && readValue(file, width);
+            ok = ok && readValue(file, height);
+            ok = ok && readValue(file, timeStamp);
+            if (!ok) { break; }
+            if ((width == 0) || (height == 0))
+            {
+                // Zero filled space, e.g. preallocated but never written
+                break;
+            }
+            if (isCoded)
+            {
+                if (!skipCodedBlock(file, fileSize, chunkEnd)) { break; }
+            }
+            else
+            {
+                unsigned int dtypeSize = (dtype == 'f') ? 4 : ((dtype == 'd') ? 8 : 1);
+                chunkEnd = uint64_t(file.tellg()) + uint64_t(width)*height*dtypeSize;
+                if (chunkEnd > fileSize) { break; }
+            }
+            index.addKeyFrame(loc, timeStamp);
+        }
+        else if (chunkId == FRAME_CHUNK_ID)
+        {
+            uint32_t numBoxes = 0;
+            bool ok = readValue(file, timeStamp);
+            ok = ok && readValue(file, numBoxes);
+            if (ok && isCoded)
+            {
+                // Boxes are in a single coded block
+                if (!skipCodedBlock(file, fileSize, chunkEnd)) { break; }
+                index.addFrame(loc, timeStamp);
+                loc = chunkEnd;
+                continue;
+            }
+            for (uint32_t i=0; (i<numBoxes) && ok; i++)
+            {
+                uint16_t boxHeader[4];
+                uint64_t boxArea = 0;
+                if (header.isFixedSize)
+                {
+                    file.read((char*) boxHeader, 2*sizeof(uint16_t));
+                    boxArea = uint64_t(header.maxWidth)*header.maxHeight;
+                }
+                else
+                {
+                    file.read((char*) boxHeader, 4*sizeof(uint16_t));
+                    boxArea = uint64_t(boxHeader[2])*boxHeader[3];
+                }
+                ok = bool(file) && (uint64_t(file.tellg()) + boxArea*bytesPerPixel <= fileSize);
+                if (ok)
+                {
+                    file.seekg(boxArea*bytesPerPixel, std::ios_base::cur);
+                }
+            }
+            if (!ok) { break; }
+            chunkEnd = uint64_t(file.tellg());
+            index.addFrame(loc, timeStamp);
+        }
+        else if (chunkId == UfmfIndex::INDEX_CHUNK_ID)
+        {
+            UfmfIndexChunkInfo chunkInfo;
+            uint64_t prevChunkLoc = 0;
+            if (!readChunkInfo(file, fileSize, loc, chunkInfo, prevChunkLoc)) { break; }
+            chunkEnd = chunkInfo.endLoc();
+        }
+        else
+        {
+            // Old index dictionary or garbage - everything before is good
+            break;
+        }
+        loc = chunkEnd;
+    }
+    return loc;
+}
+
+
+bool writeIndex(std::fstream &file, uint64_t dataEnd, const UfmfIndex &index)
+{
+    file.clear();
+    file.seekp(dataEnd, std::ios_base::beg);
+    uint8_t chunkId = UfmfIndex::INDEX_DICT_CHUNK_ID;
+    file.write((char*) &chunkId, sizeof(uint8_t));
+    uint64_t indexLocation = dataEnd + sizeof(uint8_t);
+
+    std::vector<char> prefix;
+    std::vector<char> chunkArray;
+    const std::vector<UfmfIndexChunkInfo> &chunkInfoVec = index.chunkInfoVec();
+
+    for (int i=0; i<NUMBER_OF_UFMF_INDEX_ARRAY; i++)
+    {
+        UfmfIndexArray array = UfmfIndexArray(i);
+        UfmfIndex::getDictArrayPrefix(array, index.arrayNumBytes(array), prefix);
+        file.write(&prefix[0], prefix.size());
+
+        for (unsigned int j=0; j<chunkInfoVec.size(); j++)
+        {
+            uint32_t numBytes = UfmfIndex::chunkArrayNumBytes(chunkInfoVec[j], array);
+            if (numBytes > 0)
+            {
+                uint64_t writePos = uint64_t(file.tellp());
+                chunkArray.resize(numBytes);
+                file.seekg(chunkInfoVec[j].arrayLoc(array), std::ios_base::beg);
+                file.read(&chunkArray[0], numBytes);
+                file.seekp(writePos, std::ios_base::beg);
+                file.write(&chunkArray[0], numBytes);
+            }
+        }
+
+        const char *pendingPtr = nullptr;
+        size_t numPendingBytes = index.pendingArray(array, &pendingPtr);
+        if (numPendingBytes > 0)
+        {
+            file.write(pendingPtr, numPendingBytes);
+        }
+    }
+
+    file.seekp(INDEX_LOCATION_POS, std::ios_base::beg);
+    file.write((char*) &indexLocation, sizeof(uint64_t));
+    file.flush();
+    return bool(file);
+}
+
+
+int recoverUfmf(std::string fileName, bool fullScan, bool dryRun)
+{
+    std::fstream file(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "error: unable to open " << fileName << std::endl;
+        return 1;
+    }
+
+    UfmfHeader header;
+    if (!readHeader(file, header))
+    {
+        std::cout << "error: " << fileName << " is not a ufmf file" << std::endl;
+        return 1;
+    }
+    uint64_t fileSize = getFileSize(file);
+
+    // Check for a complete index
+    if ((header.indexLocation > header.dataLocation) && (header.indexLocation <= fileSize))
+    {
+        uint8_t chunkId = 0;
+        file.clear();
+        file.seekg(header.indexLocation - 1, std::ios_base::beg);
+        if (readValue(file, chunkId) && (chunkId == UfmfIndex::INDEX_DICT_CHUNK_ID))
+        {
+            std::cout << fileName << " already has an index" << std::endl;
+            if (!dryRun)
+            {
+                removeJournal(fileName);
+            }
+            return 0;
+        }
+    }
+
+    UfmfIndex index;
+    uint64_t scanLoc = header.dataLocation;
+
+    // The header index location may point at a chunk which never reached the
+    // disk - the journal's is from the last checkpoint and was synced.
+    std::vector<UfmfIndexChunkInfo> chunkInfoVec;
+    bool haveChunks = (!fullScan) && getIndexChunks(file, fileSize, header, chunkInfoVec);
+
+    RecordingJournalRecord record;
+    if ((!fullScan) && (!haveChunks) && readJournal(fileName, JOURNAL_FORMAT_UFMF, fileSize, record))
+    {
+        UfmfHeader journalHeader = header;
+        journalHeader.indexLocation = record.indexLocation;
+        haveChunks = getIndexChunks(file, fileSize, journalHeader, chunkInfoVec);
+        if (haveChunks)
+        {
+            std::cout << "using index location from checkpoint journal" << std::endl;
+        }
+    }
+
+    if (haveChunks)
+    {
+        for (unsigned int i=0; i<chunkInfoVec.size(); i++)
+        {
+            index.addChunk(chunkInfoVec[i]);
+        }
+        scanLoc = chunkInfoVec.back().endLoc();
+        std::cout << "found " << chunkInfoVec.size() << " index chunks, ";
+        std::cout << index.numFrames() << " frames" << std::endl;
+    }
+    else
+    {
+        std::cout << "scanning all frames" << std::endl;
+    }
+
+    uint64_t dataEnd = scanChunks(file, fileSize, header, scanLoc, index);
+
+    std::cout << "frames:    " << index.numFrames() << std::endl;
+    std::cout << "keyframes: " << index.numKeyFrames() << std::endl;
+    std::cout << "truncated: " << (fileSize - dataEnd) << " bytes" << std::endl;
+
+    if (dryRun)
+    {
+        return 0;
+    }
+
+    // Drop incomplete data at end of file and write index
+    file.close();
+    if (!QFile::resize(QString::fromStdString(fileName), qint64(dataEnd)))
+    {
+        std::cout << "error: unable to truncate " << fileName << std::endl;
+        return 1;
+    }
+    file.open(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if ((!file.is_open()) || (!writeIndex(file, dataEnd, index)))
+    {
+        std::cout << "error: unable to write index to " << fileName << std::endl;
+        return 1;
+    }
+    std::cout << "index written" << std::endl;
+    file.close();
+    removeJournal(fileName);
+    return 0;
+}
+
+
+bool readFmfHeader(std::fstream &file, FmfHeader &header)
+{
+    file.seekg(0, std::ios_base::beg);
+    bool ok = readValue(file, header.version);
+    ok = ok && readValue(file, header.height);
+    ok = ok && readValue(file, header.width);
+    ok = ok && readValue(file, header.bytesPerChunk);
+    ok = ok && readValue(file, header.numFrames);
+    uint64_t imageSize = uint64_t(header.width)*header.height;
+    return ok && (header.version == FMF_VERSION) && (imageSize > 0) && (header.bytesPerChunk == imageSize + sizeof(double));
+}
+
+
+bool isZeroImage(std::fstream &file, const FmfHeader &header, std::vector<char> &imageData)
+{
+    // Reads the image following a time stamp, true if it is all zeros. 
+    imageData.resize(size_t(header.bytesPerChunk - sizeof(double)));
+    file.read(imageData.data(), imageData.size());
+    if (!file)
+    {
+        return true;
+    }
+    return std::all_of(imageData.begin(), imageData.end(), [](char value) { return value == 0; });
+}
+
+
+uint64_t scanFmfFrames(std::fstream &file, const FmfHeader &header, uint64_t firstFrame, uint64_t maxFrames)
+{
+    // Frames after firstFrame are kept while their time stamps are finite
+    // and increasing. Zero filled, e.g. preallocated, space ends the scan - 
+    // a record with a zero time stamp and an all zero image is taken as the 
+    // end of the data rather than a frame.
+    double lastTimeStamp = -HUGE_VAL;
+    if (firstFrame > 0)
+    {
+        file.clear();
+        file.seekg(FMF_HEADER_SIZE + (firstFrame - 1)*header.bytesPerChunk, std::ios_base::beg);
+        if (!readValue(file, lastTimeStamp))
+        {
+            return firstFrame - 1;
+        }
+    }
+
+    uint64_t numFrames = firstFrame;
+    std::vector<char> imageData;
+    while (numFrames < maxFrames)
+    {
+        double timeStamp = 0.0;
+        file.clear();
+        file.seekg(FMF_HEADER_SIZE + numFrames*header.bytesPerChunk, std::ios_base::beg);
+        if (!readValue(file, timeStamp))
+        {
+            break;
+        }
+        bool isValid = std::isfinite(timeStamp) && (timeStamp >= 0.0);
+        isValid = isValid && ((numFrames == 0) || (timeStamp > lastTimeStamp));
+        if ((!isValid) || ((timeStamp == 0.0) && isZeroImage(file, header, imageData)))
+        {
+            break;
+        }
+        lastTimeStamp = timeStamp;
+        numFrames++;
+    }
+    return numFrames;
+}
+
+
+int recoverFmf(std::string fileName, bool fullScan, bool dryRun)
+{
+    std::fstream file(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "error: unable to open " << fileName << std::endl;
+        return 1;
+    }
+
+    FmfHeader header;
+    if (!readFmfHeader(file, header))
+    {
+        std::cout << "error: " << fileName << " is not a version 1 fmf file" << std::endl;
+        return 1;
+    }
+    uint64_t fileSize = getFileSize(file);
+    uint64_t maxFrames = 0;
+    if (fileSize > FMF_HEADER_SIZE)
+    {
+        maxFrames = (fileSize - FMF_HEADER_SIZE)/header.bytesPerChunk;
+    }
+
+    // Frames up to the last checkpoint were synced to disk
+    uint64_t firstFrame = 0;
+    RecordingJournalRecord record;
+    if (!fullScan)
+    {
+        if (readJournal(fileName, JOURNAL_FORMAT_FMF, fileSize, record))
+        {
+            firstFrame = std::min(record.numFrames, maxFrames);
+            std::cout << "checkpoint journal: " << record.numFrames << " frames" << std::endl;
+        }
+        else
+        {
+            firstFrame = std::min(header.numFrames, maxFrames);
+        }
+    }
+    else
+    {
+        std::cout << "scanning all frames" << std::endl;
+    }
+
+    uint64_t numFrames = scanFmfFrames(file, header, firstFrame, maxFrames);
+    uint64_t dataEnd = FMF_HEADER_SIZE + numFrames*header.bytesPerChunk;
+
+    std::cout << "frames:    " << numFrames << " (header " << header.numFrames << ")" << std::endl;
+    std::cout << "truncated: " << (fileSize - dataEnd) << " bytes" << std::endl;
+
+    if (dryRun)
+    {
+        return 0;
+    }
+
+    // Drop partial frames at end of file and set the frame count
+    file.close();
+    if ((dataEnd < fileSize) && !QFile::resize(QString::fromStdString(fileName), qint64(dataEnd)))
+    {
+        std::cout << "error: unable to truncate " << fileName << std::endl;
+        return 1;
+    }
+    file.open(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (file.is_open())
+    {
+        file.seekp(FMF_NUM_FRAMES_POS, std::ios_base::beg);
+        file.write((char*) &numFrames, sizeof(uint64_t));
+        file.flush();
+    }
+    if ((!file.is_open()) || (!file))
+    {
+        std::cout << "error: unable to write frame count to " << fileName << std::endl;
+        return 1;
+    }
+    std::cout << "frame count written" << std::endl;
+    file.close();
+    removeJournal(fileName);
+    return 0;
+}
+
+
+int recover(std::string fileName, bool fullScan, bool dryRun)
+{
+    QString suffix = QFileInfo(QString::fromStdString(fileName)).suffix().toLower();
+    if (suffix == QString("fmf"))
+    {
+        return recoverFmf(fileName, fullScan, dryRun);
+    }
+    return recoverUfmf(fileName, fullScan, dryRun);
+}
+
+
+void printUsage()
+{
+    std::cout << "usage: bias_recover [--scan] [--dry-run] file.ufmf|file.fmf ..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "  --scan     ignore index chunks and checkpoints and scan all frames" << std::endl;
+    std::cout << "  --dry-run  report what would be recovered without modifying the file" << std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+    bool fullScan = false;
+    bool dryRun = false;
+    std::vector<std::string> fileNameVec;
+
+    for (int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--scan")
+        {
+            fullScan = true;
+        }
+        else if (arg == "--dry-run")
+        {
+            dryRun = true;
+        }
+        else if ((arg == "-h") || (arg == "--help"))
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            fileNameVec.push_back(arg);
+        }
+    }
+
+    if (fileNameVec.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    int rtnVal = 0;
+    for (unsigned int i=0; i<fileNameVec.size(); i++)
+    {
+        rtnVal |= recover(fileNameVec[i], fullScan, dryRun);
+    }
+    return rtnVal;
+}
@@ -0,0 +1,498 @@
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include "stamped_image.hpp"
+#include "video_reader.hpp"
+#include "video_writer.hpp"
+#include "video_writer_params.hpp"
+#include "video_writer_bmp.hpp"
+#include "video_writer_jpg.hpp"
+#include "video_writer_avi.hpp"
+#include "video_writer_fmf.hpp"
+#include "video_writer_ufmf.hpp"
+#include "video_writer_zfmf.hpp"
+#include "compression_scheduler.hpp"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QString>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// ------------------------------------------------------------------------
+// bias_transcode - converts a video file written by BIAS (fmf, ufmf, zfmf,
+// mjpg, avi or an image sequence directory) to another BIAS format (bmp, 
+// jpg, mjpg, avi, fmf, ufmf or zfmf) using the logging video writers.
+//
+// Frames are read in blocks, each block decoded on several threads, while
+// the previous block is passed to the writer. The writer compresses on the
+// shared compression workers. Frames are held back while the writer is
+// backlogged so none are skipped. Time stamps and frame numbers are taken
+// from the input file. Errors from the compressor threads are queued 
+// signals, so events are processed while transcoding and any error 
+// reported by the writer fails the transcode.
+// ------------------------------------------------------------------------
+
+using namespace bias;
+
+const uint64_t MAX_BLOCK_BYTES = 64*1024*1024;
+const unsigned long MAX_BLOCK_FRAMES = 256;
+const double REPORT_INTERVAL_SEC = 2.0;
+
+
+// Writer errors
+// ------------------------------------------------------------------------
+struct WriterError
+{
+    // First error reported by the writer's imageLoggingError signal
+    bool flag;
+    unsigned int errorId;
+    QString errorMsg;
+    WriterError() : flag(false), errorId(0) {}
+};
+
+
+void checkWriterError(const WriterError &writerError)
+{
+    QCoreApplication::processEvents();
+    if (writerError.flag)
+    {
+        throw RuntimeError(writerError.errorId, writerError.errorMsg.toStdString());
+    }
+}
+
+
+// Reader
+// ------------------------------------------------------------------------
+class ReadBlockTask : public QRunnable
+{
+    // Reads the next block while the current one is written
+
+    public:
+
+        ReadBlockTask(
+                VideoReader *sourcePtr,
+                unsigned long firstFrame,
+                unsigned long numFrames,
+                unsigned int numThreads,
+                std::vector<cv::Mat> *imageVecPtr
+                )
+        {
+            sourcePtr_ = sourcePtr;
+            firstFrame_ = firstFrame;
+            numFrames_ = numFrames;
+            numThreads_ = numThreads;
+            imageVecPtr_ = imageVecPtr;
+            errorFlag_ = false;
+            setAutoDelete(false);
+        }
+
+        void run()
+        {
+            try
+            {
+                sourcePtr_ -> getFrames(firstFrame_, numFrames_, *imageVecPtr_, numThreads_);
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                errorFlag_ = true;
+                errorMsg_ = runtimeError.what();
+            }
+        }
+
+        bool errorFlag_;
+        std::string errorMsg_;
+
+    private:
+
+        VideoReader *sourcePtr_;
+        unsigned long firstFrame_;
+        unsigned long numFrames_;
+        unsigned int numThreads_;
+        std::vector<cv::Mat> *imageVecPtr_;
+};
+
+
+// Writer
+// ------------------------------------------------------------------------
+struct TranscodeOptions
+{
+    QString format;
+    unsigned int numThreads;
+    int quality;
+    int compressionLevel;
+    QString codec;
+    unsigned long firstFrame;
+    unsigned long numFrames;
+
+    TranscodeOptions()
+    {
+        numThreads = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        quality = -1;
+        compressionLevel = -1;
+        firstFrame = 0;
+        numFrames = 0;
+    }
+};
+
+
+bool isMonoFormat(QString format)
+{
+    return (format == "fmf") || (format == "ufmf") || (format == "zfmf");
+}
+
+
+std::shared_ptr<VideoWriter> createWriter(
+        QString fileName, 
+        const TranscodeOptions &options, 
+        WriterError *writerErrorPtr
+        )
+{
+    // Writer parameters are the logging defaults with the number of
+    // compressors set from the number of threads.
+    std::shared_ptr<VideoWriter> writerPtr;
+
+    if (options.format == "bmp")
+    {
+        VideoWriterParams_bmp params;
+        params.numberOfCompressors = options.numThreads;
+        writerPtr = std::make_shared<VideoWriter_bmp>(params, fileName, 0);
+    }
+    else if ((options.format == "jpg") || (options.format == "mjpg"))
+    {
+        VideoWriterParams_jpg params;
+        params.numberOfCompressors = options.numThreads;
+        params.mjpgFlag = (options.format == "mjpg");
+        params.rateControl = false;
+        if (options.quality >= 0)
+        {
+            params.quality = (unsigned int)(options.quality);
+        }
+        writerPtr = std::make_shared<VideoWriter_jpg>(params, fileName, 0);
+    }
+    else if (options.format == "avi")
+    {
+        VideoWriterParams_avi params;
+        params.numberOfEncoders = std::max(params.numberOfEncoders, 1U);
+        if (!options.codec.isEmpty())
+        {
+            if (!VideoWriter_avi::isAllowedCodec(options.codec))
+            {
+                std::string errorMsg("avi codec not allowed, ");
+                errorMsg += options.codec.toStdString();
+                throw RuntimeError(ERROR_VIDEO_WRITER_INITIALIZE, errorMsg);
+            }
+            params.codec = options.codec;
+        }
+        writerPtr = std::make_shared<VideoWriter_avi>(params, fileName, 0);
+    }
+    else if (options.format == "fmf")
+    {
+        VideoWriterParams_fmf params;
+        writerPtr = std::make_shared<VideoWriter_fmf>(params, fileName, 0);
+    }
+    else if (options.format == "ufmf")
+    {
+        VideoWriterParams_ufmf params;
+        params.numberOfCompressors = options.numThreads;
+        if (options.compressionLevel >= 0)
+        {
+            params.compressionLevel = (unsigned int)(options.compressionLevel);
+        }
+        writerPtr = std::make_shared<VideoWriter_ufmf>(params, fileName, 0);
+    }
+    else if (options.format == "zfmf")
+    {
+        VideoWriterParams_zfmf params;
+        params.numberOfCompressors = options.numThreads;
+        if (options.compressionLevel >= 0)
+        {
+            params.compressionLevel = (unsigned int)(options.compressionLevel);
+        }
+        writerPtr = std::make_shared<VideoWriter_zfmf>(params, fileName, 0);
+    }
+    else
+    {
+        std::string errorMsg("unsupported output format, ");
+        errorMsg += options.format.toStdString();
+        throw RuntimeError(ERROR_VIDEO_WRITER_INITIALIZE, errorMsg);
+    }
+
+    writerPtr -> setVersioning(false);
+    writerPtr -> setSourceFrameNumbers(true);
+    QObject::connect(
+            writerPtr.get(),
+            &VideoWriter::imageLoggingError,
+            [writerErrorPtr](unsigned int errorId, QString errorMsg)
+            {
+                std::cerr << "writer error " << errorId << ": " << errorMsg.toStdString() << std::endl;
+                if (!writerErrorPtr -> flag)
+                {
+                    writerErrorPtr -> flag = true;
+                    writerErrorPtr -> errorId = errorId;
+                    writerErrorPtr -> errorMsg = errorMsg;
+                }
+            }
+            );
+    return writerPtr;
+}
+
+
+// Transcode
+// ------------------------------------------------------------------------
+void printProgress(unsigned long numDone, unsigned long numFrames, uint64_t numBytesRead, double elapsedSec)
+{
+    double fps = (elapsedSec > 0.0) ? numDone/elapsedSec : 0.0;
+    double mbps = (elapsedSec > 0.0) ? numBytesRead/(1.0e6*elapsedSec) : 0.0;
+    std::cout << "  " << numDone << "/" << numFrames << " frames, ";
+    std::cout << std::fixed << std::setprecision(1) << fps << " fps, ";
+    std::cout << mbps << " MB/s" << std::endl;
+}
+
+
+int transcode(QString inputFileName, QString outputFileName, TranscodeOptions options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    std::shared_ptr<VideoReader> sourcePtr;
+    std::shared_ptr<VideoWriter> writerPtr;
+    WriterError writerError;
+    unsigned long numFrames = 0;
+    unsigned long numDone = 0;
+    uint64_t numBytesRead = 0;
+
+    try
+    {
+        sourcePtr = VideoReader::createReader(inputFileName);
+        unsigned long numSourceFrames = sourcePtr -> getNumberOfFrames();
+        unsigned long firstFrame = std::min(options.firstFrame, numSourceFrames);
+        numFrames = numSourceFrames - firstFrame;
+        if (options.numFrames > 0)
+        {
+            numFrames = std::min(numFrames, options.numFrames);
+        }
+        if (numFrames == 0)
+        {
+            std::cerr << "no frames to transcode in " << inputFileName.toStdString() << std::endl;
+            return 1;
+        }
+
+        // Mean frame interval, used by avi for its frame rate
+        double dtEstimate = 0.0;
+        if (numFrames > 1)
+        {
+            double t0 = sourcePtr -> getTimeStamp(firstFrame);
+            double t1 = sourcePtr -> getTimeStamp(firstFrame + numFrames - 1);
+            dtEstimate = (t1 - t0)/double(numFrames - 1);
+        }
+
+        CompressionScheduler::instance().setMaxNumberOfWorkers(options.numThreads);
+        writerPtr = createWriter(outputFileName, options, &writerError);
+
+        std::cout << inputFileName.toStdString() << " -> " << outputFileName.toStdString();
+        std::cout << " (" << options.format.toStdString() << ", " << numFrames << " frames, ";
+        std::cout << options.numThreads << " threads)" << std::endl;
+
+        // Block size from the first frame
+        std::vector<cv::Mat> firstImageVec;
+        sourcePtr -> getFrames(firstFrame, 1, firstImageVec, 1);
+        uint64_t frameBytes = std::max(uint64_t(firstImageVec[0].total()*firstImageVec[0].elemSize()), uint64_t(1));
+        unsigned long blockSize = (unsigned long)(std::min(MAX_BLOCK_BYTES/frameBytes, uint64_t(MAX_BLOCK_FRAMES)));
+        blockSize = std::max(blockSize, (unsigned long)(options.numThreads));
+
+        QThreadPool readPool;
+        readPool.setMaxThreadCount(1);
+        std::vector<cv::Mat> currImageVec;
+        std::vector<cv::Mat> nextImageVec;
+        sourcePtr -> getFrames(firstFrame, std::min(blockSize, numFrames), currImageVec, options.numThreads);
+
+        double lastReportSec = 0.0;
+        for (unsigned long start=0; start<numFrames; start+=blockSize)
+        {
+            unsigned long count = std::min(blockSize, numFrames - start);
+            unsigned long nextStart = start + count;
+
+            // Images already passed to the writer may still be queued, so
+            // each block is read into new images.
+            std::unique_ptr<ReadBlockTask> readTaskPtr;
+            nextImageVec.clear();
+            if (nextStart < numFrames)
+            {
+                unsigned long nextCount = std::min(blockSize, numFrames - nextStart);
+                readTaskPtr.reset(new ReadBlockTask(
+                            sourcePtr.get(),
+                            firstFrame + nextStart,
+                            nextCount,
+                            options.numThreads,
+                            &nextImageVec
+                            ));
+                readPool.start(readTaskPtr.get());
+            }
+
+            for (unsigned long i=0; i<count; i++)
+            {
+                unsigned long frameNumber = firstFrame + start + i;
+                StampedImage stampedImg;
+                stampedImg.image = currImageVec[i];
+                if ((stampedImg.image.channels() == 3) && isMonoFormat(options.format))
+                {
+                    cv::cvtColor(currImageVec[i], stampedImg.image, CV_BGR2GRAY);
+                }
+                stampedImg.timeStamp = sourcePtr -> getTimeStamp(frameNumber);
+                stampedImg.hostTimeStamp = 0.0;
+                stampedImg.frameCount = sourcePtr -> getFrameCount(frameNumber);
+                stampedImg.dtEstimate = dtEstimate;
+                numBytesRead += uint64_t(currImageVec[i].total()*currImageVec[i].elemSize());
+
+                while ((writerPtr -> isBacklogged()) && (!writerError.flag))
+                {
+                    QCoreApplication::processEvents();
+                    QThread::msleep(1);
+                }
+                writerPtr -> addFrame(stampedImg);
+                numDone++;
+            }
+
+            readPool.waitForDone();
+            if (readTaskPtr && readTaskPtr -> errorFlag_)
+            {
+                throw RuntimeError(ERROR_VIDEO_READER_READ, readTaskPtr -> errorMsg_);
+            }
+            checkWriterError(writerError);
+            currImageVec.swap(nextImageVec);
+
+            double elapsedSec = 1.0e-3*timer.elapsed();
+            if (elapsedSec - lastReportSec >= REPORT_INTERVAL_SEC)
+            {
+                printProgress(numDone, numFrames, numBytesRead, elapsedSec);
+                lastReportSec = elapsedSec;
+            }
+        }
+
+        writerPtr -> finish();
+        checkWriterError(writerError);
+        uint64_t numBytesWritten = writerPtr -> getNumberOfBytesWritten();
+        writerPtr.reset();
+
+        double elapsedSec = 1.0e-3*timer.elapsed();
+        printProgress(numDone, numFrames, numBytesRead, elapsedSec);
+        std::cout << "  done in " << std::fixed << std::setprecision(1) << elapsedSec << " s";
+        if (numBytesWritten > 0)
+        {
+            std::cout << ", " << numBytesWritten << " bytes written";
+        }
+        std::cout << std::endl;
+    }
+    catch (RuntimeError &runtimeError)
+    {
+        std::cerr << "error: " << runtimeError.what() << std::endl;
+        std::cerr << "  " << numDone << " of " << numFrames << " frames transcoded" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+void printUsage()
+{
+    std::cout << "usage: bias_transcode [options] input.fmf|.ufmf|.zfmf|.mjpg|.avi|dir output" << std::endl;
+    std::cout << std::endl;
+    std::cout << "  -f, --format fmt   output format: bmp, jpg, mjpg, avi, fmf, ufmf or zfmf" << std::endl;
+    std::cout << "                     (default from the output file suffix)" << std::endl;
+    std::cout << "  -j, --threads n    number of read and compression threads" << std::endl;
+    std::cout << "  -q, --quality n    jpg/mjpg quality" << std::endl;
+    std::cout << "  -l, --level n      ufmf/zfmf compression level" << std::endl;
+    std::cout << "  -c, --codec name   avi codec" << std::endl;
+    std::cout << "  --first n          first frame to transcode" << std::endl;
+    std::cout << "  --count n          number of frames to transcode" << std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    TranscodeOptions options;
+    std::vector<QString> fileNameVec;
+
+    for (int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+        bool haveValue = (i+1 < argc);
+        QString value = haveValue ? QString(argv[i+1]) : QString();
+        bool ok = true;
+
+        if ((arg == "-h") || (arg == "--help"))
+        {
+            printUsage();
+            return 0;
+        }
+        else if ((arg == "-f") || (arg == "--format"))
+        {
+            options.format = value.toLower();
+            i++;
+        }
+        else if ((arg == "-j") || (arg == "--threads"))
+        {
+            options.numThreads = std::max(value.toUInt(&ok), 1U);
+            i++;
+        }
+        else if ((arg == "-q") || (arg == "--quality"))
+        {
+            options.quality = value.toInt(&ok);
+            i++;
+        }
+        else if ((arg == "-l") || (arg == "--level"))
+        {
+            options.compressionLevel = value.toInt(&ok);
+            i++;
+        }
+        else if ((arg == "-c") || (arg == "--codec"))
+        {
+            options.codec = value;
+            i++;
+        }
+        else if (arg == "--first")
+        {
+            options.firstFrame = value.toULong(&ok);
+            i++;
+        }
+        else if (arg == "--count")
+        {
+            options.numFrames = value.toULong(&ok);
+            i++;
+        }
+        else
+        {
+            fileNameVec.push_back(QString(argv[i]));
+            continue;
+        }
+
+        if (!haveValue || !ok)
+        {
+            std::cerr << "invalid value for " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (fileNameVec.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.format.isEmpty())
+    {
+        options.format = QFileInfo(fileNameVec[1]).suffix().toLower();
+    }
+    return transcode(fileNameVec[0], fileNameVec[1], options);
+}
@@ -0,0 +1,498 @@
+#include "fmf_reader.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace bias
+{
+    const unsigned long FmfReader::DEFAULT_READ_AHEAD = 32;
+
+
+    // FmfCopyTask - copies a contiguous block of frames for getFrames
+    // ----------------------------------------------------------------------------------
+    class FmfCopyTask : public QRunnable
+    {
+        public:
+
+            FmfCopyTask(
+                    FmfReader *readerPtr,
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    cv::Mat *imagePtr
+                    )
+            {
+                readerPtr_ = readerPtr;
+                firstFrame_ = firstFrame;
+                numFrames_ = numFrames;
+                imagePtr_ = imagePtr;
+            }
+
+            void run()
+            {
+                // Range is checked by getFrames, views can't fail
+                for (unsigned long i=0; i<numFrames_; i++)
+                {
+                    readerPtr_ -> getFrameView(firstFrame_ + i).copyTo(imagePtr_[i]);
+                }
+            }
+
+        private:
+
+            FmfReader *readerPtr_;
+            unsigned long firstFrame_;
+            unsigned long numFrames_;
+            cv::Mat *imagePtr_;
+    };
+
+
+    // FmfReader
+    // ----------------------------------------------------------------------------------
+    FmfReader::FmfReader()
+    {
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        readAhead_ = DEFAULT_READ_AHEAD;
+        close();
+    }
+
+
+    FmfReader::FmfReader(QString fileName) : FmfReader()
+    {
+        open(fileName);
+    }
+
+
+    FmfReader::~FmfReader()
+    {
+        close();
+    }
+
+
+    void FmfReader::open(QString fileName)
+    {
+        close();
+
+        file_.setFileName(fileName);
+        if (!file_.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("fmf reader unable to open file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // Private mapping - changes made through frame views are never 
+        // written back to the file.
+        dataSize_ = uint64_t(file_.size());
+        if (dataSize_ > 0)
+        {
+            dataPtr_ = file_.map(0, file_.size(), QFileDevice::MapPrivateOption);
+        }
+        if (dataPtr_ == nullptr)
+        {
+            file_.close();
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("fmf reader unable to memory map file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        try
+        {
+            readHeader();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            close();
+            throw;
+        }
+        numFrames_ = (unsigned long)((dataSize_ - headerSize_)/bytesPerChunk_);
+        dropEmptyFrames();
+    }
+
+
+    void FmfReader::close()
+    {
+        if (dataPtr_ != nullptr)
+        {
+            file_.unmap((uchar *) dataPtr_);
+        }
+        if (file_.isOpen())
+        {
+            file_.close();
+        }
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        version_ = 0;
+        size_ = cv::Size(0,0);
+        type_ = CV_8UC1;
+        format_ = QString();
+        headerSize_ = 0;
+        bytesPerChunk_ = 0;
+        numFrames_ = 0;
+        headerNumFrames_ = 0;
+        nextFrame_ = 0;
+        prefetchEnd_ = 0;
+    }
+
+
+    bool FmfReader::isOpen() const
+    {
+        return (dataPtr_ != nullptr);
+    }
+
+
+    QString FmfReader::getFileName() const
+    {
+        return file_.fileName();
+    }
+
+
+    unsigned int FmfReader::getVersion() const
+    {
+        return version_;
+    }
+
+
+    cv::Size FmfReader::getSize() const
+    {
+        return size_;
+    }
+
+
+    int FmfReader::getType() const
+    {
+        return type_;
+    }
+
+
+    QString FmfReader::getFormat() const
+    {
+        return format_;
+    }
+
+
+    uint64_t FmfReader::getBytesPerChunk() const
+    {
+        return bytesPerChunk_;
+    }
+
+
+    unsigned long FmfReader::getNumberOfFrames() const
+    {
+        return numFrames_;
+    }
+
+
+    unsigned long FmfReader::getHeaderNumberOfFrames() const
+    {
+        // Frame count stored in the header - may lag the number of frames 
+        // in the file if the writer didn't close it.
+        return headerNumFrames_;
+    }
+
+
+    double FmfReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        double timeStamp;
+        std::memcpy(&timeStamp, dataPtr_ + headerSize_ + frameNumber*bytesPerChunk_, sizeof(double));
+        return timeStamp;
+    }
+
+
+    std::vector<double> FmfReader::getTimeStamps() const
+    {
+        std::vector<double> timeStampVec(numFrames_);
+        for (unsigned long i=0; i<numFrames_; i++)
+        {
+            timeStampVec[i] = getTimeStamp(i);
+        }
+        return timeStampVec;
+    }
+
+
+    unsigned long FmfReader::getFrameNumber(double timeStamp) const
+    {
+        // Returns first frame at or after timeStamp (last frame if none).
+        // Binary search - touches only O(log n) pages of the file.
+        if (numFrames_ == 0)
+        {
+            return 0;
+        }
+        unsigned long lower = 0;
+        unsigned long upper = numFrames_;
+        while (lower < upper)
+        {
+            unsigned long middle = lower + (upper - lower)/2;
+            if (getTimeStamp(middle) < timeStamp)
+            {
+                lower = middle + 1;
+            }
+            else
+            {
+                upper = middle;
+            }
+        }
+        return std::min(lower, numFrames_ - 1);
+    }
+
+
+    cv::Mat FmfReader::getFrameView(unsigned long frameNumber)
+    {
+        // Zero copy image referencing the mapped file - valid until close. 
+        checkFrameNumber(frameNumber);
+        adviseSequential(frameNumber);
+        return cv::Mat(size_, type_, (void *) getFramePtr(frameNumber));
+    }
+
+
+    cv::Mat FmfReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void FmfReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        getFrameView(frameNumber).copyTo(image);
+    }
+
+
+    void FmfReader::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        imageVec.resize(numFrames);
+        if (numFrames == 0)
+        {
+            return;
+        }
+        checkFrameNumber(firstFrame + numFrames - 1);
+        prefetch(firstFrame, numFrames);
+
+        if (numThreads == 0)
+        {
+            numThreads = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        }
+        numThreads = (unsigned int)(std::min((unsigned long)(numThreads), numFrames));
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(numThreads);
+
+        unsigned long blockSize = (numFrames + numThreads - 1)/numThreads;
+        for (unsigned long start=0; start<numFrames; start+=blockSize)
+        {
+            unsigned long count = std::min(blockSize, numFrames - start);
+            FmfCopyTask *taskPtr = new FmfCopyTask(this, firstFrame + start, count, &imageVec[start]);
+            threadPool.start(taskPtr);
+        }
+        threadPool.waitForDone();
+    }
+
+
+    void FmfReader::prefetch(unsigned long firstFrame, unsigned long numFrames) const
+    {
+        // Asks the os to start reading the frames into the page cache, 
+        // returns immediately.
+        if ((dataPtr_ == nullptr) || (firstFrame >= numFrames_) || (numFrames == 0))
+        {
+            return;
+        }
+        numFrames = std::min(numFrames, numFrames_ - firstFrame);
+#ifndef WIN32
+        uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+        uint64_t beginPos = headerSize_ + firstFrame*bytesPerChunk_;
+        uint64_t endPos = beginPos + numFrames*bytesPerChunk_;
+        beginPos -= beginPos%pageSize;
+        madvise((void *) (dataPtr_ + beginPos), size_t(endPos - beginPos), MADV_WILLNEED);
+#endif
+    }
+
+
+    void FmfReader::setReadAhead(unsigned long numFrames)
+    {
+        // Number of frames prefetched ahead of in order reads, 0 to disable
+        acquireLock();
+        readAhead_ = numFrames;
+        releaseLock();
+    }
+
+
+    unsigned long FmfReader::getReadAhead()
+    {
+        acquireLock();
+        unsigned long readAhead = readAhead_;
+        releaseLock();
+        return readAhead;
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+    void FmfReader::readHeader()
+    {
+        // version 1: version, height, width, bytes per chunk, number of frames
+        // version 2: version, format length, format, bits per pixel, height,
+        //            width, bytes per chunk, number of frames
+        uint64_t pos = 0;
+        version_ = readValue<uint32_t>(pos);
+
+        uint32_t bitsPerPixel = 8;
+        if (version_ == 1)
+        {
+            format_ = QString("MONO8");
+        }
+        else if (version_ == 2)
+        {
+            uint32_t formatLength = readValue<uint32_t>(pos);
+            checkRange(pos, formatLength);
+            format_ = QString::fromLatin1((const char *) (dataPtr_ + pos), int(formatLength));
+            pos += formatLength;
+            bitsPerPixel = readValue<uint32_t>(pos);
+        }
+        else
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("fmf reader: unsupported version ");
+            errorMsg += std::to_string(version_);
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        uint32_t height = readValue<uint32_t>(pos);
+        uint32_t width = readValue<uint32_t>(pos);
+        bytesPerChunk_ = readValue<uint64_t>(pos);
+        headerNumFrames_ = (unsigned long)(readValue<uint64_t>(pos));
+        headerSize_ = pos;
+        size_ = cv::Size(int(width), int(height));
+
+        switch (bitsPerPixel)
+        {
+            case 8:
+                type_ = CV_8UC1;
+                break;
+
+            case 16:
+                type_ = CV_16UC1;
+                break;
+
+            case 24:
+                type_ = CV_8UC3;
+                break;
+
+            case 32:
+                type_ = CV_8UC4;
+                break;
+
+            default:
+                {
+                    unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+                    std::string errorMsg("fmf reader: unsupported bits per pixel ");
+                    errorMsg += std::to_string(bitsPerPixel);
+                    throw RuntimeError(errorId, errorMsg);
+                }
+        }
+
+        uint64_t imageSize = uint64_t(width)*uint64_t(height)*uint64_t(bitsPerPixel/8);
+        if (bytesPerChunk_ != imageSize + sizeof(double))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("fmf reader: bytes per chunk doesn't match image size");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void FmfReader::dropEmptyFrames()
+    {
+        // Space reserved or padded by the writer reads back as zeros. Only
+        // the first frame may have a zero time stamp and frames counted in
+        // the header are known to have been written.
+        while ((numFrames_ > std::max(headerNumFrames_, 1UL)) && (getTimeStamp(numFrames_-1) == 0.0))
+        {
+            numFrames_--;
+        }
+    }
+
+
+    void FmfReader::adviseSequential(unsigned long frameNumber)
+    {
+        // Keeps about readAhead_ frames prefetched ahead of in order reads. 
+        // Prefetch requests are issued in batches of half the read ahead.
+        unsigned long prefetchBegin = 0;
+        unsigned long prefetchEnd = 0;
+
+        acquireLock();
+        bool isSequential = (frameNumber == nextFrame_);
+        nextFrame_ = frameNumber + 1;
+        if (!isSequential || (readAhead_ == 0))
+        {
+            prefetchEnd_ = nextFrame_;
+        }
+        else if (nextFrame_ + readAhead_/2 >= prefetchEnd_)
+        {
+            prefetchBegin = std::max(prefetchEnd_, nextFrame_);
+            prefetchEnd = std::min(nextFrame_ + readAhead_, numFrames_);
+            prefetchEnd_ = std::max(prefetchEnd, prefetchBegin);
+        }
+        releaseLock();
+
+        if (prefetchEnd > prefetchBegin)
+        {
+            prefetch(prefetchBegin, prefetchEnd - prefetchBegin);
+        }
+    }
+
+
+    const uchar *FmfReader::getFramePtr(unsigned long frameNumber) const
+    {
+        return dataPtr_ + headerSize_ + frameNumber*bytesPerChunk_ + sizeof(double);
+    }
+
+
+    void FmfReader::checkRange(uint64_t pos, uint64_t size) const
+    {
+        if ((dataPtr_ == nullptr) || (pos + size > dataSize_))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("fmf reader: read past end of file");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void FmfReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= numFrames_)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("fmf reader: frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    template <class T>
+    T FmfReader::readValue(uint64_t &pos) const
+    {
+        T value;
+        checkRange(pos, sizeof(T));
+        std::memcpy(&value, dataPtr_ + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+} // namespace bias
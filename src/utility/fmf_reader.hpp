@@ -0,0 +1,104 @@
+#ifndef BIAS_FMF_READER_HPP
+#define BIAS_FMF_READER_HPP
+
+#include "lockable.hpp"
+#include <QString>
+#include <QFile>
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace bias
+{
+
+    class FmfReader : public Lockable<Empty>
+    {
+        // Random access reader for fmf files (version 1 as written by 
+        // VideoWriter_fmf and version 2). Frames are fixed size records - a 
+        // double time stamp followed by the image data - so the file is 
+        // memory mapped and frames are located directly from their number. 
+        //
+        // The frame count is taken from the file size rather than the header 
+        // so files left with a stale or zero count by a crash can be read. 
+        // Trailing records of zeros (e.g. unwritten preallocated or padded 
+        // space) are dropped.
+        //
+        // When frames are read in order the pages ahead of the current frame
+        // are requested from the os (madvise) so disk reads overlap 
+        // processing. getFrame and getFrames may be called from multiple 
+        // threads. 
+
+        public:
+
+            static const unsigned long DEFAULT_READ_AHEAD;
+
+            FmfReader();
+            FmfReader(QString fileName);
+            virtual ~FmfReader();
+
+            void open(QString fileName);
+            void close();
+            bool isOpen() const;
+            QString getFileName() const;
+
+            unsigned int getVersion() const;
+            cv::Size getSize() const;
+            int getType() const;
+            QString getFormat() const;
+            uint64_t getBytesPerChunk() const;
+            unsigned long getNumberOfFrames() const;
+            unsigned long getHeaderNumberOfFrames() const;
+
+            double getTimeStamp(unsigned long frameNumber) const;
+            std::vector<double> getTimeStamps() const;
+            unsigned long getFrameNumber(double timeStamp) const;
+
+            cv::Mat getFrameView(unsigned long frameNumber);
+            cv::Mat getFrame(unsigned long frameNumber);
+            void getFrame(unsigned long frameNumber, cv::Mat &image);
+            void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            void prefetch(unsigned long firstFrame, unsigned long numFrames) const;
+            void setReadAhead(unsigned long numFrames);
+            unsigned long getReadAhead();
+
+        protected:
+
+            QFile file_;
+            const uchar *dataPtr_;
+            uint64_t dataSize_;
+
+            unsigned int version_;
+            cv::Size size_;
+            int type_;
+            QString format_;
+            uint64_t headerSize_;
+            uint64_t bytesPerChunk_;
+            unsigned long numFrames_;
+            unsigned long headerNumFrames_;
+
+            unsigned long readAhead_;
+            unsigned long nextFrame_;
+            unsigned long prefetchEnd_;
+
+            void readHeader();
+            void dropEmptyFrames();
+            void adviseSequential(unsigned long frameNumber);
+            const uchar *getFramePtr(unsigned long frameNumber) const;
+
+            void checkRange(uint64_t pos, uint64_t size) const;
+            void checkFrameNumber(unsigned long frameNumber) const;
+
+            template <class T>
+            T readValue(uint64_t &pos) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_FMF_READER_HPP
@@ -0,0 +1,318 @@
+#include "fmf_stripe_reader.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include "json.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QVariantMap>
+#include <QVariantList>
+#include <algorithm>
+
+namespace bias
+{
+    const QString FmfStripeReader::MANIFEST_FILE_SUFFIX("_stripes");
+    const QString FmfStripeReader::MANIFEST_FILE_EXT(".json");
+    const QString FmfStripeReader::STRIPE_FILE_SUFFIX("_stripe");
+
+
+    FmfStripeReader::FmfStripeReader()
+    {
+        close();
+    }
+
+
+    FmfStripeReader::FmfStripeReader(QString fileName) : FmfStripeReader()
+    {
+        open(fileName);
+    }
+
+
+    void FmfStripeReader::open(QString fileName)
+    {
+        // fileName is the stripe manifest or the first stripe. A plain fmf
+        // file without a manifest is read as a single stripe.
+        close();
+
+        QString manifestFileName = fileName;
+        if (!fileName.endsWith(MANIFEST_FILE_EXT))
+        {
+            manifestFileName = getManifestFileName(fileName);
+        }
+
+        QStringList stripeFileNames;
+        if (QFileInfo(manifestFileName).exists())
+        {
+            readManifest(manifestFileName, stripeFileNames);
+        }
+        else
+        {
+            chunkFrames_ = 1;
+            stripeFileNames.append(fileName);
+        }
+
+        try
+        {
+            for (QString stripeFileName : stripeFileNames)
+            {
+                readerVec_.push_back(std::make_shared<FmfReader>(stripeFileName));
+                const FmfReader &reader = *readerVec_.back();
+                const FmfReader &firstReader = *readerVec_.front();
+                if ((reader.getSize() != firstReader.getSize()) || (reader.getType() != firstReader.getType()))
+                {
+                    unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+                    std::string errorMsg("fmf stripe reader: stripe image format mismatch, ");
+                    errorMsg += stripeFileName.toStdString();
+                    throw RuntimeError(errorId, errorMsg);
+                }
+            }
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            close();
+            throw;
+        }
+
+        // The stream ends at the first frame missing from any stripe
+        unsigned long numStripes = (unsigned long)(readerVec_.size());
+        numFrames_ = 0;
+        for (unsigned long i=0; i<numStripes; i++)
+        {
+            unsigned long stripeFrames = readerVec_[i] -> getNumberOfFrames();
+            unsigned long chunk = stripeFrames/chunkFrames_;
+            unsigned long endFrame = (chunk*numStripes + i)*chunkFrames_ + stripeFrames%chunkFrames_;
+            numFrames_ = (i == 0) ? endFrame : std::min(numFrames_, endFrame);
+        }
+        fileName_ = fileName;
+    }
+
+
+    void FmfStripeReader::close()
+    {
+        readerVec_.clear();
+        fileName_ = QString();
+        chunkFrames_ = 1;
+        numFrames_ = 0;
+    }
+
+
+    bool FmfStripeReader::isOpen() const
+    {
+        return !readerVec_.empty();
+    }
+
+
+    QString FmfStripeReader::getFileName() const
+    {
+        return fileName_;
+    }
+
+
+    unsigned int FmfStripeReader::getNumberOfStripes() const
+    {
+        return (unsigned int)(readerVec_.size());
+    }
+
+
+    unsigned long FmfStripeReader::getChunkFrames() const
+    {
+        return chunkFrames_;
+    }
+
+
+    QStringList FmfStripeReader::getStripeFileNames() const
+    {
+        QStringList stripeFileNames;
+        for (auto readerPtr : readerVec_)
+        {
+            stripeFileNames.append(readerPtr -> getFileName());
+        }
+        return stripeFileNames;
+    }
+
+
+    cv::Size FmfStripeReader::getSize() const
+    {
+        return readerVec_.empty() ? cv::Size(0,0) : readerVec_.front() -> getSize();
+    }
+
+
+    int FmfStripeReader::getType() const
+    {
+        return readerVec_.empty() ? CV_8UC1 : readerVec_.front() -> getType();
+    }
+
+
+    unsigned long FmfStripeReader::getNumberOfFrames() const
+    {
+        return numFrames_;
+    }
+
+
+    double FmfStripeReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        unsigned int stripe;
+        unsigned long stripeFrame;
+        getStripeFrame(frameNumber, stripe, stripeFrame);
+        return readerVec_[stripe] -> getTimeStamp(stripeFrame);
+    }
+
+
+    std::vector<double> FmfStripeReader::getTimeStamps() const
+    {
+        std::vector<double> timeStampVec(numFrames_);
+        for (unsigned long i=0; i<numFrames_; i++)
+        {
+            timeStampVec[i] = getTimeStamp(i);
+        }
+        return timeStampVec;
+    }
+
+
+    cv::Mat FmfStripeReader::getFrameView(unsigned long frameNumber)
+    {
+        // Zero copy image referencing the mapped stripe - valid until close.
+        // In order reads are in order within each stripe so each stripe's
+        // read ahead applies.
+        unsigned int stripe;
+        unsigned long stripeFrame;
+        getStripeFrame(frameNumber, stripe, stripeFrame);
+        return readerVec_[stripe] -> getFrameView(stripeFrame);
+    }
+
+
+    cv::Mat FmfStripeReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void FmfStripeReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        getFrameView(frameNumber).copyTo(image);
+    }
+
+
+    void FmfStripeReader::prefetch(unsigned long firstFrame, unsigned long numFrames) const
+    {
+        // Split the range into per stripe runs - the stripes are read from
+        // their devices in parallel.
+        if (firstFrame >= numFrames_)
+        {
+            return;
+        }
+        numFrames = std::min(numFrames, numFrames_ - firstFrame);
+        unsigned long endFrame = firstFrame + numFrames;
+        unsigned long frameNumber = firstFrame;
+        while (frameNumber < endFrame)
+        {
+            unsigned int stripe;
+            unsigned long stripeFrame;
+            getStripeFrame(frameNumber, stripe, stripeFrame);
+            unsigned long chunkEnd = (frameNumber/chunkFrames_ + 1)*chunkFrames_;
+            unsigned long count = std::min(chunkEnd, endFrame) - frameNumber;
+            readerVec_[stripe] -> prefetch(stripeFrame, count);
+            frameNumber += count;
+        }
+    }
+
+
+    QString FmfStripeReader::getManifestFileName(QString firstStripeFileName)
+    {
+        QFileInfo fileInfo(firstStripeFileName);
+        QDir filePath = QDir(fileInfo.absolutePath());
+        fileInfo = QFileInfo(filePath, fileInfo.baseName() + MANIFEST_FILE_SUFFIX + MANIFEST_FILE_EXT);
+        return fileInfo.absoluteFilePath();
+    }
+
+
+    QString FmfStripeReader::getStripeFileName(
+            QString firstStripeFileName,
+            QString stripeDir,
+            unsigned int stripeNumber
+            )
+    {
+        // The first stripe keeps the original file name, following stripes
+        // go into their directories with a stripe number, e.g. movie_v001.fmf,
+        // disk1/movie_v001_stripe01.fmf, ...
+        if (stripeNumber == 0)
+        {
+            return firstStripeFileName;
+        }
+        QFileInfo fileInfo(firstStripeFileName);
+        QString stripeStr = STRIPE_FILE_SUFFIX + QString("%1").arg(stripeNumber,2,10,QChar('0'));
+        fileInfo = QFileInfo(QDir(stripeDir), fileInfo.baseName() + stripeStr + "." + fileInfo.suffix());
+        return fileInfo.absoluteFilePath();
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+    void FmfStripeReader::readManifest(QString manifestFileName, QStringList &stripeFileNames)
+    {
+        QFile manifestFile(manifestFileName);
+        if (!manifestFile.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("fmf stripe reader unable to open manifest: ");
+            errorMsg += manifestFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        QString manifestJson = QString::fromUtf8(manifestFile.readAll());
+        manifestFile.close();
+
+        bool ok = false;
+        QVariantMap manifestMap = QtJson::parse(manifestJson, ok).toMap();
+        QVariantList stripeList = manifestMap["stripes"].toList();
+        unsigned long chunkFrames = (unsigned long)(manifestMap["chunkFrames"].toULongLong());
+        if (!ok || stripeList.isEmpty() || (chunkFrames == 0))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("fmf stripe reader: invalid manifest ");
+            errorMsg += manifestFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        chunkFrames_ = chunkFrames;
+
+        // Stripe file names are absolute - the first is also looked for next
+        // to the manifest in case the files were moved.
+        QDir manifestDir = QFileInfo(manifestFileName).absoluteDir();
+        for (QVariant stripeVariant : stripeList)
+        {
+            QString stripeFileName = stripeVariant.toMap()["fileName"].toString();
+            if (stripeFileNames.isEmpty() && !QFileInfo(stripeFileName).exists())
+            {
+                stripeFileName = manifestDir.absoluteFilePath(QFileInfo(stripeFileName).fileName());
+            }
+            stripeFileNames.append(stripeFileName);
+        }
+    }
+
+
+    void FmfStripeReader::getStripeFrame(
+            unsigned long frameNumber,
+            unsigned int &stripe,
+            unsigned long &stripeFrame
+            ) const
+    {
+        checkFrameNumber(frameNumber);
+        unsigned long numStripes = (unsigned long)(readerVec_.size());
+        unsigned long chunk = frameNumber/chunkFrames_;
+        stripe = (unsigned int)(chunk%numStripes);
+        stripeFrame = (chunk/numStripes)*chunkFrames_ + frameNumber%chunkFrames_;
+    }
+
+
+    void FmfStripeReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= numFrames_)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("fmf stripe reader: frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+} // namespace bias
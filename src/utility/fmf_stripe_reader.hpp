@@ -0,0 +1,82 @@
+#ifndef BIAS_FMF_STRIPE_READER_HPP
+#define BIAS_FMF_STRIPE_READER_HPP
+
+#include "fmf_reader.hpp"
+#include <QString>
+#include <QStringList>
+#include <opencv2/core/core.hpp>
+#include <memory>
+#include <vector>
+
+namespace bias
+{
+
+    class FmfStripeReader
+    {
+        // Reader for fmf files striped across several directories by
+        // VideoWriter_fmf. Frames are written in chunks of chunkFrames
+        // frames, round robin over the stripe files, and each stripe is a
+        // complete fmf file. The stripe manifest, written next to the first
+        // stripe, lists the stripe files. The reader re-interleaves the
+        // stripes so frames can be read as from a single fmf file.
+        //
+        // If the writer didn't finish, the stream ends at the first frame
+        // missing from any stripe.
+
+        public:
+
+            static const QString MANIFEST_FILE_SUFFIX;
+            static const QString MANIFEST_FILE_EXT;
+            static const QString STRIPE_FILE_SUFFIX;
+
+            FmfStripeReader();
+            FmfStripeReader(QString fileName);
+
+            void open(QString fileName);
+            void close();
+            bool isOpen() const;
+            QString getFileName() const;
+
+            unsigned int getNumberOfStripes() const;
+            unsigned long getChunkFrames() const;
+            QStringList getStripeFileNames() const;
+
+            cv::Size getSize() const;
+            int getType() const;
+            unsigned long getNumberOfFrames() const;
+
+            double getTimeStamp(unsigned long frameNumber) const;
+            std::vector<double> getTimeStamps() const;
+
+            cv::Mat getFrameView(unsigned long frameNumber);
+            cv::Mat getFrame(unsigned long frameNumber);
+            void getFrame(unsigned long frameNumber, cv::Mat &image);
+
+            void prefetch(unsigned long firstFrame, unsigned long numFrames) const;
+
+            static QString getManifestFileName(QString firstStripeFileName);
+            static QString getStripeFileName(
+                    QString firstStripeFileName,
+                    QString stripeDir,
+                    unsigned int stripeNumber
+                    );
+
+        protected:
+
+            QString fileName_;
+            unsigned long chunkFrames_;
+            unsigned long numFrames_;
+            std::vector<std::shared_ptr<FmfReader>> readerVec_;
+
+            void readManifest(QString manifestFileName, QStringList &stripeFileNames);
+            void getStripeFrame(
+                    unsigned long frameNumber,
+                    unsigned int &stripe,
+                    unsigned long &stripeFrame
+                    ) const;
+            void checkFrameNumber(unsigned long frameNumber) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_FMF_STRIPE_READER_HPP
@@ -0,0 +1,127 @@
+#include "frame_stamp_log.hpp"
+#include <QFile>
+#include <chrono>
+#include <cstring>
+
+namespace bias
+{
+    const char FrameStampLog::MAGIC[8] = {'b','i','a','s','s','t','m','p'};
+    const uint32_t FrameStampLog::VERSION = 1;
+    const size_t FrameStampLog::HEADER_SIZE = sizeof(MAGIC) + 2*sizeof(uint32_t);
+    const size_t FrameStampLog::RECORD_SIZE = sizeof(uint64_t) + 3*sizeof(double) + sizeof(uint32_t);
+    const double FrameStampLog::TIME_GAP_FACTOR = 1.5;
+    const QString FrameStampLog::FILE_EXT(".stamps");
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    template <class T>
+    static void appendValue(std::vector<char> &buf, T value)
+    {
+        const char *valuePtr = (const char *) &value;
+        buf.insert(buf.end(), valuePtr, valuePtr + sizeof(T));
+    }
+
+    template <class T>
+    static T getValue(const char *data, size_t &pos)
+    {
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+
+    // FrameStampRecord
+    // ----------------------------------------------------------------------------------
+    FrameStampRecord::FrameStampRecord()
+    {
+        frameCount = 0;
+        timeStamp = 0.0;
+        hostTimeStamp = 0.0;
+        dtEstimate = 0.0;
+        flags = 0;
+    }
+
+
+    // FrameStampLog
+    // ----------------------------------------------------------------------------------
+    double FrameStampLog::getHostTimeStamp()
+    {
+        std::chrono::duration<double> sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+        return sinceEpoch.count();
+    }
+
+
+    void FrameStampLog::getHeader(std::vector<char> &data)
+    {
+        data.clear();
+        data.reserve(HEADER_SIZE);
+        data.insert(data.end(), MAGIC, MAGIC + sizeof(MAGIC));
+        appendValue(data, VERSION);
+        appendValue(data, uint32_t(RECORD_SIZE));
+    }
+
+
+    void FrameStampLog::serialize(const FrameStampRecord &record, std::vector<char> &data)
+    {
+        // Appends to data so records can be batched
+        appendValue(data, record.frameCount);
+        appendValue(data, record.timeStamp);
+        appendValue(data, record.hostTimeStamp);
+        appendValue(data, record.dtEstimate);
+        appendValue(data, record.flags);
+    }
+
+
+    bool FrameStampLog::parse(const char *data, size_t size, FrameStampRecord &record)
+    {
+        if (size < RECORD_SIZE)
+        {
+            return false;
+        }
+        size_t pos = 0;
+        record.frameCount = getValue<uint64_t>(data, pos);
+        record.timeStamp = getValue<double>(data, pos);
+        record.hostTimeStamp = getValue<double>(data, pos);
+        record.dtEstimate = getValue<double>(data, pos);
+        record.flags = getValue<uint32_t>(data, pos);
+        return true;
+    }
+
+
+    bool FrameStampLog::read(QString fileName, std::vector<FrameStampRecord> &recordVec)
+    {
+        recordVec.clear();
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        QByteArray data = file.readAll();
+        file.close();
+
+        const char *dataPtr = data.constData();
+        size_t size = size_t(data.size());
+        if ((size < HEADER_SIZE) || (std::memcmp(dataPtr, MAGIC, sizeof(MAGIC)) != 0))
+        {
+            return false;
+        }
+        size_t pos = sizeof(MAGIC);
+        uint32_t version = getValue<uint32_t>(dataPtr, pos);
+        uint32_t recordSize = getValue<uint32_t>(dataPtr, pos);
+        if ((version != VERSION) || (recordSize != RECORD_SIZE))
+        {
+            return false;
+        }
+
+        size_t numRecords = (size - HEADER_SIZE)/RECORD_SIZE;
+        recordVec.resize(numRecords);
+        for (size_t i=0; i<numRecords; i++)
+        {
+            parse(dataPtr + HEADER_SIZE + i*RECORD_SIZE, RECORD_SIZE, recordVec[i]);
+        }
+        return true;
+    }
+
+} // namespace bias
@@ -0,0 +1,66 @@
+#ifndef BIAS_FRAME_STAMP_LOG_HPP
+#define BIAS_FRAME_STAMP_LOG_HPP
+
+#include <QString>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    enum FrameStampFlag
+    {
+        FRAME_STAMP_FLAG_COUNT_GAP=1,  // frame count doesn't follow the previous record
+        FRAME_STAMP_FLAG_TIME_GAP=2,   // device interval > TIME_GAP_FACTOR*dtEstimate
+    };
+
+
+    struct FrameStampRecord
+    {
+        uint64_t frameCount;
+        double timeStamp;            // device time stamp (sec from capture start)
+        double hostTimeStamp;        // host time when grabbed (sec since epoch)
+        double dtEstimate;
+        uint32_t flags;
+        FrameStampRecord();
+    };
+
+
+    class FrameStampLog
+    {
+        // Per-frame time stamp sidecar written by the image dispatcher, one
+        // fixed size record per dispatched frame so the file can be loaded
+        // directly as a structured array (e.g. numpy.fromfile with an offset
+        // of HEADER_SIZE).
+        //
+        // File layout (little endian)
+        //   header
+        //     char[8] magic "biasstmp"
+        //     uint32  version, uint32 record size
+        //   records
+        //     uint64  frame count
+        //     double  time stamp, double host time stamp, double dtEstimate
+        //     uint32  flags (FrameStampFlag)
+        //
+        // A trailing partial record (e.g. after a crash) is ignored by read.
+
+        public:
+
+            static const char MAGIC[8];
+            static const uint32_t VERSION;
+            static const size_t HEADER_SIZE;
+            static const size_t RECORD_SIZE;
+            static const double TIME_GAP_FACTOR;
+            static const QString FILE_EXT;
+
+            static double getHostTimeStamp();
+            static void getHeader(std::vector<char> &data);
+            static void serialize(const FrameStampRecord &record, std::vector<char> &data);
+            static bool parse(const char *data, size_t size, FrameStampRecord &record);
+            static bool read(QString fileName, std::vector<FrameStampRecord> &recordVec);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_FRAME_STAMP_LOG_HPP
@@ -0,0 +1,98 @@
+#include "image_sequence_index.hpp"
+#include <cstring>
+
+namespace bias
+{
+    const char ImageSequenceIndex::FILE_ID[] = "biasiseq";
+    const size_t ImageSequenceIndex::FILE_ID_SIZE = 8;
+    const uint32_t ImageSequenceIndex::VERSION_NUMBER = 1;
+    const size_t ImageSequenceIndex::HEADER_SIZE = FILE_ID_SIZE + 2*sizeof(uint32_t);
+    const size_t ImageSequenceIndex::ENTRY_SIZE = sizeof(ImageSequenceIndexEntry);
+    const size_t ImageSequenceIndex::PATH_SIZE = sizeof(ImageSequenceIndexEntry::path);
+
+
+    // ImageSequenceIndexEntry
+    // ----------------------------------------------------------------------------------
+    ImageSequenceIndexEntry::ImageSequenceIndexEntry()
+    {
+        frameCount = 0;
+        timeStamp = 0.0;
+        std::memset(path, 0, sizeof(path));
+    }
+
+
+    bool ImageSequenceIndexEntry::setPath(const std::string &relPath)
+    {
+        // Paths which don't fit are rejected and the path is left empty - a
+        // truncated path would refer to the wrong file.
+        std::memset(path, 0, sizeof(path));
+        if (!ImageSequenceIndex::fitsPath(relPath))
+        {
+            return false;
+        }
+        std::memcpy(path, relPath.c_str(), relPath.size());
+        return true;
+    }
+
+
+    std::string ImageSequenceIndexEntry::getPath() const
+    {
+        const char *endPtr = (const char *) std::memchr(path, 0, sizeof(path));
+        size_t size = endPtr ? size_t(endPtr - path) : sizeof(path);
+        return std::string(path, size);
+    }
+
+
+    // ImageSequenceIndex
+    // ----------------------------------------------------------------------------------
+
+    void ImageSequenceIndex::getHeader(std::vector<char> &header)
+    {
+        uint32_t versionNumber = VERSION_NUMBER;
+        uint32_t entrySize = uint32_t(ENTRY_SIZE);
+        header.resize(HEADER_SIZE);
+        std::memcpy(&header[0], FILE_ID, FILE_ID_SIZE);
+        std::memcpy(&header[FILE_ID_SIZE], &versionNumber, sizeof(uint32_t));
+        std::memcpy(&header[FILE_ID_SIZE + sizeof(uint32_t)], &entrySize, sizeof(uint32_t));
+    }
+
+
+    bool ImageSequenceIndex::parseHeader(const unsigned char *data, uint64_t dataSize, uint32_t &entrySize)
+    {
+        uint32_t versionNumber = 0;
+        if (dataSize < HEADER_SIZE)
+        {
+            return false;
+        }
+        if (std::memcmp(data, FILE_ID, FILE_ID_SIZE) != 0)
+        {
+            return false;
+        }
+        std::memcpy(&versionNumber, data + FILE_ID_SIZE, sizeof(uint32_t));
+        std::memcpy(&entrySize, data + FILE_ID_SIZE + sizeof(uint32_t), sizeof(uint32_t));
+        if ((versionNumber == 0) || (entrySize < ENTRY_SIZE))
+        {
+            return false;
+        }
+        return true;
+    }
+
+
+    uint64_t ImageSequenceIndex::numEntries(uint64_t dataSize, uint32_t entrySize)
+    {
+        // A partially written last entry is ignored
+        if ((dataSize < HEADER_SIZE) || (entrySize == 0))
+        {
+            return 0;
+        }
+        return (dataSize - HEADER_SIZE)/entrySize;
+    }
+
+
+    bool ImageSequenceIndex::fitsPath(const std::string &relPath)
+    {
+        // The path field is nul padded, a path filling it needs no terminator
+        return (!relPath.empty()) && (relPath.size() <= PATH_SIZE);
+    }
+
+} // namespace bias
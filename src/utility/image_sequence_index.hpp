@@ -0,0 +1,56 @@
+#ifndef BIAS_IMAGE_SEQUENCE_INDEX_HPP
+#define BIAS_IMAGE_SEQUENCE_INDEX_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    struct ImageSequenceIndexEntry
+    {
+        // One frame of an image sequence 
+        uint64_t frameCount;  // camera frame count
+        double timeStamp;
+        char path[48];        // image file path relative to the log directory
+        ImageSequenceIndexEntry();
+        bool setPath(const std::string &relPath);
+        std::string getPath() const;
+    };
+
+
+    class ImageSequenceIndex
+    {
+        // Binary index for image sequences (one file per frame) written into
+        // the log directory. Entries have a fixed size and are appended in 
+        // frame order as images are written, so after a crash every complete
+        // entry refers to an image on disk.
+        //
+        // Layout
+        //   char[8] file id (FILE_ID)
+        //   uint32  version number, uint32 entry size
+        //   entries: uint64 frame count, double timestamp, char[48] path 
+        //            (relative, '/' separated, nul padded)
+        //
+        // Writers must check that their paths fit, see fitsPath.
+
+        public:
+
+            static const char FILE_ID[];
+            static const size_t FILE_ID_SIZE;
+            static const uint32_t VERSION_NUMBER;
+            static const size_t HEADER_SIZE;
+            static const size_t ENTRY_SIZE;
+            static const size_t PATH_SIZE;
+
+            static void getHeader(std::vector<char> &header);
+            static bool parseHeader(const unsigned char *data, uint64_t dataSize, uint32_t &entrySize);
+            static uint64_t numEntries(uint64_t dataSize, uint32_t entrySize);
+            static bool fitsPath(const std::string &relPath);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_IMAGE_SEQUENCE_INDEX_HPP
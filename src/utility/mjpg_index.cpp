@@ -0,0 +1,73 @@
+#include "mjpg_index.hpp"
+#include <cstring>
+
+namespace bias
+{
+    const char MjpgIndex::FILE_ID[] = "biasmjpg";
+    const size_t MjpgIndex::FILE_ID_SIZE = 8;
+    const uint32_t MjpgIndex::VERSION_NUMBER = 2;
+    const size_t MjpgIndex::HEADER_SIZE = FILE_ID_SIZE + 2*sizeof(uint32_t);
+    const size_t MjpgIndex::ENTRY_SIZE = sizeof(MjpgIndexEntry);
+    const size_t MjpgIndex::MIN_ENTRY_SIZE = 3*sizeof(uint64_t) + sizeof(double);
+
+
+    // MjpgIndexEntry
+    // ----------------------------------------------------------------------------------
+    MjpgIndexEntry::MjpgIndexEntry()
+    {
+        frameCount = 0;
+        timeStamp = 0.0;
+        offset = 0;
+        size = 0;
+        quality = 0;
+        reserved = 0;
+    }
+
+
+    // MjpgIndex
+    // ----------------------------------------------------------------------------------
+
+    void MjpgIndex::getHeader(std::vector<char> &header)
+    {
+        uint32_t versionNumber = VERSION_NUMBER;
+        uint32_t entrySize = uint32_t(ENTRY_SIZE);
+        header.resize(HEADER_SIZE);
+        std::memcpy(&header[0], FILE_ID, FILE_ID_SIZE);
+        std::memcpy(&header[FILE_ID_SIZE], &versionNumber, sizeof(uint32_t));
+        std::memcpy(&header[FILE_ID_SIZE + sizeof(uint32_t)], &entrySize, sizeof(uint32_t));
+    }
+
+
+    bool MjpgIndex::parseHeader(const unsigned char *data, uint64_t dataSize, uint32_t &entrySize)
+    {
+        // Entries may grow in later versions, but the leading fields stay the same
+        uint32_t versionNumber = 0;
+        if (dataSize < HEADER_SIZE)
+        {
+            return false;
+        }
+        if (std::memcmp(data, FILE_ID, FILE_ID_SIZE) != 0)
+        {
+            return false;
+        }
+        std::memcpy(&versionNumber, data + FILE_ID_SIZE, sizeof(uint32_t));
+        std::memcpy(&entrySize, data + FILE_ID_SIZE + sizeof(uint32_t), sizeof(uint32_t));
+        if ((versionNumber == 0) || (entrySize < MIN_ENTRY_SIZE))
+        {
+            return false;
+        }
+        return true;
+    }
+
+
+    uint64_t MjpgIndex::numEntries(uint64_t dataSize, uint32_t entrySize)
+    {
+        // A partially written last entry is ignored
+        if ((dataSize < HEADER_SIZE) || (entrySize == 0))
+        {
+            return 0;
+        }
+        return (dataSize - HEADER_SIZE)/entrySize;
+    }
+
+} // namespace bias
@@ -0,0 +1,52 @@
+#ifndef BIAS_MJPG_INDEX_HPP
+#define BIAS_MJPG_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    struct MjpgIndexEntry
+    {
+        // One frame of an mjpg movie file
+        uint64_t frameCount;  // camera frame count
+        double timeStamp;
+        uint64_t offset;      // location of jpeg data in movie file
+        uint64_t size;        // size of jpeg data
+        uint32_t quality;     // jpeg quality, 0 if unknown (version 1)
+        uint32_t reserved;
+        MjpgIndexEntry();
+    };
+
+
+    class MjpgIndex
+    {
+        // Binary index for mjpg movie files written alongside the text index. 
+        // Entries have a fixed size and are appended as frames are written, so
+        // after a crash every complete entry can still be used.
+        //
+        // Layout
+        //   char[8] file id (FILE_ID)
+        //   uint32  version number, uint32 entry size
+        //   entries: uint64 frame count, double timestamp, uint64 offset, uint64 size,
+        //            uint32 quality, uint32 reserved (version 2)
+
+        public:
+
+            static const char FILE_ID[];
+            static const size_t FILE_ID_SIZE;
+            static const uint32_t VERSION_NUMBER;
+            static const size_t HEADER_SIZE;
+            static const size_t ENTRY_SIZE;
+            static const size_t MIN_ENTRY_SIZE;
+
+            static void getHeader(std::vector<char> &header);
+            static bool parseHeader(const unsigned char *data, uint64_t dataSize, uint32_t &entrySize);
+            static uint64_t numEntries(uint64_t dataSize, uint32_t entrySize);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_MJPG_INDEX_HPP
@@ -0,0 +1,484 @@
+#include "mjpg_reader.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <opencv2/highgui/highgui.hpp>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QDir>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+namespace bias
+{
+    const std::string MjpgReader::BOUNDARY_MARKER = std::string("--boundary\r\n");
+    const QString MjpgReader::MOVIE_FILE_NAME = QString("movie");
+    const QString MjpgReader::INDEX_FILE_NAME = QString("index");
+    const QString MjpgReader::BINARY_INDEX_EXT = QString(".bin");
+    const QString MjpgReader::TEXT_INDEX_EXT = QString(".txt");
+
+
+    // MjpgDecodeTask - decodes a contiguous block of frames for getFrames
+    // ----------------------------------------------------------------------------------
+    class MjpgDecodeTask : public QRunnable
+    {
+        public:
+
+            MjpgDecodeTask(
+                    MjpgReader *readerPtr,
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    cv::Mat *imagePtr,
+                    RuntimeError *errorPtr,
+                    bool *errorFlagPtr
+                    )
+            {
+                readerPtr_ = readerPtr;
+                firstFrame_ = firstFrame;
+                numFrames_ = numFrames;
+                imagePtr_ = imagePtr;
+                errorPtr_ = errorPtr;
+                errorFlagPtr_ = errorFlagPtr;
+            }
+
+            void run()
+            {
+                try
+                {
+                    for (unsigned long i=0; i<numFrames_; i++)
+                    {
+                        readerPtr_ -> getFrame(firstFrame_ + i, imagePtr_[i]);
+                    }
+                }
+                catch (RuntimeError &runtimeError)
+                {
+                    readerPtr_ -> acquireLock();
+                    if (!(*errorFlagPtr_))
+                    {
+                        *errorPtr_ = runtimeError;
+                        *errorFlagPtr_ = true;
+                    }
+                    readerPtr_ -> releaseLock();
+                }
+            }
+
+        private:
+
+            MjpgReader *readerPtr_;
+            unsigned long firstFrame_;
+            unsigned long numFrames_;
+            cv::Mat *imagePtr_;
+            RuntimeError *errorPtr_;
+            bool *errorFlagPtr_;
+    };
+
+
+    // MjpgReader
+    // ----------------------------------------------------------------------------------
+    MjpgReader::MjpgReader()
+    {
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+    }
+
+
+    MjpgReader::MjpgReader(QString fileName, QString indexFileName) : MjpgReader()
+    {
+        open(fileName, indexFileName);
+    }
+
+
+    MjpgReader::~MjpgReader()
+    {
+        close();
+    }
+
+
+    void MjpgReader::open(QString fileName, QString indexFileName)
+    {
+        // If indexFileName is empty the binary and then the text index 
+        // matching the movie file name are tried. 
+        close();
+
+        file_.setFileName(fileName);
+        if (!file_.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("mjpg reader unable to open file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        dataSize_ = uint64_t(file_.size());
+        if (dataSize_ > 0)
+        {
+            dataPtr_ = file_.map(0, file_.size());
+        }
+        if (dataPtr_ == nullptr)
+        {
+            file_.close();
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("mjpg reader unable to memory map file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        bool haveIndex = false;
+        if (!indexFileName.isEmpty())
+        {
+            haveIndex = readBinaryIndex(indexFileName) || readTextIndex(indexFileName);
+            if (!haveIndex)
+            {
+                close();
+                unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+                std::string errorMsg("mjpg reader unable to read index file: ");
+                errorMsg += indexFileName.toStdString();
+                throw RuntimeError(errorId, errorMsg);
+            }
+        }
+        else
+        {
+            haveIndex = readBinaryIndex(getDefaultIndexFileName(fileName, BINARY_INDEX_EXT));
+            if (!haveIndex)
+            {
+                haveIndex = readTextIndex(getDefaultIndexFileName(fileName, TEXT_INDEX_EXT));
+            }
+        }
+
+        if (!haveIndex)
+        {
+            scanBoundaries();
+        }
+        dropInvalidEntries();
+    }
+
+
+    void MjpgReader::close()
+    {
+        if (dataPtr_ != nullptr)
+        {
+            file_.unmap((uchar *) dataPtr_);
+        }
+        if (file_.isOpen())
+        {
+            file_.close();
+        }
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        indexFileName_ = QString();
+        entryVec_.clear();
+    }
+
+
+    bool MjpgReader::isOpen() const
+    {
+        return (dataPtr_ != nullptr);
+    }
+
+
+    QString MjpgReader::getFileName() const
+    {
+        return file_.fileName();
+    }
+
+
+    QString MjpgReader::getIndexFileName() const
+    {
+        // Empty if frame locations were found by scanning the movie file
+        return indexFileName_;
+    }
+
+
+    unsigned long MjpgReader::getNumberOfFrames() const
+    {
+        return (unsigned long)(entryVec_.size());
+    }
+
+
+    double MjpgReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return entryVec_[frameNumber].timeStamp;
+    }
+
+
+    std::vector<double> MjpgReader::getTimeStamps() const
+    {
+        std::vector<double> timeStampVec(entryVec_.size());
+        for (size_t i=0; i<entryVec_.size(); i++)
+        {
+            timeStampVec[i] = entryVec_[i].timeStamp;
+        }
+        return timeStampVec;
+    }
+
+
+    unsigned int MjpgReader::getQuality(unsigned long frameNumber) const
+    {
+        // Jpeg quality the frame was encoded with, 0 if not in the index
+        checkFrameNumber(frameNumber);
+        return (unsigned int)(entryVec_[frameNumber].quality);
+    }
+
+
+    unsigned long MjpgReader::getFrameCount(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return (unsigned long)(entryVec_[frameNumber].frameCount);
+    }
+
+
+    unsigned long MjpgReader::getFrameNumber(double timeStamp) const
+    {
+        // Returns first frame at or after timeStamp (last frame if none)
+        if (entryVec_.empty())
+        {
+            return 0;
+        }
+        std::vector<MjpgIndexEntry>::const_iterator it = std::lower_bound(
+                entryVec_.begin(),
+                entryVec_.end(),
+                timeStamp,
+                [](const MjpgIndexEntry &entry, double value) { return entry.timeStamp < value; }
+                );
+        if (it == entryVec_.end())
+        {
+            return getNumberOfFrames() - 1;
+        }
+        return (unsigned long)(it - entryVec_.begin());
+    }
+
+
+    const uchar *MjpgReader::getEncodedFrame(unsigned long frameNumber, uint64_t &size) const
+    {
+        // Pointer into the mapped movie file - valid until close
+        checkFrameNumber(frameNumber);
+        size = entryVec_[frameNumber].size;
+        return dataPtr_ + entryVec_[frameNumber].offset;
+    }
+
+
+    cv::Mat MjpgReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void MjpgReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        uint64_t size = 0;
+        const uchar *jpgPtr = getEncodedFrame(frameNumber, size);
+        cv::Mat jpgMat(1, int(size), CV_8UC1, (void *) jpgPtr);
+        try
+        {
+            image = cv::imdecode(jpgMat, CV_LOAD_IMAGE_UNCHANGED);
+        }
+        catch (cv::Exception &exc)
+        {
+            image = cv::Mat();
+        }
+        if (image.empty())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("mjpg reader unable to decode frame ");
+            errorMsg += std::to_string(frameNumber);
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void MjpgReader::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        imageVec.resize(numFrames);
+        if (numFrames == 0)
+        {
+            return;
+        }
+        checkFrameNumber(firstFrame + numFrames - 1);
+
+        if (numThreads == 0)
+        {
+            numThreads = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        }
+        numThreads = (unsigned int)(std::min((unsigned long)(numThreads), numFrames));
+
+        RuntimeError error(0, std::string(""));
+        bool errorFlag = false;
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(numThreads);
+
+        unsigned long blockSize = (numFrames + numThreads - 1)/numThreads;
+        for (unsigned long start=0; start<numFrames; start+=blockSize)
+        {
+            unsigned long count = std::min(blockSize, numFrames - start);
+            MjpgDecodeTask *taskPtr = new MjpgDecodeTask(
+                    this,
+                    firstFrame + start,
+                    count,
+                    &imageVec[start],
+                    &error,
+                    &errorFlag
+                    );
+            threadPool.start(taskPtr);
+        }
+        threadPool.waitForDone();
+
+        if (errorFlag)
+        {
+            throw error;
+        }
+    }
+
+
+    QString MjpgReader::getDefaultIndexFileName(QString fileName, QString indexExt)
+    {
+        // movie.mjpg -> index.ext,  movie_3.mjpg -> index_3.ext
+        QFileInfo fileInfo(fileName);
+        QString baseName = fileInfo.completeBaseName();
+        if (baseName.startsWith(MOVIE_FILE_NAME))
+        {
+            baseName = INDEX_FILE_NAME + baseName.mid(MOVIE_FILE_NAME.size());
+        }
+        else
+        {
+            baseName = baseName + QString("_") + INDEX_FILE_NAME;
+        }
+        return fileInfo.dir().absoluteFilePath(baseName + indexExt);
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+    bool MjpgReader::readBinaryIndex(QString indexFileName)
+    {
+        QFile indexFile(indexFileName);
+        if (!indexFile.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        uint64_t indexSize = uint64_t(indexFile.size());
+        if (indexSize < MjpgIndex::HEADER_SIZE)
+        {
+            return false;
+        }
+        const uchar *indexPtr = indexFile.map(0, indexFile.size());
+        if (indexPtr == nullptr)
+        {
+            return false;
+        }
+
+        uint32_t entrySize = 0;
+        bool isValid = MjpgIndex::parseHeader(indexPtr, indexSize, entrySize);
+        if (isValid)
+        {
+            // Fields missing from older versions keep their default values
+            uint64_t numEntries = MjpgIndex::numEntries(indexSize, entrySize);
+            size_t copySize = std::min(size_t(entrySize), MjpgIndex::ENTRY_SIZE);
+            entryVec_.assign(numEntries, MjpgIndexEntry());
+            for (uint64_t i=0; i<numEntries; i++)
+            {
+                const uchar *entryPtr = indexPtr + MjpgIndex::HEADER_SIZE + i*entrySize;
+                std::memcpy(&entryVec_[i], entryPtr, copySize);
+            }
+            indexFileName_ = indexFileName;
+        }
+        indexFile.unmap((uchar *) indexPtr);
+        indexFile.close();
+        return isValid;
+    }
+
+
+    bool MjpgReader::readTextIndex(QString indexFileName)
+    {
+        // Lines of: frame count, time stamp, begin position, end position and,
+        // when written with rate control, jpeg quality
+        std::ifstream indexFile(indexFileName.toStdString());
+        if (!indexFile.is_open())
+        {
+            return false;
+        }
+        entryVec_.clear();
+        std::string line;
+        while (std::getline(indexFile, line))
+        {
+            std::istringstream lineStream(line);
+            MjpgIndexEntry entry;
+            uint64_t endPos;
+            if (!(lineStream >> entry.frameCount >> entry.timeStamp >> entry.offset >> endPos))
+            {
+                break;
+            }
+            if (!(lineStream >> entry.quality))
+            {
+                entry.quality = 0;
+            }
+            entry.size = (endPos > entry.offset) ? (endPos - entry.offset) : 0;
+            entryVec_.push_back(entry);
+        }
+        indexFileName_ = indexFileName;
+        return true;
+    }
+
+
+    void MjpgReader::scanBoundaries()
+    {
+        // No index - frames run from each boundary marker to the next one. 
+        // Camera frame counts and time stamps are unknown.
+        entryVec_.clear();
+        const uchar *markerPtr = (const uchar *) BOUNDARY_MARKER.c_str();
+        const uchar *endPtr = dataPtr_ + dataSize_;
+        const uchar *pos = std::search(dataPtr_, endPtr, markerPtr, markerPtr + BOUNDARY_MARKER.size());
+        while (pos != endPtr)
+        {
+            const uchar *framePtr = pos + BOUNDARY_MARKER.size();
+            pos = std::search(framePtr, endPtr, markerPtr, markerPtr + BOUNDARY_MARKER.size());
+            MjpgIndexEntry entry;
+            entry.frameCount = entryVec_.size();
+            entry.timeStamp = 0.0;
+            entry.offset = uint64_t(framePtr - dataPtr_);
+            entry.size = uint64_t(pos - framePtr);
+            entryVec_.push_back(entry);
+        }
+    }
+
+
+    void MjpgReader::dropInvalidEntries()
+    {
+        // Index entries are written after the frame data but the two files
+        // are flushed separately, so the tail of the index may be ahead of 
+        // the movie file.
+        size_t numValid = 0;
+        while (numValid < entryVec_.size())
+        {
+            const MjpgIndexEntry &entry = entryVec_[numValid];
+            if ((entry.size == 0) || (entry.offset > dataSize_) || (entry.size > dataSize_ - entry.offset))
+            {
+                break;
+            }
+            numValid++;
+        }
+        entryVec_.resize(numValid);
+    }
+
+
+    void MjpgReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= entryVec_.size())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("mjpg reader frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+} // namespace bias
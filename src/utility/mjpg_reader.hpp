@@ -0,0 +1,83 @@
+#ifndef BIAS_MJPG_READER_HPP
+#define BIAS_MJPG_READER_HPP
+
+#include "lockable.hpp"
+#include "mjpg_index.hpp"
+#include <QString>
+#include <QFile>
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace bias
+{
+
+    class MjpgReader : public Lockable<Empty>
+    {
+        // Random access reader for mjpg movie files written by VideoWriter_jpg.
+        // The movie file is memory mapped and frame locations come from the 
+        // binary index (index.bin), the text index (index.txt) or, when 
+        // neither exists, from scanning the file for boundary markers. Index
+        // entries which point past the end of the movie file (e.g. after a 
+        // crash) are dropped.
+        //
+        // getFrame and getFrames may be called from multiple threads.
+
+        public:
+
+            static const std::string BOUNDARY_MARKER;
+            static const QString MOVIE_FILE_NAME;
+            static const QString INDEX_FILE_NAME;
+            static const QString BINARY_INDEX_EXT;
+            static const QString TEXT_INDEX_EXT;
+
+            MjpgReader();
+            MjpgReader(QString fileName, QString indexFileName=QString());
+            virtual ~MjpgReader();
+
+            void open(QString fileName, QString indexFileName=QString());
+            void close();
+            bool isOpen() const;
+            QString getFileName() const;
+            QString getIndexFileName() const;
+
+            unsigned long getNumberOfFrames() const;
+            double getTimeStamp(unsigned long frameNumber) const;
+            std::vector<double> getTimeStamps() const;
+            unsigned long getFrameCount(unsigned long frameNumber) const;
+            unsigned int getQuality(unsigned long frameNumber) const;
+            unsigned long getFrameNumber(double timeStamp) const;
+
+            const uchar *getEncodedFrame(unsigned long frameNumber, uint64_t &size) const;
+            cv::Mat getFrame(unsigned long frameNumber);
+            void getFrame(unsigned long frameNumber, cv::Mat &image);
+            void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            static QString getDefaultIndexFileName(QString fileName, QString indexExt);
+
+        protected:
+
+            QFile file_;
+            const uchar *dataPtr_;
+            uint64_t dataSize_;
+            QString indexFileName_;
+
+            std::vector<MjpgIndexEntry> entryVec_;
+
+            bool readBinaryIndex(QString indexFileName);
+            bool readTextIndex(QString indexFileName);
+            void scanBoundaries();
+            void dropInvalidEntries();
+
+            void checkFrameNumber(unsigned long frameNumber) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_MJPG_READER_HPP
@@ -0,0 +1,330 @@
+#include "prefetch_video_reader.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <algorithm>
+
+namespace bias
+{
+    const unsigned int PrefetchVideoReader::DEFAULT_QUEUE_SIZE = 32;
+    const unsigned int PrefetchVideoReader::DEFAULT_CACHE_SIZE = 64;
+
+
+    // PrefetchedFrame
+    // ----------------------------------------------------------------------------------
+    PrefetchedFrame::PrefetchedFrame()
+    {
+        frameNumber = 0;
+        error = false;
+    }
+
+
+    // PrefetchVideoReader
+    // ----------------------------------------------------------------------------------
+    PrefetchVideoReader::PrefetchVideoReader(
+            std::shared_ptr<VideoReader> readerPtr,
+            unsigned int queueSize,
+            unsigned int cacheSize
+            )
+    {
+        readerPtr_ = readerPtr;
+        queueSize_ = std::max(queueSize, 1u);
+        cacheSize_ = cacheSize;
+        running_ = false;
+        stopped_ = true;
+        numFrames_ = 0;
+        nextDecode_ = 0;
+        decodingFrame_ = 0;
+        isDecoding_ = false;
+        generation_ = 0;
+        numberOfRestarts_ = 0;
+
+        setAutoDelete(false);
+        threadPool_.setMaxThreadCount(1);
+        start();
+    }
+
+
+    PrefetchVideoReader::~PrefetchVideoReader()
+    {
+        stop();
+    }
+
+
+    void PrefetchVideoReader::open(QString fileName)
+    {
+        stop();
+        readerPtr_ -> open(fileName);
+        start();
+    }
+
+
+    void PrefetchVideoReader::close()
+    {
+        stop();
+        readerPtr_ -> close();
+    }
+
+
+    bool PrefetchVideoReader::isOpen() const
+    {
+        return readerPtr_ -> isOpen();
+    }
+
+
+    QString PrefetchVideoReader::getFileName() const
+    {
+        return readerPtr_ -> getFileName();
+    }
+
+
+    unsigned long PrefetchVideoReader::getNumberOfFrames() const
+    {
+        return readerPtr_ -> getNumberOfFrames();
+    }
+
+
+    double PrefetchVideoReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        return readerPtr_ -> getTimeStamp(frameNumber);
+    }
+
+
+    unsigned long PrefetchVideoReader::getFrameCount(unsigned long frameNumber) const
+    {
+        return readerPtr_ -> getFrameCount(frameNumber);
+    }
+
+
+    unsigned long PrefetchVideoReader::getFrameNumber(double timeStamp) const
+    {
+        return readerPtr_ -> getFrameNumber(timeStamp);
+    }
+
+
+    void PrefetchVideoReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        checkFrameNumber(frameNumber);
+
+        acquireLock();
+        if (findInCache(frameNumber, image))
+        {
+            releaseLock();
+            return;
+        }
+
+        // Restart decoding unless the frame is queued or will be shortly
+        unsigned long firstPending = nextDecode_;
+        if (!queue_.empty())
+        {
+            firstPending = queue_.front().frameNumber;
+        }
+        else if (isDecoding_)
+        {
+            firstPending = decodingFrame_;
+        }
+        bool isComing = (frameNumber >= firstPending) && (frameNumber < nextDecode_ + queueSize_);
+        if (running_ && !isComing)
+        {
+            queue_.clear();
+            nextDecode_ = frameNumber;
+            isDecoding_ = false;
+            generation_++;
+            numberOfRestarts_++;
+            spaceWaitCond_.wakeAll();
+        }
+
+        // Frames before the one requested are moved to the cache
+        bool haveFrame = false;
+        PrefetchedFrame frame;
+        while (running_ && !stopped_)
+        {
+            while (!queue_.empty() && (queue_.front().frameNumber < frameNumber))
+            {
+                if (!queue_.front().error)
+                {
+                    addToCache(queue_.front().frameNumber, queue_.front().image);
+                }
+                queue_.pop_front();
+            }
+            if (!queue_.empty())
+            {
+                frame = queue_.front();
+                queue_.pop_front();
+                haveFrame = true;
+                break;
+            }
+            spaceWaitCond_.wakeAll();
+            decodedWaitCond_.wait(&mutex_);
+        }
+        spaceWaitCond_.wakeAll();
+        if (haveFrame && !frame.error)
+        {
+            addToCache(frameNumber, frame.image);
+        }
+        releaseLock();
+
+        if (!haveFrame)
+        {
+            // Not prefetching (stopped) - read directly
+            readerPtr_ -> getFrame(frameNumber, image);
+            return;
+        }
+        if (frame.error)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            throw RuntimeError(errorId, frame.errorMsg);
+        }
+        image = frame.image;
+    }
+
+
+    bool PrefetchVideoReader::isRandomAccess() const
+    {
+        return readerPtr_ -> isRandomAccess();
+    }
+
+
+    std::shared_ptr<VideoReader> PrefetchVideoReader::getReader()
+    {
+        return readerPtr_;
+    }
+
+
+    unsigned int PrefetchVideoReader::getQueueSize() const
+    {
+        return queueSize_;
+    }
+
+
+    unsigned int PrefetchVideoReader::getCacheSize() const
+    {
+        return cacheSize_;
+    }
+
+
+    unsigned long PrefetchVideoReader::getNumberOfRestarts()
+    {
+        acquireLock();
+        unsigned long numberOfRestarts = numberOfRestarts_;
+        releaseLock();
+        return numberOfRestarts;
+    }
+
+
+    void PrefetchVideoReader::start()
+    {
+        if (!readerPtr_ || !(readerPtr_ -> isOpen()))
+        {
+            return;
+        }
+        acquireLock();
+        queue_.clear();
+        cacheOrder_.clear();
+        cacheMap_.clear();
+        numFrames_ = readerPtr_ -> getNumberOfFrames();
+        nextDecode_ = 0;
+        isDecoding_ = false;
+        generation_++;
+        stopped_ = false;
+        running_ = true;
+        releaseLock();
+        threadPool_.start(this);
+    }
+
+
+    void PrefetchVideoReader::stop()
+    {
+        acquireLock();
+        stopped_ = true;
+        spaceWaitCond_.wakeAll();
+        decodedWaitCond_.wakeAll();
+        releaseLock();
+
+        threadPool_.waitForDone();
+
+        acquireLock();
+        running_ = false;
+        queue_.clear();
+        cacheOrder_.clear();
+        cacheMap_.clear();
+        releaseLock();
+    }
+
+
+    void PrefetchVideoReader::run()
+    {
+        acquireLock();
+        while (true)
+        {
+            while (!stopped_ && ((queue_.size() >= queueSize_) || (nextDecode_ >= numFrames_)))
+            {
+                spaceWaitCond_.wait(&mutex_);
+            }
+            if (stopped_)
+            {
+                break;
+            }
+            PrefetchedFrame frame;
+            frame.frameNumber = nextDecode_;
+            unsigned long generation = generation_;
+            decodingFrame_ = nextDecode_;
+            isDecoding_ = true;
+            nextDecode_++;
+            releaseLock();
+
+            try
+            {
+                readerPtr_ -> getFrame(frame.frameNumber, frame.image);
+            }
+            catch (RuntimeError &runtimeError)
+            {
+                frame.error = true;
+                frame.errorMsg = runtimeError.what();
+            }
+
+            // Frames decoded before a restart are dropped
+            acquireLock();
+            if (generation == generation_)
+            {
+                isDecoding_ = false;
+                queue_.push_back(frame);
+                decodedWaitCond_.wakeAll();
+            }
+        }
+        decodedWaitCond_.wakeAll();
+        releaseLock();
+    }
+
+
+    bool PrefetchVideoReader::findInCache(unsigned long frameNumber, cv::Mat &image)
+    {
+        // Use lock when calling
+        std::map<unsigned long, cv::Mat>::iterator it = cacheMap_.find(frameNumber);
+        if (it == cacheMap_.end())
+        {
+            return false;
+        }
+        image = it -> second;
+        cacheOrder_.remove(frameNumber);
+        cacheOrder_.push_front(frameNumber);
+        return true;
+    }
+
+
+    void PrefetchVideoReader::addToCache(unsigned long frameNumber, const cv::Mat &image)
+    {
+        // Use lock when calling
+        if ((cacheSize_ == 0) || (cacheMap_.find(frameNumber) != cacheMap_.end()))
+        {
+            return;
+        }
+        cacheMap_[frameNumber] = image;
+        cacheOrder_.push_front(frameNumber);
+        while (cacheOrder_.size() > cacheSize_)
+        {
+            cacheMap_.erase(cacheOrder_.back());
+            cacheOrder_.pop_back();
+        }
+    }
+
+} // namespace bias
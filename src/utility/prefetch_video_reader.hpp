@@ -0,0 +1,108 @@
+#ifndef BIAS_PREFETCH_VIDEO_READER_HPP
+#define BIAS_PREFETCH_VIDEO_READER_HPP
+
+#include "video_reader.hpp"
+#include "lockable.hpp"
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+
+namespace bias
+{
+
+    struct PrefetchedFrame
+    {
+        unsigned long frameNumber;
+        cv::Mat image;
+        bool error;
+        std::string errorMsg;
+        PrefetchedFrame();
+    };
+
+
+    class PrefetchVideoReader : public VideoReader, public QRunnable, public Lockable<Empty>
+    {
+        // Wraps another reader and decodes ahead of the caller on a 
+        // background thread. Decoded frames are put in a bounded queue
+        // (queueSize frames) in order, starting from the last frame
+        // requested, so reading in order runs at the speed of the slower of
+        // the decoder and the caller rather than their sum. Frames taken
+        // from the queue, or skipped over, are kept in an LRU cache 
+        // (cacheSize frames) so stepping back or reading recent frames again
+        // doesn't decode them again. Requesting a frame which is neither 
+        // cached nor coming up restarts decoding from that frame.
+        //
+        // The images returned share their data with the cache - clone them 
+        // before modifying them. Read errors are thrown from getFrame for 
+        // the frame which failed. getFrame may be called from multiple 
+        // threads, but interleaving different positions restarts decoding.
+
+        public:
+
+            static const unsigned int DEFAULT_QUEUE_SIZE;
+            static const unsigned int DEFAULT_CACHE_SIZE;
+
+            PrefetchVideoReader(
+                    std::shared_ptr<VideoReader> readerPtr,
+                    unsigned int queueSize=DEFAULT_QUEUE_SIZE,
+                    unsigned int cacheSize=DEFAULT_CACHE_SIZE
+                    );
+            virtual ~PrefetchVideoReader();
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameCount(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+            virtual bool isRandomAccess() const;
+
+            std::shared_ptr<VideoReader> getReader();
+            unsigned int getQueueSize() const;
+            unsigned int getCacheSize() const;
+            unsigned long getNumberOfRestarts();
+
+        protected:
+
+            std::shared_ptr<VideoReader> readerPtr_;
+            unsigned int queueSize_;
+            unsigned int cacheSize_;
+            QThreadPool threadPool_;
+            QWaitCondition decodedWaitCond_;
+            QWaitCondition spaceWaitCond_;
+
+            // use lock when setting these values
+            // -----------------------------------
+            bool running_;
+            bool stopped_;
+            unsigned long numFrames_;
+            unsigned long nextDecode_;
+            unsigned long decodingFrame_;
+            bool isDecoding_;
+            unsigned long generation_;
+            unsigned long numberOfRestarts_;
+            std::deque<PrefetchedFrame> queue_;
+            std::list<unsigned long> cacheOrder_;
+            std::map<unsigned long, cv::Mat> cacheMap_;
+            // -----------------------------------
+
+            void start();
+            void stop();
+            void run();
+            bool findInCache(unsigned long frameNumber, cv::Mat &image);
+            void addToCache(unsigned long frameNumber, const cv::Mat &image);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_PREFETCH_VIDEO_READER_HPP
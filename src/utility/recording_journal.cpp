@@ -0,0 +1,113 @@
+#include "recording_journal.hpp"
+#include <QFile>
+#include <cstring>
+
+namespace bias
+{
+    const char RecordingJournal::MAGIC[8] = {'b','i','a','s','j','r','n','l'};
+    const uint32_t RecordingJournal::VERSION = 1;
+    const size_t RecordingJournal::RECORD_SIZE = sizeof(MAGIC) + 2*sizeof(uint32_t) + 4*sizeof(uint64_t) + sizeof(uint32_t);
+    const QString RecordingJournal::FILE_EXT(".journal");
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    template <class T>
+    static void appendValue(std::vector<char> &buf, T value)
+    {
+        const char *valuePtr = (const char *) &value;
+        buf.insert(buf.end(), valuePtr, valuePtr + sizeof(T));
+    }
+
+    template <class T>
+    static T getValue(const char *data, size_t &pos)
+    {
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+
+    // RecordingJournalRecord
+    // ----------------------------------------------------------------------------------
+    RecordingJournalRecord::RecordingJournalRecord()
+    {
+        format = 0;
+        sequence = 0;
+        numFrames = 0;
+        dataEnd = 0;
+        indexLocation = 0;
+    }
+
+
+    // RecordingJournal
+    // ----------------------------------------------------------------------------------
+    QString RecordingJournal::getFileName(QString videoFileName)
+    {
+        return videoFileName + FILE_EXT;
+    }
+
+
+    void RecordingJournal::serialize(const RecordingJournalRecord &record, std::vector<char> &data)
+    {
+        data.clear();
+        data.reserve(RECORD_SIZE);
+        data.insert(data.end(), MAGIC, MAGIC + sizeof(MAGIC));
+        appendValue(data, VERSION);
+        appendValue(data, record.format);
+        appendValue(data, record.sequence);
+        appendValue(data, record.numFrames);
+        appendValue(data, record.dataEnd);
+        appendValue(data, record.indexLocation);
+        appendValue(data, crc32(&data[0], data.size()));
+    }
+
+
+    bool RecordingJournal::parse(const char *data, size_t size, RecordingJournalRecord &record)
+    {
+        if ((size < RECORD_SIZE) || (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0))
+        {
+            return false;
+        }
+        size_t pos = sizeof(MAGIC);
+        uint32_t version = getValue<uint32_t>(data, pos);
+        record.format = getValue<uint32_t>(data, pos);
+        record.sequence = getValue<uint64_t>(data, pos);
+        record.numFrames = getValue<uint64_t>(data, pos);
+        record.dataEnd = getValue<uint64_t>(data, pos);
+        record.indexLocation = getValue<uint64_t>(data, pos);
+        uint32_t crc = getValue<uint32_t>(data, pos);
+        return (version == VERSION) && (crc == crc32(data, RECORD_SIZE - sizeof(uint32_t)));
+    }
+
+
+    bool RecordingJournal::read(QString journalFileName, RecordingJournalRecord &record)
+    {
+        QFile journalFile(journalFileName);
+        if (!journalFile.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        QByteArray data = journalFile.readAll();
+        journalFile.close();
+        return parse(data.constData(), size_t(data.size()), record);
+    }
+
+
+    uint32_t RecordingJournal::crc32(const char *data, size_t size)
+    {
+        // Standard (zlib) crc32 - records are small so no table is used
+        uint32_t crc = 0xffffffff;
+        for (size_t i=0; i<size; i++)
+        {
+            crc ^= uint8_t(data[i]);
+            for (int j=0; j<8; j++)
+            {
+                crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+} // namespace bias
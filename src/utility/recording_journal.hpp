@@ -0,0 +1,64 @@
+#ifndef BIAS_RECORDING_JOURNAL_HPP
+#define BIAS_RECORDING_JOURNAL_HPP
+
+#include <QString>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    enum RecordingJournalFormat
+    {
+        JOURNAL_FORMAT_FMF=1,
+        JOURNAL_FORMAT_UFMF,
+    };
+
+
+    struct RecordingJournalRecord
+    {
+        // State of a video file at its last checkpoint. Everything up to
+        // dataEnd was on disk when the record was written.
+        uint32_t format;
+        uint64_t sequence;
+        uint64_t numFrames;
+        uint64_t dataEnd;
+        uint64_t indexLocation;      // ufmf: header index location, 0 if none
+        RecordingJournalRecord();
+    };
+
+
+    class RecordingJournal
+    {
+        // Checkpoint journal kept next to a video file while it is being
+        // written, e.g. movie.fmf.journal. The journal holds a single fixed
+        // size record which is overwritten and synced to disk at each
+        // checkpoint, after the video data it describes has been synced. The
+        // writer removes the journal when the file is closed properly, so a
+        // journal left behind marks a file which needs bias_recover.
+        //
+        // Record layout (little endian)
+        //   char[8] magic "biasjrnl"
+        //   uint32  version, uint32 format
+        //   uint64  sequence, uint64 number of frames
+        //   uint64  data end, uint64 index location
+        //   uint32  crc32 of the preceding bytes
+
+        public:
+
+            static const char MAGIC[8];
+            static const uint32_t VERSION;
+            static const size_t RECORD_SIZE;
+            static const QString FILE_EXT;
+
+            static QString getFileName(QString videoFileName);
+            static void serialize(const RecordingJournalRecord &record, std::vector<char> &data);
+            static bool parse(const char *data, size_t size, RecordingJournalRecord &record);
+            static bool read(QString journalFileName, RecordingJournalRecord &record);
+            static uint32_t crc32(const char *data, size_t size);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_RECORDING_JOURNAL_HPP
@@ -0,0 +1,140 @@
+#ifndef BIAS_REORDER_RING_HPP
+#define BIAS_REORDER_RING_HPP
+
+#include <atomic>
+#include <vector>
+#include <utility>
+
+namespace bias
+{
+
+    template <class T>
+    class ReorderRing
+    {
+        // Fixed size ring for putting items finished out of order (e.g. by a
+        // pool of compressor threads) back into order. Each item has an index
+        // which is reserved, by a single consumer thread, before the item is
+        // handed to a producer. Producers fill the slot for their index, or mark
+        // it as skipped, and the consumer drains contiguous slots from the head.
+        //
+        // Only the consumer thread may call reserve, drain and reset.
+
+        public:
+
+            enum SlotState
+            {
+                SLOT_EMPTY=0,
+                SLOT_READY,
+                SLOT_SKIPPED,
+            };
+
+            explicit ReorderRing(unsigned int capacity) : slots_(capacity)
+            {
+                capacity_ = capacity;
+                reset();
+            }
+
+            unsigned int capacity() const
+            {
+                return capacity_;
+            }
+
+            // Number of reserved indices which have not yet been drained
+            unsigned long pending() const
+            {
+                return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+            }
+
+            bool full() const
+            {
+                return pending() >= capacity_;
+            }
+
+            // Consumer: reserve the next index, returns false if the ring is full.
+            bool reserve(unsigned long &index)
+            {
+                if (full())
+                {
+                    return false;
+                }
+                index = tail_.load(std::memory_order_relaxed);
+                tail_.store(index+1, std::memory_order_release);
+                return true;
+            }
+
+            // Producer: move finished item into the slot for its reserved index
+            void insert(unsigned long index, T &&item)
+            {
+                Slot &slot = slots_[index%capacity_];
+                slot.item = std::move(item);
+                slot.state.store(SLOT_READY, std::memory_order_release);
+            }
+
+            // Producer: mark the slot for a reserved index as skipped
+            void markSkipped(unsigned long index)
+            {
+                Slot &slot = slots_[index%capacity_];
+                slot.state.store(SLOT_SKIPPED, std::memory_order_release);
+            }
+
+            // Consumer: move contiguous ready items out of their slots and pass
+            // them to func in index order. Skipped slots are passed over. 
+            // Returns the number of slots drained.
+            template <class Func>
+            unsigned int drain(Func func)
+            {
+                unsigned int numDrained = 0;
+                unsigned long head = head_.load(std::memory_order_relaxed);
+                unsigned long tail = tail_.load(std::memory_order_acquire);
+
+                while (head < tail)
+                {
+                    Slot &slot = slots_[head%capacity_];
+                    int state = slot.state.load(std::memory_order_acquire);
+                    if (state == SLOT_EMPTY)
+                    {
+                        break;
+                    }
+                    if (state == SLOT_READY)
+                    {
+                        T item(std::move(slot.item));
+                        slot.item = T();
+                        func(item);
+                    }
+                    slot.state.store(SLOT_EMPTY, std::memory_order_relaxed);
+                    head++;
+                    head_.store(head, std::memory_order_release);
+                    numDrained++;
+                }
+                return numDrained;
+            }
+
+            void reset()
+            {
+                for (unsigned int i=0; i<slots_.size(); i++)
+                {
+                    slots_[i].item = T();
+                    slots_[i].state.store(SLOT_EMPTY, std::memory_order_relaxed);
+                }
+                head_.store(0, std::memory_order_relaxed);
+                tail_.store(0, std::memory_order_release);
+            }
+
+        protected:
+
+            struct Slot
+            {
+                Slot() : state(SLOT_EMPTY) {};
+                std::atomic<int> state;
+                T item;
+            };
+
+            unsigned int capacity_;
+            std::vector<Slot> slots_;
+            std::atomic<unsigned long> head_;  // Next index to drain
+            std::atomic<unsigned long> tail_;  // Next index to reserve
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_REORDER_RING_HPP
@@ -9,6 +9,7 @@ namespace bias
     {
         cv::Mat image;
         double timeStamp;
+        double hostTimeStamp;   // sec since epoch, set by the image grabber
         double dtEstimate;
         unsigned long frameCount;
     };
@@ -0,0 +1,118 @@
+#include "ufmf_codec.hpp"
+#include <QByteArray>
+#include <algorithm>
+#include <cstring>
+
+namespace bias
+{
+    const unsigned int UfmfCodec::CODED_VERSION_NUMBER = 5;
+    const size_t UfmfCodec::CODED_HEADER_SIZE = sizeof(uint8_t) + 2*sizeof(uint32_t);
+    const unsigned int UfmfCodec::MAX_LEVEL = 9;
+
+    // Size of the big endian length prefix added by qCompress
+    static const int QCOMPRESS_PREFIX_SIZE = 4;
+
+
+    void UfmfCodec::encode(
+            const char *data, 
+            uint32_t size, 
+            unsigned int level, 
+            std::vector<char> &coded
+            )
+    {
+        QByteArray zlibData;
+        if (level > 0)
+        {
+            zlibData = qCompress((const uchar *) data, int(size), int(std::min(level, MAX_LEVEL)));
+        }
+
+        uint8_t coding = UFMF_CODING_RAW;
+        const char *codedPtr = data;
+        uint32_t codedSize = size;
+        if (zlibData.size() > QCOMPRESS_PREFIX_SIZE) 
+        {
+            uint32_t zlibSize = uint32_t(zlibData.size() - QCOMPRESS_PREFIX_SIZE);
+            if (zlibSize < size)
+            {
+                coding = UFMF_CODING_ZLIB;
+                codedPtr = zlibData.constData() + QCOMPRESS_PREFIX_SIZE;
+                codedSize = zlibSize;
+            }
+        }
+
+        coded.resize(CODED_HEADER_SIZE + codedSize);
+        char *ptr = &coded[0];
+        std::memcpy(ptr, &coding, sizeof(uint8_t));
+        ptr += sizeof(uint8_t);
+        std::memcpy(ptr, &size, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        std::memcpy(ptr, &codedSize, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        if (codedSize > 0)
+        {
+            std::memcpy(ptr, codedPtr, codedSize);
+        }
+    }
+
+
+    bool UfmfCodec::parseHeader(
+            const char *data, 
+            uint8_t &coding, 
+            uint32_t &rawSize, 
+            uint32_t &codedSize
+            )
+    {
+        // Parses CODED_HEADER_SIZE bytes
+        std::memcpy(&coding, data, sizeof(uint8_t));
+        std::memcpy(&rawSize, data + sizeof(uint8_t), sizeof(uint32_t));
+        std::memcpy(&codedSize, data + sizeof(uint8_t) + sizeof(uint32_t), sizeof(uint32_t));
+        if (coding == UFMF_CODING_RAW)
+        {
+            return (codedSize == rawSize);
+        }
+        return (coding == UFMF_CODING_ZLIB);
+    }
+
+
+    bool UfmfCodec::decode(
+            const char *codedData, 
+            uint8_t coding, 
+            uint32_t rawSize, 
+            uint32_t codedSize, 
+            char *data
+            )
+    {
+        if (coding == UFMF_CODING_RAW)
+        {
+            if (codedSize != rawSize)
+            {
+                return false;
+            }
+            std::memcpy(data, codedData, rawSize);
+            return true;
+        }
+        if (coding != UFMF_CODING_ZLIB)
+        {
+            return false;
+        }
+
+        // qUncompress expects the big endian size prefix written by qCompress
+        QByteArray zlibData;
+        zlibData.resize(QCOMPRESS_PREFIX_SIZE + int(codedSize));
+        uchar *prefixPtr = (uchar *) zlibData.data();
+        prefixPtr[0] = uchar((rawSize >> 24) & 0xff);
+        prefixPtr[1] = uchar((rawSize >> 16) & 0xff);
+        prefixPtr[2] = uchar((rawSize >>  8) & 0xff);
+        prefixPtr[3] = uchar(rawSize & 0xff);
+        std::memcpy(zlibData.data() + QCOMPRESS_PREFIX_SIZE, codedData, codedSize);
+
+        QByteArray rawData = qUncompress(zlibData);
+        if (uint32_t(rawData.size()) != rawSize)
+        {
+            return false;
+        }
+        std::memcpy(data, rawData.constData(), rawSize);
+        return true;
+    }
+
+} // namespace bias
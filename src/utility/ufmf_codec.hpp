@@ -0,0 +1,62 @@
+#ifndef BIAS_UFMF_CODEC_HPP
+#define BIAS_UFMF_CODEC_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    enum UfmfCoding
+    {
+        UFMF_CODING_RAW=0,
+        UFMF_CODING_ZLIB,
+    };
+
+
+    class UfmfCodec
+    {
+        // Lossless coding of ufmf keyframe and frame data. Coded files are
+        // flagged by CODED_VERSION_NUMBER in the ufmf header. In these files 
+        // the keyframe image data and the frame box data (box headers and 
+        // pixels) are stored as a coded block
+        //
+        //   uint8  coding (UfmfCoding)
+        //   uint32 raw size, uint32 coded size
+        //   coded data (zlib stream or raw bytes)
+        //
+        // Data which doesn't get smaller is stored raw.
+
+        public:
+
+            static const unsigned int CODED_VERSION_NUMBER;
+            static const size_t CODED_HEADER_SIZE;
+            static const unsigned int MAX_LEVEL;
+
+            static void encode(
+                    const char *data, 
+                    uint32_t size, 
+                    unsigned int level, 
+                    std::vector<char> &coded
+                    );
+
+            static bool parseHeader(
+                    const char *data, 
+                    uint8_t &coding, 
+                    uint32_t &rawSize, 
+                    uint32_t &codedSize
+                    );
+
+            static bool decode(
+                    const char *codedData, 
+                    uint8_t coding, 
+                    uint32_t rawSize, 
+                    uint32_t codedSize, 
+                    char *data
+                    );
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_UFMF_CODEC_HPP
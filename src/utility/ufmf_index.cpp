@@ -0,0 +1,320 @@
+#include "ufmf_index.hpp"
+#include <cstring>
+
+namespace bias
+{
+    const uint8_t UfmfIndex::INDEX_DICT_CHUNK_ID = 2;
+    const uint8_t UfmfIndex::INDEX_CHUNK_ID = 3;
+    const size_t UfmfIndex::CHUNK_HEADER_SIZE = sizeof(uint8_t) + 2*sizeof(uint32_t) + sizeof(uint64_t);
+    const unsigned int UfmfIndex::DEFAULT_CHUNK_SIZE = 4096;
+
+    const char UfmfIndex::CHAR_FOR_DICT = 'd';
+    const char UfmfIndex::CHAR_FOR_ARRAY = 'a';
+    const char UfmfIndex::CHAR_FOR_DTYPE_UINT64 = 'q';
+    const char UfmfIndex::CHAR_FOR_DTYPE_DOUBLE = 'd';
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    template <class T>
+    static void appendValue(std::vector<char> &buf, T value)
+    {
+        const char *valuePtr = (const char *) &value;
+        buf.insert(buf.end(), valuePtr, valuePtr + sizeof(T));
+    }
+
+    template <class T>
+    static void appendArray(std::vector<char> &buf, const std::vector<T> &array)
+    {
+        if (!array.empty())
+        {
+            const char *arrayPtr = (const char *) &array[0];
+            buf.insert(buf.end(), arrayPtr, arrayPtr + array.size()*sizeof(T));
+        }
+    }
+
+    static void appendKey(std::vector<char> &buf, const char *key)
+    {
+        uint16_t keyLength = uint16_t(std::strlen(key));
+        appendValue(buf, keyLength);
+        buf.insert(buf.end(), key, key + keyLength);
+    }
+
+    static void appendDict(std::vector<char> &buf, uint8_t numKeys)
+    {
+        appendValue(buf, UfmfIndex::CHAR_FOR_DICT);
+        appendValue(buf, numKeys);
+    }
+
+
+    // UfmfIndexChunkInfo
+    // ----------------------------------------------------------------------------------
+    UfmfIndexChunkInfo::UfmfIndexChunkInfo()
+    {
+        loc = 0;
+        numFrames = 0;
+        numKeyFrames = 0;
+    }
+
+
+    uint64_t UfmfIndexChunkInfo::arrayLoc(UfmfIndexArray array) const
+    {
+        uint64_t arrayLoc = loc + UfmfIndex::CHUNK_HEADER_SIZE;
+        for (int i=0; i<int(array); i++)
+        {
+            arrayLoc += UfmfIndex::chunkArrayNumBytes(*this, UfmfIndexArray(i));
+        }
+        return arrayLoc;
+    }
+
+
+    uint64_t UfmfIndexChunkInfo::endLoc() const
+    {
+        return arrayLoc(NUMBER_OF_UFMF_INDEX_ARRAY);
+    }
+
+
+    // UfmfIndex
+    // ----------------------------------------------------------------------------------
+    UfmfIndex::UfmfIndex(unsigned int chunkSize)
+    {
+        chunkSize_ = (chunkSize > 0) ? chunkSize : DEFAULT_CHUNK_SIZE;
+        frameLoc_.reserve(chunkSize_);
+        frameTimeStamp_.reserve(chunkSize_);
+        clear();
+    }
+
+
+    void UfmfIndex::clear()
+    {
+        numFramesInChunks_ = 0;
+        numKeyFramesInChunks_ = 0;
+        frameLoc_.clear();
+        frameTimeStamp_.clear();
+        keyFrameLoc_.clear();
+        keyFrameTimeStamp_.clear();
+        chunkInfoVec_.clear();
+    }
+
+
+    void UfmfIndex::addFrame(uint64_t loc, double timeStamp)
+    {
+        frameLoc_.push_back(loc);
+        frameTimeStamp_.push_back(timeStamp);
+    }
+
+
+    void UfmfIndex::addKeyFrame(uint64_t loc, double timeStamp)
+    {
+        keyFrameLoc_.push_back(loc);
+        keyFrameTimeStamp_.push_back(timeStamp);
+    }
+
+
+    bool UfmfIndex::isChunkFull() const
+    {
+        return (frameLoc_.size() >= chunkSize_) || (keyFrameLoc_.size() >= chunkSize_);
+    }
+
+
+    bool UfmfIndex::havePending() const
+    {
+        return (!frameLoc_.empty()) || (!keyFrameLoc_.empty());
+    }
+
+
+    void UfmfIndex::takeChunk(uint64_t chunkLoc, std::vector<char> &chunkData)
+    {
+        UfmfIndexChunkInfo chunkInfo;
+        chunkInfo.loc = chunkLoc;
+        chunkInfo.numFrames = uint32_t(frameLoc_.size());
+        chunkInfo.numKeyFrames = uint32_t(keyFrameLoc_.size());
+
+        chunkData.clear();
+        chunkData.reserve(size_t(chunkInfo.endLoc() - chunkLoc));
+        appendValue(chunkData, INDEX_CHUNK_ID);
+        appendValue(chunkData, chunkInfo.numFrames);
+        appendValue(chunkData, chunkInfo.numKeyFrames);
+        appendValue(chunkData, lastChunkLoc());
+        appendArray(chunkData, frameLoc_);
+        appendArray(chunkData, frameTimeStamp_);
+        appendArray(chunkData, keyFrameLoc_);
+        appendArray(chunkData, keyFrameTimeStamp_);
+
+        frameLoc_.clear();
+        frameTimeStamp_.clear();
+        keyFrameLoc_.clear();
+        keyFrameTimeStamp_.clear();
+
+        addChunk(chunkInfo);
+    }
+
+
+    void UfmfIndex::addChunk(UfmfIndexChunkInfo chunkInfo)
+    {
+        numFramesInChunks_ += chunkInfo.numFrames;
+        numKeyFramesInChunks_ += chunkInfo.numKeyFrames;
+        chunkInfoVec_.push_back(chunkInfo);
+    }
+
+
+    unsigned long UfmfIndex::numFrames() const
+    {
+        return numFramesInChunks_ + frameLoc_.size();
+    }
+
+
+    unsigned long UfmfIndex::numKeyFrames() const
+    {
+        return numKeyFramesInChunks_ + keyFrameLoc_.size();
+    }
+
+
+    uint64_t UfmfIndex::lastChunkLoc() const
+    {
+        if (chunkInfoVec_.empty())
+        {
+            return 0;
+        }
+        return chunkInfoVec_.back().loc;
+    }
+
+
+    const std::vector<UfmfIndexChunkInfo> &UfmfIndex::chunkInfoVec() const
+    {
+        return chunkInfoVec_;
+    }
+
+
+    uint32_t UfmfIndex::arrayNumBytes(UfmfIndexArray array) const
+    {
+        unsigned long numEntries = 0;
+        if ((array == UFMF_INDEX_FRAME_LOC) || (array == UFMF_INDEX_FRAME_TIMESTAMP))
+        {
+            numEntries = numFrames();
+        }
+        else
+        {
+            numEntries = numKeyFrames();
+        }
+        return uint32_t(numEntries*entrySize(array));
+    }
+
+
+    size_t UfmfIndex::pendingArray(UfmfIndexArray array, const char **dataPtr) const
+    {
+        size_t numEntries = 0;
+        *dataPtr = nullptr;
+        switch (array)
+        {
+            case UFMF_INDEX_FRAME_LOC:
+                numEntries = frameLoc_.size();
+                *dataPtr = numEntries ? (const char *) &frameLoc_[0] : nullptr;
+                break;
+
+            case UFMF_INDEX_FRAME_TIMESTAMP:
+                numEntries = frameTimeStamp_.size();
+                *dataPtr = numEntries ? (const char *) &frameTimeStamp_[0] : nullptr;
+                break;
+
+            case UFMF_INDEX_KEYFRAME_LOC:
+                numEntries = keyFrameLoc_.size();
+                *dataPtr = numEntries ? (const char *) &keyFrameLoc_[0] : nullptr;
+                break;
+
+            case UFMF_INDEX_KEYFRAME_TIMESTAMP:
+                numEntries = keyFrameTimeStamp_.size();
+                *dataPtr = numEntries ? (const char *) &keyFrameTimeStamp_[0] : nullptr;
+                break;
+
+            default:
+                break;
+        }
+        return numEntries*entrySize(array);
+    }
+
+
+    size_t UfmfIndex::entrySize(UfmfIndexArray array)
+    {
+        if ((array == UFMF_INDEX_FRAME_LOC) || (array == UFMF_INDEX_KEYFRAME_LOC))
+        {
+            return sizeof(uint64_t);
+        }
+        return sizeof(double);
+    }
+
+
+    uint32_t UfmfIndex::chunkArrayNumBytes(const UfmfIndexChunkInfo &chunkInfo, UfmfIndexArray array)
+    {
+        uint32_t numEntries = 0;
+        if ((array == UFMF_INDEX_FRAME_LOC) || (array == UFMF_INDEX_FRAME_TIMESTAMP))
+        {
+            numEntries = chunkInfo.numFrames;
+        }
+        else if ((array == UFMF_INDEX_KEYFRAME_LOC) || (array == UFMF_INDEX_KEYFRAME_TIMESTAMP))
+        {
+            numEntries = chunkInfo.numKeyFrames;
+        }
+        return uint32_t(numEntries*entrySize(array));
+    }
+
+
+    bool UfmfIndex::parseChunkHeader(const char *data, UfmfIndexChunkInfo &chunkInfo, uint64_t &prevChunkLoc)
+    {
+        // Parses CHUNK_HEADER_SIZE bytes starting at chunk id. Doesn't set loc.
+        if (uint8_t(data[0]) != INDEX_CHUNK_ID)
+        {
+            return false;
+        }
+        size_t pos = sizeof(uint8_t);
+        std::memcpy(&chunkInfo.numFrames, data + pos, sizeof(uint32_t));
+        pos += sizeof(uint32_t);
+        std::memcpy(&chunkInfo.numKeyFrames, data + pos, sizeof(uint32_t));
+        pos += sizeof(uint32_t);
+        std::memcpy(&prevChunkLoc, data + pos, sizeof(uint64_t));
+        return true;
+    }
+
+
+    void UfmfIndex::getDictArrayPrefix(UfmfIndexArray array, uint32_t numBytes, std::vector<char> &prefix)
+    {
+        // Dictionary structure preceding each array in the index. Written in
+        // array order these make up the whole index dictionary:
+        //
+        // index {frame {loc, timestamp}, keyframe {mean {loc, timestamp}}}
+        prefix.clear();
+        char dtype = CHAR_FOR_DTYPE_UINT64;
+        switch (array)
+        {
+            case UFMF_INDEX_FRAME_LOC:
+                appendDict(prefix, 2);
+                appendKey(prefix, "frame");
+                appendDict(prefix, 2);
+                appendKey(prefix, "loc");
+                break;
+
+            case UFMF_INDEX_FRAME_TIMESTAMP:
+                appendKey(prefix, "timestamp");
+                dtype = CHAR_FOR_DTYPE_DOUBLE;
+                break;
+
+            case UFMF_INDEX_KEYFRAME_LOC:
+                appendKey(prefix, "keyframe");
+                appendDict(prefix, 1);
+                appendKey(prefix, "mean");
+                appendDict(prefix, 2);
+                appendKey(prefix, "loc");
+                break;
+
+            case UFMF_INDEX_KEYFRAME_TIMESTAMP:
+            default:
+                appendKey(prefix, "timestamp");
+                dtype = CHAR_FOR_DTYPE_DOUBLE;
+                break;
+        }
+        appendValue(prefix, CHAR_FOR_ARRAY);
+        appendValue(prefix, dtype);
+        appendValue(prefix, numBytes);
+    }
+
+} // namespace bias
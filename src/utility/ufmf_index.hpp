@@ -0,0 +1,101 @@
+#ifndef BIAS_UFMF_INDEX_HPP
+#define BIAS_UFMF_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    enum UfmfIndexArray
+    {
+        UFMF_INDEX_FRAME_LOC=0,
+        UFMF_INDEX_FRAME_TIMESTAMP,
+        UFMF_INDEX_KEYFRAME_LOC,
+        UFMF_INDEX_KEYFRAME_TIMESTAMP,
+        NUMBER_OF_UFMF_INDEX_ARRAY,
+    };
+
+
+    struct UfmfIndexChunkInfo
+    {
+        // Location (of chunk id) and entry counts of an index chunk written
+        // into the file.
+        uint64_t loc;
+        uint32_t numFrames;
+        uint32_t numKeyFrames;
+        UfmfIndexChunkInfo();
+        uint64_t arrayLoc(UfmfIndexArray array) const;
+        uint64_t endLoc() const;
+    };
+
+
+    class UfmfIndex
+    {
+        // Bounded memory index for ufmf files. Frame and keyframe entries are
+        // collected in fixed size arrays. When the frame array is full the
+        // entries are serialized as an index chunk, written into the file by
+        // the caller, and dropped from memory. At close the index chunks and
+        // the remaining entries are merged into the standard index dictionary.
+        //
+        // Index chunk layout
+        //   uint8  chunk id (INDEX_CHUNK_ID)
+        //   uint32 number of frames, uint32 number of keyframes
+        //   uint64 location of previous index chunk (0 if none)
+        //   uint64 frame loc[], double frame timestamp[]
+        //   uint64 keyframe loc[], double keyframe timestamp[]
+
+        public:
+
+            static const uint8_t INDEX_DICT_CHUNK_ID;
+            static const uint8_t INDEX_CHUNK_ID;
+            static const size_t CHUNK_HEADER_SIZE;
+            static const unsigned int DEFAULT_CHUNK_SIZE;
+
+            static const char CHAR_FOR_DICT;
+            static const char CHAR_FOR_ARRAY;
+            static const char CHAR_FOR_DTYPE_UINT64;
+            static const char CHAR_FOR_DTYPE_DOUBLE;
+
+            UfmfIndex(unsigned int chunkSize=DEFAULT_CHUNK_SIZE);
+
+            void clear();
+            void addFrame(uint64_t loc, double timeStamp);
+            void addKeyFrame(uint64_t loc, double timeStamp);
+
+            bool isChunkFull() const;
+            bool havePending() const;
+            void takeChunk(uint64_t chunkLoc, std::vector<char> &chunkData);
+            void addChunk(UfmfIndexChunkInfo chunkInfo);
+
+            unsigned long numFrames() const;
+            unsigned long numKeyFrames() const;
+            uint64_t lastChunkLoc() const;
+
+            const std::vector<UfmfIndexChunkInfo> &chunkInfoVec() const;
+            uint32_t arrayNumBytes(UfmfIndexArray array) const;
+            size_t pendingArray(UfmfIndexArray array, const char **dataPtr) const;
+
+            static size_t entrySize(UfmfIndexArray array);
+            static uint32_t chunkArrayNumBytes(const UfmfIndexChunkInfo &chunkInfo, UfmfIndexArray array);
+            static bool parseChunkHeader(const char *data, UfmfIndexChunkInfo &chunkInfo, uint64_t &prevChunkLoc);
+            static void getDictArrayPrefix(UfmfIndexArray array, uint32_t numBytes, std::vector<char> &prefix);
+
+        private:
+
+            unsigned int chunkSize_;
+            unsigned long numFramesInChunks_;
+            unsigned long numKeyFramesInChunks_;
+
+            std::vector<uint64_t> frameLoc_;
+            std::vector<double> frameTimeStamp_;
+            std::vector<uint64_t> keyFrameLoc_;
+            std::vector<double> keyFrameTimeStamp_;
+
+            std::vector<UfmfIndexChunkInfo> chunkInfoVec_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_UFMF_INDEX_HPP
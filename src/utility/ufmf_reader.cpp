@@ -0,0 +1,782 @@
+#include "ufmf_reader.hpp"
+#include "ufmf_index.hpp"
+#include "ufmf_codec.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+
+namespace bias
+{
+    const unsigned int UfmfReader::DEFAULT_KEYFRAME_CACHE_SIZE = 8;
+    const unsigned int UfmfReader::UFMF_VERSION_NUMBER = 4;
+    const uint8_t UfmfReader::KEYFRAME_CHUNK_ID = 0;
+    const uint8_t UfmfReader::FRAME_CHUNK_ID = 1;
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    static void checkBufferRange(uint64_t bufSize, uint64_t pos, uint64_t size)
+    {
+        if (pos + size > bufSize)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: read past end of frame data");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+    template <class T>
+    static T readBufferValue(const uchar *bufPtr, uint64_t bufSize, uint64_t &pos)
+    {
+        T value;
+        checkBufferRange(bufSize, pos, sizeof(T));
+        std::memcpy(&value, bufPtr + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+
+    // UfmfDecodeTask - decodes a contiguous block of frames for getFrames
+    // ----------------------------------------------------------------------------------
+    class UfmfDecodeTask : public QRunnable
+    {
+        public:
+
+            UfmfDecodeTask(
+                    UfmfReader *readerPtr,
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    cv::Mat *imagePtr,
+                    RuntimeError *errorPtr,
+                    bool *errorFlagPtr
+                    )
+            {
+                readerPtr_ = readerPtr;
+                firstFrame_ = firstFrame;
+                numFrames_ = numFrames;
+                imagePtr_ = imagePtr;
+                errorPtr_ = errorPtr;
+                errorFlagPtr_ = errorFlagPtr;
+            }
+
+            void run()
+            {
+                try
+                {
+                    for (unsigned long i=0; i<numFrames_; i++)
+                    {
+                        readerPtr_ -> getFrame(firstFrame_ + i, imagePtr_[i]);
+                    }
+                }
+                catch (RuntimeError &runtimeError)
+                {
+                    readerPtr_ -> acquireLock();
+                    if (!(*errorFlagPtr_))
+                    {
+                        *errorPtr_ = runtimeError;
+                        *errorFlagPtr_ = true;
+                    }
+                    readerPtr_ -> releaseLock();
+                }
+            }
+
+        private:
+
+            UfmfReader *readerPtr_;
+            unsigned long firstFrame_;
+            unsigned long numFrames_;
+            cv::Mat *imagePtr_;
+            RuntimeError *errorPtr_;
+            bool *errorFlagPtr_;
+    };
+
+
+    // UfmfReader
+    // ----------------------------------------------------------------------------------
+    UfmfReader::UfmfReader()
+    {
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        version_ = 0;
+        isFixedSize_ = false;
+        isCoded_ = false;
+        indexLocation_ = 0;
+        keyFrameCacheSize_ = DEFAULT_KEYFRAME_CACHE_SIZE;
+    }
+
+
+    UfmfReader::UfmfReader(QString fileName) : UfmfReader()
+    {
+        open(fileName);
+    }
+
+
+    UfmfReader::~UfmfReader()
+    {
+        close();
+    }
+
+
+    void UfmfReader::open(QString fileName)
+    {
+        close();
+
+        file_.setFileName(fileName);
+        if (!file_.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("ufmf reader unable to open file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        dataSize_ = uint64_t(file_.size());
+        dataPtr_ = file_.map(0, file_.size());
+        if (dataPtr_ == nullptr)
+        {
+            file_.close();
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("ufmf reader unable to memory map file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        try
+        {
+            readHeader();
+            readIndex();
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            close();
+            throw;
+        }
+    }
+
+
+    void UfmfReader::close()
+    {
+        if (dataPtr_ != nullptr)
+        {
+            file_.unmap((uchar *) dataPtr_);
+        }
+        if (file_.isOpen())
+        {
+            file_.close();
+        }
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        version_ = 0;
+        isCoded_ = false;
+        size_ = cv::Size(0,0);
+        boxSize_ = cv::Size(0,0);
+        indexLocation_ = 0;
+
+        frameLocVec_.clear();
+        frameTimeStampVec_.clear();
+        keyFrameLocVec_.clear();
+        keyFrameTimeStampVec_.clear();
+
+        acquireLock();
+        keyFrameCacheOrder_.clear();
+        keyFrameCacheMap_.clear();
+        releaseLock();
+    }
+
+
+    bool UfmfReader::isOpen() const
+    {
+        return (dataPtr_ != nullptr);
+    }
+
+
+    QString UfmfReader::getFileName() const
+    {
+        return file_.fileName();
+    }
+
+
+    unsigned int UfmfReader::getVersion() const
+    {
+        return version_;
+    }
+
+
+    bool UfmfReader::isCoded() const
+    {
+        return isCoded_;
+    }
+
+
+    cv::Size UfmfReader::getSize() const
+    {
+        return size_;
+    }
+
+
+    QString UfmfReader::getColorCoding() const
+    {
+        return colorCoding_;
+    }
+
+
+    unsigned long UfmfReader::getNumberOfFrames() const
+    {
+        return (unsigned long)(frameLocVec_.size());
+    }
+
+
+    unsigned long UfmfReader::getNumberOfKeyFrames() const
+    {
+        return (unsigned long)(keyFrameLocVec_.size());
+    }
+
+
+    double UfmfReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return frameTimeStampVec_[frameNumber];
+    }
+
+
+    std::vector<double> UfmfReader::getTimeStamps() const
+    {
+        return frameTimeStampVec_;
+    }
+
+
+    unsigned long UfmfReader::getFrameNumber(double timeStamp) const
+    {
+        // Returns first frame at or after timeStamp (last frame if none)
+        if (frameTimeStampVec_.empty())
+        {
+            return 0;
+        }
+        std::vector<double>::const_iterator it = std::lower_bound(
+                frameTimeStampVec_.begin(),
+                frameTimeStampVec_.end(),
+                timeStamp
+                );
+        if (it == frameTimeStampVec_.end())
+        {
+            return getNumberOfFrames() - 1;
+        }
+        return (unsigned long)(it - frameTimeStampVec_.begin());
+    }
+
+
+    cv::Mat UfmfReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void UfmfReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        checkFrameNumber(frameNumber);
+        cv::Mat keyFrame = getKeyFrame(getKeyFrameNumber(frameNumber));
+        keyFrame.copyTo(image);
+        pasteBoxes(frameNumber, image);
+    }
+
+
+    void UfmfReader::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        imageVec.resize(numFrames);
+        if (numFrames == 0)
+        {
+            return;
+        }
+        checkFrameNumber(firstFrame + numFrames - 1);
+
+        if (numThreads == 0)
+        {
+            numThreads = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        }
+        numThreads = (unsigned int)(std::min((unsigned long)(numThreads), numFrames));
+
+        // Each thread decodes a contiguous block so keyframes are reused
+        RuntimeError error(0, std::string(""));
+        bool errorFlag = false;
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(numThreads);
+
+        unsigned long blockSize = (numFrames + numThreads - 1)/numThreads;
+        for (unsigned long start=0; start<numFrames; start+=blockSize)
+        {
+            unsigned long count = std::min(blockSize, numFrames - start);
+            UfmfDecodeTask *taskPtr = new UfmfDecodeTask(
+                    this,
+                    firstFrame + start,
+                    count,
+                    &imageVec[start],
+                    &error,
+                    &errorFlag
+                    );
+            threadPool.start(taskPtr);
+        }
+        threadPool.waitForDone();
+
+        if (errorFlag)
+        {
+            throw error;
+        }
+    }
+
+
+    cv::Mat UfmfReader::getKeyFrame(unsigned long keyFrameNumber)
+    {
+        if (keyFrameNumber >= keyFrameLocVec_.size())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader keyframe number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // Check cache
+        acquireLock();
+        std::map<unsigned long, cv::Mat>::iterator it = keyFrameCacheMap_.find(keyFrameNumber);
+        if (it != keyFrameCacheMap_.end())
+        {
+            cv::Mat keyFrame = it -> second;
+            keyFrameCacheOrder_.remove(keyFrameNumber);
+            keyFrameCacheOrder_.push_front(keyFrameNumber);
+            releaseLock();
+            return keyFrame;
+        }
+        releaseLock();
+
+        // Decode without holding lock so other threads aren't held up
+        cv::Mat keyFrame = decodeKeyFrame(keyFrameNumber);
+
+        acquireLock();
+        if (keyFrameCacheMap_.find(keyFrameNumber) == keyFrameCacheMap_.end())
+        {
+            keyFrameCacheMap_[keyFrameNumber] = keyFrame;
+            keyFrameCacheOrder_.push_front(keyFrameNumber);
+            while (keyFrameCacheOrder_.size() > keyFrameCacheSize_)
+            {
+                keyFrameCacheMap_.erase(keyFrameCacheOrder_.back());
+                keyFrameCacheOrder_.pop_back();
+            }
+        }
+        releaseLock();
+        return keyFrame;
+    }
+
+
+    unsigned long UfmfReader::getKeyFrameNumber(unsigned long frameNumber) const
+    {
+        // Latest keyframe with time stamp at or before the frame's time stamp
+        checkFrameNumber(frameNumber);
+        double timeStamp = frameTimeStampVec_[frameNumber];
+        std::vector<double>::const_iterator it = std::upper_bound(
+                keyFrameTimeStampVec_.begin(),
+                keyFrameTimeStampVec_.end(),
+                timeStamp
+                );
+        if (it == keyFrameTimeStampVec_.begin())
+        {
+            return 0;
+        }
+        return (unsigned long)(it - keyFrameTimeStampVec_.begin()) - 1;
+    }
+
+
+    void UfmfReader::setKeyFrameCacheSize(unsigned int cacheSize)
+    {
+        acquireLock();
+        keyFrameCacheSize_ = std::max(cacheSize, 1u);
+        while (keyFrameCacheOrder_.size() > keyFrameCacheSize_)
+        {
+            keyFrameCacheMap_.erase(keyFrameCacheOrder_.back());
+            keyFrameCacheOrder_.pop_back();
+        }
+        releaseLock();
+    }
+
+
+    unsigned int UfmfReader::getKeyFrameCacheSize()
+    {
+        acquireLock();
+        unsigned int cacheSize = keyFrameCacheSize_;
+        releaseLock();
+        return cacheSize;
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+
+    void UfmfReader::readHeader()
+    {
+        uint64_t pos = 0;
+        checkRange(pos, 4);
+        if (std::strncmp((const char *) dataPtr_, "ufmf", 4) != 0)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: file is not a ufmf file");
+            throw RuntimeError(errorId, errorMsg);
+        }
+        pos += 4;
+
+        version_ = readValue<uint32_t>(pos);
+        isCoded_ = (version_ == UfmfCodec::CODED_VERSION_NUMBER);
+        if ((version_ != UFMF_VERSION_NUMBER) && (!isCoded_))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: unsupported ufmf version");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        indexLocation_ = readValue<uint64_t>(pos);
+        uint16_t width = readValue<uint16_t>(pos);
+        uint16_t height = readValue<uint16_t>(pos);
+        isFixedSize_ = (readValue<uint8_t>(pos) != 0);
+        uint8_t colorCodingLength = readValue<uint8_t>(pos);
+        checkRange(pos, colorCodingLength);
+        colorCoding_ = QString::fromStdString(std::string((const char *)(dataPtr_ + pos), colorCodingLength));
+        pos += colorCodingLength;
+
+        if (colorCoding_ != QString("MONO8"))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: unsupported color coding ");
+            errorMsg += colorCoding_.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        // For fixed size boxes the header holds the box size - the frame size
+        // is taken from the first keyframe in readIndex.
+        size_ = cv::Size(width, height);
+        boxSize_ = cv::Size(width, height);
+    }
+
+
+    void UfmfReader::readIndex()
+    {
+        if ((indexLocation_ == 0) || (indexLocation_ >= dataSize_) ||
+                (dataPtr_[indexLocation_-1] != UfmfIndex::INDEX_DICT_CHUNK_ID))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: file has no index, run bias_recover to rebuild it");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        uint64_t pos = indexLocation_;
+        readIndexDict(pos, std::string(""));
+
+        if ((frameLocVec_.size() != frameTimeStampVec_.size()) ||
+                (keyFrameLocVec_.size() != keyFrameTimeStampVec_.size()))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: index location and timestamp arrays differ in size");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        if (isFixedSize_ && !keyFrameLocVec_.empty())
+        {
+            uint64_t keyPos = keyFrameLocVec_[0] + sizeof(uint8_t);
+            uint8_t typeLength = readValue<uint8_t>(keyPos);
+            keyPos += typeLength + sizeof(char);
+            uint16_t width = readValue<uint16_t>(keyPos);
+            uint16_t height = readValue<uint16_t>(keyPos);
+            size_ = cv::Size(width, height);
+        }
+    }
+
+
+    void UfmfReader::readIndexDict(uint64_t &pos, std::string path)
+    {
+        if (readValue<char>(pos) != UfmfIndex::CHAR_FOR_DICT)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: index dictionary expected");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        uint8_t numKeys = readValue<uint8_t>(pos);
+        for (unsigned int i=0; i<numKeys; i++)
+        {
+            uint16_t keyLength = readValue<uint16_t>(pos);
+            checkRange(pos, keyLength);
+            std::string key((const char *)(dataPtr_ + pos), keyLength);
+            pos += keyLength;
+
+            checkRange(pos, 1);
+            char valueType = char(dataPtr_[pos]);
+            if (valueType == UfmfIndex::CHAR_FOR_DICT)
+            {
+                readIndexDict(pos, path + "/" + key);
+            }
+            else if (valueType == UfmfIndex::CHAR_FOR_ARRAY)
+            {
+                readIndexArray(pos, path + "/" + key);
+            }
+            else
+            {
+                unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+                std::string errorMsg("ufmf reader: unknown index value type");
+                throw RuntimeError(errorId, errorMsg);
+            }
+        }
+    }
+
+
+    void UfmfReader::readIndexArray(uint64_t &pos, std::string path)
+    {
+        pos += sizeof(char);
+        char dtype = readValue<char>(pos);
+        uint32_t numBytes = readValue<uint32_t>(pos);
+        checkRange(pos, numBytes);
+
+        const uchar *arrayPtr = dataPtr_ + pos;
+        pos += numBytes;
+
+        std::vector<uint64_t> *locVecPtr = nullptr;
+        std::vector<double> *timeStampVecPtr = nullptr;
+
+        if (path == "/frame/loc")
+        {
+            locVecPtr = &frameLocVec_;
+        }
+        else if (path == "/frame/timestamp")
+        {
+            timeStampVecPtr = &frameTimeStampVec_;
+        }
+        else if (path == "/keyframe/mean/loc")
+        {
+            locVecPtr = &keyFrameLocVec_;
+        }
+        else if (path == "/keyframe/mean/timestamp")
+        {
+            timeStampVecPtr = &keyFrameTimeStampVec_;
+        }
+
+        // Arrays may be unaligned in the file so are copied out
+        if ((locVecPtr != nullptr) && (dtype == UfmfIndex::CHAR_FOR_DTYPE_UINT64))
+        {
+            locVecPtr -> resize(numBytes/sizeof(uint64_t));
+            if (!locVecPtr -> empty())
+            {
+                std::memcpy(&(*locVecPtr)[0], arrayPtr, locVecPtr -> size()*sizeof(uint64_t));
+            }
+        }
+        else if ((timeStampVecPtr != nullptr) && (dtype == UfmfIndex::CHAR_FOR_DTYPE_DOUBLE))
+        {
+            timeStampVecPtr -> resize(numBytes/sizeof(double));
+            if (!timeStampVecPtr -> empty())
+            {
+                std::memcpy(&(*timeStampVecPtr)[0], arrayPtr, timeStampVecPtr -> size()*sizeof(double));
+            }
+        }
+        else if ((locVecPtr != nullptr) || (timeStampVecPtr != nullptr))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: unexpected data type for index array ");
+            errorMsg += path;
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    cv::Mat UfmfReader::decodeKeyFrame(unsigned long keyFrameNumber)
+    {
+        uint64_t pos = keyFrameLocVec_[keyFrameNumber];
+        if (readValue<uint8_t>(pos) != KEYFRAME_CHUNK_ID)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: keyframe chunk expected");
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        uint8_t typeLength = readValue<uint8_t>(pos);
+        pos += typeLength;
+        char dtype = readValue<char>(pos);
+        uint16_t width = readValue<uint16_t>(pos);
+        uint16_t height = readValue<uint16_t>(pos);
+        readValue<double>(pos);
+
+        uint64_t pixelSize = 0;
+        if (dtype == 'B')
+        {
+            pixelSize = sizeof(uint8_t);
+        }
+        else if (dtype == 'f')
+        {
+            pixelSize = sizeof(float);
+        }
+        else
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("ufmf reader: unsupported keyframe data type");
+            throw RuntimeError(errorId, errorMsg);
+        }
+        uint64_t keyFrameDataSize = uint64_t(width)*height*pixelSize;
+
+        // Keyframe data is read in place or, for coded files, from a decoded copy
+        const uchar *keyFrameDataPtr = dataPtr_ + pos;
+        std::vector<uchar> decodedData;
+        if (isCoded_)
+        {
+            decodeBlock(pos, decodedData);
+            checkBufferRange(decodedData.size(), 0, keyFrameDataSize);
+            keyFrameDataPtr = decodedData.data();
+        }
+        else
+        {
+            checkRange(pos, keyFrameDataSize);
+        }
+
+        cv::Mat keyFrame;
+        if (dtype == 'B')
+        {
+            cv::Mat keyFrameData(height, width, CV_8UC1, (void *) keyFrameDataPtr);
+            keyFrame = keyFrameData.clone();
+        }
+        else 
+        {
+            cv::Mat keyFrameData(height, width, CV_32FC1);
+            std::memcpy(keyFrameData.data, keyFrameDataPtr, keyFrameDataSize);
+            keyFrameData.convertTo(keyFrame, CV_8UC1);
+        }
+        return keyFrame;
+    }
+
+
+    void UfmfReader::pasteBoxes(unsigned long frameNumber, cv::Mat &image)
+    {
+        uint64_t pos = frameLocVec_[frameNumber];
+        if (readValue<uint8_t>(pos) != FRAME_CHUNK_ID)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: frame chunk expected");
+            throw RuntimeError(errorId, errorMsg);
+        }
+        readValue<double>(pos);
+        uint32_t numBoxes = readValue<uint32_t>(pos);
+
+        // Box data is read in place or, for coded files, from a decoded copy
+        const uchar *boxDataPtr = dataPtr_ + pos;
+        uint64_t boxDataSize = dataSize_ - pos;
+        std::vector<uchar> decodedData;
+        if (isCoded_)
+        {
+            decodeBlock(pos, decodedData);
+            boxDataPtr = decodedData.data();
+            boxDataSize = decodedData.size();
+        }
+        pos = 0;
+
+        for (uint32_t i=0; i<numBoxes; i++)
+        {
+            unsigned int col = readBufferValue<uint16_t>(boxDataPtr, boxDataSize, pos);
+            unsigned int row = readBufferValue<uint16_t>(boxDataPtr, boxDataSize, pos);
+            unsigned int width = 0;
+            unsigned int height = 0;
+            if (isFixedSize_)
+            {
+                width = (unsigned int)(boxSize_.width);
+                height = (unsigned int)(boxSize_.height);
+            }
+            else
+            {
+                width = readBufferValue<uint16_t>(boxDataPtr, boxDataSize, pos);
+                height = readBufferValue<uint16_t>(boxDataPtr, boxDataSize, pos);
+            }
+            checkBufferRange(boxDataSize, pos, uint64_t(width)*height);
+
+            // Clip box to image
+            unsigned int copyWidth = 0;
+            if (col < (unsigned int)(image.cols))
+            {
+                copyWidth = std::min(width, (unsigned int)(image.cols) - col);
+            }
+            for (unsigned int j=0; j<height; j++)
+            {
+                if ((row + j < (unsigned int)(image.rows)) && (copyWidth > 0))
+                {
+                    std::memcpy(image.ptr<uchar>(row + j) + col, boxDataPtr + pos + j*width, copyWidth);
+                }
+            }
+            pos += uint64_t(width)*height;
+        }
+    }
+
+
+    void UfmfReader::decodeBlock(uint64_t &pos, std::vector<uchar> &data) const
+    {
+        // Decodes coded block (see UfmfCodec) at pos and moves pos past it
+        uint8_t coding = 0;
+        uint32_t rawSize = 0;
+        uint32_t codedSize = 0;
+
+        checkRange(pos, UfmfCodec::CODED_HEADER_SIZE);
+        bool ok = UfmfCodec::parseHeader((const char *)(dataPtr_ + pos), coding, rawSize, codedSize);
+        pos += UfmfCodec::CODED_HEADER_SIZE;
+        if (ok)
+        {
+            checkRange(pos, codedSize);
+            data.resize(rawSize);
+            ok = UfmfCodec::decode(
+                    (const char *)(dataPtr_ + pos), 
+                    coding, 
+                    rawSize, 
+                    codedSize, 
+                    (char *) data.data()
+                    );
+            pos += codedSize;
+        }
+        if (!ok)
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: unable to decode coded data");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void UfmfReader::checkRange(uint64_t pos, uint64_t size) const
+    {
+        if ((dataPtr_ == nullptr) || (pos + size > dataSize_))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: read past end of file");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    void UfmfReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= frameLocVec_.size())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("ufmf reader: frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    template <class T>
+    T UfmfReader::readValue(uint64_t &pos) const
+    {
+        T value;
+        checkRange(pos, sizeof(T));
+        std::memcpy(&value, dataPtr_ + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+} // namespace bias
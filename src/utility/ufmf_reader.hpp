@@ -0,0 +1,110 @@
+#ifndef BIAS_UFMF_READER_HPP
+#define BIAS_UFMF_READER_HPP
+
+#include "lockable.hpp"
+#include <QString>
+#include <QFile>
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <list>
+#include <map>
+#include <string>
+#include <cstdint>
+
+namespace bias
+{
+
+    class UfmfReader : public Lockable<Empty>
+    {
+        // Random access reader for ufmf files (version 4 and coded version 5)
+        // as written by VideoWriter_ufmf. The file is memory mapped and the 
+        // index dictionary is parsed on open. A frame is reconstructed by 
+        // pasting its boxes onto a copy of the latest keyframe at or before 
+        // its time stamp. Decoded keyframes are kept in a small LRU cache.
+        //
+        // getFrame and getFrames may be called from multiple threads.
+
+        public:
+
+            static const unsigned int DEFAULT_KEYFRAME_CACHE_SIZE;
+            static const unsigned int UFMF_VERSION_NUMBER;
+            static const uint8_t KEYFRAME_CHUNK_ID;
+            static const uint8_t FRAME_CHUNK_ID;
+
+            UfmfReader();
+            UfmfReader(QString fileName);
+            virtual ~UfmfReader();
+
+            void open(QString fileName);
+            void close();
+            bool isOpen() const;
+            QString getFileName() const;
+
+            unsigned int getVersion() const;
+            bool isCoded() const;
+            cv::Size getSize() const;
+            QString getColorCoding() const;
+            unsigned long getNumberOfFrames() const;
+            unsigned long getNumberOfKeyFrames() const;
+
+            double getTimeStamp(unsigned long frameNumber) const;
+            std::vector<double> getTimeStamps() const;
+            unsigned long getFrameNumber(double timeStamp) const;
+
+            cv::Mat getFrame(unsigned long frameNumber);
+            void getFrame(unsigned long frameNumber, cv::Mat &image);
+            void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            cv::Mat getKeyFrame(unsigned long keyFrameNumber);
+            unsigned long getKeyFrameNumber(unsigned long frameNumber) const;
+
+            void setKeyFrameCacheSize(unsigned int cacheSize);
+            unsigned int getKeyFrameCacheSize();
+
+        protected:
+
+            QFile file_;
+            const uchar *dataPtr_;
+            uint64_t dataSize_;
+
+            unsigned int version_;
+            cv::Size size_;
+            bool isFixedSize_;
+            bool isCoded_;
+            cv::Size boxSize_;
+            QString colorCoding_;
+            uint64_t indexLocation_;
+
+            std::vector<uint64_t> frameLocVec_;
+            std::vector<double> frameTimeStampVec_;
+            std::vector<uint64_t> keyFrameLocVec_;
+            std::vector<double> keyFrameTimeStampVec_;
+
+            unsigned int keyFrameCacheSize_;
+            std::list<unsigned long> keyFrameCacheOrder_;
+            std::map<unsigned long, cv::Mat> keyFrameCacheMap_;
+
+            void readHeader();
+            void readIndex();
+            void readIndexDict(uint64_t &pos, std::string path);
+            void readIndexArray(uint64_t &pos, std::string path);
+
+            cv::Mat decodeKeyFrame(unsigned long keyFrameNumber);
+            void pasteBoxes(unsigned long frameNumber, cv::Mat &image);
+            void decodeBlock(uint64_t &pos, std::vector<uchar> &data) const;
+
+            void checkRange(uint64_t pos, uint64_t size) const;
+            void checkFrameNumber(unsigned long frameNumber) const;
+
+            template <class T>
+            T readValue(uint64_t &pos) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_UFMF_READER_HPP
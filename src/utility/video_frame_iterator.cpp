@@ -0,0 +1,117 @@
+#include "video_frame_iterator.hpp"
+#include <algorithm>
+
+namespace bias
+{
+
+    VideoFrameIterator::VideoFrameIterator(std::shared_ptr<VideoReader> readerPtr)
+    {
+        readerPtr_ = readerPtr;
+        frameNumber_ = 0;
+        startFrame_ = 0;
+        stopFrame_ = readerPtr_ -> getNumberOfFrames();
+    }
+
+
+    void VideoFrameIterator::seek(unsigned long frameNumber)
+    {
+        frameNumber_ = std::min(frameNumber, readerPtr_ -> getNumberOfFrames());
+        startFrame_ = frameNumber_;
+    }
+
+
+    void VideoFrameIterator::seekTime(double timeStamp)
+    {
+        seek(findFrame(timeStamp));
+    }
+
+
+    void VideoFrameIterator::setStopFrame(unsigned long frameNumber)
+    {
+        stopFrame_ = std::min(frameNumber, readerPtr_ -> getNumberOfFrames());
+    }
+
+
+    void VideoFrameIterator::setStopTime(double timeStamp)
+    {
+        setStopFrame(findFrame(timeStamp));
+    }
+
+
+    bool VideoFrameIterator::atEnd() const
+    {
+        return frameNumber_ >= stopFrame_;
+    }
+
+
+    bool VideoFrameIterator::next(StampedImage &stampedImg)
+    {
+        // Returns false at the end. Read errors are thrown as RuntimeError.
+        if (atEnd())
+        {
+            return false;
+        }
+        readerPtr_ -> getFrame(frameNumber_, stampedImg.image);
+        stampedImg.timeStamp = readerPtr_ -> getTimeStamp(frameNumber_);
+        stampedImg.hostTimeStamp = 0.0;
+        stampedImg.frameCount = readerPtr_ -> getFrameCount(frameNumber_);
+        stampedImg.dtEstimate = getDtEstimate();
+        frameNumber_++;
+        return true;
+    }
+
+
+    unsigned long VideoFrameIterator::getFrameNumber() const
+    {
+        return frameNumber_;
+    }
+
+
+    unsigned long VideoFrameIterator::getStopFrame() const
+    {
+        return stopFrame_;
+    }
+
+
+    unsigned long VideoFrameIterator::getNumberRemaining() const
+    {
+        return atEnd() ? 0 : stopFrame_ - frameNumber_;
+    }
+
+
+    unsigned long VideoFrameIterator::findFrame(double timeStamp) const
+    {
+        // First frame at or after timeStamp, number of frames if none
+        unsigned long numFrames = readerPtr_ -> getNumberOfFrames();
+        if (numFrames == 0)
+        {
+            return 0;
+        }
+        unsigned long frameNumber = readerPtr_ -> getFrameNumber(timeStamp);
+        if (readerPtr_ -> getTimeStamp(frameNumber) < timeStamp)
+        {
+            frameNumber = numFrames;
+        }
+        return frameNumber;
+    }
+
+
+    double VideoFrameIterator::getDtEstimate() const
+    {
+        // Mean interval since the start frame, or to the following frame 
+        // for the start frame itself
+        unsigned long numFrames = readerPtr_ -> getNumberOfFrames();
+        if (frameNumber_ > startFrame_)
+        {
+            double t0 = readerPtr_ -> getTimeStamp(startFrame_);
+            double t1 = readerPtr_ -> getTimeStamp(frameNumber_);
+            return (t1 - t0)/double(frameNumber_ - startFrame_);
+        }
+        if (frameNumber_ + 1 < numFrames)
+        {
+            return readerPtr_ -> getTimeStamp(frameNumber_ + 1) - readerPtr_ -> getTimeStamp(frameNumber_);
+        }
+        return 0.0;
+    }
+
+} // namespace bias
@@ -0,0 +1,48 @@
+#ifndef BIAS_VIDEO_FRAME_ITERATOR_HPP
+#define BIAS_VIDEO_FRAME_ITERATOR_HPP
+
+#include "video_reader.hpp"
+#include "stamped_image.hpp"
+#include <memory>
+
+namespace bias
+{
+
+    class VideoFrameIterator
+    {
+        // Steps through the frames of a reader in order and returns them as
+        // stamped images, as passed to the video writers. dtEstimate is the 
+        // mean frame interval since the start of the iteration. The range 
+        // can be set by frame number or by time stamp. Use a 
+        // PrefetchVideoReader to decode ahead of the caller.
+
+        public:
+
+            VideoFrameIterator(std::shared_ptr<VideoReader> readerPtr);
+
+            void seek(unsigned long frameNumber);
+            void seekTime(double timeStamp);          // first frame at or after timeStamp
+            void setStopFrame(unsigned long frameNumber);
+            void setStopTime(double timeStamp);       // stop before first frame at or after timeStamp
+
+            bool atEnd() const;
+            bool next(StampedImage &stampedImg);
+
+            unsigned long getFrameNumber() const;     // of the next frame
+            unsigned long getStopFrame() const;
+            unsigned long getNumberRemaining() const;
+
+        protected:
+
+            std::shared_ptr<VideoReader> readerPtr_;
+            unsigned long frameNumber_;
+            unsigned long stopFrame_;
+            unsigned long startFrame_;
+
+            unsigned long findFrame(double timeStamp) const;
+            double getDtEstimate() const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_FRAME_ITERATOR_HPP
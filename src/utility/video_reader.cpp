@@ -0,0 +1,139 @@
+#include "video_reader.hpp"
+#include "video_reader_fmf.hpp"
+#include "video_reader_ufmf.hpp"
+#include "video_reader_zfmf.hpp"
+#include "video_reader_mjpg.hpp"
+#include "video_reader_avi.hpp"
+#include "video_reader_images.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <QFileInfo>
+#include <algorithm>
+
+namespace bias
+{
+
+    VideoReader::VideoReader() 
+    {}
+
+
+    VideoReader::~VideoReader() 
+    {}
+
+
+    unsigned long VideoReader::getFrameCount(unsigned long frameNumber) const
+    {
+        return frameNumber;
+    }
+
+
+    unsigned long VideoReader::getFrameNumber(double timeStamp) const
+    {
+        // Returns first frame at or after timeStamp (last frame if none).
+        unsigned long numFrames = getNumberOfFrames();
+        if (numFrames == 0)
+        {
+            return 0;
+        }
+        unsigned long lower = 0;
+        unsigned long upper = numFrames;
+        while (lower < upper)
+        {
+            unsigned long middle = lower + (upper - lower)/2;
+            if (getTimeStamp(middle) < timeStamp)
+            {
+                lower = middle + 1;
+            }
+            else
+            {
+                upper = middle;
+            }
+        }
+        return std::min(lower, numFrames - 1);
+    }
+
+
+    cv::Mat VideoReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void VideoReader::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int
+            )
+    {
+        // Frames are read in order on the calling thread - formats which can 
+        // decode in parallel override this and use the number of threads.
+        if (numFrames > 0)
+        {
+            checkFrameNumber(firstFrame + numFrames - 1);
+        }
+        imageVec.resize(numFrames);
+        for (unsigned long i=0; i<numFrames; i++)
+        {
+            getFrame(firstFrame + i, imageVec[i]);
+        }
+    }
+
+
+    bool VideoReader::isRandomAccess() const
+    {
+        return true;
+    }
+
+
+    std::shared_ptr<VideoReader> VideoReader::createReader(QString fileName)
+    {
+        // Image sequences are read from their log directory
+        QFileInfo fileInfo(fileName);
+        if (fileInfo.isDir())
+        {
+            return std::make_shared<VideoReader_images>(fileName);
+        }
+
+        QString suffix = fileInfo.suffix().toLower();
+        if (suffix == "fmf")
+        {
+            return std::make_shared<VideoReader_fmf>(fileName);
+        }
+        if (suffix == "ufmf")
+        {
+            return std::make_shared<VideoReader_ufmf>(fileName);
+        }
+        if (suffix == "zfmf")
+        {
+            return std::make_shared<VideoReader_zfmf>(fileName);
+        }
+        if (suffix == "mjpg")
+        {
+            return std::make_shared<VideoReader_mjpg>(fileName);
+        }
+        if ((suffix == "avi") || (suffix == "mov") || (suffix == "mp4"))
+        {
+            return std::make_shared<VideoReader_avi>(fileName);
+        }
+
+        unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+        std::string errorMsg("video reader: unsupported file format, ");
+        errorMsg += fileName.toStdString();
+        throw RuntimeError(errorId, errorMsg);
+    }
+
+
+    void VideoReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= getNumberOfFrames())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("video reader: frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+} // namespace bias
@@ -0,0 +1,59 @@
+#ifndef BIAS_VIDEO_READER_HPP
+#define BIAS_VIDEO_READER_HPP
+
+#include <QString>
+#include <opencv2/core/core.hpp>
+#include <memory>
+#include <vector>
+
+namespace bias
+{
+
+    class VideoReader
+    {
+        // Common interface to the readers for files written by the video 
+        // writers - the reading counterpart of VideoWriter. The derived 
+        // classes (VideoReader_fmf, VideoReader_ufmf, ...) adapt the format 
+        // specific readers. createReader picks one from the file name.
+        //
+        // Frame numbers are positions in the file (0 .. numberOfFrames-1), 
+        // frame counts are the camera frame counts where the format records
+        // them. getFrame and getFrames may be called from multiple threads.
+
+        public:
+
+            VideoReader();
+            virtual ~VideoReader();
+
+            virtual void open(QString fileName) = 0;
+            virtual void close() = 0;
+            virtual bool isOpen() const = 0;
+            virtual QString getFileName() const = 0;
+
+            virtual unsigned long getNumberOfFrames() const = 0;
+            virtual double getTimeStamp(unsigned long frameNumber) const = 0;
+            virtual unsigned long getFrameCount(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            cv::Mat getFrame(unsigned long frameNumber);
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image) = 0;
+            virtual void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            // False when frames out of order are expensive (seek and decode)
+            virtual bool isRandomAccess() const;
+
+            static std::shared_ptr<VideoReader> createReader(QString fileName);
+
+        protected:
+
+            void checkFrameNumber(unsigned long frameNumber) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_HPP
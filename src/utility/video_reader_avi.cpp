@@ -0,0 +1,176 @@
+#include "video_reader_avi.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace bias
+{
+
+    VideoReader_avi::VideoReader_avi()
+    {
+        numFrames_ = 0;
+        frameRate_ = 0.0;
+        fourcc_ = 0;
+        nextFrame_ = 0;
+    }
+
+
+    VideoReader_avi::VideoReader_avi(QString fileName) : VideoReader_avi()
+    {
+        open(fileName);
+    }
+
+
+    VideoReader_avi::~VideoReader_avi()
+    {
+        close();
+    }
+
+
+    void VideoReader_avi::open(QString fileName)
+    {
+        close();
+
+        bool isOpened = false;
+        try
+        {
+            isOpened = capture_.open(fileName.toStdString());
+            if (isOpened)
+            {
+                numFrames_ = (unsigned long)(std::max(capture_.get(CV_CAP_PROP_FRAME_COUNT), 0.0));
+                frameRate_ = capture_.get(CV_CAP_PROP_FPS);
+                fourcc_ = int(capture_.get(CV_CAP_PROP_FOURCC));
+            }
+        }
+        catch (cv::Exception &exception)
+        {
+            isOpened = false;
+        }
+
+        if (!isOpened)
+        {
+            close();
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("avi reader unable to open file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        if (!(frameRate_ > 0.0))
+        {
+            frameRate_ = 1.0;
+        }
+        fileName_ = fileName;
+        nextFrame_ = 0;
+    }
+
+
+    void VideoReader_avi::close()
+    {
+        if (capture_.isOpened())
+        {
+            capture_.release();
+        }
+        fileName_ = QString();
+        numFrames_ = 0;
+        frameRate_ = 0.0;
+        fourcc_ = 0;
+        nextFrame_ = 0;
+    }
+
+
+    bool VideoReader_avi::isOpen() const
+    {
+        return capture_.isOpened();
+    }
+
+
+    QString VideoReader_avi::getFileName() const
+    {
+        return fileName_;
+    }
+
+
+    unsigned long VideoReader_avi::getNumberOfFrames() const
+    {
+        return numFrames_;
+    }
+
+
+    double VideoReader_avi::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return double(frameNumber)/frameRate_;
+    }
+
+
+    unsigned long VideoReader_avi::getFrameNumber(double timeStamp) const
+    {
+        // Time stamps are evenly spaced
+        if (numFrames_ == 0)
+        {
+            return 0;
+        }
+        double frameNumber = std::ceil(std::max(timeStamp, 0.0)*frameRate_ - 1.0e-6);
+        return (unsigned long)(std::min(frameNumber, double(numFrames_ - 1)));
+    }
+
+
+    void VideoReader_avi::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        checkFrameNumber(frameNumber);
+
+        // Read into a new image - retrieve copies into an existing image 
+        // of the same size, which may be shared.
+        cv::Mat frame;
+        acquireLock();
+        bool ok = true;
+        try
+        {
+            if (frameNumber != nextFrame_)
+            {
+                capture_.set(CV_CAP_PROP_POS_FRAMES, double(frameNumber));
+            }
+            ok = capture_.read(frame);
+            nextFrame_ = frameNumber + 1;
+        }
+        catch (cv::Exception &exception)
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            // Force a seek on the next read
+            nextFrame_ = numFrames_;
+        }
+        releaseLock();
+
+        if (!ok || frame.empty())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("avi reader unable to read frame ");
+            errorMsg += std::to_string(frameNumber);
+            throw RuntimeError(errorId, errorMsg);
+        }
+        image = frame;
+    }
+
+
+    bool VideoReader_avi::isRandomAccess() const
+    {
+        return false;
+    }
+
+
+    double VideoReader_avi::getFrameRate() const
+    {
+        return frameRate_;
+    }
+
+
+    int VideoReader_avi::getFourcc() const
+    {
+        return fourcc_;
+    }
+
+} // namespace bias
@@ -0,0 +1,53 @@
+#ifndef BIAS_VIDEO_READER_AVI_HPP
+#define BIAS_VIDEO_READER_AVI_HPP
+
+#include "video_reader.hpp"
+#include "lockable.hpp"
+#include <opencv2/highgui/highgui.hpp>
+
+namespace bias
+{
+
+    class VideoReader_avi : public VideoReader, public Lockable<Empty>
+    {
+        // avi (and other container) files read with cv::VideoCapture. Frames
+        // are decoded in order - reading out of order seeks, which for most
+        // codecs decodes from the previous keyframe. Time stamps are derived
+        // from the frame rate in the file.
+
+        public:
+
+            VideoReader_avi();
+            VideoReader_avi(QString fileName);
+            virtual ~VideoReader_avi();
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+
+            virtual bool isRandomAccess() const;
+
+            double getFrameRate() const;
+            int getFourcc() const;
+
+        protected:
+
+            cv::VideoCapture capture_;
+            QString fileName_;
+            unsigned long numFrames_;
+            double frameRate_;
+            int fourcc_;
+            unsigned long nextFrame_;   // use lock
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_AVI_HPP
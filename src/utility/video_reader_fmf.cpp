@@ -0,0 +1,63 @@
+#include "video_reader_fmf.hpp"
+
+namespace bias
+{
+
+    VideoReader_fmf::VideoReader_fmf() 
+    {}
+
+
+    VideoReader_fmf::VideoReader_fmf(QString fileName)
+    {
+        open(fileName);
+    }
+
+
+    void VideoReader_fmf::open(QString fileName)
+    {
+        reader_.open(fileName);
+    }
+
+
+    void VideoReader_fmf::close()
+    {
+        reader_.close();
+    }
+
+
+    bool VideoReader_fmf::isOpen() const
+    {
+        return reader_.isOpen();
+    }
+
+
+    QString VideoReader_fmf::getFileName() const
+    {
+        return reader_.getFileName();
+    }
+
+
+    unsigned long VideoReader_fmf::getNumberOfFrames() const
+    {
+        return reader_.getNumberOfFrames();
+    }
+
+
+    double VideoReader_fmf::getTimeStamp(unsigned long frameNumber) const
+    {
+        return reader_.getTimeStamp(frameNumber);
+    }
+
+
+    void VideoReader_fmf::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        reader_.getFrame(frameNumber, image);
+    }
+
+
+    FmfStripeReader &VideoReader_fmf::getReader()
+    {
+        return reader_;
+    }
+
+} // namespace bias
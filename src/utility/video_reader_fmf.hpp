@@ -0,0 +1,39 @@
+#ifndef BIAS_VIDEO_READER_FMF_HPP
+#define BIAS_VIDEO_READER_FMF_HPP
+
+#include "video_reader.hpp"
+#include "fmf_stripe_reader.hpp"
+
+namespace bias
+{
+
+    class VideoReader_fmf : public VideoReader
+    {
+        // fmf files, striped or not (see FmfStripeReader)
+
+        public:
+
+            VideoReader_fmf();
+            VideoReader_fmf(QString fileName);
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+
+            FmfStripeReader &getReader();
+
+        protected:
+
+            FmfStripeReader reader_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_FMF_HPP
@@ -0,0 +1,263 @@
+#include "video_reader_images.hpp"
+#include "image_sequence_index.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <opencv2/highgui/highgui.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace bias
+{
+    const QString VideoReader_images::INDEX_FILE_NAME = QString("index.bin");
+    const QStringList VideoReader_images::IMAGE_FILE_FILTERS = 
+        QStringList() << "*.bmp" << "*.jpg" << "*.jpeg" << "*.png" << "*.tif" << "*.tiff";
+    const int VideoReader_images::DEFAULT_READ_FLAGS = CV_LOAD_IMAGE_UNCHANGED;
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    static bool getTrailingNumber(QString fileName, unsigned long &number)
+    {
+        // image_123.bmp -> 123
+        QString baseName = QFileInfo(fileName).completeBaseName();
+        int pos = baseName.size();
+        while ((pos > 0) && baseName[pos-1].isDigit())
+        {
+            pos--;
+        }
+        bool ok = false;
+        number = baseName.mid(pos).toULong(&ok);
+        return ok;
+    }
+
+
+    // VideoReader_images
+    // ----------------------------------------------------------------------------------
+    VideoReader_images::VideoReader_images()
+    {
+        isOpen_ = false;
+        readFlags_ = DEFAULT_READ_FLAGS;
+    }
+
+
+    VideoReader_images::VideoReader_images(QString fileName) : VideoReader_images()
+    {
+        open(fileName);
+    }
+
+
+    VideoReader_images::VideoReader_images(QStringList fileNames) : VideoReader_images()
+    {
+        open(fileNames);
+    }
+
+
+    void VideoReader_images::open(QString fileName)
+    {
+        close();
+
+        QFileInfo fileInfo(fileName);
+        QString dirName = fileInfo.isDir() ? fileInfo.absoluteFilePath() : fileInfo.absolutePath();
+        if (!QDir(dirName).exists())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("image sequence reader: directory does not exist, ");
+            errorMsg += dirName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        QString indexFileName = fileInfo.isDir() ? QDir(dirName).absoluteFilePath(INDEX_FILE_NAME) : fileName;
+        if (!readIndex(indexFileName))
+        {
+            if (!fileInfo.isDir())
+            {
+                unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+                std::string errorMsg("image sequence reader: unable to read index file, ");
+                errorMsg += fileName.toStdString();
+                throw RuntimeError(errorId, errorMsg);
+            }
+            listImageFiles(dirName);
+        }
+        fileName_ = fileName;
+        isOpen_ = true;
+    }
+
+
+    void VideoReader_images::open(QStringList fileNames)
+    {
+        // Frames in the order given
+        close();
+        for (const QString &name : fileNames)
+        {
+            unsigned long frameNumber = (unsigned long)(frameCountVec_.size());
+            imageFileNames_.append(QFileInfo(name).absoluteFilePath());
+            timeStampVec_.push_back(double(frameNumber));
+            frameCountVec_.push_back(frameNumber);
+        }
+        isOpen_ = true;
+    }
+
+
+    void VideoReader_images::close()
+    {
+        isOpen_ = false;
+        fileName_ = QString();
+        imageFileNames_.clear();
+        timeStampVec_.clear();
+        frameCountVec_.clear();
+    }
+
+
+    bool VideoReader_images::isOpen() const
+    {
+        return isOpen_;
+    }
+
+
+    QString VideoReader_images::getFileName() const
+    {
+        return fileName_;
+    }
+
+
+    unsigned long VideoReader_images::getNumberOfFrames() const
+    {
+        return (unsigned long)(imageFileNames_.size());
+    }
+
+
+    double VideoReader_images::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return timeStampVec_[frameNumber];
+    }
+
+
+    unsigned long VideoReader_images::getFrameCount(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return frameCountVec_[frameNumber];
+    }
+
+
+    void VideoReader_images::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        checkFrameNumber(frameNumber);
+        QString imageFileName = imageFileNames_[int(frameNumber)];
+        try
+        {
+            image = cv::imread(imageFileName.toStdString(), readFlags_);
+        }
+        catch (cv::Exception &exception)
+        {
+            image = cv::Mat();
+        }
+        if (image.empty())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("image sequence reader: unable to read image, ");
+            errorMsg += imageFileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    QString VideoReader_images::getImageFileName(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return imageFileNames_[int(frameNumber)];
+    }
+
+
+    void VideoReader_images::setReadFlags(int flags)
+    {
+        readFlags_ = flags;
+    }
+
+
+    int VideoReader_images::getReadFlags() const
+    {
+        return readFlags_;
+    }
+
+
+    bool VideoReader_images::readIndex(QString indexFileName)
+    {
+        QFile indexFile(indexFileName);
+        if (!indexFile.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        QByteArray data = indexFile.readAll();
+        indexFile.close();
+
+        const unsigned char *dataPtr = (const unsigned char *) data.constData();
+        uint64_t dataSize = uint64_t(data.size());
+        uint32_t entrySize = 0;
+        if (!ImageSequenceIndex::parseHeader(dataPtr, dataSize, entrySize))
+        {
+            return false;
+        }
+
+        // Paths are relative to the log directory
+        QDir logDir = QFileInfo(indexFileName).absoluteDir();
+        uint64_t numEntries = ImageSequenceIndex::numEntries(dataSize, entrySize);
+        for (uint64_t i=0; i<numEntries; i++)
+        {
+            ImageSequenceIndexEntry entry;
+            std::memcpy(&entry, dataPtr + ImageSequenceIndex::HEADER_SIZE + i*entrySize, sizeof(entry));
+            imageFileNames_.append(logDir.absoluteFilePath(QString::fromStdString(entry.getPath())));
+            timeStampVec_.push_back(entry.timeStamp);
+            frameCountVec_.push_back((unsigned long)(entry.frameCount));
+        }
+        return true;
+    }
+
+
+    void VideoReader_images::listImageFiles(QString dirName)
+    {
+        // Files without a number sort after those with one, by name
+        QFileInfoList fileInfoList = QDir(dirName).entryInfoList(IMAGE_FILE_FILTERS, QDir::Files, QDir::Name);
+        std::vector<std::pair<unsigned long, QString>> numberedVec;
+        QStringList unnumberedList;
+        for (QFileInfo fileInfo : fileInfoList)
+        {
+            unsigned long number = 0;
+            if (getTrailingNumber(fileInfo.fileName(), number))
+            {
+                numberedVec.push_back(std::make_pair(number, fileInfo.absoluteFilePath()));
+            }
+            else
+            {
+                unnumberedList.append(fileInfo.absoluteFilePath());
+            }
+        }
+        std::stable_sort(
+                numberedVec.begin(), 
+                numberedVec.end(),
+                [](const std::pair<unsigned long,QString> &a, const std::pair<unsigned long,QString> &b)
+                {
+                    return a.first < b.first;
+                }
+                );
+
+        for (const std::pair<unsigned long,QString> &numbered : numberedVec)
+        {
+            frameCountVec_.push_back(numbered.first);
+            imageFileNames_.append(numbered.second);
+        }
+        for (QString fileName : unnumberedList)
+        {
+            frameCountVec_.push_back((unsigned long)(imageFileNames_.size()));
+            imageFileNames_.append(fileName);
+        }
+        for (size_t i=0; i<frameCountVec_.size(); i++)
+        {
+            timeStampVec_.push_back(double(i));
+        }
+    }
+
+} // namespace bias
@@ -0,0 +1,64 @@
+#ifndef BIAS_VIDEO_READER_IMAGES_HPP
+#define BIAS_VIDEO_READER_IMAGES_HPP
+
+#include "video_reader.hpp"
+#include <QStringList>
+#include <vector>
+
+namespace bias
+{
+
+    class VideoReader_images : public VideoReader
+    {
+        // Image sequences (one file per frame) as written by VideoWriter_bmp
+        // and VideoWriter_jpg. open takes the log directory or its index 
+        // file. Frames, time stamps and frame counts come from the index 
+        // (see ImageSequenceIndex) when there is one. Otherwise the image 
+        // files in the directory are ordered by the number at the end of 
+        // their names, which is also used as the frame count, and the time 
+        // stamps are the frame numbers. An explicit list of image files can
+        // be given instead.
+
+        public:
+
+            static const QString INDEX_FILE_NAME;
+            static const QStringList IMAGE_FILE_FILTERS;
+            static const int DEFAULT_READ_FLAGS;
+
+            VideoReader_images();
+            VideoReader_images(QString fileName);
+            VideoReader_images(QStringList fileNames);
+
+            virtual void open(QString fileName);
+            void open(QStringList fileNames);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameCount(unsigned long frameNumber) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+
+            QString getImageFileName(unsigned long frameNumber) const;
+            void setReadFlags(int flags);   // cv::imread flags, set before reading
+            int getReadFlags() const;
+
+        protected:
+
+            bool isOpen_;
+            QString fileName_;
+            int readFlags_;
+            QStringList imageFileNames_;
+            std::vector<double> timeStampVec_;
+            std::vector<unsigned long> frameCountVec_;
+
+            bool readIndex(QString indexFileName);
+            void listImageFiles(QString dirName);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_IMAGES_HPP
@@ -0,0 +1,86 @@
+#include "video_reader_mjpg.hpp"
+
+namespace bias
+{
+
+    VideoReader_mjpg::VideoReader_mjpg() 
+    {}
+
+
+    VideoReader_mjpg::VideoReader_mjpg(QString fileName)
+    {
+        open(fileName);
+    }
+
+
+    void VideoReader_mjpg::open(QString fileName)
+    {
+        reader_.open(fileName);
+    }
+
+
+    void VideoReader_mjpg::close()
+    {
+        reader_.close();
+    }
+
+
+    bool VideoReader_mjpg::isOpen() const
+    {
+        return reader_.isOpen();
+    }
+
+
+    QString VideoReader_mjpg::getFileName() const
+    {
+        return reader_.getFileName();
+    }
+
+
+    unsigned long VideoReader_mjpg::getNumberOfFrames() const
+    {
+        return reader_.getNumberOfFrames();
+    }
+
+
+    double VideoReader_mjpg::getTimeStamp(unsigned long frameNumber) const
+    {
+        return reader_.getTimeStamp(frameNumber);
+    }
+
+
+    unsigned long VideoReader_mjpg::getFrameCount(unsigned long frameNumber) const
+    {
+        return reader_.getFrameCount(frameNumber);
+    }
+
+
+    unsigned long VideoReader_mjpg::getFrameNumber(double timeStamp) const
+    {
+        return reader_.getFrameNumber(timeStamp);
+    }
+
+
+    void VideoReader_mjpg::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        reader_.getFrame(frameNumber, image);
+    }
+
+
+    void VideoReader_mjpg::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        reader_.getFrames(firstFrame, numFrames, imageVec, numThreads);
+    }
+
+
+    MjpgReader &VideoReader_mjpg::getReader()
+    {
+        return reader_;
+    }
+
+} // namespace bias
@@ -0,0 +1,48 @@
+#ifndef BIAS_VIDEO_READER_MJPG_HPP
+#define BIAS_VIDEO_READER_MJPG_HPP
+
+#include "video_reader.hpp"
+#include "mjpg_reader.hpp"
+
+namespace bias
+{
+
+    class VideoReader_mjpg : public VideoReader
+    {
+        // mjpg movie files with their index (see MjpgReader). Frame counts
+        // are those recorded by the writer.
+
+        public:
+
+            VideoReader_mjpg();
+            VideoReader_mjpg(QString fileName);
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameCount(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+            virtual void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            MjpgReader &getReader();
+
+        protected:
+
+            MjpgReader reader_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_MJPG_HPP
@@ -0,0 +1,80 @@
+#include "video_reader_ufmf.hpp"
+
+namespace bias
+{
+
+    VideoReader_ufmf::VideoReader_ufmf() 
+    {}
+
+
+    VideoReader_ufmf::VideoReader_ufmf(QString fileName)
+    {
+        open(fileName);
+    }
+
+
+    void VideoReader_ufmf::open(QString fileName)
+    {
+        reader_.open(fileName);
+    }
+
+
+    void VideoReader_ufmf::close()
+    {
+        reader_.close();
+    }
+
+
+    bool VideoReader_ufmf::isOpen() const
+    {
+        return reader_.isOpen();
+    }
+
+
+    QString VideoReader_ufmf::getFileName() const
+    {
+        return reader_.getFileName();
+    }
+
+
+    unsigned long VideoReader_ufmf::getNumberOfFrames() const
+    {
+        return reader_.getNumberOfFrames();
+    }
+
+
+    double VideoReader_ufmf::getTimeStamp(unsigned long frameNumber) const
+    {
+        return reader_.getTimeStamp(frameNumber);
+    }
+
+
+    unsigned long VideoReader_ufmf::getFrameNumber(double timeStamp) const
+    {
+        return reader_.getFrameNumber(timeStamp);
+    }
+
+
+    void VideoReader_ufmf::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        reader_.getFrame(frameNumber, image);
+    }
+
+
+    void VideoReader_ufmf::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        reader_.getFrames(firstFrame, numFrames, imageVec, numThreads);
+    }
+
+
+    UfmfReader &VideoReader_ufmf::getReader()
+    {
+        return reader_;
+    }
+
+} // namespace bias
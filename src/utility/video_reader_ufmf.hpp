@@ -0,0 +1,46 @@
+#ifndef BIAS_VIDEO_READER_UFMF_HPP
+#define BIAS_VIDEO_READER_UFMF_HPP
+
+#include "video_reader.hpp"
+#include "ufmf_reader.hpp"
+
+namespace bias
+{
+
+    class VideoReader_ufmf : public VideoReader
+    {
+        // ufmf files (see UfmfReader)
+
+        public:
+
+            VideoReader_ufmf();
+            VideoReader_ufmf(QString fileName);
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+            virtual void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            UfmfReader &getReader();
+
+        protected:
+
+            UfmfReader reader_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_UFMF_HPP
@@ -0,0 +1,80 @@
+#include "video_reader_zfmf.hpp"
+
+namespace bias
+{
+
+    VideoReader_zfmf::VideoReader_zfmf() 
+    {}
+
+
+    VideoReader_zfmf::VideoReader_zfmf(QString fileName)
+    {
+        open(fileName);
+    }
+
+
+    void VideoReader_zfmf::open(QString fileName)
+    {
+        reader_.open(fileName);
+    }
+
+
+    void VideoReader_zfmf::close()
+    {
+        reader_.close();
+    }
+
+
+    bool VideoReader_zfmf::isOpen() const
+    {
+        return reader_.isOpen();
+    }
+
+
+    QString VideoReader_zfmf::getFileName() const
+    {
+        return reader_.getFileName();
+    }
+
+
+    unsigned long VideoReader_zfmf::getNumberOfFrames() const
+    {
+        return reader_.getNumberOfFrames();
+    }
+
+
+    double VideoReader_zfmf::getTimeStamp(unsigned long frameNumber) const
+    {
+        return reader_.getTimeStamp(frameNumber);
+    }
+
+
+    unsigned long VideoReader_zfmf::getFrameNumber(double timeStamp) const
+    {
+        return reader_.getFrameNumber(timeStamp);
+    }
+
+
+    void VideoReader_zfmf::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        reader_.getFrame(frameNumber, image);
+    }
+
+
+    void VideoReader_zfmf::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        reader_.getFrames(firstFrame, numFrames, imageVec, numThreads);
+    }
+
+
+    ZfmfReader &VideoReader_zfmf::getReader()
+    {
+        return reader_;
+    }
+
+} // namespace bias
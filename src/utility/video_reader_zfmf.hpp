@@ -0,0 +1,46 @@
+#ifndef BIAS_VIDEO_READER_ZFMF_HPP
+#define BIAS_VIDEO_READER_ZFMF_HPP
+
+#include "video_reader.hpp"
+#include "zfmf_reader.hpp"
+
+namespace bias
+{
+
+    class VideoReader_zfmf : public VideoReader
+    {
+        // zfmf files (see ZfmfReader)
+
+        public:
+
+            VideoReader_zfmf();
+            VideoReader_zfmf(QString fileName);
+
+            virtual void open(QString fileName);
+            virtual void close();
+            virtual bool isOpen() const;
+            virtual QString getFileName() const;
+
+            virtual unsigned long getNumberOfFrames() const;
+            virtual double getTimeStamp(unsigned long frameNumber) const;
+            virtual unsigned long getFrameNumber(double timeStamp) const;
+
+            using VideoReader::getFrame;
+            virtual void getFrame(unsigned long frameNumber, cv::Mat &image);
+            virtual void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            ZfmfReader &getReader();
+
+        protected:
+
+            ZfmfReader reader_;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_VIDEO_READER_ZFMF_HPP
@@ -0,0 +1,236 @@
+#include "zfmf_codec.hpp"
+#include "ufmf_codec.hpp"
+#include <cstring>
+#include <climits>
+
+namespace bias
+{
+    const char ZfmfCodec::HEADER_STRING[4] = {'z','f','m','f'};
+    const uint32_t ZfmfCodec::VERSION = 1;
+    const uint64_t ZfmfCodec::HEADER_SIZE = sizeof(HEADER_STRING) + 4*sizeof(uint32_t) + 2*sizeof(uint64_t);
+    const uint64_t ZfmfCodec::NUM_FRAMES_POS = sizeof(HEADER_STRING) + 4*sizeof(uint32_t);
+    const uint64_t ZfmfCodec::INDEX_LOCATION_POS = sizeof(HEADER_STRING) + 4*sizeof(uint32_t) + sizeof(uint64_t);
+    const uint8_t ZfmfCodec::CHUNK_ID = 1;
+    const uint8_t ZfmfCodec::INDEX_ID = 2;
+    const uint64_t ZfmfCodec::CHUNK_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+    const uint64_t ZfmfCodec::INDEX_ENTRY_SIZE = 2*sizeof(uint64_t);
+    const unsigned int ZfmfCodec::MAX_LEVEL = UfmfCodec::MAX_LEVEL;
+    const uint64_t ZfmfCodec::MAX_CHUNK_BYTES = uint64_t(INT_MAX);
+
+
+    // Helper functions
+    // ----------------------------------------------------------------------------------
+    template <class T>
+    static void appendValue(std::vector<char> &buf, T value)
+    {
+        const char *valuePtr = (const char *) &value;
+        buf.insert(buf.end(), valuePtr, valuePtr + sizeof(T));
+    }
+
+    template <class T>
+    static T getValue(const char *data, uint64_t &pos)
+    {
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+
+    // ZfmfHeader
+    // ----------------------------------------------------------------------------------
+    ZfmfHeader::ZfmfHeader()
+    {
+        version = ZfmfCodec::VERSION;
+        height = 0;
+        width = 0;
+        chunkFrames = 0;
+        numFrames = 0;
+        indexLocation = 0;
+    }
+
+
+    uint32_t ZfmfHeader::frameSize() const
+    {
+        return width*height;
+    }
+
+
+    // ZfmfChunkInfo
+    // ----------------------------------------------------------------------------------
+    ZfmfChunkInfo::ZfmfChunkInfo()
+    {
+        loc = 0;
+        firstFrame = 0;
+        numFrames = 0;
+        coding = 0;
+        rawSize = 0;
+        codedSize = 0;
+    }
+
+
+    uint64_t ZfmfChunkInfo::timeStampLoc() const
+    {
+        return loc + ZfmfCodec::CHUNK_HEADER_SIZE;
+    }
+
+
+    uint64_t ZfmfChunkInfo::codedLoc() const
+    {
+        return timeStampLoc() + uint64_t(numFrames)*sizeof(double);
+    }
+
+
+    uint64_t ZfmfChunkInfo::endLoc() const
+    {
+        return codedLoc() + UfmfCodec::CODED_HEADER_SIZE + codedSize;
+    }
+
+
+    // ZfmfCodec
+    // ----------------------------------------------------------------------------------
+    void ZfmfCodec::getHeader(const ZfmfHeader &header, std::vector<char> &data)
+    {
+        data.clear();
+        data.insert(data.end(), HEADER_STRING, HEADER_STRING + sizeof(HEADER_STRING));
+        appendValue(data, header.version);
+        appendValue(data, header.height);
+        appendValue(data, header.width);
+        appendValue(data, header.chunkFrames);
+        appendValue(data, header.numFrames);
+        appendValue(data, header.indexLocation);
+    }
+
+
+    bool ZfmfCodec::parseHeader(const char *data, size_t size, ZfmfHeader &header)
+    {
+        if ((size < HEADER_SIZE) || (std::memcmp(data, HEADER_STRING, sizeof(HEADER_STRING)) != 0))
+        {
+            return false;
+        }
+        uint64_t pos = sizeof(HEADER_STRING);
+        header.version = getValue<uint32_t>(data, pos);
+        header.height = getValue<uint32_t>(data, pos);
+        header.width = getValue<uint32_t>(data, pos);
+        header.chunkFrames = getValue<uint32_t>(data, pos);
+        header.numFrames = getValue<uint64_t>(data, pos);
+        header.indexLocation = getValue<uint64_t>(data, pos);
+        return (header.version == VERSION) && (header.frameSize() > 0) && (header.chunkFrames > 0);
+    }
+
+
+    void ZfmfCodec::encodeChunk(
+            char *frameData,
+            uint32_t frameSize,
+            const std::vector<double> &timeStampVec,
+            unsigned int level,
+            std::vector<char> &chunkData
+            )
+    {
+        // frameData holds the frames back to back and is delta coded in
+        // place - last frame first so each frame is taken from the original.
+        uint32_t numFrames = uint32_t(timeStampVec.size());
+        uint8_t *framePtr = (uint8_t *) frameData;
+        for (uint32_t i=numFrames; i>1; i--)
+        {
+            uint8_t *currPtr = framePtr + uint64_t(i-1)*frameSize;
+            const uint8_t *prevPtr = currPtr - frameSize;
+            for (uint32_t j=0; j<frameSize; j++)
+            {
+                currPtr[j] = uint8_t(currPtr[j] - prevPtr[j]);
+            }
+        }
+
+        uint64_t rawSize = uint64_t(numFrames)*frameSize;
+        std::vector<char> coded;
+        UfmfCodec::encode(frameData, uint32_t(rawSize), level, coded);
+
+        chunkData.clear();
+        chunkData.reserve(CHUNK_HEADER_SIZE + numFrames*sizeof(double) + coded.size());
+        appendValue(chunkData, CHUNK_ID);
+        appendValue(chunkData, numFrames);
+        for (uint32_t i=0; i<numFrames; i++)
+        {
+            appendValue(chunkData, timeStampVec[i]);
+        }
+        chunkData.insert(chunkData.end(), coded.begin(), coded.end());
+    }
+
+
+    bool ZfmfCodec::parseChunk(
+            const char *data,
+            uint64_t size,
+            uint64_t loc,
+            ZfmfChunkInfo &chunkInfo
+            )
+    {
+        // data points at the chunk id and holds size bytes. Checks that the
+        // whole chunk is present.
+        uint64_t pos = 0;
+        if ((size < CHUNK_HEADER_SIZE) || (getValue<uint8_t>(data, pos) != CHUNK_ID))
+        {
+            return false;
+        }
+        chunkInfo.loc = loc;
+        chunkInfo.numFrames = getValue<uint32_t>(data, pos);
+        uint64_t codedPos = chunkInfo.codedLoc() - loc;
+        if ((chunkInfo.numFrames == 0) || (codedPos + UfmfCodec::CODED_HEADER_SIZE > size))
+        {
+            return false;
+        }
+        bool ok = UfmfCodec::parseHeader(
+                data + codedPos,
+                chunkInfo.coding,
+                chunkInfo.rawSize,
+                chunkInfo.codedSize
+                );
+        return ok && (chunkInfo.endLoc() - loc <= size);
+    }
+
+
+    bool ZfmfCodec::decodeChunk(
+            const char *data,
+            const ZfmfChunkInfo &chunkInfo,
+            uint32_t frameSize,
+            char *frameData
+            )
+    {
+        // data points at the chunk id, frameData must hold numFrames frames
+        if (chunkInfo.rawSize != uint64_t(chunkInfo.numFrames)*frameSize)
+        {
+            return false;
+        }
+        const char *codedPtr = data + (chunkInfo.codedLoc() - chunkInfo.loc) + UfmfCodec::CODED_HEADER_SIZE;
+        if (!UfmfCodec::decode(codedPtr, chunkInfo.coding, chunkInfo.rawSize, chunkInfo.codedSize, frameData))
+        {
+            return false;
+        }
+
+        uint8_t *framePtr = (uint8_t *) frameData;
+        for (uint32_t i=1; i<chunkInfo.numFrames; i++)
+        {
+            uint8_t *currPtr = framePtr + uint64_t(i)*frameSize;
+            const uint8_t *prevPtr = currPtr - frameSize;
+            for (uint32_t j=0; j<frameSize; j++)
+            {
+                currPtr[j] = uint8_t(currPtr[j] + prevPtr[j]);
+            }
+        }
+        return true;
+    }
+
+
+    void ZfmfCodec::getIndex(const std::vector<ZfmfChunkInfo> &chunkInfoVec, std::vector<char> &data)
+    {
+        data.clear();
+        data.reserve(sizeof(uint8_t) + sizeof(uint64_t) + chunkInfoVec.size()*INDEX_ENTRY_SIZE);
+        appendValue(data, INDEX_ID);
+        appendValue(data, uint64_t(chunkInfoVec.size()));
+        for (const ZfmfChunkInfo &chunkInfo : chunkInfoVec)
+        {
+            appendValue(data, chunkInfo.loc);
+            appendValue(data, chunkInfo.firstFrame);
+        }
+    }
+
+} // namespace bias
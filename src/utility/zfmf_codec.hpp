@@ -0,0 +1,114 @@
+#ifndef BIAS_ZFMF_CODEC_HPP
+#define BIAS_ZFMF_CODEC_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace bias
+{
+
+    struct ZfmfHeader
+    {
+        uint32_t version;
+        uint32_t height;
+        uint32_t width;
+        uint32_t chunkFrames;
+        uint64_t numFrames;
+        uint64_t indexLocation;
+        ZfmfHeader();
+        uint32_t frameSize() const;
+    };
+
+
+    struct ZfmfChunkInfo
+    {
+        // Location (of chunk id) and contents of a chunk in the file
+        uint64_t loc;
+        uint64_t firstFrame;
+        uint32_t numFrames;
+        uint8_t coding;
+        uint32_t rawSize;
+        uint32_t codedSize;
+        ZfmfChunkInfo();
+        uint64_t timeStampLoc() const;
+        uint64_t codedLoc() const;
+        uint64_t endLoc() const;
+    };
+
+
+    class ZfmfCodec
+    {
+        // Lossless compressed fmf (zfmf) for mono8 images. Frames are grouped
+        // into chunks of up to chunkFrames frames. Within a chunk the first
+        // frame is stored as is and each following frame as its difference
+        // (mod 256) from the previous frame, and the chunk is coded as a
+        // single UfmfCodec block. Chunks don't depend on each other so they
+        // can be coded in parallel and decoded on their own.
+        //
+        // File layout
+        //   header
+        //     char[4] "zfmf", uint32 version
+        //     uint32  height, uint32 width, uint32 chunk frames
+        //     uint64  number of frames, uint64 index location (0 if none)
+        //   chunks
+        //     uint8   chunk id (CHUNK_ID)
+        //     uint32  number of frames
+        //     double  time stamp[number of frames]
+        //     coded block (see UfmfCodec)
+        //   index
+        //     uint8   index id (INDEX_ID)
+        //     uint64  number of chunks
+        //     uint64  chunk loc, uint64 first frame [number of chunks]
+        //
+        // The frame count and index location are written when the file is
+        // closed. Files without an index are read by scanning the chunks.
+        //
+        // The frames of a chunk may not exceed MAX_CHUNK_BYTES as the raw 
+        // size is stored as a uint32 and zlib coded with qCompress.
+
+        public:
+
+            static const char HEADER_STRING[4];
+            static const uint32_t VERSION;
+            static const uint64_t HEADER_SIZE;
+            static const uint64_t NUM_FRAMES_POS;
+            static const uint64_t INDEX_LOCATION_POS;
+            static const uint8_t CHUNK_ID;
+            static const uint8_t INDEX_ID;
+            static const uint64_t CHUNK_HEADER_SIZE;
+            static const uint64_t INDEX_ENTRY_SIZE;
+            static const unsigned int MAX_LEVEL;
+            static const uint64_t MAX_CHUNK_BYTES;
+
+            static void getHeader(const ZfmfHeader &header, std::vector<char> &data);
+            static bool parseHeader(const char *data, size_t size, ZfmfHeader &header);
+
+            static void encodeChunk(
+                    char *frameData,
+                    uint32_t frameSize,
+                    const std::vector<double> &timeStampVec,
+                    unsigned int level,
+                    std::vector<char> &chunkData
+                    );
+
+            static bool parseChunk(
+                    const char *data,
+                    uint64_t size,
+                    uint64_t loc,
+                    ZfmfChunkInfo &chunkInfo
+                    );
+
+            static bool decodeChunk(
+                    const char *data,
+                    const ZfmfChunkInfo &chunkInfo,
+                    uint32_t frameSize,
+                    char *frameData
+                    );
+
+            static void getIndex(const std::vector<ZfmfChunkInfo> &chunkInfoVec, std::vector<char> &data);
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_ZFMF_CODEC_HPP
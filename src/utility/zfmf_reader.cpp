@@ -0,0 +1,497 @@
+#include "zfmf_reader.hpp"
+#include "basic_types.hpp"
+#include "exception.hpp"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+
+namespace bias
+{
+
+    // ZfmfDecodeTask - decodes a block of chunks for getFrames
+    // ----------------------------------------------------------------------------------
+    class ZfmfDecodeTask : public QRunnable
+    {
+        public:
+
+            ZfmfDecodeTask(
+                    const ZfmfReader *readerPtr,
+                    unsigned long firstChunk,
+                    unsigned long numChunks,
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    cv::Mat *imagePtr
+                    )
+            {
+                readerPtr_ = readerPtr;
+                firstChunk_ = firstChunk;
+                numChunks_ = numChunks;
+                firstFrame_ = firstFrame;
+                numFrames_ = numFrames;
+                imagePtr_ = imagePtr;
+                errorFlag_ = false;
+            }
+
+            void run()
+            {
+                // Copies the frames of its chunks which fall in the range
+                // [firstFrame_, firstFrame_ + numFrames_) into imagePtr_
+                cv::Size size = readerPtr_ -> getSize();
+                uint64_t frameSize = uint64_t(size.width)*size.height;
+                std::vector<char> frameData;
+                try
+                {
+                    for (unsigned long i=firstChunk_; i<firstChunk_+numChunks_; i++)
+                    {
+                        const ZfmfChunkInfo &chunkInfo = readerPtr_ -> getChunkInfo(i);
+                        readerPtr_ -> decodeChunk(i, frameData);
+                        for (uint32_t j=0; j<chunkInfo.numFrames; j++)
+                        {
+                            unsigned long frameNumber = (unsigned long)(chunkInfo.firstFrame) + j;
+                            if ((frameNumber < firstFrame_) || (frameNumber >= firstFrame_ + numFrames_))
+                            {
+                                continue;
+                            }
+                            cv::Mat view(size, CV_8UC1, (void *) (&frameData[0] + j*frameSize));
+                            view.copyTo(imagePtr_[frameNumber - firstFrame_]);
+                        }
+                    }
+                }
+                catch (RuntimeError &runtimeError)
+                {
+                    errorFlag_ = true;
+                    errorMsg_ = runtimeError.what();
+                }
+            }
+
+            bool errorFlag_;
+            std::string errorMsg_;
+
+        private:
+
+            const ZfmfReader *readerPtr_;
+            unsigned long firstChunk_;
+            unsigned long numChunks_;
+            unsigned long firstFrame_;
+            unsigned long numFrames_;
+            cv::Mat *imagePtr_;
+    };
+
+
+    // ZfmfReader
+    // ----------------------------------------------------------------------------------
+    ZfmfReader::ZfmfReader()
+    {
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        close();
+    }
+
+
+    ZfmfReader::ZfmfReader(QString fileName) : ZfmfReader()
+    {
+        open(fileName);
+    }
+
+
+    ZfmfReader::~ZfmfReader()
+    {
+        close();
+    }
+
+
+    void ZfmfReader::open(QString fileName)
+    {
+        close();
+
+        file_.setFileName(fileName);
+        if (!file_.open(QIODevice::ReadOnly))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("zfmf reader unable to open file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        dataSize_ = uint64_t(file_.size());
+        if (dataSize_ > 0)
+        {
+            dataPtr_ = file_.map(0, file_.size());
+        }
+        if (dataPtr_ == nullptr)
+        {
+            file_.close();
+            unsigned int errorId = ERROR_VIDEO_READER_OPEN;
+            std::string errorMsg("zfmf reader unable to memory map file: ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+
+        if (!ZfmfCodec::parseHeader((const char *) dataPtr_, size_t(dataSize_), header_))
+        {
+            close();
+            unsigned int errorId = ERROR_VIDEO_READER_FORMAT;
+            std::string errorMsg("zfmf reader: not a zfmf file or unsupported version, ");
+            errorMsg += fileName.toStdString();
+            throw RuntimeError(errorId, errorMsg);
+        }
+        size_ = cv::Size(int(header_.width), int(header_.height));
+
+        haveIndex_ = readIndex();
+        if (!haveIndex_)
+        {
+            scanChunks();
+        }
+        readTimeStamps();
+    }
+
+
+    void ZfmfReader::close()
+    {
+        if (dataPtr_ != nullptr)
+        {
+            file_.unmap((uchar *) dataPtr_);
+        }
+        if (file_.isOpen())
+        {
+            file_.close();
+        }
+        dataPtr_ = nullptr;
+        dataSize_ = 0;
+        header_ = ZfmfHeader();
+        size_ = cv::Size(0,0);
+        haveIndex_ = false;
+        chunkInfoVec_.clear();
+        timeStampVec_.clear();
+
+        acquireLock();
+        cachedChunk_ = -1;
+        cachedFrameData_.clear();
+        releaseLock();
+    }
+
+
+    bool ZfmfReader::isOpen() const
+    {
+        return (dataPtr_ != nullptr);
+    }
+
+
+    QString ZfmfReader::getFileName() const
+    {
+        return file_.fileName();
+    }
+
+
+    cv::Size ZfmfReader::getSize() const
+    {
+        return size_;
+    }
+
+
+    int ZfmfReader::getType() const
+    {
+        return CV_8UC1;
+    }
+
+
+    unsigned int ZfmfReader::getChunkFrames() const
+    {
+        return (unsigned int)(header_.chunkFrames);
+    }
+
+
+    unsigned long ZfmfReader::getNumberOfFrames() const
+    {
+        return (unsigned long)(timeStampVec_.size());
+    }
+
+
+    unsigned long ZfmfReader::getNumberOfChunks() const
+    {
+        return (unsigned long)(chunkInfoVec_.size());
+    }
+
+
+    bool ZfmfReader::haveIndex() const
+    {
+        // False if the chunks were found by scanning
+        return haveIndex_;
+    }
+
+
+    double ZfmfReader::getTimeStamp(unsigned long frameNumber) const
+    {
+        checkFrameNumber(frameNumber);
+        return timeStampVec_[frameNumber];
+    }
+
+
+    std::vector<double> ZfmfReader::getTimeStamps() const
+    {
+        return timeStampVec_;
+    }
+
+
+    unsigned long ZfmfReader::getFrameNumber(double timeStamp) const
+    {
+        // Returns first frame at or after timeStamp (last frame if none)
+        if (timeStampVec_.empty())
+        {
+            return 0;
+        }
+        std::vector<double>::const_iterator it;
+        it = std::lower_bound(timeStampVec_.begin(), timeStampVec_.end(), timeStamp);
+        unsigned long frameNumber = (unsigned long)(it - timeStampVec_.begin());
+        return std::min(frameNumber, getNumberOfFrames() - 1);
+    }
+
+
+    cv::Mat ZfmfReader::getFrame(unsigned long frameNumber)
+    {
+        cv::Mat image;
+        getFrame(frameNumber, image);
+        return image;
+    }
+
+
+    void ZfmfReader::getFrame(unsigned long frameNumber, cv::Mat &image)
+    {
+        checkFrameNumber(frameNumber);
+        unsigned long chunkNumber = getChunkNumber(frameNumber);
+        uint64_t frameSize = uint64_t(header_.frameSize());
+        uint64_t offset = (frameNumber - chunkInfoVec_[chunkNumber].firstFrame)*frameSize;
+
+        acquireLock();
+        try
+        {
+            if (cachedChunk_ != long(chunkNumber))
+            {
+                cachedChunk_ = -1;
+                decodeChunk(chunkNumber, cachedFrameData_);
+                cachedChunk_ = long(chunkNumber);
+            }
+            cv::Mat view(size_, CV_8UC1, (void *) (&cachedFrameData_[0] + offset));
+            view.copyTo(image);
+        }
+        catch (RuntimeError &runtimeError)
+        {
+            releaseLock();
+            throw;
+        }
+        releaseLock();
+    }
+
+
+    void ZfmfReader::getFrames(
+            unsigned long firstFrame,
+            unsigned long numFrames,
+            std::vector<cv::Mat> &imageVec,
+            unsigned int numThreads
+            )
+    {
+        imageVec.resize(numFrames);
+        if (numFrames == 0)
+        {
+            return;
+        }
+        checkFrameNumber(firstFrame + numFrames - 1);
+        unsigned long firstChunk = getChunkNumber(firstFrame);
+        unsigned long numChunks = getChunkNumber(firstFrame + numFrames - 1) - firstChunk + 1;
+
+        if (numThreads == 0)
+        {
+            numThreads = (unsigned int)(std::max(QThread::idealThreadCount(), 1));
+        }
+        numThreads = (unsigned int)(std::min((unsigned long)(numThreads), numChunks));
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(numThreads);
+
+        std::vector<ZfmfDecodeTask*> taskPtrVec;
+        unsigned long blockSize = (numChunks + numThreads - 1)/numThreads;
+        for (unsigned long start=0; start<numChunks; start+=blockSize)
+        {
+            unsigned long count = std::min(blockSize, numChunks - start);
+            ZfmfDecodeTask *taskPtr = new ZfmfDecodeTask(
+                    this,
+                    firstChunk + start,
+                    count,
+                    firstFrame,
+                    numFrames,
+                    &imageVec[0]
+                    );
+            taskPtr -> setAutoDelete(false);
+            taskPtrVec.push_back(taskPtr);
+            threadPool.start(taskPtr);
+        }
+        threadPool.waitForDone();
+
+        std::string errorMsg;
+        for (ZfmfDecodeTask *taskPtr : taskPtrVec)
+        {
+            if (taskPtr -> errorFlag_ && errorMsg.empty())
+            {
+                errorMsg = taskPtr -> errorMsg_;
+            }
+            delete taskPtr;
+        }
+        if (!errorMsg.empty())
+        {
+            throw RuntimeError(ERROR_VIDEO_READER_READ, errorMsg);
+        }
+    }
+
+
+    void ZfmfReader::decodeChunk(unsigned long chunkNumber, std::vector<char> &frameData) const
+    {
+        const ZfmfChunkInfo &chunkInfo = getChunkInfo(chunkNumber);
+        frameData.resize(size_t(chunkInfo.rawSize));
+        const char *chunkPtr = (const char *) (dataPtr_ + chunkInfo.loc);
+        if (!ZfmfCodec::decodeChunk(chunkPtr, chunkInfo, header_.frameSize(), &frameData[0]))
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("zfmf reader: unable to decode chunk ");
+            errorMsg += std::to_string(chunkNumber);
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+
+    unsigned long ZfmfReader::getChunkNumber(unsigned long frameNumber) const
+    {
+        // Last chunk starting at or before frameNumber
+        checkFrameNumber(frameNumber);
+        unsigned long lower = 0;
+        unsigned long upper = getNumberOfChunks();
+        while (upper - lower > 1)
+        {
+            unsigned long middle = lower + (upper - lower)/2;
+            if (chunkInfoVec_[middle].firstFrame <= frameNumber)
+            {
+                lower = middle;
+            }
+            else
+            {
+                upper = middle;
+            }
+        }
+        return lower;
+    }
+
+
+    const ZfmfChunkInfo &ZfmfReader::getChunkInfo(unsigned long chunkNumber) const
+    {
+        if (chunkNumber >= getNumberOfChunks())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("zfmf reader: chunk number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+        return chunkInfoVec_[chunkNumber];
+    }
+
+
+    // Protected methods
+    // ----------------------------------------------------------------------------------
+    bool ZfmfReader::readIndex()
+    {
+        // Index written at close - each entry is checked against its chunk
+        uint64_t loc = header_.indexLocation;
+        uint64_t indexHeaderSize = sizeof(uint8_t) + sizeof(uint64_t);
+        if ((loc < ZfmfCodec::HEADER_SIZE) || (loc + indexHeaderSize > dataSize_))
+        {
+            return false;
+        }
+        const char *indexPtr = (const char *) (dataPtr_ + loc);
+        uint64_t numChunks = 0;
+        std::memcpy(&numChunks, indexPtr + sizeof(uint8_t), sizeof(uint64_t));
+        if ((uint8_t(indexPtr[0]) != ZfmfCodec::INDEX_ID) || (numChunks > (dataSize_ - loc)/ZfmfCodec::INDEX_ENTRY_SIZE))
+        {
+            return false;
+        }
+        if (loc + indexHeaderSize + numChunks*ZfmfCodec::INDEX_ENTRY_SIZE > dataSize_)
+        {
+            return false;
+        }
+
+        std::vector<ZfmfChunkInfo> chunkInfoVec;
+        const char *entryPtr = indexPtr + indexHeaderSize;
+        uint64_t nextFrame = 0;
+        for (uint64_t i=0; i<numChunks; i++)
+        {
+            uint64_t chunkLoc = 0;
+            uint64_t firstFrame = 0;
+            std::memcpy(&chunkLoc, entryPtr, sizeof(uint64_t));
+            std::memcpy(&firstFrame, entryPtr + sizeof(uint64_t), sizeof(uint64_t));
+            entryPtr += ZfmfCodec::INDEX_ENTRY_SIZE;
+
+            ZfmfChunkInfo chunkInfo;
+            if ((chunkLoc < ZfmfCodec::HEADER_SIZE) || (chunkLoc >= loc) || (firstFrame != nextFrame))
+            {
+                return false;
+            }
+            if (!ZfmfCodec::parseChunk((const char *) (dataPtr_ + chunkLoc), loc - chunkLoc, chunkLoc, chunkInfo))
+            {
+                return false;
+            }
+            chunkInfo.firstFrame = firstFrame;
+            chunkInfoVec.push_back(chunkInfo);
+            nextFrame += chunkInfo.numFrames;
+        }
+        chunkInfoVec_ = chunkInfoVec;
+        return true;
+    }
+
+
+    void ZfmfReader::scanChunks()
+    {
+        // Chunks follow each other from the header - stops at the index or
+        // at the first incomplete chunk.
+        chunkInfoVec_.clear();
+        uint64_t loc = ZfmfCodec::HEADER_SIZE;
+        uint64_t nextFrame = 0;
+        while (loc < dataSize_)
+        {
+            ZfmfChunkInfo chunkInfo;
+            if (!ZfmfCodec::parseChunk((const char *) (dataPtr_ + loc), dataSize_ - loc, loc, chunkInfo))
+            {
+                break;
+            }
+            chunkInfo.firstFrame = nextFrame;
+            chunkInfoVec_.push_back(chunkInfo);
+            nextFrame += chunkInfo.numFrames;
+            loc = chunkInfo.endLoc();
+        }
+    }
+
+
+    void ZfmfReader::readTimeStamps()
+    {
+        timeStampVec_.clear();
+        for (const ZfmfChunkInfo &chunkInfo : chunkInfoVec_)
+        {
+            const uchar *timeStampPtr = dataPtr_ + chunkInfo.timeStampLoc();
+            for (uint32_t i=0; i<chunkInfo.numFrames; i++)
+            {
+                double timeStamp;
+                std::memcpy(&timeStamp, timeStampPtr + i*sizeof(double), sizeof(double));
+                timeStampVec_.push_back(timeStamp);
+            }
+        }
+    }
+
+
+    void ZfmfReader::checkFrameNumber(unsigned long frameNumber) const
+    {
+        if (frameNumber >= getNumberOfFrames())
+        {
+            unsigned int errorId = ERROR_VIDEO_READER_READ;
+            std::string errorMsg("zfmf reader: frame number out of range");
+            throw RuntimeError(errorId, errorMsg);
+        }
+    }
+
+} // namespace bias
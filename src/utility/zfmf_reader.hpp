@@ -0,0 +1,85 @@
+#ifndef BIAS_ZFMF_READER_HPP
+#define BIAS_ZFMF_READER_HPP
+
+#include "lockable.hpp"
+#include "zfmf_codec.hpp"
+#include <QString>
+#include <QFile>
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace bias
+{
+
+    class ZfmfReader : public Lockable<Empty>
+    {
+        // Random access reader for zfmf files as written by VideoWriter_zfmf.
+        // The file is memory mapped and chunks are located from the index,
+        // or by scanning them if the file has no index (e.g. the writer
+        // didn't close it). Frames are decoded a chunk at a time. The last
+        // decoded chunk is kept so frames read in order decode each chunk
+        // once. getFrames decodes chunks in parallel.
+        //
+        // getFrame and getFrames may be called from multiple threads.
+
+        public:
+
+            ZfmfReader();
+            ZfmfReader(QString fileName);
+            virtual ~ZfmfReader();
+
+            void open(QString fileName);
+            void close();
+            bool isOpen() const;
+            QString getFileName() const;
+
+            cv::Size getSize() const;
+            int getType() const;
+            unsigned int getChunkFrames() const;
+            unsigned long getNumberOfFrames() const;
+            unsigned long getNumberOfChunks() const;
+            bool haveIndex() const;
+
+            double getTimeStamp(unsigned long frameNumber) const;
+            std::vector<double> getTimeStamps() const;
+            unsigned long getFrameNumber(double timeStamp) const;
+
+            cv::Mat getFrame(unsigned long frameNumber);
+            void getFrame(unsigned long frameNumber, cv::Mat &image);
+            void getFrames(
+                    unsigned long firstFrame,
+                    unsigned long numFrames,
+                    std::vector<cv::Mat> &imageVec,
+                    unsigned int numThreads=0
+                    );
+
+            void decodeChunk(unsigned long chunkNumber, std::vector<char> &frameData) const;
+            unsigned long getChunkNumber(unsigned long frameNumber) const;
+            const ZfmfChunkInfo &getChunkInfo(unsigned long chunkNumber) const;
+
+        protected:
+
+            QFile file_;
+            const uchar *dataPtr_;
+            uint64_t dataSize_;
+
+            ZfmfHeader header_;
+            cv::Size size_;
+            bool haveIndex_;
+            std::vector<ZfmfChunkInfo> chunkInfoVec_;
+            std::vector<double> timeStampVec_;
+
+            // Last decoded chunk - use lock
+            long cachedChunk_;
+            std::vector<char> cachedFrameData_;
+
+            bool readIndex();
+            void scanChunks();
+            void readTimeStamps();
+            void checkFrameNumber(unsigned long frameNumber) const;
+    };
+
+} // namespace bias
+
+#endif // #ifndef BIAS_ZFMF_READER_HPP